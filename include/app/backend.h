@@ -0,0 +1,363 @@
+/**
+ * @file backend.h
+ * @brief The dictionary storage used by the command loop.
+ *
+ * A backend hides which container holds the dictionary, so `main.c` can run
+ * the same commands on a single `SkipList` or on a `ShardList`.
+ */
+
+#ifndef BACKEND_H_DEFINED
+#define BACKEND_H_DEFINED
+
+#include "tads/frontcoded.h"
+#include "tads/item.h"
+#include "tads/shardlist.h"
+#include "tads/skiplist.h"
+#include "tads/tad_types.h"
+#include "tads/valuelog.h"
+
+// Words held by the write buffer when its size is left to the backend, see
+// backend_buffer_enable().
+#define BACKEND_BUFFER_SIZE (1024)
+
+// The value log is compacted once it is twice as big as right after its last
+// compaction, and at least this big, see backend_cold_enable().
+#define BACKEND_COMPACT_MIN (1 << 20)
+
+/**
+ * @brief Told of every write a backend applied, see backend_journal().
+ *
+ * @param ctx the ptr given to backend_journal().
+ * @param kind what was done.
+ * @param item the item inserted, the new value of an update, or the key of a
+ * removal: only read, and only until the call returns.
+ */
+typedef void (*backend_journal_t)(void *ctx, skiplist_op_kind_t kind,
+                                  const Item *item);
+
+/**
+ * @brief The containers a backend can be built on.
+ */
+typedef enum {
+    BACKEND_SKIPLIST,
+    BACKEND_SHARDED,
+} backend_kind_t;
+
+/**
+ * @brief An incomplete wrapper for the backend. Use it as a ptr.
+ */
+typedef struct _backend_s Backend;
+
+/**
+ * @brief Creates a backend made of a single skiplist.
+ *
+ * @param config the configuration of the skiplist, see
+ * skiplist_new_with_config(). NULL selects the default one.
+ * @return Backend* ptr WITH OWNERSHIP, or NULL on error.
+ */
+Backend *backend_new_skiplist(const skiplist_config_t *config);
+
+/**
+ * @brief Creates a backend made of a sharded list.
+ *
+ * @param shards number of shards.
+ * @param threads number of threads used to apply batches.
+ * @param config the configuration of every shard, see
+ * skiplist_new_with_config(). NULL selects the default one.
+ * @return Backend* ptr WITH OWNERSHIP, or NULL on error.
+ */
+Backend *backend_new_sharded(size_t shards, size_t threads,
+                             const skiplist_config_t *config);
+
+/**
+ * @brief Deletes the backend and every item it holds.
+ *
+ * @param backend a ptr to the backend ptr. It will be set to NULL.
+ */
+void backend_del(Backend **backend);
+
+/**
+ * @brief A getter to the kind of the backend.
+ */
+backend_kind_t backend_kind(const Backend *backend);
+
+/**
+ * @brief A getter to the configuration of the lists, with the limits of the
+ * whole backend, see shardlist_config().
+ */
+skiplist_config_t backend_config(const Backend *backend);
+
+/**
+ * @brief Adds a hash index for exact-key lookups, see
+ * skiplist_index_enable(). A later backend_load_sorted() keeps it.
+ *
+ * @return status_t \c SUCCESS, \c NUL_ERR or \c ALLOC_ERR.
+ */
+status_t backend_index_enable(Backend *backend);
+
+/**
+ * @brief Adds a Bloom filter that answers lookups of absent words without a
+ * descent, see skiplist_bloom_enable(). A later backend_load_sorted() keeps
+ * it.
+ *
+ * @param backend ptr to the backend.
+ * @param fp_rate the false positive rate, see skiplist_bloom_enable().
+ * @return status_t \c SUCCESS, \c NUL_ERR or \c ALLOC_ERR.
+ */
+status_t backend_bloom_enable(Backend *backend, double fp_rate);
+
+/**
+ * @brief Turns on the adaptive tower heights for skewed lookups, see
+ * skiplist_adaptive_enable(). A later backend_load_sorted() keeps it.
+ *
+ * @return status_t \c SUCCESS, \c NUL_ERR or \c ALLOC_ERR.
+ */
+status_t backend_adaptive_enable(Backend *backend);
+
+/**
+ * @brief Turns on lazy deletion, see skiplist_lazy_enable(). A later
+ * backend_load_sorted() keeps it.
+ *
+ * @param backend ptr to the backend.
+ * @param ratio the tombstone share that starts the compaction.
+ * @return status_t \c SUCCESS, \c NUL_ERR or \c ALLOC_ERR.
+ */
+status_t backend_lazy_enable(Backend *backend, double ratio);
+
+/**
+ * @brief Turns on front coding for the words loaded by a later
+ * backend_load_sorted() into an empty backend.
+ *
+ * The loaded words are packed in a read-only base (see frontcoded.h) and the
+ * lists only take the writes that come after: insertions of new words, and
+ * the words of the base that are updated, which move to the lists. Removed
+ * words of the base are only marked. Lookups try the lists, then the base.
+ * Items found in the base live until the next backend_search(); printing
+ * merges both sides in order.
+ *
+ * @param backend ptr to the backend.
+ * @param restart entries per block of the base, \c 0 for the default.
+ * @return status_t \c SUCCESS or \c NUL_ERR.
+ */
+status_t backend_front_code_enable(Backend *backend, size_t restart);
+
+/**
+ * @brief Freezes the lists for a read-only phase, e.g. right after
+ * backend_load_sorted(), see skiplist_freeze(). The first write to a list
+ * thaws it.
+ *
+ * @param backend ptr to the backend.
+ * @return status_t \c SUCCESS, \c NUL_ERR or \c ALLOC_ERR, in which case
+ * the lists that are not frozen search their lanes.
+ */
+status_t backend_freeze(Backend *backend);
+
+/**
+ * @brief Turns on a write buffer in front of the lists.
+ *
+ * Insertions and removals are kept in a small sorted buffer, folded into the
+ * net change of every word, and applied together once it holds \c size words
+ * (see backend_flush()): one sorted sweep per list instead of a descent per
+ * write. Lookups and updates read the buffer first, so the buffered writes
+ * are visible at once. Updates of words that are not buffered change the
+ * lists in place, as they move no node.
+ *
+ * A buffered word expires from its insertion, as in the lists (see
+ * skiplist_stamp()), and takes its deadline to them. Insertions into bounded
+ * lists are not buffered, as only the lists know if they have room: they
+ * are refused at once when they do not. The writes a flush can not apply
+ * for want of memory stay buffered for the next one, and a buffer full of
+ * them refuses the writes. Nothing is buffered while a journal is set, see
+ * backend_journal().
+ *
+ * @param backend ptr to the backend.
+ * @param size words buffered before a flush, \c 0 for BACKEND_BUFFER_SIZE.
+ * @return status_t \c SUCCESS, \c NUL_ERR or \c ALLOC_ERR.
+ */
+status_t backend_buffer_enable(Backend *backend, size_t size);
+
+/**
+ * @brief Applies the buffered writes to the lists, in one commit (see
+ * backend_commit()). The words the lists changed since they were buffered,
+ * which expired or were evicted, are then applied one at a time. The ones
+ * that expired in the buffer are dropped.
+ *
+ * @param backend ptr to the backend.
+ * @return status_t \c SUCCESS, \c NUL_ERR or the error of the last write
+ * that could not be applied. Only \c ALLOC_ERR leaves writes in the buffer,
+ * to be applied by the next flush.
+ */
+status_t backend_flush(Backend *backend);
+
+/**
+ * @brief Moves the descriptions of the lists to disk, for dictionaries
+ * bigger than the memory.
+ *
+ * The words, and the lanes over them, stay in memory; the descriptions that
+ * reach the lists from then on are appended to a value log (see valuelog.h)
+ * and the lists keep cold items, with the offset of their description
+ * instead of it (see item_new_cold()). Lookups, removals and prints read
+ * the descriptions back through the page cache of the log. Replaced and
+ * removed descriptions stay in the log until the next backend_compact(),
+ * which runs on its own once the log doubles in size (and is at least
+ * \c BACKEND_COMPACT_MIN bytes).
+ *
+ * @param backend ptr to the backend.
+ * @param dir the directory of the log file, NULL for /tmp.
+ * @param cache_bytes the size of the page cache, \c 0 for \c VALUELOG_CACHE.
+ * @return status_t \c SUCCESS, \c NUL_ERR or \c ALLOC_ERR, also when the
+ * file could not be created (errno tells why).
+ *
+ * @note the words of the front-coded base (see backend_front_code_enable())
+ * keep their descriptions in it. Items found in the log live until the next
+ * backend_search(), as those of the base, and a lookup whose description
+ * cannot be read misses.
+ */
+status_t backend_cold_enable(Backend *backend, const char *dir,
+                             size_t cache_bytes);
+
+/**
+ * @brief Copies the live descriptions to a new value log, in word order, and
+ * drops the old one. Nothing happens without a log.
+ *
+ * @param backend ptr to the backend.
+ * @return status_t \c SUCCESS, \c NUL_ERR, \c ALLOC_ERR or \c CRITICAL_ERR if
+ * a file could not be read or written, in which case the old log stays.
+ */
+status_t backend_compact(Backend *backend);
+
+/**
+ * @brief Inserts an item, see skiplist_insert().
+ */
+status_t backend_insert(Backend *backend, Item *item);
+
+/**
+ * @brief Inserts many items at once. The sharded backend applies them in
+ * parallel.
+ *
+ * @param backend ptr to the backend.
+ * @param items the items; ownership of each one moves on its success.
+ * @param results output, the status of each insertion.
+ * @param n number of items.
+ * @return status_t \c SUCCESS if the batch ran (check \c results), an error
+ * otherwise, in which case nothing was inserted.
+ */
+status_t backend_insert_batch(Backend *backend, Item **items,
+                              status_t *results, size_t n);
+
+/**
+ * @brief Loads items that are already sorted and unique (see loader.h). An
+ * empty backend is built bottom-up; otherwise the items are inserted one by
+ * one.
+ *
+ * @param backend ptr to the backend.
+ * @param items the items; the backend takes ownership of all of them, and
+ * those that could not be stored are freed.
+ * @param n number of items.
+ * @param pool the workers used to build a single skiplist, or NULL.
+ * @return status_t \c SUCCESS, or the last error found.
+ */
+status_t backend_load_sorted(Backend *backend, Item **items, size_t n,
+                             ThreadPool *pool);
+
+/**
+ * @brief Updates an item, see skiplist_update().
+ */
+status_t backend_update(Backend *backend, Item *item);
+
+/**
+ * @brief Removes an item, see skiplist_remove().
+ */
+Item *backend_remove(Backend *backend, Item *item);
+
+/**
+ * @brief Removes and frees an item, see skiplist_delete().
+ */
+status_t backend_delete(Backend *backend, Item *item);
+
+/**
+ * @brief Applies a batch of insertions, updates and removals, all or nothing,
+ * see skiplist_commit() and shardlist_commit(). The words of the batch that
+ * are in the front-coded base move to the lists first, and the buffered
+ * writes are flushed before the batch is checked.
+ */
+status_t backend_commit(Backend *backend, skiplist_op_t *ops, size_t n);
+
+/**
+ * @brief Searches an item, see skiplist_lookup().
+ */
+Item *backend_search(Backend *backend, const Item *item);
+
+/**
+ * @brief Calls fn for every item, in order, from the lists and the base
+ * alike, with its whole description. The buffered writes are flushed first.
+ *
+ * @param backend ptr to the backend.
+ * @param fn the visitor: the item is only valid until it returns, and no
+ * write may be made meanwhile. Anything but \c SUCCESS stops the walk.
+ * @param ctx handed to fn.
+ * @return status_t \c SUCCESS, \c NUL_ERR, or the error that stopped it.
+ */
+status_t backend_foreach(Backend *backend,
+                         status_t (*fn)(Item *item, void *ctx), void *ctx);
+
+/**
+ * @brief Tells fn of every write applied from now on, in the order they are
+ * applied: successful insertions, updates and removals, and the ops of a
+ * committed batch (see backend_commit()). A word that expires or is evicted
+ * is told as a removal when the lists free it (see skiplist_on_drop()). The
+ * words of a backend_load_sorted() are not told. The write buffer (see
+ * backend_buffer_enable()) is flushed, and skipped by the writes from then
+ * on, so that they reach the lists in the order they are told.
+ *
+ * @param backend ptr to the backend.
+ * @param fn the journal, NULL for none.
+ * @param ctx handed to fn.
+ */
+void backend_journal(Backend *backend, backend_journal_t fn, void *ctx);
+
+/**
+ * @brief Makes the backend a replica, or a backend of its own again: a
+ * replica refuses the insertions, updates, removals and batches (see
+ * backend_commit()) with \c READ_ONLY_ERR, as it only takes the writes of
+ * backend_replay().
+ */
+void backend_read_only(Backend *backend, _Bool on);
+
+/**
+ * @brief Applies a write of another backend, e.g. one streamed to a replica
+ * (see backend_read_only()): an insertion (see backend_insert()), an update
+ * or a removal (see backend_delete()).
+ *
+ * @param backend ptr to the backend.
+ * @param kind what the write does.
+ * @param item the item of the write; an insertion takes ownership of it on
+ * success.
+ * @return status_t what the write returned.
+ */
+status_t backend_replay(Backend *backend, skiplist_op_kind_t kind,
+                        Item *item);
+
+/**
+ * @brief Removes every word, e.g. before a replica gets a snapshot again.
+ * The removals are told to the journal (see backend_journal()), and a
+ * replica takes them too.
+ *
+ * @param backend ptr to the backend.
+ * @return status_t \c SUCCESS, \c NUL_ERR, or the error that stopped it, in
+ * which case some words are left.
+ */
+status_t backend_clear(Backend *backend);
+
+/**
+ * @brief Prints to out every item that starts with c, see skiplist_print().
+ * The buffered writes are flushed first.
+ */
+status_t backend_print(Backend *backend, FILE *out, const char c);
+
+/**
+ * @brief Prints the memory summary to out, see skiplist_memory_print().
+ */
+void backend_debug(const Backend *backend, FILE *out);
+
+#endif // BACKEND_H_DEFINED
@@ -0,0 +1,117 @@
+/**
+ * @file binproto.h
+ * @brief A compact binary protocol for machine clients.
+ *
+ * Every message is a frame: a little-endian `u32` with the length of the
+ * body, then the body. Strings are a `u8` length and their bytes (no '\0').
+ *
+ * Request bodies start with an opcode:
+ * - `INSERT`, `UPDATE`: word, description.
+ * - `REMOVE`, `SEARCH`: word.
+ * - `PRINT`: `u8` character.
+ * - `DEBUG`: nothing.
+ * - `MGET`: `u16` n, then n words.
+ * - `MPUT`: `u16` n, then n (word, description) pairs, inserted as a batch.
+ *
+ * Every request gets exactly one response, in order. Its body is the
+ * opcode, an `i8` status (the status_t value) and:
+ * - `SEARCH`, `REMOVE`: on \c SUCCESS, the word and the description found.
+ * - `MGET`: `u16` n, then per word an `i8` status and, on \c SUCCESS, the
+ *   word and the description.
+ * - `MPUT`: `u16` n, then an `i8` status per pair.
+ * - `PRINT`, `DEBUG`: the rest of the body is the listing or the memory
+ *   summary, as text, exactly as printed in text mode. An empty dictionary
+ *   answers `PRINT` \c NOT_FOUND_ERR.
+ * - others: nothing.
+ *
+ * A request with an unknown opcode is answered \c NOT_FOUND_ERR and a
+ * truncated one \c CRITICAL_ERR. Words and descriptions follow the rules of
+ * the text commands (see item_is_parsable()): an empty word, or one with a
+ * space or a '\0', or a description with a '\n', a '\0' or a leading
+ * space, is answered \c INVALID_ERR (per entry in `MGET` and `MPUT`).
+ * Lookup keys are decoded into stack items (see item_place()); only the
+ * stored entries are allocated.
+ */
+
+#ifndef BINPROTO_H_DEFINED
+#define BINPROTO_H_DEFINED
+
+#include <stdio.h>
+
+#include "app/backend.h"
+#include "tads/tad_types.h"
+#include "utils/bytebuf.h"
+
+// Bytes of the frame length prefix.
+#define BINPROTO_HEADER (4)
+
+// Largest accepted request body.
+#define BINPROTO_MAX_BODY (1 << 20)
+
+/**
+ * @brief The opcodes.
+ */
+typedef enum {
+    BIN_INSERT = 1,
+    BIN_UPDATE,
+    BIN_REMOVE,
+    BIN_SEARCH,
+    BIN_PRINT,
+    BIN_DEBUG,
+    BIN_MGET,
+    BIN_MPUT,
+} bin_op_t;
+
+/**
+ * @brief Measures the first frame of a buffer.
+ *
+ * @param buf ptr to the received bytes.
+ * @param len number of received bytes.
+ * @param frame_len set to the size of the complete frame, header included,
+ * or to 0 if it was not fully received yet.
+ * @return status_t \c SUCCESS, or \c TOO_MUCH_ERR if the frame is larger
+ * than BINPROTO_MAX_BODY (the stream can not be resynchronized).
+ */
+status_t binproto_frame(const unsigned char *buf, size_t len,
+                        size_t *frame_len);
+
+/**
+ * @brief Executes a request and appends its response frame.
+ *
+ * @param backend ptr to the backend.
+ * @param body ptr to the request body (after the header).
+ * @param len length of the body.
+ * @param out where the response is appended.
+ * @return status_t \c SUCCESS, or \c ALLOC_ERR if the response could not be
+ * written.
+ */
+status_t binproto_execute(Backend *backend, const unsigned char *body,
+                          size_t len, ByteBuf *out);
+
+/**
+ * @brief Serves the requests read from in until its end, writing the
+ * responses to out.
+ *
+ * @return status_t \c SUCCESS at the end of the input, or an error on a
+ * broken frame or stream.
+ */
+status_t binproto_run(Backend *backend, FILE *in, FILE *out);
+
+/**
+ * @brief Starts a frame: appends the length placeholder and the opcode.
+ *
+ * @return size_t where the frame starts, for binproto_end().
+ */
+size_t binproto_begin(ByteBuf *buf, bin_op_t op);
+
+/**
+ * @brief Finishes a frame started at start, filling its length.
+ */
+void binproto_end(ByteBuf *buf, size_t start);
+
+/**
+ * @brief Appends a string (truncated to 255 bytes).
+ */
+status_t binproto_put_str(ByteBuf *buf, const char *s, size_t len);
+
+#endif // BINPROTO_H_DEFINED
@@ -0,0 +1,173 @@
+/**
+ * @file command.h
+ * @brief The commands read by the program, split in three steps.
+ *
+ * A command is read from stdin (command_read()), executed against a backend
+ * (executor_submit()) and its reply is written out (reply_write()). Each step
+ * only hands plain values to the next one, so they can run one after the
+ * other (serial mode) or on their own threads (see pipeline.h) and produce
+ * the very same output.
+ */
+
+#ifndef COMMAND_H_DEFINED
+#define COMMAND_H_DEFINED
+
+#include <stdio.h>
+
+#include "app/backend.h"
+#include "tads/item.h"
+#include "tads/tad_types.h"
+
+#define INVALID_OP_MSG "OPERACAO INVALIDA\n"
+
+/**
+ * @brief The operations understood by the program.
+ */
+typedef enum {
+    CMD_INSERT,  // insercao {W} {D}
+    CMD_UPDATE,  // alteracao {W} {D}
+    CMD_REMOVE,  // remocao {W}
+    CMD_SEARCH,  // busca {W}
+    CMD_PRINT,   // impressao {C}
+    CMD_DEBUG,   // debug
+    CMD_BEGIN,   // inicio
+    CMD_COMMIT,  // confirmacao
+    CMD_INVALID, // anything else
+} cmd_op_t;
+
+/**
+ * @brief A parsed command. Only insertions allocate their item, which the
+ * backend keeps; the other operations only read theirs, so it is parsed
+ * into the command itself (see item_in()).
+ */
+typedef struct {
+    cmd_op_t op;
+    Item *item;      // WITH OWNERSHIP, for CMD_INSERT
+    item_buf_t key;  // for CMD_UPDATE, CMD_REMOVE and CMD_SEARCH
+    char c;          // for CMD_PRINT
+    _Bool last;      // no command is read after this one
+} command_t;
+
+/**
+ * @brief The outcome of a command, everything needed to write it out.
+ */
+typedef struct {
+    cmd_op_t op;
+    status_t status;
+    item_buf_t found; // a copy of the item of a successful CMD_SEARCH
+    char *text; // WITH OWNERSHIP, the rendered output of CMD_PRINT/CMD_DEBUG
+    size_t len;
+} reply_t;
+
+/**
+ * @brief Receives the replies, in command order. Takes ownership of the
+ * reply contents.
+ */
+typedef void (*reply_sink_f)(reply_t *reply, void *ctx);
+
+/**
+ * @brief An incomplete wrapper for the executor. Use it as a ptr.
+ */
+typedef struct _executor_s Executor;
+
+/**
+ * @brief An incomplete wrapper for the writes collected between \c inicio
+ * and \c confirmacao. Use it as a ptr.
+ */
+typedef struct _block_s Block;
+
+/**
+ * @brief Reads the next command from stdin.
+ *
+ * @param cmd ptr to where the command is stored.
+ * @return status_t \c SUCCESS, or \c EOF_ERR when there are no more commands.
+ */
+status_t command_read(command_t *cmd);
+
+/**
+ * @brief Parses a command held in memory. Unlike command_read(), a command
+ * is a single line: its arguments must be on it and anything after the
+ * expected ones is ignored.
+ *
+ * @param line ptr to the first character of the line.
+ * @param len number of characters of the line, without the '\n'.
+ * @param cmd ptr to where the command is stored.
+ * @return status_t \c SUCCESS, or \c EOF_ERR if the line is blank.
+ */
+status_t command_parse(const char *line, size_t len, command_t *cmd);
+
+/**
+ * @brief Creates an executor for a backend.
+ *
+ * Consecutive insertions are held and applied as one backend batch (so the
+ * sharded backend can spread them across its threads); any other command,
+ * executor_flush() or a full batch applies them first. Replies are emitted
+ * in command order regardless.
+ *
+ * Between \c inicio and \c confirmacao, insertions, updates and removals
+ * are collected in a block and committed together, all or nothing (see
+ * backend_commit()): they have no reply of their own, the commit answers for
+ * the block. Searches, prints and debug run right away and do not see the
+ * block.
+ *
+ * @param backend ptr to the backend, borrowed.
+ * @param sink called with every reply.
+ * @param ctx opaque ptr forwarded to sink.
+ * @return Executor* ptr WITH OWNERSHIP, or NULL on error.
+ */
+Executor *executor_new(Backend *backend, reply_sink_f sink, void *ctx);
+
+/**
+ * @brief Flushes the pending insertions and frees the executor.
+ *
+ * @param executor a ptr to the executor ptr. It will be set to NULL.
+ */
+void executor_del(Executor **executor);
+
+/**
+ * @brief Executes a command.
+ *
+ * @param executor ptr to the executor.
+ * @param cmd ptr to the command. Its item is taken.
+ */
+void executor_submit(Executor *executor, command_t *cmd);
+
+/**
+ * @brief Applies the pending insertions and emits their replies.
+ *
+ * @param executor ptr to the executor.
+ */
+void executor_flush(Executor *executor);
+
+/**
+ * @brief Swaps the open block of the executor, NULL if there is none, with
+ * another one, so the clients of a server each keep their own.
+ *
+ * @param executor ptr to the executor.
+ * @param block in and out, ptr to the block ptr.
+ */
+void executor_swap_block(Executor *executor, Block **block);
+
+/**
+ * @brief Frees a block that will not be committed, with its insertions.
+ *
+ * @param block a ptr to the block ptr. It will be set to NULL.
+ */
+void block_del(Block **block);
+
+/**
+ * @brief Writes a reply the way the serial program always did.
+ *
+ * @param reply ptr to the reply.
+ * @param out the output stream.
+ */
+void reply_write(const reply_t *reply, FILE *out);
+
+/**
+ * @brief Frees the contents of a reply.
+ *
+ * @param reply ptr to the reply.
+ */
+void reply_clear(reply_t *reply);
+
+#endif // COMMAND_H_DEFINED
@@ -0,0 +1,35 @@
+/**
+ * @file loader.h
+ * @brief Parallel loading of unsorted word lists.
+ *
+ * The input is read at once, cut in chunks at line boundaries and parsed on
+ * several threads. The items are then sorted with a parallel, stable merge
+ * sort and the repeated words are dropped, keeping the first occurrence (the
+ * same one a loop of insertions would keep). The result is ready for
+ * skiplist_from_sorted() or shardlist_load_sorted().
+ */
+
+#ifndef LOADER_H_DEFINED
+#define LOADER_H_DEFINED
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "tads/item.h"
+#include "tads/tad_types.h"
+#include "utils/threadpool.h"
+
+/**
+ * @brief Reads every `{W} {D}` line of a stream and returns the items sorted
+ * and without repeated words.
+ *
+ * @param in the stream, read until EOF.
+ * @param pool the workers, or NULL to do everything on the calling thread.
+ * @param items output, a heap array of items; you own the array and the items.
+ * @param n output, the number of items.
+ * @return status_t \c SUCCESS, \c NUL_ERR or \c ALLOC_ERR.
+ */
+status_t loader_read_sorted(FILE *in, ThreadPool *pool, Item ***items,
+                            size_t *n);
+
+#endif // LOADER_H_DEFINED
@@ -0,0 +1,60 @@
+/**
+ * @file loadgen.h
+ * @brief A load generator and benchmark for the socket server.
+ *
+ * First, one connection inserts `keys` distinct words. Then `clients`
+ * connections send `requests` commands between them, `window` at a time
+ * without waiting for the replies (pipelining): searches of random words,
+ * and a `writes` percentage of updates. Every window ends with a search, and
+ * each search gets exactly one reply line while a successful update gets
+ * none, so the replies of a window are known to be complete when its
+ * searches are answered.
+ *
+ * With the binary protocol, the searches of a window travel in a single MGET
+ * and each update in its own frame (the window is capped at 65535), and the
+ * keys are prefilled with MPUT batches. Every frame gets one response.
+ *
+ * Keys are picked uniformly, or with a Zipfian popularity: with skew s, the
+ * key of rank r gets a share of the commands proportional to 1 / r^s (s near
+ * 1 resembles the word frequencies of natural text).
+ *
+ * The report gives the throughput and the latency of the windows.
+ */
+
+#ifndef LOADGEN_H_DEFINED
+#define LOADGEN_H_DEFINED
+
+#include <stdio.h>
+
+#include "tads/tad_types.h"
+
+#define LOADGEN_CLIENTS (16)
+#define LOADGEN_REQUESTS (100000)
+#define LOADGEN_WINDOW (16)
+#define LOADGEN_KEYS (10000)
+
+/**
+ * @brief Load generator settings. Zeros select the defaults above.
+ */
+typedef struct {
+    const char *addr;    // see netutils.h for the forms
+    size_t clients;      // simultaneous connections
+    size_t requests;     // measured commands, over all the clients
+    size_t window;       // commands in flight per connection
+    size_t keys;         // words inserted before measuring
+    unsigned int writes; // percentage of updates among the commands
+    _Bool binary;        // speak the binary protocol (binproto.h)
+    double zipf;         // Zipfian skew of the searched keys, 0 for uniform
+} loadgen_config_t;
+
+/**
+ * @brief Runs the load and writes the report.
+ *
+ * @param config ptr to the settings.
+ * @param report where the report is written.
+ * @return status_t \c SUCCESS, or an error if the server could not be
+ * reached or a connection broke.
+ */
+status_t loadgen_run(const loadgen_config_t *config, FILE *report);
+
+#endif // LOADGEN_H_DEFINED
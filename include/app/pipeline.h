@@ -0,0 +1,35 @@
+/**
+ * @file pipeline.h
+ * @brief Runs the commands as a three stage pipeline.
+ *
+ * A parser thread reads the commands from stdin, an executor thread applies
+ * them to the backend and the calling thread writes the replies. The stages
+ * are joined by bounded rings (see ring.h), which keep the command order, so
+ * the output is exactly the one of the serial loop.
+ */
+
+#ifndef PIPELINE_H_DEFINED
+#define PIPELINE_H_DEFINED
+
+#include <stdio.h>
+
+#include "app/backend.h"
+#include "app/command.h"
+#include "tads/tad_types.h"
+
+// Default number of commands (and replies) in flight between two stages.
+#define PIPELINE_DEPTH (1024)
+
+/**
+ * @brief Reads and executes every command of stdin, writing the replies to
+ * out.
+ *
+ * @param backend ptr to the backend.
+ * @param out the output stream.
+ * @param depth capacity of each ring, zero means PIPELINE_DEPTH.
+ * @return status_t \c SUCCESS, or an error if the pipeline could not be
+ * started (no command was read in that case).
+ */
+status_t pipeline_run(Backend *backend, FILE *out, size_t depth);
+
+#endif // PIPELINE_H_DEFINED
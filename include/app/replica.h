@@ -0,0 +1,193 @@
+/**
+ * @file replica.h
+ * @brief Streams the writes of a leader to followers that replay them.
+ *
+ * A leader records every write its backend applies (see backend_journal())
+ * as a frame of a stream, numbered from 1, and keeps the most recent frames
+ * in a backlog. Followers connect to its address, say the first number they
+ * want, and get the frames from there on, in order; they apply them to a
+ * backend of their own, where they serve the reads.
+ *
+ * Frames are those of binproto.h: a little-endian `u32` with the length of
+ * the body, then the body, which starts with an opcode:
+ * - `HELLO`, follower to leader: `u64` the first number wanted, or 0 for a
+ *   snapshot. It may come again on the same connection, see
+ *   follower_resync().
+ * - `INSERT`, `UPDATE`: `u64` number, word, description.
+ * - `REMOVE`: `u64` number, word.
+ * - `SNAPSHOT`: `u64` number. The whole dictionary as of that number
+ *   follows, as `INSERT` frames numbered 0, then the stream after it.
+ * - `GONE`: `u64` the oldest number of the backlog. The number asked for
+ *   was dropped from it (or is not there yet), and the leader hangs up.
+ *
+ * A follower that starts empty asks for a snapshot. One that starts from a
+ * copy of the leader's words as of number N, e.g. the leader's own `--load`
+ * as of 0, asks for N + 1, which the leader streams as long as its backlog
+ * still holds it. Its backend takes no other writes (see
+ * backend_read_only()).
+ *
+ * Both ends are single threaded and never block: they are pumped by the
+ * loop that owns the backend, as the leader renders the snapshots from the
+ * backend and the follower applies the frames to it. Their descriptor tells
+ * when a pump has work to do (see server_config_t::watch_fd).
+ *
+ * @note the stream is the only source of truth: the words that expire or
+ * are evicted on the leader come as `REMOVE` frames (see backend_journal()),
+ * and a follower has no limits of its own (see follower_new()). So every
+ * write applies as it is, and one that does not means the stream broke.
+ */
+
+#ifndef REPLICA_H_DEFINED
+#define REPLICA_H_DEFINED
+
+#include <stdint.h>
+
+#include "app/backend.h"
+#include "tads/tad_types.h"
+
+// Bytes of frames a leader keeps when none is given, see leader_new().
+#define REPLICA_BACKLOG (16 << 20)
+
+// Bytes queued for a follower before the socket takes them.
+#define REPLICA_OUT_HIGH (1 << 20)
+
+// Milliseconds a leader waits for its followers on leader_drain().
+#define REPLICA_DRAIN_MS (5000)
+
+/**
+ * @brief The opcodes.
+ */
+typedef enum {
+    REPLICA_HELLO = 1,
+    REPLICA_INSERT,
+    REPLICA_UPDATE,
+    REPLICA_REMOVE,
+    REPLICA_SNAPSHOT,
+    REPLICA_GONE,
+} replica_op_t;
+
+/**
+ * @brief An incomplete wrapper for the leader. Use it as a ptr.
+ */
+typedef struct _leader_s Leader;
+
+/**
+ * @brief An incomplete wrapper for a follower. Use it as a ptr.
+ */
+typedef struct _follower_s Follower;
+
+/**
+ * @brief Starts streaming the writes of a backend: listens on an address and
+ * becomes the journal of the backend.
+ *
+ * @param backend ptr to the backend. It must outlive the leader.
+ * @param addr the address, see netutils.h.
+ * @param backlog bytes of frames kept for the followers that lag behind,
+ * \c 0 for \c REPLICA_BACKLOG. A follower that lags even more is dropped.
+ * @return Leader* ptr WITH OWNERSHIP, or NULL on error.
+ */
+Leader *leader_new(Backend *backend, const char *addr, size_t backlog);
+
+/**
+ * @brief Stops streaming: the followers are dropped and the backend is left
+ * without a journal.
+ *
+ * @param leader a ptr to the leader ptr. It will be set to NULL.
+ */
+void leader_del(Leader **leader);
+
+/**
+ * @brief A getter to the descriptor that turns readable when leader_pump()
+ * has work to do.
+ */
+int leader_fd(const Leader *leader);
+
+/**
+ * @brief Accepts the followers, answers their hellos and sends them what was
+ * recorded since the last pump, as far as their sockets take it. It goes on
+ * until none is left to accept or read, so a hello that came right after its
+ * connection is answered by the same pump.
+ *
+ * @param leader ptr to the leader.
+ * @return status_t \c SUCCESS or \c NUL_ERR. A follower whose connection
+ * broke, or who lagged past the backlog, is dropped.
+ */
+status_t leader_pump(Leader *leader);
+
+/**
+ * @brief Pumps until every follower has been sent every frame, e.g. before
+ * the leader exits.
+ *
+ * @param leader ptr to the leader.
+ * @param timeout_ms how long to wait for slow followers.
+ * @return size_t the followers still behind when it gave up.
+ */
+size_t leader_drain(Leader *leader, int timeout_ms);
+
+/**
+ * @brief A getter to the number of the last frame recorded.
+ */
+uint64_t leader_seq(const Leader *leader);
+
+/**
+ * @brief Connects to a leader and asks for its stream.
+ *
+ * @param backend ptr to the backend the frames are applied to. It must
+ * outlive the follower.
+ * @param addr the address of the leader, see netutils.h.
+ * @param from the first number wanted, \c 0 for a snapshot (then the
+ * backend should be empty).
+ * @return Follower* ptr WITH OWNERSHIP, or NULL on error, e.g. a backend
+ * with a ttl, max entries or max bytes (see backend_config()): its words
+ * may only go away with the leader's stream.
+ *
+ * @note the backend stays read-only (see backend_read_only()), even after
+ * follower_del(): its words are the leader's.
+ */
+Follower *follower_new(Backend *backend, const char *addr, uint64_t from);
+
+/**
+ * @brief Hangs up.
+ *
+ * @param follower a ptr to the follower ptr. It will be set to NULL.
+ */
+void follower_del(Follower **follower);
+
+/**
+ * @brief A getter to the descriptor that turns readable when
+ * follower_pump() has frames to apply.
+ */
+int follower_fd(const Follower *follower);
+
+/**
+ * @brief Applies, in order, every frame received so far.
+ *
+ * @param follower ptr to the follower.
+ * @return status_t \c SUCCESS, \c NUL_ERR, \c EOF_ERR once the leader hung
+ * up or the connection broke, \c NOT_FOUND_ERR if it no longer has the
+ * frames asked for (see follower_seq()), \c TOO_MUCH_ERR on a frame too
+ * large, or \c CRITICAL_ERR on a frame that does not apply: a broken or
+ * missing one, or a write the backend refused (see the note of replica.h).
+ * After an
+ * error, the follower applies nothing else; after \c CRITICAL_ERR,
+ * follower_resync() starts it over.
+ */
+status_t follower_pump(Follower *follower);
+
+/**
+ * @brief Starts over from a snapshot, on the same connection: the backend
+ * is emptied (see backend_clear()), and the frames still coming from the
+ * old stream are dropped until the snapshot.
+ *
+ * @param follower ptr to the follower.
+ * @return status_t \c SUCCESS, \c NUL_ERR, or the error that kept it from
+ * asking, in which case it applies nothing else.
+ */
+status_t follower_resync(Follower *follower);
+
+/**
+ * @brief A getter to the number of the last frame applied.
+ */
+uint64_t follower_seq(const Follower *follower);
+
+#endif // REPLICA_H_DEFINED
@@ -0,0 +1,60 @@
+/**
+ * @file server.h
+ * @brief Serves the dictionary over a socket.
+ *
+ * The server speaks the same command language as stdin, one command per line
+ * (see command_parse()), and answers with exactly the text the program would
+ * print. Clients may pipeline: every complete line received is executed, in
+ * order, and the replies are queued on the connection.
+ *
+ * A single thread multiplexes every client with epoll and non-blocking
+ * sockets; each connection owns a read buffer (for partial lines) and a write
+ * buffer (for replies the client has not taken yet). A connection whose write
+ * buffer grows past SERVER_OUT_HIGH is not read again until it drains.
+ *
+ * With server_config_t::binary set, the clients speak the binary protocol
+ * instead (see binproto.h): every complete frame is executed, in order.
+ */
+
+#ifndef SERVER_H_DEFINED
+#define SERVER_H_DEFINED
+
+#include "app/backend.h"
+#include "tads/tad_types.h"
+
+// Default max number of simultaneous clients.
+#define SERVER_MAX_CLIENTS (4096)
+
+// Bytes of pending replies above which a client is not read.
+#define SERVER_OUT_HIGH (1 << 20)
+
+// Longest accepted line; longer ones are cut (and are invalid anyway).
+#define SERVER_LINE_MAX (1024)
+
+/**
+ * @brief Server settings.
+ */
+typedef struct {
+    const char *addr;   // see netutils.h for the forms
+    size_t max_clients; // zero means SERVER_MAX_CLIENTS
+    _Bool binary;       // speak the binary protocol (binproto.h) instead
+
+    // Other work of the loop, e.g. replication (see replica.h): on_watch, if
+    // set, runs after every wake up, and watch_fd turning readable wakes the
+    // loop up. Once it fails, it is not run again.
+    int watch_fd;
+    status_t (*on_watch)(void *ctx);
+    void *watch_ctx;
+} server_config_t;
+
+/**
+ * @brief Serves until SIGINT or SIGTERM.
+ *
+ * @param backend ptr to the backend.
+ * @param config ptr to the settings.
+ * @return status_t \c SUCCESS after a clean stop, or an error if the address
+ * could not be listened on.
+ */
+status_t server_run(Backend *backend, const server_config_t *config);
+
+#endif // SERVER_H_DEFINED
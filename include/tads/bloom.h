@@ -0,0 +1,89 @@
+/**
+ * @file bloom.h
+ * @brief Header file for a blocked Bloom filter of key hashes.
+ *
+ * Each key sets k bits inside a single 64 byte block (one cache line), chosen
+ * by its hash, so a query costs one cache miss. The filter can say that a key
+ * is surely absent, or that it may be present.
+ *
+ * Bits can not be cleared, so a removed key stays as a stale positive. The
+ * filter counts the keys added and the keys forgotten; once it holds more
+ * keys than it was sized for, or too many are stale, bloom_is_saturated()
+ * tells the owner to build a new one.
+ */
+
+#ifndef BLOOM_H_DEFINED
+#define BLOOM_H_DEFINED
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "tads/tad_types.h"
+
+// False positive rate used when the requested one is not in (0, 1).
+#define BLOOM_FP_RATE (0.01)
+
+// Keys a new filter is sized for, at least.
+#define BLOOM_MIN_CAPACITY (1024)
+
+/**
+ * @brief An incomplete wrapper for the filter. Use it as a ptr.
+ */
+typedef struct _bloom_s Bloom;
+
+/**
+ * @brief Creates an empty filter.
+ *
+ * @param capacity number of keys it is sized for.
+ * @param fp_rate false positive rate expected at that capacity.
+ * @return Bloom* ptr to the filter, WITH OWNERSHIP, or NULL on error.
+ */
+Bloom *bloom_new(size_t capacity, double fp_rate);
+
+/**
+ * @brief Frees the filter.
+ *
+ * @param bloom a ptr to the filter ptr. It will be set to NULL.
+ */
+void bloom_del(Bloom **bloom);
+
+/**
+ * @brief Adds a key, by its hash (see item_hash()).
+ */
+void bloom_add(Bloom *bloom, uint64_t hash);
+
+/**
+ * @brief Checks a key, by its hash.
+ *
+ * @return _Bool \c 0 if the key was surely never added, \c 1 if it may have
+ * been.
+ */
+_Bool bloom_may_contain(const Bloom *bloom, uint64_t hash);
+
+/**
+ * @brief Records that n keys added before were removed. Their bits stay set.
+ */
+void bloom_forget(Bloom *bloom, size_t n);
+
+/**
+ * @brief Checks if the filter should be rebuilt: it holds more keys than its
+ * capacity, or more than half of them are stale.
+ */
+_Bool bloom_is_saturated(const Bloom *bloom);
+
+/**
+ * @brief Removes every key, keeping the size.
+ */
+void bloom_clear(Bloom *bloom);
+
+/**
+ * @brief A getter to the false positive rate the filter was sized for.
+ */
+double bloom_fp_rate(const Bloom *bloom);
+
+/**
+ * @brief Heap bytes used by the filter, its header included.
+ */
+size_t bloom_bytes(const Bloom *bloom);
+
+#endif // BLOOM_H_DEFINED
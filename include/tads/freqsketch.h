@@ -0,0 +1,65 @@
+/**
+ * @file freqsketch.h
+ * @brief Header file for an aging count-min sketch of key accesses.
+ *
+ * The sketch estimates how often each key was accessed, in a fixed amount of
+ * memory: FREQSKETCH_ROWS rows of 16 bit counters, each row indexed by a
+ * different mix of the key hash. The estimate is the smallest of the key's
+ * counters, so it can be too high (when other keys share all of them) but
+ * never too low. Only the smallest counters are incremented (conservative
+ * update), which keeps the overestimation down.
+ *
+ * Once the sketch has counted ten accesses per column, every counter and the
+ * total are halved, so old popularity fades and the counts follow the
+ * recent accesses.
+ */
+
+#ifndef FREQSKETCH_H_DEFINED
+#define FREQSKETCH_H_DEFINED
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "tads/tad_types.h"
+
+// Rows of counters.
+#define FREQSKETCH_ROWS (4)
+
+/**
+ * @brief An incomplete wrapper for the sketch. Use it as a ptr.
+ */
+typedef struct _freqsketch_s FreqSketch;
+
+/**
+ * @brief Creates a sketch with every count at zero.
+ *
+ * @param width counters per row, rounded up to a power of two.
+ * @return FreqSketch* ptr to the sketch, WITH OWNERSHIP, or NULL on error.
+ */
+FreqSketch *freqsketch_new(size_t width);
+
+/**
+ * @brief Frees the sketch.
+ *
+ * @param sketch a ptr to the sketch ptr. It will be set to NULL.
+ */
+void freqsketch_del(FreqSketch **sketch);
+
+/**
+ * @brief Counts an access to a key, by its hash (see item_hash()).
+ *
+ * @return uint32_t the estimated accesses to the key, this one included.
+ */
+uint32_t freqsketch_touch(FreqSketch *sketch, uint64_t hash);
+
+/**
+ * @brief A getter to the number of accesses counted, aged like the counters.
+ */
+size_t freqsketch_total(const FreqSketch *sketch);
+
+/**
+ * @brief Heap bytes used by the sketch, its header included.
+ */
+size_t freqsketch_bytes(const FreqSketch *sketch);
+
+#endif // FREQSKETCH_H_DEFINED
@@ -0,0 +1,107 @@
+/**
+ * @file frontcoded.h
+ * @brief Header file for a read-only, front-coded set of items.
+ *
+ * The items, sorted by word, are packed in blocks: the first entry of a block
+ * keeps its whole word (the restart key), every other one only the length of
+ * the prefix it shares with the previous word and the rest of it. Sorted
+ * dictionaries share long prefixes, so the words take a fraction of the
+ * fixed entry buffers of the items (see item.h).
+ *
+ * The restart keys play the role of the upper lanes of a skiplist: a lookup
+ * searches them, then decodes a single block. Words can be forgotten, but not
+ * added: the set is meant for the read-mostly part of a dictionary, with the
+ * writes kept elsewhere (see backend_front_code_enable()).
+ */
+
+#ifndef FRONTCODED_H_DEFINED
+#define FRONTCODED_H_DEFINED
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "tads/item.h"
+#include "tads/tad_types.h"
+
+/**
+ * @brief Entries per block used when none is given.
+ */
+#define FRONTCODED_RESTART (16)
+
+/**
+ * @brief An incomplete wrapper for the set. Use it as a ptr.
+ */
+typedef struct _frontcoded_s FrontCoded;
+
+/**
+ * @brief Packs items into a new set. The items are only read.
+ *
+ * @param items the items, sorted by item_cmp() and without repeated words.
+ * @param n number of items.
+ * @param restart entries per block, \c 0 selects \c FRONTCODED_RESTART.
+ * @return FrontCoded* ptr to the set, WITH OWNERSHIP, or NULL on error.
+ */
+FrontCoded *frontcoded_new(Item *const *items, size_t n, size_t restart);
+
+/**
+ * @brief Frees the set.
+ *
+ * @param fc a ptr to the set ptr. It will be set to NULL.
+ */
+void frontcoded_del(FrontCoded **fc);
+
+/**
+ * @brief Searches the word of an item, decoding its entry into buf.
+ *
+ * @param fc ptr to the set.
+ * @param item the key: only its word is read.
+ * @param buf the storage of the decoded entry, see item_place().
+ * @return Item* a ptr into buf, WITHOUT OWNERSHIP, or NULL if the word is
+ * absent or was forgotten.
+ */
+Item *frontcoded_get(const FrontCoded *fc, const Item *item, item_buf_t *buf);
+
+/**
+ * @brief Forgets the word of an item: later searches miss it.
+ *
+ * @param fc ptr to the set.
+ * @param item the key: only its word is read.
+ * @return status_t \c SUCCESS, \c NUL_ERR or \c NOT_FOUND_ERR.
+ */
+status_t frontcoded_forget(FrontCoded *fc, const Item *item);
+
+/**
+ * @brief Calls fn, in order, for every word of the set that starts with c.
+ * The items are decoded on the stack, see frontcoded_get().
+ *
+ * @param fc ptr to the set.
+ * @param c the first character.
+ * @param fn the callback. Anything other than \c SUCCESS stops the walk.
+ * @param ctx passed to fn.
+ * @return status_t \c SUCCESS, \c NUL_ERR or the status that stopped it.
+ */
+status_t frontcoded_foreach_char(const FrontCoded *fc, const char c,
+                                 status_t (*fn)(Item *item, void *ctx),
+                                 void *ctx);
+
+/**
+ * @brief A getter to the number of words not forgotten.
+ */
+size_t frontcoded_length(const FrontCoded *fc);
+
+/**
+ * @brief Heap bytes used by the set, its header included.
+ */
+size_t frontcoded_bytes(const FrontCoded *fc);
+
+/**
+ * @brief Prints the size of the set, and the size of its words next to the
+ * size of the word buffers of as many items.
+ *
+ * @param out the output stream.
+ * @param fc ptr to the set.
+ */
+void frontcoded_memory_fprint(FILE *out, const FrontCoded *fc);
+
+#endif // FRONTCODED_H_DEFINED
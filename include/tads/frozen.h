@@ -0,0 +1,83 @@
+/**
+ * @file frozen.h
+ * @brief Header file for an immutable, read-optimized index of items.
+ *
+ * The items, sorted by word, are laid out in a single array in Eytzinger
+ * order: the root of an implicit binary search tree at slot 1 and the
+ * children of slot k at 2k and 2k + 1, as in a binary heap. A search walks
+ * down the array with no branch on the comparisons, and the slots it may
+ * visit three levels below share a cache line that is fetched ahead, so it
+ * waits for about one miss per three levels instead of one per node of a
+ * skiplist lane.
+ *
+ * Every slot keeps the first 8 bytes of its word next to the item, as a big
+ * endian integer: the items themselves are only read when those tie. The
+ * index does not own the items, and it cannot change: it is built for the
+ * read-only phases of a list and dropped at the first write (see
+ * skiplist_freeze()).
+ */
+
+#ifndef FROZEN_H_DEFINED
+#define FROZEN_H_DEFINED
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "tads/item.h"
+#include "tads/tad_types.h"
+
+/**
+ * @brief An incomplete wrapper for the index. Use it as a ptr.
+ */
+typedef struct _frozen_s Frozen;
+
+/**
+ * @brief Lays items out in a new index. The items are only referenced.
+ *
+ * @param items the items, sorted by item_cmp() and without repeated words.
+ * @param n number of items.
+ * @return Frozen* ptr to the index, WITH OWNERSHIP, or NULL on error.
+ */
+Frozen *frozen_new(Item *const *items, size_t n);
+
+/**
+ * @brief Frees the index, but not the items.
+ *
+ * @param frozen a ptr to the index ptr. It will be set to NULL.
+ */
+void frozen_del(Frozen **frozen);
+
+/**
+ * @brief Searches the word of an item.
+ *
+ * @param frozen ptr to the index.
+ * @param item the key: only its word is read.
+ * @return Item* the item of the word, WITHOUT OWNERSHIP, or NULL.
+ */
+Item *frozen_get(const Frozen *frozen, const Item *item);
+
+/**
+ * @brief Calls fn, in order, for every item whose word starts with c.
+ *
+ * @param frozen ptr to the index.
+ * @param c the first character.
+ * @param fn the callback. Anything other than \c SUCCESS stops the walk.
+ * @param ctx passed to fn.
+ * @return status_t \c SUCCESS, \c NUL_ERR or the status that stopped it.
+ */
+status_t frozen_foreach_char(const Frozen *frozen, const char c,
+                             status_t (*fn)(Item *item, void *ctx),
+                             void *ctx);
+
+/**
+ * @brief A getter to the number of items.
+ */
+size_t frozen_length(const Frozen *frozen);
+
+/**
+ * @brief Heap bytes used by the index, its header included.
+ */
+size_t frozen_bytes(const Frozen *frozen);
+
+#endif // FROZEN_H_DEFINED
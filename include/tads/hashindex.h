@@ -0,0 +1,87 @@
+/**
+ * @file hashindex.h
+ * @brief Header file for an open addressing hash index of items by key.
+ *
+ * The index maps the word of an item to the item itself, WITHOUT OWNERSHIP:
+ * it is a side structure kept next to a container that owns the items (see
+ * skiplist_index_enable()). Slots hold the hash and the item ptr, are probed
+ * linearly, and removals shift the following slots back, so there are no
+ * tombstones. The table doubles when it is three quarters full.
+ */
+
+#ifndef HASHINDEX_H_DEFINED
+#define HASHINDEX_H_DEFINED
+
+#include <stdlib.h>
+
+#include "tads/item.h"
+#include "tads/tad_types.h"
+
+/**
+ * @brief An incomplete wrapper for the index. Use it as a ptr.
+ */
+typedef struct _hashindex_s HashIndex;
+
+/**
+ * @brief Creates an empty index.
+ *
+ * @param capacity number of items it should hold without growing.
+ * @return HashIndex* ptr to the index, WITH OWNERSHIP, or NULL on error.
+ */
+HashIndex *hashindex_new(size_t capacity);
+
+/**
+ * @brief Frees the index. The items are not touched.
+ *
+ * @param index a ptr to the index ptr. It will be set to NULL.
+ */
+void hashindex_del(HashIndex **index);
+
+/**
+ * @brief Makes room for a total of capacity items, so the next puts do not
+ * fail.
+ *
+ * @return status_t \c SUCCESS or \c ALLOC_ERR.
+ */
+status_t hashindex_reserve(HashIndex *index, size_t capacity);
+
+/**
+ * @brief Adds an item, or replaces the one with the same word.
+ *
+ * @param index ptr to the index.
+ * @param item ptr to the item, WITHOUT OWNERSHIP.
+ * @return status_t \c SUCCESS, \c NUL_ERR or \c ALLOC_ERR if the table could
+ * not grow.
+ */
+status_t hashindex_put(HashIndex *index, Item *item);
+
+/**
+ * @brief Finds the item with the same word as key.
+ *
+ * @return Item* the item, WITHOUT OWNERSHIP, or NULL if there is none.
+ */
+Item *hashindex_get(const HashIndex *index, const Item *key);
+
+/**
+ * @brief Removes the item with the same word as key from the index.
+ *
+ * @return Item* the item that was removed, WITHOUT OWNERSHIP, or NULL.
+ */
+Item *hashindex_take(HashIndex *index, const Item *key);
+
+/**
+ * @brief Removes every item, keeping the table.
+ */
+void hashindex_clear(HashIndex *index);
+
+/**
+ * @brief A getter to the number of items in the index.
+ */
+size_t hashindex_length(const HashIndex *index);
+
+/**
+ * @brief Heap bytes used by the index, its header included.
+ */
+size_t hashindex_bytes(const HashIndex *index);
+
+#endif // HASHINDEX_H_DEFINED
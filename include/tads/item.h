@@ -10,6 +10,8 @@
 #ifndef ITEM_H_DEFINED
 #define ITEM_H_DEFINED
 
+#include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -25,6 +27,15 @@
  */
 typedef struct _item_s Item;
 
+/**
+ * @brief Room for an item outside the heap (e.g. on the stack), see
+ * item_place(). It is as big as an item.
+ */
+typedef union {
+    char bytes[3 + MAX_WORD_SIZE + MAX_DESCRIPTION_SIZE];
+    max_align_t align;
+} item_buf_t;
+
 /**
  * @brief Creates a new item on the heap and returns a ptr to it.
  *
@@ -32,6 +43,14 @@ typedef struct _item_s Item;
  */
 Item *item_new(void);
 
+/**
+ * @brief Creates a heap allocated copy of an item.
+ *
+ * @param item ptr to the item that will be copied.
+ * @return Item* a ptr to the copy, WITH OWNERSHIP, or NULL on error.
+ */
+Item *item_clone(const Item *item);
+
 /**
  * @brief deletes
  *
@@ -39,6 +58,15 @@ Item *item_new(void);
  */
 void item_del(Item **item);
 
+/**
+ * @brief Hashes the key (the word) of an item, with 64-bit FNV-1a. Items that
+ * compare equal with item_raw_cmp() hash the same.
+ *
+ * @param item ptr to the item. It must not be NULL.
+ * @return uint64_t the hash.
+ */
+uint64_t item_hash(const Item *item);
+
 /**
  * @brief Compares two itens.
  *
@@ -78,6 +106,14 @@ int item_cmp(const Item *item_1, const Item *item_2);
  */
 void item_print(const Item *item);
 
+/**
+ * @brief Same as item_print(), but writes to the given stream.
+ *
+ * @param out the output stream.
+ * @param item ptr to an item.
+ */
+void item_fprint(FILE *out, const Item *item);
+
 /**
  * @brief prints the word atribute found in the item entry.
  *
@@ -103,6 +139,151 @@ void item_print_description(const Item *item);
  */
 Item *item_read(void);
 
+/**
+ * @brief Same as item_read(), but the item is read straight into buf instead
+ * of a new allocation, see item_place().
+ *
+ * @param buf the storage.
+ * @return Item* a ptr into buf, WITHOUT OWNERSHIP.
+ */
+Item *item_read_into(item_buf_t *buf);
+
+/**
+ * @brief Parses an item from a line held in memory, in the same `{W} {D}`
+ * format read by item_read(): the word, then the rest of the line without its
+ * leading spaces. Words and descriptions longer than the entry buffers are
+ * truncated.
+ *
+ * @param line ptr to the first character of the line.
+ * @param len number of characters of the line, without the '\n'.
+ * @return Item* a ptr to a new item, WITH OWNERSHIP, or NULL if the line has
+ * no word or on allocation error.
+ */
+Item *item_parse(const char *line, size_t len);
+
+/**
+ * @brief Same as item_parse(), but the item is built inside buf instead of
+ * being allocated, see item_place().
+ *
+ * @param buf the storage.
+ * @return Item* a ptr into buf, WITHOUT OWNERSHIP, or NULL if the line has no
+ * word (buf then holds an item with an empty word).
+ */
+Item *item_parse_into(item_buf_t *buf, const char *line, size_t len);
+
+/**
+ * @brief Tells whether a word and a description survive a `{W} {D}` line, as
+ * written by the listings and read back by item_parse(): the word is not
+ * empty and has no space or '\0', and the description has no '\n' or '\0'
+ * and does not start with a space.
+ *
+ * @param description may be NULL if the length is 0.
+ * @return _Bool 1 if they do.
+ */
+_Bool item_is_parsable(const char *word, size_t word_len,
+                       const char *description, size_t description_len);
+
+/**
+ * @brief Creates an item from a word and a description that are not '\0'
+ * terminated. Both are truncated to the entry buffers.
+ *
+ * @param word ptr to the word.
+ * @param word_len length of the word.
+ * @param description ptr to the description, may be NULL if the length is 0.
+ * @param description_len length of the description.
+ * @return Item* a ptr to a new item, WITH OWNERSHIP, or NULL on error.
+ */
+Item *item_new_from(const char *word, size_t word_len,
+                    const char *description, size_t description_len);
+
+/**
+ * @brief Same as item_new_from(), but the item is built inside buf instead of
+ * being allocated. Use it for lookup keys and update values, which are only
+ * read by the callee.
+ *
+ * @param buf the storage.
+ * @return Item* a ptr into buf, WITHOUT OWNERSHIP: never item_del() it nor
+ * hand it to a container that keeps it.
+ */
+Item *item_place(item_buf_t *buf, const char *word, size_t word_len,
+                 const char *description, size_t description_len);
+
+/**
+ * @brief Same as item_clone(), but the copy is built inside buf instead of
+ * being allocated, see item_place().
+ *
+ * @param buf the storage.
+ * @param item ptr to the item that will be copied.
+ * @return Item* a ptr into buf, WITHOUT OWNERSHIP, or NULL if item is NULL.
+ */
+Item *item_clone_into(item_buf_t *buf, const Item *item);
+
+/**
+ * @brief The item built inside buf by item_place() or the other \c _into
+ * functions, e.g. once buf was copied elsewhere with what holds it.
+ *
+ * @param buf the storage.
+ * @return Item* a ptr into buf, WITHOUT OWNERSHIP.
+ */
+Item *item_in(const item_buf_t *buf);
+
+/**
+ * @brief A getter to the word of an item.
+ *
+ * @param item ptr to the item.
+ * @return const char* the '\0' terminated word, borrowed.
+ */
+const char *item_word(const Item *item);
+
+/**
+ * @brief A getter to the description of an item.
+ *
+ * @param item ptr to the item.
+ * @return const char* the '\0' terminated description, borrowed. Cold items
+ * (see item_new_cold()) have an empty one.
+ */
+const char *item_description(const Item *item);
+
+/**
+ * @brief Creates a cold item: the word, and a reference to a description
+ * kept elsewhere (e.g. in a value log, see valuelog.h) instead of the
+ * description buffer. The item is cut right after the word, so it takes a
+ * fraction of the heap of a whole one.
+ *
+ * @param word the '\0' terminated word, truncated to the entry buffer.
+ * @param ref the reference, opaque to the item.
+ * @return Item* a ptr to a new item, WITH OWNERSHIP, or NULL on error.
+ *
+ * @note the entry buffers of a cold item end with the word: it can be
+ * cloned, compared and updated from another cold item, but never updated
+ * from a whole one (see item_raw_update()).
+ */
+Item *item_new_cold(const char *word, uint64_t ref);
+
+/**
+ * @brief Checks if an item is cold, see item_new_cold().
+ *
+ * @param item ptr to the item.
+ * @return _Bool \c 1 if it is cold, \c 0 otherwise (NULL included).
+ */
+_Bool item_is_cold(const Item *item);
+
+/**
+ * @brief A getter to the reference of a cold item.
+ *
+ * @param item ptr to a cold item.
+ * @return uint64_t the reference given to item_new_cold().
+ */
+uint64_t item_cold_ref(const Item *item);
+
+/**
+ * @brief Points a cold item to another copy of its description.
+ *
+ * @param item ptr to a cold item.
+ * @param ref the new reference.
+ */
+void item_set_cold_ref(Item *item, uint64_t ref);
+
 /**
  * @brief Reads a word from stdin and returns a pointer to a new item with the
  * word as its word atribute.
@@ -111,6 +292,16 @@ Item *item_read(void);
 */
 Item *item_read_word(void);
 
+/**
+ * @brief Same as item_read_word(), but the word is read straight into buf
+ * instead of a new allocation, see item_place().
+ *
+ * @param buf the storage.
+ * @return Item* a ptr into buf, WITHOUT OWNERSHIP, or NULL at the end of the
+ * input (buf then holds an item with an empty word).
+ */
+Item *item_read_word_into(item_buf_t *buf);
+
 /**
  * @brief Compares the first character of the word with the given char.
  * 
@@ -124,10 +315,111 @@ int item_raw_char_cmp (const Item* item, const char c);
 
 /**
  * @brief Updates the destiny item with the reference item.
+ *
+ * A cold reference (see item_new_cold()) makes the destiny cold, and a
+ * whole one makes it whole again. An item made by item_new_cold() has no
+ * room for a description: it only takes cold references with the same
+ * word, and is left as it is otherwise.
  * 
  * @param destiny ptr to the item that will be updated.
  * @param reference ptr to the item that will be used as reference.
 */
 void item_raw_update (Item* destiny, const Item* reference);
 
+/**
+ * @brief Marks an item as removed from its container, or clears the mark.
+ * Containers with lazy deletion (see skiplist_lazy_enable()) keep marked
+ * items, invisible, until they compact. New items are not marked, and
+ * item_raw_update() does not change the mark.
+ *
+ * @param item ptr to the item.
+ * @param tombstone \c 1 to mark it, \c 0 to clear the mark.
+ */
+void item_set_tombstone(Item *item, _Bool tombstone);
+
+/**
+ * @brief Checks the mark set by item_set_tombstone().
+ *
+ * @param item ptr to the item.
+ * @return _Bool \c 1 if it is marked, \c 0 otherwise (NULL included).
+ */
+_Bool item_is_tombstone(const Item *item);
+
+/**
+ * @brief Sets or clears the reference bit of an item. Containers that evict
+ * (see skiplist_config_t) set it on every lookup and clear it as their
+ * clock hand passes, so the items looked up since its last pass are spared.
+ * New items do not have it, and item_raw_update() does not change it.
+ *
+ * @param item ptr to the item.
+ * @param referenced \c 1 to set it, \c 0 to clear it.
+ */
+void item_set_referenced(Item *item, _Bool referenced);
+
+/**
+ * @brief Checks the bit set by item_set_referenced().
+ *
+ * @param item ptr to the item.
+ * @return _Bool \c 1 if it is set, \c 0 otherwise (NULL included).
+ */
+_Bool item_is_referenced(const Item *item);
+
+/**
+ * @brief Sets the tick at which an item expires, on the clock of its
+ * container (see skiplist_insert_ttl()). New items never expire, and
+ * item_raw_update() does not change the expiry.
+ *
+ * @param item ptr to the item.
+ * @param expires the tick, or \c 0 for never.
+ */
+void item_set_expiry(Item *item, uint32_t expires);
+
+/**
+ * @brief A getter to the tick set by item_set_expiry().
+ *
+ * @param item ptr to the item.
+ * @return uint32_t the tick, \c 0 if it never expires (NULL included).
+ */
+uint32_t item_expiry(const Item *item);
+
+/**
+ * @brief Records where a timer wheel keeps an item (see timerwheel.h), so
+ * it can be cancelled without a search. Only the wheel should set it.
+ *
+ * @param item ptr to the item.
+ * @param timer the position of the item in its slot.
+ */
+void item_set_timer(Item *item, uint32_t timer);
+
+/**
+ * @brief A getter to the position set by item_set_timer().
+ */
+uint32_t item_timer(const Item *item);
+
+/**
+ * @brief Returns the size, in bytes, of an item as it is stored on the heap.
+ *
+ * @return size_t sizeof the item structure.
+ */
+size_t item_size(void);
+
+/**
+ * @brief Returns the size, in bytes, of a given item on the heap: item_size()
+ * for whole items, less for cold ones (see item_new_cold()).
+ *
+ * @param item ptr to the item.
+ * @return size_t the bytes allocated for it.
+ */
+size_t item_bytes(const Item *item);
+
+/**
+ * @brief Counts the bytes of the fixed entry buffers that an item does not use,
+ * that is, everything after the terminating '\0' of the word and of the
+ * description.
+ *
+ * @param item ptr to the item.
+ * @return size_t the number of unused bytes.
+ */
+size_t item_padding(const Item *item);
+
 #endif // ITEM_H_DEFINED
\ No newline at end of file
@@ -0,0 +1,318 @@
+/**
+ * @file shardlist.h
+ * @brief this header declares a key-range sharded container built on top of
+ * `SkipList`, and the functions that can be used with it.
+ *
+ * The key space is split in N contiguous ranges, one skiplist per range. Shard
+ * boundaries are taken from the quantiles of the stored keys and are
+ * recomputed when the shards become unbalanced. Batches of operations are
+ * partitioned by shard and every shard is processed by one task of a thread
+ * pool, so there is never more than one thread touching a given skiplist.
+ *
+ * @version 1.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#ifndef SHARDLIST_H_DEFINED
+#define SHARDLIST_H_DEFINED
+
+//=============================================================================/
+//=================|    Dependencies    |======================================/
+//=============================================================================/
+
+#include "tads/item.h"
+#include "tads/skiplist.h"
+#include "tads/tad_types.h"
+#include "utils/threadpool.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+//=============================================================================/
+//=================|    Constants   |==========================================/
+//=============================================================================/
+
+// Shards are only rebalanced once the container holds at least this many
+// items...
+#define SHARDLIST_REBALANCE_MIN (1024)
+
+// ...and the biggest shard is this many times bigger than the average one.
+#define SHARDLIST_IMBALANCE (2)
+
+//=============================================================================/
+//=================|    Types     |============================================/
+//=============================================================================/
+
+/**
+ * @brief An incomplete wrapper for the sharded list. Use it as a ptr.
+ */
+typedef struct _shardlist_s ShardList;
+
+/**
+ * @brief The kinds of operation that can be batched.
+ */
+typedef enum {
+    SHARD_INSERT,
+    SHARD_UPDATE,
+    SHARD_REMOVE,
+    SHARD_SEARCH,
+} shard_op_kind_t;
+
+/**
+ * @brief One operation of a batch. Operations on the same key are applied in
+ * the order they appear in the batch.
+ *
+ * @note as in the skiplist functions, a successful insert takes ownership of
+ * \c item, and a successful remove gives ownership of \c result to the caller.
+ * A search sets \c result WITHOUT OWNERSHIP.
+ */
+typedef struct {
+    shard_op_kind_t kind;
+    Item *item;      // input
+    Item *result;    // output of removes and searches
+    status_t status; // output
+} shard_op_t;
+
+//=============================================================================/
+//=================|    Functions     |========================================/
+//=============================================================================/
+
+/**
+ * @brief Creates a new empty sharded list.
+ *
+ * @param shards number of shards. Zero is promoted to one.
+ * @param threads size of the thread pool used by batches. With zero, batches
+ * run on the calling thread.
+ * @param config the configuration of every shard, see
+ * skiplist_new_with_config(). NULL selects the default one. Its \c
+ * max_length and \c max_bytes bound the whole list, not each shard: an
+ * insertion into a full list evicts from the shard of its word, or from the
+ * biggest one if that is not enough.
+ * @return ShardList* ptr to the list, WITH OWNERSHIP, or NULL in case of error.
+ */
+ShardList *shardlist_new(size_t shards, size_t threads,
+                         const skiplist_config_t *config);
+
+/**
+ * @brief Deletes the list, all its shards and all their items.
+ *
+ * @param shardlist a ptr to the list ptr. It will be set to NULL.
+ */
+void shardlist_del(ShardList **shardlist);
+
+/**
+ * @brief A getter to the configuration: the one of the shards, with the
+ * limits of the whole list (see shardlist_new()).
+ */
+skiplist_config_t shardlist_config(const ShardList *shardlist);
+
+/**
+ * @brief Tells fn of the items every shard drops, see skiplist_on_drop().
+ * From then on, batches run on the calling thread: fn is never called from
+ * two threads at once.
+ *
+ * @param shardlist ptr to the list.
+ * @param fn the callback, NULL for none.
+ * @param ctx handed to fn.
+ */
+void shardlist_on_drop(ShardList *shardlist,
+                       void (*fn)(void *ctx, const Item *item), void *ctx);
+
+/**
+ * @brief Inserts an item, see skiplist_insert().
+ */
+status_t shardlist_insert(ShardList *shardlist, Item *item);
+
+/**
+ * @brief Gives an item the expiry an insertion would give it now, see
+ * skiplist_stamp().
+ */
+void shardlist_stamp(const ShardList *shardlist, Item *item);
+
+/**
+ * @brief Checks if an item expired on the clock of the list, see
+ * skiplist_expired().
+ */
+_Bool shardlist_expired(const ShardList *shardlist, const Item *item);
+
+/**
+ * @brief Updates an item, see skiplist_update().
+ */
+status_t shardlist_update(ShardList *shardlist, Item *item);
+
+/**
+ * @brief Removes an item, see skiplist_remove().
+ */
+Item *shardlist_remove(ShardList *shardlist, Item *item);
+
+/**
+ * @brief Removes and frees an item, see skiplist_delete().
+ */
+status_t shardlist_delete(ShardList *shardlist, Item *item);
+
+/**
+ * @brief Searches an item, see skiplist_lookup().
+ */
+Item *shardlist_search(ShardList *shardlist, const Item *item);
+
+/**
+ * @brief Prints, in order, every item that starts with c, see
+ * skiplist_print().
+ */
+status_t shardlist_print(const ShardList *shardlist, const char c);
+
+/**
+ * @brief Same as shardlist_print(), but writes to the given stream.
+ */
+status_t shardlist_fprint(FILE *out, const ShardList *shardlist, const char c);
+
+/**
+ * @brief Calls fn for every item, in order, concatenating the shards. See
+ * skiplist_foreach().
+ */
+status_t shardlist_foreach(const ShardList *shardlist,
+                           status_t (*fn)(Item *item, void *ctx), void *ctx);
+
+/**
+ * @brief Calls fn for every item that starts with c, in order. See
+ * skiplist_foreach_char().
+ */
+status_t shardlist_foreach_char(const ShardList *shardlist, const char c,
+                                status_t (*fn)(Item *item, void *ctx),
+                                void *ctx);
+
+/**
+ * @brief Applies a batch of operations, in parallel across shards. A
+ * bounded list (see shardlist_new()) runs them one at a time instead, as
+ * every insertion needs the room the ones before it left.
+ *
+ * @param shardlist ptr to the list.
+ * @param ops the operations. Their \c result and \c status are filled.
+ * @param n number of operations.
+ * @return status_t \c SUCCESS if the batch ran (check each op status), \c
+ * NUL_ERR or \c ALLOC_ERR otherwise, in which case nothing was applied.
+ */
+status_t shardlist_apply(ShardList *shardlist, shard_op_t *ops, size_t n);
+
+/**
+ * @brief Applies a batch of insertions, updates and removals, all or
+ * nothing, see skiplist_commit(). Every shard checks its ops before the
+ * first one commits its own. In a bounded list, each shard is limited to a
+ * share of the room left, in proportion to its insertions.
+ *
+ * @param shardlist ptr to the list.
+ * @param ops the operations. Their \c result and \c status are filled.
+ * @param n number of operations.
+ * @return status_t see skiplist_commit(). A shard that fails after another
+ * one committed (out of memory, an item expired in between, or towers that
+ * took more than its share of the bytes) makes it
+ * \c CRITICAL_ERR: the shards before it keep their part of the batch, and
+ * the ops of the others carry the error.
+ */
+status_t shardlist_commit(ShardList *shardlist, skiplist_op_t *ops, size_t n);
+
+/**
+ * @brief Recomputes the shard boundaries from the quantiles of the stored
+ * keys and moves the items to their new shards. Items are not reallocated.
+ *
+ * The new shards are built next to the current ones, which are only emptied
+ * once every new shard is ready: for a while, the nodes take twice the room.
+ *
+ * @param shardlist ptr to the list.
+ * @return status_t \c SUCCESS, \c NUL_ERR or \c ALLOC_ERR, in which case
+ * the list is left as it was, every item in its shard.
+ */
+status_t shardlist_rebalance(ShardList *shardlist);
+
+/**
+ * @brief Fills an empty sharded list with items that are already sorted and
+ * unique: the boundaries are set from their quantiles and every shard is
+ * built bottom-up (see skiplist_from_sorted()) in parallel.
+ *
+ * @param shardlist ptr to an empty list.
+ * @param items the items, sorted by item_raw_cmp and without repeated words.
+ * @param n number of items.
+ * @return status_t \c SUCCESS, \c NUL_ERR, \c ARR_IS_FULL_ERR if the list is not
+ * empty, or \c ALLOC_ERR.
+ *
+ * @note on success the list owns the items. After an \c ALLOC_ERR, the list
+ * is still empty and the items were freed.
+ */
+status_t shardlist_load_sorted(ShardList *shardlist, Item **items, size_t n);
+
+/**
+ * @brief Adds a hash index to every shard, see skiplist_index_enable(). The
+ * shards rebuilt by a rebalance keep it.
+ *
+ * @param shardlist ptr to the list.
+ * @return status_t \c SUCCESS, \c NUL_ERR or \c ALLOC_ERR, in which case
+ * only some shards are indexed.
+ */
+status_t shardlist_index_enable(ShardList *shardlist);
+
+/**
+ * @brief Adds a Bloom filter to every shard, see skiplist_bloom_enable(). The
+ * shards rebuilt by a rebalance keep it.
+ *
+ * @param shardlist ptr to the list.
+ * @param fp_rate the false positive rate of every filter.
+ * @return status_t \c SUCCESS, \c NUL_ERR or \c ALLOC_ERR, in which case
+ * only some shards are filtered.
+ */
+status_t shardlist_bloom_enable(ShardList *shardlist, double fp_rate);
+
+/**
+ * @brief Turns on the adaptive mode of every shard, see
+ * skiplist_adaptive_enable(). The shards rebuilt by a rebalance keep it.
+ *
+ * @param shardlist ptr to the list.
+ * @return status_t \c SUCCESS, \c NUL_ERR or \c ALLOC_ERR, in which case
+ * only some shards are adaptive.
+ */
+status_t shardlist_adaptive_enable(ShardList *shardlist);
+
+/**
+ * @brief Turns on lazy deletion in every shard, see skiplist_lazy_enable().
+ * The shards rebuilt by a rebalance keep it.
+ *
+ * @param shardlist ptr to the list.
+ * @param ratio the tombstone share that starts the compaction of a shard.
+ * @return status_t \c SUCCESS, \c NUL_ERR or \c ALLOC_ERR, in which case
+ * only some shards are lazy.
+ */
+status_t shardlist_lazy_enable(ShardList *shardlist, double ratio);
+
+/**
+ * @brief Freezes every shard, see skiplist_freeze(). Each shard thaws on its
+ * own first write.
+ *
+ * @param shardlist ptr to the list.
+ * @return status_t \c SUCCESS, \c NUL_ERR or \c ALLOC_ERR, in which case
+ * only some shards are frozen.
+ */
+status_t shardlist_freeze(ShardList *shardlist);
+
+/**
+ * @brief A getter to the total number of items.
+ */
+size_t shardlist_length(const ShardList *shardlist);
+
+/**
+ * @brief A getter to the number of shards.
+ */
+size_t shardlist_shards(const ShardList *shardlist);
+
+/**
+ * @brief Prints the memory summary of every shard, see
+ * skiplist_memory_print().
+ */
+void shardlist_memory_print(const ShardList *shardlist);
+
+/**
+ * @brief Same as shardlist_memory_print(), but writes to the given stream.
+ */
+void shardlist_memory_fprint(FILE *out, const ShardList *shardlist);
+
+#endif // SHARDLIST_H_DEFINED
@@ -16,9 +16,16 @@
 //=================|    Dependencies    |======================================/
 //=============================================================================/
 
+#include "tads/bloom.h"
+#include "tads/freqsketch.h"
+#include "tads/frozen.h"
+#include "tads/hashindex.h"
 #include "tads/item.h"
 #include "tads/tad_types.h"
+#include "tads/timerwheel.h"
 #include "utils/mathutils.h"
+#include "utils/memutils.h"
+#include "utils/threadpool.h"
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -27,13 +34,22 @@
 //=============================================================================/
 
 // Defines the probability p that is used to model the distribution of the level
-// of a new node being inserted on the skiplist.
+// of a new node being inserted on the skiplist. Like RAISE_ONLY_ONCE and the
+// limits below, it is only the default of skiplist_config_default().
 #define SKIPLIST_PROB (0.5)
 
 // If this is set to 1, then the skiplist will be limited to never increase its
 // total height (the max level) by more than one at each insersion.
 #define RAISE_ONLY_ONCE (0)
 
+// Lookups in a row a list with \c freeze serves before it is frozen again,
+// whatever its length (see skiplist_new_with_config()).
+#define SKIPLIST_FREEZE_READS (1024)
+
+// Tombstone share of the columns that starts a compaction in the lazy mode,
+// when the one given to skiplist_lazy_enable() is out of range.
+#define LAZY_RATIO (0.25)
+
 // You can choose to define SKIPLIST_MAX_HEIGHT and/or SKIPLIST_MAX_LENGTH. If
 // defined, they will act as a hardlimit. If not defined, lenght will be limited
 // by memory and height by one billion (since we cannot use limits.h). 
@@ -53,6 +69,73 @@
  */
 typedef struct _skiplist_s SkipList;
 
+/**
+ * @brief A read-only view of a skiplist as it was when it was taken, see
+ * skiplist_snapshot(). Use it as a ptr.
+ */
+typedef struct _snapshot_s Snapshot;
+
+/**
+ * @brief How a skiplist picks the heights of its towers.
+ *
+ * \c SKIPLIST_RANDOMIZED flips coins (see SKIPLIST_PROB): O(log n) expected,
+ * but a bad run of flips can leave a long stretch of short towers.
+ * \c SKIPLIST_DETERMINISTIC keeps the 1-2-3 invariant instead: between two
+ * consecutive nodes of a lane there are 1 to 3 nodes on the lane below, and
+ * the top lane holds at most 3 nodes besides the head. A search then makes
+ * at most 4 comparisons per lane on at most log2(n) + 1 lanes, whatever the
+ * order of the insertions and removals.
+ */
+typedef enum {
+    SKIPLIST_RANDOMIZED,
+    SKIPLIST_DETERMINISTIC,
+} skiplist_mode_t;
+
+/**
+ * @brief The parameters of a skiplist, see skiplist_new_with_config().
+ *
+ * Every list has its own; skiplist_config_default() gives the ones set by the
+ * constants above. A zero limit means no limit.
+ */
+typedef struct {
+    skiplist_mode_t mode;
+    double prob;       // p of the tower heights, in (0, 1)
+    size_t max_height; // hard limit of the height, or 0
+    size_t max_length; // hard limit of the length, or 0
+    size_t max_bytes;  // limit of the heap bytes, or 0
+    _Bool raise_once;  // raise the list by at most one lane per insertion
+    _Bool auto_tune;   // pick prob and max_height from the workload
+    _Bool rebalance;   // rebalance in steps as the shape drifts
+    _Bool evict;       // make room past the limits instead of refusing
+    _Bool freeze;      // freeze the list again after a run of lookups
+    uint32_t ttl;      // ticks new items live, or 0 for ever
+    uint32_t (*clock)(void); // the ticks of the expiries, or NULL: seconds
+    void (*drop)(void *ctx, const Item *item); // see skiplist_on_drop()
+    void *drop_ctx;
+} skiplist_config_t;
+
+/**
+ * @brief A breakdown of the heap memory used by a skiplist.
+ *
+ * Byte counts are the sizes requested from malloc; the allocator headers and
+ * rounding are reported apart in \c overhead_bytes. \c level_nodes is heap
+ * allocated, release it with skiplist_memory_usage_del().
+ */
+typedef struct {
+    size_t levels;         // number of lanes (the height of the list)
+    size_t *level_nodes;   // nodes per lane, index 0 is the main lane
+    size_t node_bytes;     // bytes used by all the nodes
+    size_t item_bytes;     // bytes used by all the items
+    size_t overhead_bytes; // estimated allocator headers and rounding
+    size_t padding_bytes;  // unused bytes inside the fixed entry buffers
+    size_t index_bytes;    // the hash index, if enabled
+    size_t bloom_bytes;    // the Bloom filter, if enabled
+    size_t sketch_bytes;   // the access counts of the adaptive mode
+    size_t timer_bytes;    // the timer wheel of the expiring items
+    size_t frozen_bytes;   // the frozen index, while there is one
+    size_t total_bytes;    // everything above plus the list header
+} skiplist_mem_t;
+
 //=============================================================================/
 //=================|    Functions     |========================================/
 //=============================================================================/
@@ -65,13 +148,151 @@ typedef struct _skiplist_s SkipList;
  */
 SkipList *skiplist_new(void);
 
+/**
+ * @brief Creates a new heap-allocated empty skiplist with the given mode.
+ *
+ * In the deterministic mode insertions split every gap of 3 nodes met on the
+ * way down by raising its middle node, and removals widen every gap of 1 node
+ * they are about to enter by borrowing a node from, or merging with, a
+ * neighbour gap. Both stay O(log n) in the worst case; no coin is flipped.
+ *
+ * @param mode see skiplist_mode_t.
+ * @return SkipList* ptr to the skip list, WITH OWNERSHIP, or NULL in case of
+ * error.
+ */
+SkipList *skiplist_new_with_mode(skiplist_mode_t mode);
+
+/**
+ * @brief The configuration set by the constants of this header: the
+ * randomized mode, SKIPLIST_PROB, RAISE_ONLY_ONCE and, if they are defined,
+ * SKIPLIST_MAX_HEIGHT and SKIPLIST_MAX_LENGTH. No auto-tuning.
+ *
+ * @return skiplist_config_t the default configuration.
+ */
+skiplist_config_t skiplist_config_default(void);
+
+/**
+ * @brief Creates a new heap-allocated empty skiplist with its own parameters.
+ *
+ * With \c auto_tune, the list counts its lookups and its insertions and
+ * removals, and every time it has seen about as many of them as it holds
+ * items, it picks p and the max height again: 1/e, which makes the fewest
+ * comparisons, when at least 4 in 5 are lookups, and 1/4, which makes as few
+ * as 1/2 with a third fewer nodes to allocate, when at least 2 in 5 are
+ * writes (in between, p stays). The max height is log_1/p of twice the
+ * length, plus one. If the shape changes, the towers are moved to it by a
+ * skiplist_rebalance() run in steps after the next operations.
+ *
+ * With \c rebalance, once the insertions and removals since the last
+ * rebalance reach half the length, the list starts another one, run the
+ * same way. Either costs O(1) amortized and a bounded step per operation.
+ *
+ * With \c ttl, new items expire that many ticks of \c clock after their
+ * insertion (see skiplist_insert_ttl()). With \c evict, an insertion into a
+ * list at \c max_length items, or at \c max_bytes, makes room for itself
+ * by freeing an item picked by a CLOCK hand instead of failing with
+ * \c ARR_IS_FULL_ERR: the hand walks the main lane from where it stopped
+ * last time, takes the first item that expired or was not looked up since
+ * its last pass, and clears the reference bit (see item_set_referenced()) of
+ * the ones it spares. A bounded list then keeps a flat memory use under any
+ * flow of insertions. The bytes are counted as they are (see
+ * skiplist_bytes()), so an insertion whose tower takes the list past
+ * \c max_bytes evicts again, or is undone and refused.
+ *
+ * With \c freeze, a list that has served as many lookups in a row as it
+ * holds items, and at least \c SKIPLIST_FREEZE_READS, builds a frozen index
+ * again (see skiplist_freeze()), so a read-only phase gets one back after
+ * the writes that dropped it. The build costs about as much as those lookups.
+ *
+ * @param config the parameters; a p out of (0, 1) selects SKIPLIST_PROB.
+ * NULL selects skiplist_config_default().
+ * @return SkipList* ptr to the skip list, WITH OWNERSHIP, or NULL in case of
+ * error.
+ */
+SkipList *skiplist_new_with_config(const skiplist_config_t *config);
+
+/**
+ * @brief A getter to the parameters of the skiplist, as tuned so far.
+ *
+ * @param skiplist ptr to the skiplist.
+ * @return skiplist_config_t a copy of the parameters.
+ */
+skiplist_config_t skiplist_config(const SkipList *skiplist);
+
+/**
+ * @brief Changes the \c max_length and \c max_bytes of a skiplist. A list
+ * already past them is brought back under them by its next insertion,
+ * which evicts or fails as usual.
+ *
+ * @param skiplist ptr to the skiplist.
+ * @param max_length the new limit of the length, or 0 for none.
+ * @param max_bytes the new limit of the heap bytes, or 0 for none.
+ */
+void skiplist_limit(SkipList *skiplist, size_t max_length, size_t max_bytes);
+
+/**
+ * @brief Tells fn of every item that leaves the skiplist on its own: one
+ * evicted, or one that expired, once it is freed (unlinked by the timer
+ * wheel, replaced by an insertion of its word, or left behind by a batch or
+ * a shallow clear). fn gets the item right before it is freed. It is part of
+ * the configuration, so the lists that take it (see skiplist_split() and
+ * skiplist_inherit_options()) tell fn too.
+ *
+ * @param skiplist ptr to the skiplist.
+ * @param fn the callback, NULL for none.
+ * @param ctx handed to fn.
+ */
+void skiplist_on_drop(SkipList *skiplist,
+                      void (*fn)(void *ctx, const Item *item), void *ctx);
+
+/**
+ * @brief Rebuilds the fast lanes of a randomized list with a new p and max
+ * height, drawing every tower again; the main lane, and so every item, stays
+ * in place, as do the index, filter and tombstones. Deterministic lists only
+ * record the parameters: their lanes do not depend on them.
+ *
+ * @param skiplist ptr to the skiplist.
+ * @param prob the new p, in (0, 1); other values select SKIPLIST_PROB.
+ * @param max_height the new max height, or 0 for none.
+ * @return status_t \c SUCCESS, \c NUL_ERR or \c ALLOC_ERR, in which case
+ * the lanes built so far are kept, and they are valid.
+ *
+ * @note in the adaptive mode the towers are drawn from the word hashes, as
+ * skiplist_adaptive_enable() lowers them to.
+ */
+status_t skiplist_reshape(SkipList *skiplist, double prob, size_t max_height);
+
+/**
+ * @brief Runs a step of a rebalance: moves the towers of the next columns of
+ * the main lane to the heights of an ideal list, where every 1/p-th node of
+ * a lane (rounded) rises to the next one, and the list is as tall as its
+ * length asks for. No item is moved or reallocated.
+ *
+ * A rebalance is a single O(n) pass that can be split in steps of bounded
+ * time: each step resumes after the last column the previous one visited,
+ * and the list stays valid and searchable between them, so they can be
+ * interleaved with any other operation. Columns inserted behind the step get
+ * coin-flipped heights as usual.
+ *
+ * @param skiplist ptr to the skiplist.
+ * @param budget how many main lane nodes this step visits, or 0 for the rest
+ * of the pass.
+ * @return _Bool \c 1 if the pass is over, \c 0 if it needs more steps.
+ *
+ * @note in the adaptive mode the towers are moved to the heights drawn from
+ * the word hashes instead. Deterministic lists are balanced already: for them
+ * this does nothing.
+ */
+_Bool skiplist_rebalance(SkipList *skiplist, size_t budget);
+
 /**
  * @brief An opinionated function to delete a skiplist (it cleans the memory
  * used by it).
  *
  * @param skiplist a ptr to the skiplist.
  *
- * @note this will set your ptr to NULL to avoid dangling ptrs.
+ * @note this will set your ptr to NULL to avoid dangling ptrs. Its open
+ * snapshots stay valid, but empty: release them as usual.
  */
 void skiplist_del(SkipList **skiplist);
 
@@ -89,6 +310,43 @@ void skiplist_del(SkipList **skiplist);
  */
 status_t skiplist_insert(SkipList *skiplist, Item *item);
 
+/**
+ * @brief Inserts an item that expires ttl ticks from now, whatever the
+ * \c ttl of the list (see skiplist_config_t).
+ *
+ * Expired items are invisible at once, like tombstones, and inserting their
+ * word again replaces them. They are scheduled on a timer wheel (see
+ * timerwheel.h), so nothing scans the list for them: every operation reads
+ * the clock and unlinks and frees the few items that expired first, at most
+ * a bounded number of them. Until then they still count in
+ * skiplist_length() and in the limits.
+ *
+ * @param skiplist a ptr to the skip list.
+ * @param item a ptr to the item.
+ * @param ttl how many ticks the item lives, or 0 for ever.
+ * @return status_t see skiplist_insert().
+ *
+ * @note the expiry moves with the item: a list rebuilt with
+ * skiplist_inherit_options() schedules it again.
+ */
+status_t skiplist_insert_ttl(SkipList *skiplist, Item *item, uint32_t ttl);
+
+/**
+ * @brief Gives an item the expiry an insertion would give it now (see
+ * skiplist_insert()), e.g. one held elsewhere before it is inserted, whose
+ * time to live starts at once.
+ *
+ * @param skiplist a ptr to the skip list.
+ * @param item a ptr to the item. One that carries an expiry keeps it.
+ */
+void skiplist_stamp(const SkipList *skiplist, Item *item);
+
+/**
+ * @brief Checks if an item expired on the clock of the list, whether it is
+ * in the list or not, see skiplist_stamp().
+ */
+_Bool skiplist_expired(const SkipList *skiplist, const Item *item);
+
 /**
  * @brief Removes an item from the skiplist.
  *
@@ -106,6 +364,18 @@ status_t skiplist_insert(SkipList *skiplist, Item *item);
  */
 Item *skiplist_remove(SkipList *skiplist, Item *item);
 
+/**
+ * @brief Removes an item from the skiplist and frees it.
+ *
+ * Unlike skiplist_remove(), nothing is handed back, so in the lazy mode (see
+ * skiplist_lazy_enable()) this costs about as much as a lookup.
+ *
+ * @param skiplist A pointer to a skiplist.
+ * @param item A pointer to an item with the word to remove.
+ * @return status_t \c SUCCESS, \c NOT_FOUND_ERR or \c NUL_ERR.
+ */
+status_t skiplist_delete(SkipList *skiplist, Item *item);
+
 /**
  * @brief Searched for an item in the skiplist.
  *
@@ -126,6 +396,17 @@ Item *skiplist_search(const SkipList *skiplist, const Item *item);
  */
 status_t skiplist_print(const SkipList *skiplist, const char c);
 
+/**
+ * @brief Same as skiplist_print(), but writes to the given stream.
+ *
+ * @param out the output stream.
+ * @param skiplist ptr to the skiplist.
+ * @param c the character we are interested on.
+ * @return status_t \c SUCCESS for a successiful print, \c ERROR if any errors
+ * occurr.
+ */
+status_t skiplist_fprint(FILE *out, const SkipList *skiplist, const char c);
+
 /**
  * @brief prints all the levels of the skiplist and some debug info. Use it to
  * aid debugging.
@@ -140,10 +421,24 @@ void skiplist_debug_print(const SkipList *skiplist);
  * @param skiplist ptr to the list.
  * @return _Bool \c 1 if max length was reached, \c 0 otherwise.
  *
- * @note if SKIPLIST_MAX_LENGTH is not defined, this will always return flase.
+ * @note if the list has no max length nor max bytes (see skiplist_config_t),
+ * this will always return false. It is full at \c max_bytes when one more
+ * column of the expected height, item included, would go past them.
  */
 _Bool skiplist_is_full(const SkipList *skiplist);
 
+/**
+ * @brief Frees something to make room, as a list with \c evict does when it
+ * is full (see skiplist_new_with_config()): every tombstone if there are
+ * any, otherwise the item the CLOCK hand stops at.
+ *
+ * @param skiplist ptr to the skiplist.
+ * @param spare ptr to an item of the list the hand steps over, or NULL.
+ * @return status_t \c SUCCESS, \c NUL_ERR, \c NOT_FOUND_ERR if nothing
+ * else is left to free or \c ALLOC_ERR.
+ */
+status_t skiplist_evict(SkipList *skiplist, const Item *spare);
+
 /**
  * @brief Checks if the list is empty
  *
@@ -160,6 +455,14 @@ _Bool skiplist_is_empty(const SkipList *skiplist);
  */
 size_t skiplist_length(const SkipList *skiplist);
 
+/**
+ * @brief A getter to the mode the skiplist was created with.
+ *
+ * @param skiplist a ptr to the skiplist.
+ * @return skiplist_mode_t the mode, \c SKIPLIST_RANDOMIZED for NULL.
+ */
+skiplist_mode_t skiplist_mode(const SkipList *skiplist);
+
 /**
  * @brief A getter to the skiplist height.
  *
@@ -188,11 +491,71 @@ size_t skiplist_height(const SkipList *skiplist);
  */
 status_t skiplist_update(SkipList *skiplist, Item *item);
 
+/**
+ * @brief The kinds of operation of a batch, see skiplist_commit().
+ */
+typedef enum {
+    SKIPLIST_INSERT,
+    SKIPLIST_UPDATE,
+    SKIPLIST_REMOVE,
+} skiplist_op_kind_t;
+
+/**
+ * @brief One operation of a batch. Operations on the same word run in the
+ * order they appear in the batch, each on what the ones before it left.
+ *
+ * @note as in the single operations, a committed insert takes ownership of
+ * \c item, and a committed remove gives ownership of \c result to the
+ * caller: it may be the item of an insert of the same batch.
+ */
+typedef struct {
+    skiplist_op_kind_t kind;
+    Item *item;      // input: the new item, or the word and its new value
+    Item *result;    // output of removes
+    status_t status; // output
+} skiplist_op_t;
+
+/**
+ * @brief Applies a batch of insertions, updates and removals, all or nothing.
+ *
+ * The ops are sorted by word and checked in one left-to-right sweep of a
+ * single trace, which climbs only as far as the next word needs, so k
+ * words cost about one walk of the list instead of k searches. Nothing is
+ * changed until every op passes. Then each word gets the net effect of its
+ * ops in a second sweep, a change undone if a later one fails for memory.
+ *
+ * Batches do not evict, even in a list with \c evict: a batch whose new
+ * words do not fit is refused.
+ *
+ * @param skiplist ptr to the skiplist.
+ * @param ops the batch. Every \c status is filled, and \c result too once
+ * the batch is committed.
+ * @param n number of ops.
+ * @return status_t \c SUCCESS if every op was applied. Otherwise nothing was:
+ * \c NUL_ERR, \c ARR_IS_FULL_ERR, \c ALLOC_ERR, or the status of the first op
+ * that fails (\c REPEATED_ENTRY_ERR or \c NOT_FOUND_ERR), by word. Only \c
+ * CRITICAL_ERR, when memory ran out while undoing, leaves part of the batch.
+ */
+status_t skiplist_commit(SkipList *skiplist, skiplist_op_t *ops, size_t n);
+
+/**
+ * @brief Checks a batch as skiplist_commit() does, without applying it.
+ *
+ * @param skiplist ptr to the skiplist.
+ * @param ops the batch. Every \c status is filled.
+ * @param n number of ops.
+ * @return status_t \c SUCCESS if skiplist_commit() would apply it, barring
+ * memory and the items that expire in between, or why it would not.
+ */
+status_t skiplist_commit_check(const SkipList *skiplist, skiplist_op_t *ops,
+                               size_t n);
+
 /**
  * @brief Checks if the current configurantion of a skiplist is valid and has no
  * errors.
  *
- * Use this to debug the skiplist
+ * Use this to debug the skiplist. Deterministic lists are also checked for
+ * the 1-2-3 invariant (see skiplist_mode_t).
  *
  * @param skiplist a ptr to the skiplist.
  * @return _Bool \c 1 if the skiplist if valid, \c 0 if the skiplist has one or
@@ -200,4 +563,490 @@ status_t skiplist_update(SkipList *skiplist, Item *item);
  */
 _Bool skiplist_debug_validate(const SkipList *skiplist);
 
+/**
+ * @brief Measures the memory used by a skiplist, lane by lane.
+ *
+ * @param skiplist a ptr to the skiplist.
+ * @param usage output parameter, filled on success.
+ * @return status_t \c SUCCESS, \c NUL_ERR if any ptr is NULL or \c ALLOC_ERR
+ * if the per lane counters could not be allocated.
+ *
+ * @note it walks every node once, so it is O(n).
+ */
+status_t skiplist_memory_usage(const SkipList *skiplist, skiplist_mem_t *usage);
+
+/**
+ * @brief Releases the heap memory held by a skiplist_mem_t.
+ *
+ * @param usage a ptr to the usage report.
+ */
+void skiplist_memory_usage_del(skiplist_mem_t *usage);
+
+/**
+ * @brief The heap bytes of a skiplist without a walk: the \c total_bytes of
+ * skiplist_memory_usage(), but with every item counted as a whole one (see
+ * item_bytes()). It is what \c max_bytes limits.
+ *
+ * @param skiplist a ptr to the skiplist.
+ * @return size_t the bytes, or 0 if skiplist is NULL.
+ */
+size_t skiplist_bytes(const SkipList *skiplist);
+
+/**
+ * @brief Prints a summary of the memory used by the skiplist. Unlike
+ * skiplist_debug_print(), the output size does not depend on the length.
+ *
+ * @param skiplist ptr to the skiplist.
+ */
+void skiplist_memory_print(const SkipList *skiplist);
+
+/**
+ * @brief Same as skiplist_memory_print(), but writes to the given stream.
+ *
+ * @param out the output stream.
+ * @param skiplist ptr to the skiplist.
+ */
+void skiplist_memory_fprint(FILE *out, const SkipList *skiplist);
+
+/**
+ * @brief Calls fn for every item of the skiplist, in order.
+ *
+ * @param skiplist ptr to the skiplist.
+ * @param fn the visitor. It receives the items WITHOUT OWNERSHIP and must not
+ * change their keys. Returning anything other than \c SUCCESS stops the walk.
+ * @param ctx opaque ptr forwarded to fn.
+ * @return status_t \c SUCCESS if every item was visited, \c NUL_ERR for NULL
+ * ptrs, or the status that stopped the walk.
+ */
+status_t skiplist_foreach(const SkipList *skiplist,
+                          status_t (*fn)(Item *item, void *ctx), void *ctx);
+
+/**
+ * @brief Calls fn, in order, for every item whose word starts with c. It uses
+ * the fast lanes to reach the first one, so it costs O(log n + k).
+ *
+ * @param skiplist ptr to the skiplist.
+ * @param c the character we are interested on.
+ * @param fn the visitor, see skiplist_foreach().
+ * @param ctx opaque ptr forwarded to fn.
+ * @return status_t see skiplist_foreach().
+ */
+status_t skiplist_foreach_char(const SkipList *skiplist, const char c,
+                               status_t (*fn)(Item *item, void *ctx),
+                               void *ctx);
+
+/**
+ * @brief Calls fn, in descending order, for every item whose word is not
+ * after the one of from: "the last k words before X" stops fn after k items.
+ *
+ * The fast lanes find the first item. With back links (see
+ * skiplist_backlinks_enable()) every other item is one step away, so the walk
+ * costs O(log n + k); without them each one takes a descent, O(k log n).
+ *
+ * @param skiplist ptr to the skiplist.
+ * @param from ptr to the key, or NULL to start at the last item.
+ * @param fn the visitor, see skiplist_foreach().
+ * @param ctx opaque ptr forwarded to fn.
+ * @return status_t see skiplist_foreach().
+ */
+status_t skiplist_foreach_reverse(const SkipList *skiplist, const Item *from,
+                                  status_t (*fn)(Item *item, void *ctx),
+                                  void *ctx);
+
+/**
+ * @brief Removes every node of the skiplist WITHOUT deleting the items. The
+ * list is left empty and ready to be reused.
+ *
+ * @param skiplist ptr to the skiplist.
+ *
+ * @warning the items are not freed. Take them with skiplist_foreach() first
+ * or they will leak. Open snapshots (see skiplist_snapshot()) do not keep
+ * the words cleared.
+ */
+void skiplist_shallow_clear(SkipList *skiplist);
+
+/**
+ * @brief Deletes a list built over items another list still holds (e.g. by
+ * skiplist_from_sorted() and skiplist_inherit_options()), WITHOUT deleting
+ * a single item: unlike skiplist_shallow_clear(), not even the ones it sees
+ * as expired. The items keep the positions it gave them in its timer wheel;
+ * see skiplist_timers_reclaim().
+ *
+ * @param skiplist a ptr to the list ptr. It will be set to NULL.
+ *
+ * @warning the list must hold no tombstones: those are still freed.
+ */
+void skiplist_abandon(SkipList **skiplist);
+
+/**
+ * @brief Builds a skiplist bottom-up from items that are already sorted and
+ * unique, in O(n), without a single search.
+ *
+ * The items are split in segments. Each segment draws the tower heights and
+ * links its own lanes on a thread of the pool; the segments are then stitched
+ * together lane by lane.
+ *
+ * @param items the items, sorted by item_raw_cmp and without repeated words.
+ * @param n the number of items.
+ * @param pool the workers to use, or NULL to build on the calling thread.
+ * @return SkipList* ptr to the skiplist, WITH OWNERSHIP, or NULL on error. On
+ * success the list owns the items; on error they are left untouched.
+ *
+ * @warning the order and uniqueness of the items are not checked.
+ */
+SkipList *skiplist_from_sorted(Item **items, size_t n, ThreadPool *pool);
+
+/**
+ * @brief Which item skiplist_merge() keeps when both lists hold a word.
+ *
+ * \c SKIPLIST_KEEP_OURS keeps the item of the list merged into, like a
+ * refused skiplist_insert(); \c SKIPLIST_KEEP_THEIRS keeps the one of the
+ * other list, like a skiplist_update(). Either way, an item that is gone
+ * (removed lazily or expired) loses to one that is not.
+ */
+typedef enum {
+    SKIPLIST_KEEP_OURS,
+    SKIPLIST_KEEP_THEIRS,
+} skiplist_merge_t;
+
+/**
+ * @brief Moves every item of other into the skiplist, in O(n + m), without a
+ * single search. other is left empty, with its settings.
+ *
+ * When every word of one list comes before every word of the other, their
+ * lanes are joined: the head column of the first one is raised to the
+ * height of the second and each lane is linked to the next, in O(log n).
+ * Otherwise the main lanes are merged node by node, reusing the nodes, the
+ * tombstones and the items that lose to the policy are freed, and the fast
+ * lanes are built again as skiplist_reshape() does (or as the 1-2-3
+ * invariant asks, in the deterministic mode).
+ *
+ * The hash index, Bloom filter and timer wheel of the skiplist take the items
+ * of other, which costs O(m) when the list has them.
+ *
+ * @param skiplist ptr to the skiplist that receives the items.
+ * @param other ptr to the skiplist that gives them.
+ * @param policy see skiplist_merge_t.
+ * @return status_t \c SUCCESS, \c NUL_ERR or \c ALLOC_ERR, in which case both
+ * lists are untouched. With \c SUCCESS, a failure to rebuild the Bloom
+ * filter or the timer wheel leaves the list without it.
+ *
+ * @note the limits of the configuration (max length and bytes) are not
+ * enforced here, but by the next insertions.
+ */
+status_t skiplist_merge(SkipList *skiplist, SkipList *other,
+                        skiplist_merge_t policy);
+
+/**
+ * @brief Cuts the skiplist at a key: the items from the key on move to a new
+ * list, with the same settings (see skiplist_inherit_options()).
+ *
+ * It costs O(log n + min(k, n - k)), k being the items kept, not O(log n):
+ * the lanes are spliced where the trace of the key crosses them, and the
+ * first item moved gets a head column in the new list, but the list keeps
+ * no lane widths. Both lengths, and the nodes of every lane (see
+ * skiplist_bytes()), are counted by walking the two parts side by side, up
+ * to the end of the shorter one. Moving the items from the hash index and
+ * the timer wheel, and the deterministic mode, whose lanes are built again,
+ * cost O(n) more.
+ *
+ * @param skiplist ptr to the skiplist. It keeps the words before key.
+ * @param key the first word to move; it does not need to be in the list.
+ * @return SkipList* the list with the rest, WITH OWNERSHIP, or NULL on error,
+ * in which case the skiplist is untouched.
+ *
+ * @note the Bloom filter of the skiplist is not rebuilt here: the words that
+ * moved are counted as stale in it, so the next insertion rebuilds it once
+ * they are too many (see bloom_is_saturated()).
+ */
+SkipList *skiplist_split(SkipList *skiplist, const Item *key);
+
+/**
+ * @brief Takes a read-only view of the skiplist as it is now, in O(1): the
+ * list keeps taking writes, which the snapshot does not see.
+ *
+ * Nothing is copied up front. The first write to a word after the newest
+ * snapshot was taken keeps its previous state (a copy of the item, or a
+ * mark that the word was absent) in a small skiplist of that snapshot, and
+ * later writes to the word keep nothing. A snapshot reads its own versions
+ * first, then the ones of the newer snapshots, then the list itself, so the
+ * unchanged words are shared by the list and every snapshot. A write costs
+ * an extra O(log d) search while snapshots are open, d being the words kept
+ * by the newest one; a read of a snapshot with k newer ones costs O(k log d)
+ * more than the same read of the list.
+ *
+ * Items removed lazily or expired when the snapshot is taken are not in it;
+ * the ones that expire later are.
+ *
+ * @param skiplist ptr to the skiplist.
+ * @return Snapshot* ptr to the snapshot, WITH OWNERSHIP, or NULL on error.
+ * Release it with skiplist_snapshot_del().
+ *
+ * @note reading a snapshot while another thread writes to the list needs the
+ * same lock as reading the list itself. skiplist_merge() and skiplist_split()
+ * keep, for the open snapshots, every word they move; skiplist_shallow_clear()
+ * does not.
+ */
+Snapshot *skiplist_snapshot(SkipList *skiplist);
+
+/**
+ * @brief Releases a snapshot. The versions it kept go to the snapshot taken
+ * before it, if that one is still open, and are freed otherwise: O(d + d'),
+ * d and d' being the words kept by each.
+ *
+ * @param snapshot a ptr to the snapshot ptr. It will be set to NULL.
+ */
+void skiplist_snapshot_del(Snapshot **snapshot);
+
+/**
+ * @brief Searches a word as it was when the snapshot was taken.
+ *
+ * @param snapshot ptr to the snapshot.
+ * @param item the key: only its word is read.
+ * @param buf the storage of a copy of the item found, see item_place().
+ * @return Item* a ptr into buf, WITHOUT OWNERSHIP, or NULL if the word was
+ * absent or the list was deleted.
+ */
+Item *skiplist_snapshot_search(const Snapshot *snapshot, const Item *item,
+                               item_buf_t *buf);
+
+/**
+ * @brief Calls fn, in order, for every item of the snapshot.
+ *
+ * @param snapshot ptr to the snapshot.
+ * @param fn the visitor, see skiplist_foreach(). It must not write to the
+ * list, nor release the snapshot.
+ * @param ctx opaque ptr forwarded to fn.
+ * @return status_t see skiplist_foreach(); \c NUL_ERR too if the list was
+ * deleted.
+ */
+status_t skiplist_snapshot_foreach(const Snapshot *snapshot,
+                                   status_t (*fn)(Item *item, void *ctx),
+                                   void *ctx);
+
+/**
+ * @brief Same as skiplist_snapshot_foreach(), but only for the words that
+ * start with c, reached through the fast lanes.
+ */
+status_t skiplist_snapshot_foreach_char(const Snapshot *snapshot, const char c,
+                                        status_t (*fn)(Item *item, void *ctx),
+                                        void *ctx);
+
+/**
+ * @brief A getter to the length of the list when the snapshot was taken.
+ */
+size_t skiplist_snapshot_length(const Snapshot *snapshot);
+
+/**
+ * @brief Adds a hash index of the items by word, kept in sync from now on.
+ *
+ * Exact-key operations then skip the lanes: skiplist_search() and
+ * skiplist_update() become O(1), and so do the duplicate and presence checks
+ * of skiplist_insert() and skiplist_remove() (which still walk the lanes to
+ * link or unlink the nodes). Ordered operations keep using the lanes. The
+ * index costs about 16 bytes per slot, with at least one free slot in four.
+ *
+ * @param skiplist ptr to the skiplist.
+ * @return status_t \c SUCCESS (also if it was indexed already), \c NUL_ERR
+ * or \c ALLOC_ERR.
+ *
+ * @note skiplist_shallow_clear() keeps the index, empty. Lists built by
+ * skiplist_from_sorted() start without one.
+ */
+status_t skiplist_index_enable(SkipList *skiplist);
+
+/**
+ * @brief Drops the hash index of the skiplist, if it has one.
+ *
+ * @param skiplist ptr to the skiplist.
+ */
+void skiplist_index_disable(SkipList *skiplist);
+
+/**
+ * @brief Checks if the skiplist has a hash index.
+ *
+ * @param skiplist ptr to the skiplist.
+ * @return _Bool \c 1 if it has, \c 0 otherwise.
+ */
+_Bool skiplist_is_indexed(const SkipList *skiplist);
+
+/**
+ * @brief Adds a Bloom filter of the words, kept in sync from now on.
+ *
+ * skiplist_search() asks the filter first and answers a surely absent word
+ * without walking the lanes; so do the presence checks of skiplist_update()
+ * and skiplist_remove(), and the duplicate check of skiplist_insert(). The
+ * filter is rebuilt, sized for twice the length, when it holds more words
+ * than it was sized for or when too many of them were removed.
+ *
+ * @param skiplist ptr to the skiplist.
+ * @param fp_rate the false positive rate, in (0, 1); other values select
+ * BLOOM_FP_RATE. An enabled filter is rebuilt with the new rate.
+ * @return status_t \c SUCCESS, \c NUL_ERR or \c ALLOC_ERR.
+ */
+status_t skiplist_bloom_enable(SkipList *skiplist, double fp_rate);
+
+/**
+ * @brief Drops the Bloom filter of the skiplist, if it has one.
+ *
+ * @param skiplist ptr to the skiplist.
+ */
+void skiplist_bloom_disable(SkipList *skiplist);
+
+/**
+ * @brief Turns on the adaptive mode: skiplist_lookup() counts the accesses to
+ * every word and moves the tower of the word it finds one lane towards the
+ * height its popularity deserves.
+ *
+ * A word taking a share s of the lookups is raised to the lane that has about
+ * 1 / s nodes, so the hot words are found after few hops; lookups stop at the
+ * first node of the word instead of descending to the main lane. A word that
+ * cooled down is lowered back, one lane per lookup, to a height drawn from
+ * its hash, which keeps the lanes balanced. The counts live in an aging
+ * count-min sketch (see freqsketch.h) of fixed size; no node grows.
+ *
+ * @param skiplist ptr to the skiplist.
+ * @return status_t \c SUCCESS, \c NUL_ERR or \c ALLOC_ERR.
+ *
+ * @note with a hash index (skiplist_index_enable()), lookups do not walk the
+ * lanes and nothing is adapted. Deterministic lists keep their own heights:
+ * for them this does nothing.
+ */
+status_t skiplist_adaptive_enable(SkipList *skiplist);
+
+/**
+ * @brief Turns off the adaptive mode. The towers keep their heights.
+ *
+ * @param skiplist ptr to the skiplist.
+ */
+void skiplist_adaptive_disable(SkipList *skiplist);
+
+/**
+ * @brief Searches an item like skiplist_search(), but in the adaptive mode
+ * it also counts the access and adjusts the tower found.
+ *
+ * @param skiplist ptr to the skiplist.
+ * @param item ptr to the item.
+ * @return Item* see skiplist_search().
+ */
+Item *skiplist_lookup(SkipList *skiplist, const Item *item);
+
+/**
+ * @brief Turns on lazy deletion: removals only mark the item found as a
+ * tombstone (see item_set_tombstone()) and leave its column in the lanes.
+ *
+ * Tombstones are invisible: searches, walks and prints skip them, and
+ * inserting their word again reuses their column. They are unlinked and
+ * freed by compaction steps, which walk a bounded number of main lane nodes
+ * from where the previous step stopped; once the tombstones exceed ratio of
+ * the columns, every removal runs one, until they are down to half of it.
+ * skiplist_compact() runs one on demand.
+ *
+ * @param skiplist ptr to the skiplist.
+ * @param ratio the tombstone share that starts the compaction, in (0, 1];
+ * other values select LAZY_RATIO.
+ * @return status_t \c SUCCESS, \c NUL_ERR or \c ALLOC_ERR.
+ *
+ * @note skiplist_remove() must hand the item back, so in this mode it
+ * returns a copy; skiplist_delete() does not.
+ */
+status_t skiplist_lazy_enable(SkipList *skiplist, double ratio);
+
+/**
+ * @brief Turns off lazy deletion, after compacting every tombstone.
+ *
+ * @param skiplist ptr to the skiplist.
+ */
+void skiplist_lazy_disable(SkipList *skiplist);
+
+/**
+ * @brief Runs a compaction step of the lazy mode: unlinks and frees the
+ * tombstones among the next main lane nodes.
+ *
+ * @param skiplist ptr to the skiplist.
+ * @param budget how many main lane nodes to visit, or 0 for the whole list.
+ * @return size_t how many tombstones were freed.
+ */
+size_t skiplist_compact(SkipList *skiplist, size_t budget);
+
+/**
+ * @brief A getter to the number of tombstones still in the lanes.
+ *
+ * @param skiplist a ptr to the skiplist.
+ * @return size_t the number of tombstones, not counted by skiplist_length().
+ */
+size_t skiplist_tombstones(const SkipList *skiplist);
+
+/**
+ * @brief Links the main lane both ways from now on, for the descending walks
+ * of skiplist_foreach_reverse().
+ *
+ * Every main lane node gets a ptr to the node before it, kept by the
+ * insertions and removals; the fast lanes are left as they are. This costs a
+ * ptr per item, and the nodes already linked are moved once, in O(n). Lists
+ * without back links keep their nodes as small as before.
+ *
+ * @param skiplist ptr to the skiplist.
+ * @return status_t \c SUCCESS (also if it had them already), \c NUL_ERR or
+ * \c ALLOC_ERR.
+ *
+ * @note skiplist_split() gives them to the new list, and skiplist_merge()
+ * to the list merged into one that has them.
+ */
+status_t skiplist_backlinks_enable(SkipList *skiplist);
+
+/**
+ * @brief Stops keeping the back links. The nodes keep their room for them
+ * until they are freed.
+ *
+ * @param skiplist ptr to the skiplist.
+ */
+void skiplist_backlinks_disable(SkipList *skiplist);
+
+/**
+ * @brief Builds a frozen index of the visible items: their words in a single
+ * array in Eytzinger order, searched without branches and with the next
+ * levels fetched ahead (see frozen.h). While it is there, searches and
+ * skiplist_foreach_char() use it instead of the lanes (the hash index, if
+ * any, still answers the exact words first), and the adaptive mode stops
+ * moving towers. The first write drops it: an insertion, removal, batch,
+ * merge or split, an eviction or an item that expires; an update changes
+ * the item in place, so it keeps it.
+ *
+ * @param skiplist ptr to the skiplist.
+ * @return status_t \c SUCCESS (also if it is frozen already), \c NUL_ERR or
+ * \c ALLOC_ERR, in which case the lanes keep serving the searches.
+ *
+ * @note it costs O(n) time and 16 bytes per item, next to the lanes.
+ */
+status_t skiplist_freeze(SkipList *skiplist);
+
+/**
+ * @brief Drops the frozen index of a list, if it has one.
+ *
+ * @param skiplist ptr to the skiplist.
+ */
+void skiplist_thaw(SkipList *skiplist);
+
+/**
+ * @brief Gives a skiplist the same configuration, hash index, Bloom filter,
+ * adaptive, lazy deletion and back link settings as model, e.g. after
+ * rebuilding a list with skiplist_from_sorted(). A list taking the
+ * deterministic mode, another p or a lower max height has its fast lanes
+ * rebuilt from the main lane, in O(n).
+ *
+ * @param skiplist ptr to the skiplist.
+ * @param model ptr to the skiplist whose settings are copied.
+ * @return status_t \c SUCCESS, \c NUL_ERR or \c ALLOC_ERR.
+ */
+status_t skiplist_inherit_options(SkipList *skiplist, const SkipList *model);
+
+/**
+ * @brief Points the items of a list back to its own timer wheel, after a
+ * list built over the same items was dropped with skiplist_abandon().
+ *
+ * @param skiplist ptr to the skiplist.
+ */
+void skiplist_timers_reclaim(SkipList *skiplist);
+
 #endif // SKIPLIST_H_DEFINED
\ No newline at end of file
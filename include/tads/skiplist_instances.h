@@ -0,0 +1,36 @@
+/**
+ * @file skiplist_instances.h
+ * @brief Ready-made skiplists generated from skiplist_template.h.
+ *
+ * - `U64SkipList`: uint64_t keys (timestamps, ids) with an inlined integer
+ *   comparison.
+ * - `WordSkipList`: fixed-width word keys (`word_t`), compared in place
+ *   without going through a pointer to an Item.
+ * - `ItemSkipList`: the dictionary `Item *` ordered by item_raw_cmp, without
+ *   the NULL checks of item_cmp.
+ *
+ * All of them map the key to an opaque `void *` value.
+ */
+
+#ifndef SKIPLIST_INSTANCES_H_DEFINED
+#define SKIPLIST_INSTANCES_H_DEFINED
+
+#include <stdint.h>
+
+#include "tads/item.h"
+#include "tads/skiplist_template.h"
+#include "tads/tad_constants.h"
+
+/**
+ * @brief A fixed-width, '\0' terminated word. Wrapping it in a struct lets it
+ * be stored and copied by value.
+ */
+typedef struct {
+    char s[1 + MAX_WORD_SIZE];
+} word_t;
+
+SKIPLIST_TEMPLATE_DECLARE(U64SkipList, u64skiplist, uint64_t, void *)
+SKIPLIST_TEMPLATE_DECLARE(WordSkipList, wordskiplist, word_t, void *)
+SKIPLIST_TEMPLATE_DECLARE(ItemSkipList, itemskiplist, Item *, void *)
+
+#endif // SKIPLIST_INSTANCES_H_DEFINED
@@ -0,0 +1,232 @@
+/**
+ * @file skiplist_template.h
+ * @brief Macros that generate a skiplist specialized for a key and a value
+ * type at compile time.
+ *
+ * The `SkipList` in skiplist.h is tied to `Item *` and `item_cmp`. The macros
+ * in this header stamp out an independent skiplist for any key/value pair,
+ * with the comparator expanded in place so the compiler can inline it.
+ *
+ * Usage:
+ *
+ *     // in a header
+ *     SKIPLIST_TEMPLATE_DECLARE(U64SkipList, u64skiplist, uint64_t, void *)
+ *
+ *     // in exactly one translation unit
+ *     #define U64_CMP(a, b) ((*(a) > *(b)) - (*(a) < *(b)))
+ *     SKIPLIST_TEMPLATE_DEFINE(U64SkipList, u64skiplist, uint64_t, void *,
+ *                              U64_CMP)
+ *
+ * `CMP(a, b)` receives two `const PREFIX##_key_t *` and must behave like
+ * strcmp. Keys and values are stored by value inside the nodes; nothing they
+ * point to is ever freed by the list.
+ *
+ * Each generated list stores its towers as arrays of forward pointers (one
+ * allocation per key instead of one per level) and has its own random seed.
+ *
+ * The program itself only uses the `SkipList` of skiplist.h: this header is a
+ * library for other code, with sample instances in skiplist_instances.h.
+ *
+ * @version 1.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#ifndef SKIPLIST_TEMPLATE_H_DEFINED
+#define SKIPLIST_TEMPLATE_H_DEFINED
+
+//=============================================================================/
+//=================|    Dependencies    |======================================/
+//=============================================================================/
+
+#include "tads/skiplist.h"
+#include "tads/tad_types.h"
+#include "utils/mathutils.h"
+#include <stdlib.h>
+
+//=============================================================================/
+//=================|    Constants   |==========================================/
+//=============================================================================/
+
+// Towers of a generated skiplist are arrays, so their height must be bounded.
+// With p = 1/2, 32 levels are enough for about four billion keys.
+#define SKIPLIST_TEMPLATE_MAX_HEIGHT (32)
+
+//=============================================================================/
+//=================|    Macros    |============================================/
+//=============================================================================/
+
+/**
+ * @brief Declares the type NAME and the functions PREFIX_new, PREFIX_del,
+ * PREFIX_insert, PREFIX_update, PREFIX_search, PREFIX_remove, PREFIX_foreach,
+ * PREFIX_length and PREFIX_height. They follow the same contracts as their
+ * counterparts in skiplist.h.
+ */
+#define SKIPLIST_TEMPLATE_DECLARE(NAME, PREFIX, KEY_T, VAL_T)                  \
+    typedef KEY_T PREFIX##_key_t;                                              \
+    typedef struct PREFIX##_s NAME;                                            \
+    NAME *PREFIX##_new(void);                                                  \
+    void PREFIX##_del(NAME **list);                                            \
+    status_t PREFIX##_insert(NAME *list, KEY_T key, VAL_T val);                \
+    status_t PREFIX##_update(NAME *list, const PREFIX##_key_t *key,            \
+                             VAL_T val);                                       \
+    VAL_T *PREFIX##_search(const NAME *list, const PREFIX##_key_t *key);       \
+    status_t PREFIX##_remove(NAME *list, const PREFIX##_key_t *key,            \
+                             KEY_T *key_out, VAL_T *val_out);                  \
+    status_t PREFIX##_foreach(                                                 \
+        const NAME *list,                                                      \
+        status_t (*fn)(const PREFIX##_key_t *, VAL_T *, void *), void *ctx);   \
+    size_t PREFIX##_length(const NAME *list);                                  \
+    size_t PREFIX##_height(const NAME *list);
+
+/**
+ * @brief Defines everything declared by SKIPLIST_TEMPLATE_DECLARE. Use it in a
+ * single translation unit.
+ *
+ * @note CMP is expanded inside the search loops, so a macro or a static inline
+ * function costs no call per visited node.
+ */
+#define SKIPLIST_TEMPLATE_DEFINE(NAME, PREFIX, KEY_T, VAL_T, CMP)              \
+    typedef struct PREFIX##_node_s {                                           \
+        KEY_T key;                                                             \
+        VAL_T val;                                                             \
+        size_t height;                                                         \
+        struct PREFIX##_node_s *next[];                                        \
+    } PREFIX##_node_t;                                                         \
+                                                                               \
+    struct PREFIX##_s {                                                        \
+        PREFIX##_node_t *head;                                                 \
+        size_t length;                                                         \
+        size_t height;                                                         \
+        unsigned int seed;                                                     \
+    };                                                                         \
+                                                                               \
+    static PREFIX##_node_t *PREFIX##_node_new(size_t height) {                 \
+        PREFIX##_node_t *n = (PREFIX##_node_t *)calloc(                        \
+            1, sizeof(PREFIX##_node_t) + height * sizeof(PREFIX##_node_t *));  \
+        if (n) n->height = height;                                             \
+        return n;                                                              \
+    }                                                                          \
+                                                                               \
+    /* Walks down the towers, filling trace with the last node of each    */   \
+    /* lane whose key is smaller than the target key.                     */   \
+    static inline PREFIX##_node_t *PREFIX##_trace(                             \
+        const NAME *list, const PREFIX##_key_t *key,                           \
+        PREFIX##_node_t **trace) {                                             \
+        PREFIX##_node_t *sentinel = list->head;                                \
+        for (size_t lv = list->height; lv-- > 0;) {                            \
+            while (sentinel->next[lv] &&                                       \
+                   CMP(&sentinel->next[lv]->key, key) < 0)                     \
+                sentinel = sentinel->next[lv];                                 \
+            if (trace) trace[lv] = sentinel;                                   \
+        }                                                                      \
+        return sentinel->next[0];                                              \
+    }                                                                          \
+                                                                               \
+    NAME *PREFIX##_new(void) {                                                 \
+        NAME *list = (NAME *)malloc(sizeof(NAME));                             \
+        if (NULL == list) return NULL;                                         \
+        list->head = PREFIX##_node_new(SKIPLIST_TEMPLATE_MAX_HEIGHT);          \
+        if (NULL == list->head) {                                              \
+            free(list);                                                        \
+            return NULL;                                                       \
+        }                                                                      \
+        list->length = 0;                                                      \
+        list->height = 1;                                                      \
+        list->seed = (unsigned int)rand() | 1u;                                \
+        return list;                                                           \
+    }                                                                          \
+                                                                               \
+    void PREFIX##_del(NAME **list) {                                           \
+        if (NULL == list || NULL == *list) return;                             \
+        PREFIX##_node_t *runner = (*list)->head;                               \
+        while (runner) {                                                       \
+            PREFIX##_node_t *temp = runner->next[0];                           \
+            free(runner);                                                      \
+            runner = temp;                                                     \
+        }                                                                      \
+        free(*list);                                                           \
+        *list = NULL;                                                          \
+    }                                                                          \
+                                                                               \
+    status_t PREFIX##_insert(NAME *list, KEY_T key, VAL_T val) {               \
+        if (NULL == list) return NUL_ERR;                                      \
+        PREFIX##_node_t *trace[SKIPLIST_TEMPLATE_MAX_HEIGHT];                  \
+        PREFIX##_node_t *found = PREFIX##_trace(list, &key, trace);            \
+        if (found && 0 == CMP(&found->key, &key)) return REPEATED_ENTRY_ERR;   \
+                                                                               \
+        size_t h = 1 + (size_t)geometric_dist_test_r(                          \
+                           SKIPLIST_PROB, SKIPLIST_TEMPLATE_MAX_HEIGHT - 1,    \
+                           &list->seed);                                       \
+        PREFIX##_node_t *node = PREFIX##_node_new(h);                          \
+        if (NULL == node) return ALLOC_ERR;                                    \
+        node->key = key;                                                       \
+        node->val = val;                                                       \
+                                                                               \
+        for (; list->height < h; list->height++)                               \
+            trace[list->height] = list->head;                                  \
+        for (size_t lv = 0; lv < h; lv++) {                                    \
+            node->next[lv] = trace[lv]->next[lv];                              \
+            trace[lv]->next[lv] = node;                                        \
+        }                                                                      \
+                                                                               \
+        list->length++;                                                        \
+        return SUCCESS;                                                        \
+    }                                                                          \
+                                                                               \
+    status_t PREFIX##_update(NAME *list, const PREFIX##_key_t *key,            \
+                             VAL_T val) {                                      \
+        if (NULL == list || NULL == key) return NUL_ERR;                       \
+        VAL_T *slot = PREFIX##_search(list, key);                              \
+        if (NULL == slot) return NOT_FOUND_ERR;                                \
+        *slot = val;                                                           \
+        return SUCCESS;                                                        \
+    }                                                                          \
+                                                                               \
+    VAL_T *PREFIX##_search(const NAME *list, const PREFIX##_key_t *key) {      \
+        if (NULL == list || NULL == key) return NULL;                          \
+        PREFIX##_node_t *found = PREFIX##_trace(list, key, NULL);              \
+        return found && 0 == CMP(&found->key, key) ? &found->val : NULL;       \
+    }                                                                          \
+                                                                               \
+    status_t PREFIX##_remove(NAME *list, const PREFIX##_key_t *key,            \
+                             KEY_T *key_out, VAL_T *val_out) {                 \
+        if (NULL == list || NULL == key) return NUL_ERR;                       \
+        PREFIX##_node_t *trace[SKIPLIST_TEMPLATE_MAX_HEIGHT];                  \
+        PREFIX##_node_t *found = PREFIX##_trace(list, key, trace);             \
+        if (NULL == found || 0 != CMP(&found->key, key)) return NOT_FOUND_ERR; \
+                                                                               \
+        for (size_t lv = 0; lv < found->height; lv++)                          \
+            trace[lv]->next[lv] = found->next[lv];                             \
+        while (list->height > 1 && NULL == list->head->next[list->height - 1]) \
+            list->height--;                                                    \
+                                                                               \
+        if (key_out) *key_out = found->key;                                    \
+        if (val_out) *val_out = found->val;                                    \
+        free(found);                                                           \
+        list->length--;                                                        \
+        return SUCCESS;                                                        \
+    }                                                                          \
+                                                                               \
+    status_t PREFIX##_foreach(                                                 \
+        const NAME *list,                                                      \
+        status_t (*fn)(const PREFIX##_key_t *, VAL_T *, void *), void *ctx) {  \
+        if (NULL == list || NULL == fn) return NUL_ERR;                        \
+        for (PREFIX##_node_t *n = list->head->next[0]; n; n = n->next[0]) {    \
+            status_t flag = fn(&n->key, &n->val, ctx);                         \
+            if (SUCCESS != flag) return flag;                                  \
+        }                                                                      \
+        return SUCCESS;                                                        \
+    }                                                                          \
+                                                                               \
+    size_t PREFIX##_length(const NAME *list) {                                 \
+        return list ? list->length : 0;                                        \
+    }                                                                          \
+                                                                               \
+    size_t PREFIX##_height(const NAME *list) {                                 \
+        return list ? list->height : 0;                                        \
+    }
+
+#endif // SKIPLIST_TEMPLATE_H_DEFINED
@@ -33,6 +33,8 @@ typedef enum {
     PARTIAL_FAILURE,
     NOT_FOUND_ERR,
     CRITICAL_ERR,
+    READ_ONLY_ERR,
+    INVALID_ERR,
 } status_t;
 
 #endif // TAD_TYPES_H_INCLUDED
\ No newline at end of file
@@ -0,0 +1,109 @@
+/**
+ * @file timerwheel.h
+ * @brief Header file for a hashed timer wheel of expiring items.
+ *
+ * The wheel schedules items by their expiry tick (see item_set_expiry()):
+ * a ring of slots, a power of two of them, where the item expiring at tick
+ * t waits in slot t mod slots. The wheel turns one slot per tick, so finding
+ * the items that expired only looks at the slots of the ticks that went by,
+ * never at the whole set. Items expiring more than a turn away share their
+ * slot with nearer ones and are stepped over until their own turn.
+ *
+ * Adding and cancelling cost O(1): every item records its position in its
+ * slot (see item_set_timer()). The slots grow as needed and give their room
+ * back as they empty, so the memory follows the number of items scheduled.
+ */
+
+#ifndef TIMERWHEEL_H_DEFINED
+#define TIMERWHEEL_H_DEFINED
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "tads/item.h"
+#include "tads/tad_types.h"
+
+/**
+ * @brief An incomplete wrapper for the wheel. Use it as a ptr.
+ */
+typedef struct _timerwheel_s TimerWheel;
+
+/**
+ * @brief Creates an empty wheel.
+ *
+ * @param slots number of slots, rounded up to a power of two.
+ * @param now the current tick: the wheel starts turning from it.
+ * @return TimerWheel* ptr to the wheel, WITH OWNERSHIP, or NULL on error.
+ */
+TimerWheel *timerwheel_new(size_t slots, uint32_t now);
+
+/**
+ * @brief Frees the wheel, but not the items it schedules.
+ *
+ * @param wheel a ptr to the wheel ptr. It will be set to NULL.
+ */
+void timerwheel_del(TimerWheel **wheel);
+
+/**
+ * @brief Forgets every item, keeping the room of the slots, and moves the
+ * wheel to a new tick.
+ *
+ * @param wheel ptr to the wheel.
+ * @param now the current tick.
+ */
+void timerwheel_clear(TimerWheel *wheel, uint32_t now);
+
+/**
+ * @brief Schedules an item at its expiry tick. Items that expired already
+ * are due at the next timerwheel_pop_due().
+ *
+ * @param wheel ptr to the wheel.
+ * @param item ptr to the item, WITHOUT OWNERSHIP, with an expiry and not
+ * scheduled yet.
+ * @return status_t \c SUCCESS, \c NUL_ERR or \c ALLOC_ERR.
+ */
+status_t timerwheel_add(TimerWheel *wheel, Item *item);
+
+/**
+ * @brief Takes an item off the wheel. Items it does not schedule (e.g.
+ * already popped) are ignored.
+ *
+ * @param wheel ptr to the wheel.
+ * @param item ptr to the item.
+ */
+void timerwheel_cancel(TimerWheel *wheel, Item *item);
+
+/**
+ * @brief Turns the wheel up to a tick and takes off the next item that
+ * expired at or before it.
+ *
+ * The wheel remembers where it stopped, so popping every due item, one call
+ * at a time, visits each slot once per turn. A wheel left alone for more
+ * than a turn skips the extra turns.
+ *
+ * @param wheel ptr to the wheel.
+ * @param now the current tick.
+ * @return Item* the expired item, WITHOUT OWNERSHIP, or NULL if none is due.
+ */
+Item *timerwheel_pop_due(TimerWheel *wheel, uint32_t now);
+
+/**
+ * @brief Records again, in every item it schedules, its position in its
+ * slot (see item_set_timer()), e.g. after another wheel scheduled the same
+ * items and was dropped.
+ *
+ * @param wheel ptr to the wheel.
+ */
+void timerwheel_renumber(TimerWheel *wheel);
+
+/**
+ * @brief A getter to the number of items scheduled.
+ */
+size_t timerwheel_length(const TimerWheel *wheel);
+
+/**
+ * @brief Heap bytes used by the wheel, its header and slots included.
+ */
+size_t timerwheel_bytes(const TimerWheel *wheel);
+
+#endif // TIMERWHEEL_H_DEFINED
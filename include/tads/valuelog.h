@@ -0,0 +1,126 @@
+/**
+ * @file valuelog.h
+ * @brief Header file for an append-only log of descriptions on disk.
+ *
+ * Descriptions are appended to a scratch file, one after the other, and
+ * referenced by their offset and length packed in a single integer (see
+ * item_new_cold()): a dictionary keeps its words and its lanes in memory and
+ * only fetches a description when it prints it. The last, partial page of
+ * the file is kept in memory, so appends write whole pages.
+ *
+ * Reads go through a bounded page cache, set associative with a clock per
+ * set. A miss right after the pages read by the previous one is taken as a
+ * sequential scan (e.g. printing words appended in order) and reads twice
+ * as many pages ahead, up to \c VALUELOG_READAHEAD, in a single call; any
+ * other miss reads one page.
+ *
+ * Nothing is ever overwritten: replaced and removed descriptions stay in
+ * the file until it is compacted, by copying the live ones to a new log
+ * (see backend_compact()). The file is unlinked as soon as it is created,
+ * as the dictionary itself does not outlive the process.
+ */
+
+#ifndef VALUELOG_H_DEFINED
+#define VALUELOG_H_DEFINED
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "tads/tad_types.h"
+
+/**
+ * @brief Bytes of a page, the unit of the reads and the writes.
+ */
+#define VALUELOG_PAGE (4096)
+
+/**
+ * @brief Pages of a set of the cache: a page can only be cached in the set
+ * its number selects.
+ */
+#define VALUELOG_WAYS (8)
+
+/**
+ * @brief Most pages read ahead by a single miss.
+ */
+#define VALUELOG_READAHEAD (16)
+
+/**
+ * @brief Bytes of page cache used when none is given.
+ */
+#define VALUELOG_CACHE (16 << 20)
+
+/**
+ * @brief An incomplete wrapper for the log. Use it as a ptr.
+ */
+typedef struct _valuelog_s ValueLog;
+
+/**
+ * @brief Creates an empty log in a scratch file.
+ *
+ * @param dir the directory of the file, NULL for /tmp.
+ * @param cache_bytes bytes of page cache, \c 0 for \c VALUELOG_CACHE. It is
+ * rounded to whole sets, and is at least one.
+ * @return ValueLog* ptr to the log, WITH OWNERSHIP, or NULL on error (errno
+ * tells why).
+ */
+ValueLog *valuelog_new(const char *dir, size_t cache_bytes);
+
+/**
+ * @brief Closes the log, and with it its file.
+ *
+ * @param log a ptr to the log ptr. It will be set to NULL.
+ */
+void valuelog_del(ValueLog **log);
+
+/**
+ * @brief Appends a description.
+ *
+ * @param log ptr to the log.
+ * @param data the bytes.
+ * @param len number of bytes, at most 255.
+ * @param ref output, the reference to them.
+ * @return status_t \c SUCCESS, \c NUL_ERR, \c TOO_MUCH_ERR or
+ * \c CRITICAL_ERR if the file could not be written.
+ */
+status_t valuelog_append(ValueLog *log, const char *data, size_t len,
+                         uint64_t *ref);
+
+/**
+ * @brief Reads a description back.
+ *
+ * @param log ptr to the log.
+ * @param ref a reference given by valuelog_append().
+ * @param out output, room for 256 bytes: the description and a '\0'.
+ * @return status_t \c SUCCESS, \c NUL_ERR, \c NOT_FOUND_ERR if the
+ * reference is past the end of the log, or \c CRITICAL_ERR if the file could
+ * not be read.
+ */
+status_t valuelog_read(ValueLog *log, uint64_t ref, char *out);
+
+/**
+ * @brief A getter to the length of the reference: the bytes it takes in the
+ * log.
+ */
+size_t valuelog_ref_length(uint64_t ref);
+
+/**
+ * @brief A getter to the bytes appended so far, live or not.
+ */
+uint64_t valuelog_size(const ValueLog *log);
+
+/**
+ * @brief Heap bytes used by the log, its cache included.
+ */
+size_t valuelog_bytes(const ValueLog *log);
+
+/**
+ * @brief Prints the size of the log and of its cache, and how the cache
+ * served the reads.
+ *
+ * @param out the output stream.
+ * @param log ptr to the log.
+ */
+void valuelog_memory_fprint(FILE *out, const ValueLog *log);
+
+#endif // VALUELOG_H_DEFINED
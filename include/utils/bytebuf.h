@@ -0,0 +1,92 @@
+/**
+ * @file bytebuf.h
+ * @brief Header file for a growable byte buffer.
+ *
+ * A plain value type: zero initialize it (`(ByteBuf){0}`), append to it and
+ * release it with bytebuf_free().
+ */
+
+
+#ifndef BYTEBUF_H_INCLUDED
+#define BYTEBUF_H_INCLUDED
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "tads/tad_types.h"
+
+/**
+ * @brief The buffer: `len` bytes in use out of `cap` allocated.
+ */
+typedef struct {
+    unsigned char *data;
+    size_t len;
+    size_t cap;
+} ByteBuf;
+
+/**
+ * @brief Grows the buffer to hold at least `need` bytes.
+ *
+ * @return status_t \c SUCCESS, or \c ALLOC_ERR (the buffer is unchanged).
+ */
+status_t bytebuf_reserve(ByteBuf *buf, size_t need);
+
+/**
+ * @brief Appends bytes to the buffer.
+ *
+ * @return status_t \c SUCCESS, or \c ALLOC_ERR.
+ */
+status_t bytebuf_append(ByteBuf *buf, const void *data, size_t len);
+
+/**
+ * @brief Appends one byte.
+ */
+status_t bytebuf_put_u8(ByteBuf *buf, uint8_t value);
+
+/**
+ * @brief Appends a 16 bit value, little-endian.
+ */
+status_t bytebuf_put_u16(ByteBuf *buf, uint16_t value);
+
+/**
+ * @brief Appends a 32 bit value, little-endian.
+ */
+status_t bytebuf_put_u32(ByteBuf *buf, uint32_t value);
+
+/**
+ * @brief Appends a 64 bit value, little-endian.
+ */
+status_t bytebuf_put_u64(ByteBuf *buf, uint64_t value);
+
+/**
+ * @brief Overwrites a 32 bit value, little-endian, at a position already in
+ * use (e.g. a length known only after the rest was appended).
+ */
+void bytebuf_set_u32(ByteBuf *buf, size_t at, uint32_t value);
+
+/**
+ * @brief Drops the first n bytes, keeping the rest.
+ */
+void bytebuf_consume(ByteBuf *buf, size_t n);
+
+/**
+ * @brief Frees the buffer and zeroes it.
+ */
+void bytebuf_free(ByteBuf *buf);
+
+/**
+ * @brief Reads a little-endian 16 bit value.
+ */
+uint16_t bytebuf_get_u16(const unsigned char *at);
+
+/**
+ * @brief Reads a little-endian 32 bit value.
+ */
+uint32_t bytebuf_get_u32(const unsigned char *at);
+
+/**
+ * @brief Reads a little-endian 64 bit value.
+ */
+uint64_t bytebuf_get_u64(const unsigned char *at);
+
+#endif // BYTEBUF_H_INCLUDED
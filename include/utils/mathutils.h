@@ -33,4 +33,24 @@ float rnd_normalized (void);
 int geometric_dist_test (float p, int max_val);
 // NOTE: We ended up not using this one.
 
+/**
+ * @brief Reentrant version of rnd_normalized(). It uses a xorshift generator
+ * whose state is kept by the caller, so concurrent users do not contend on
+ * the global rand() state.
+ *
+ * @param state ptr to the generator state. It must not be zero.
+ * @return float a random float in the range [0, 1).
+ */
+float rnd_normalized_r (unsigned int *state);
+
+/**
+ * @brief Reentrant version of geometric_dist_test().
+ *
+ * @param p the probability of success of the geometric distribution.
+ * @param max_val the maximum value that the geometric distribution.
+ * @param state ptr to the generator state. It must not be zero.
+ * @return int
+ */
+int geometric_dist_test_r (float p, int max_val, unsigned int *state);
+
 #endif // MATHUTILS_H_INCLUDED
\ No newline at end of file
@@ -0,0 +1,36 @@
+/**
+ * @file memutils.h
+ * @brief Header file for memory utility functions.
+ *
+ * This header contains utility functions used to reason about heap memory,
+ * such as estimating how much the allocator really reserves for a request.
+ */
+
+
+#ifndef MEMUTILS_H_INCLUDED
+#define MEMUTILS_H_INCLUDED
+
+#include <stdlib.h>
+
+/**
+ * @brief Estimates how many bytes the allocator reserves for a malloc call.
+ *
+ * The estimate follows the usual dlmalloc/ptmalloc model: every chunk carries
+ * a size_t header, is rounded up to 2 * sizeof(size_t) and has a minimum size
+ * of 4 * sizeof(size_t).
+ *
+ * @param request the number of bytes passed to malloc.
+ * @return size_t the estimated number of bytes reserved, header included.
+ */
+size_t memutils_alloc_size(size_t request);
+
+/**
+ * @brief Estimates the allocator overhead (header and rounding) of a malloc
+ * call.
+ *
+ * @param request the number of bytes passed to malloc.
+ * @return size_t the estimated number of bytes reserved beyond the request.
+ */
+size_t memutils_alloc_overhead(size_t request);
+
+#endif // MEMUTILS_H_INCLUDED
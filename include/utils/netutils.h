@@ -0,0 +1,53 @@
+/**
+ * @file netutils.h
+ * @brief Header file for the socket helpers shared by the server and the
+ * load generator.
+ *
+ * Addresses are strings in one of the forms:
+ * - `unix:PATH`, a Unix domain stream socket;
+ * - `HOST:PORT`, a TCP socket (HOST is an IPv4 address, e.g. 127.0.0.1);
+ * - `PORT`, a TCP socket on localhost.
+ */
+
+
+#ifndef NETUTILS_H_INCLUDED
+#define NETUTILS_H_INCLUDED
+
+#include <stdlib.h>
+
+#include "tads/tad_types.h"
+
+/**
+ * @brief Creates a non-blocking socket listening on an address. An existing
+ * Unix socket file at the same path is replaced.
+ *
+ * @param addr the address.
+ * @param backlog max pending connections.
+ * @return int the socket, or -1 on error (see errno).
+ */
+int netutils_listen(const char *addr, int backlog);
+
+/**
+ * @brief Connects a (blocking) socket to an address.
+ *
+ * @param addr the address.
+ * @return int the socket, or -1 on error (see errno).
+ */
+int netutils_connect(const char *addr);
+
+/**
+ * @brief Puts a socket in non-blocking mode.
+ *
+ * @param fd the socket.
+ * @return status_t \c SUCCESS, or \c CRITICAL_ERR.
+ */
+status_t netutils_set_nonblocking(int fd);
+
+/**
+ * @brief Removes the socket file of a Unix address, if any.
+ *
+ * @param addr the address.
+ */
+void netutils_unlink(const char *addr);
+
+#endif // NETUTILS_H_INCLUDED
@@ -0,0 +1,81 @@
+/**
+ * @file ring.h
+ * @brief Header file for a bounded single producer / single consumer queue.
+ *
+ * Elements are fixed size and copied in and out of a power of two array. One
+ * thread may push and one (other) thread may pop, without locks: each side
+ * only writes its own index. A full push or an empty pop waits by spinning
+ * a little and then sleeping in short steps.
+ *
+ * The producer closes the ring when it is done; after that, pops drain what
+ * is left and then fail with \c EOF_ERR.
+ */
+
+
+#ifndef RING_H_INCLUDED
+#define RING_H_INCLUDED
+
+#include <stdlib.h>
+
+#include "tads/tad_types.h"
+
+/**
+ * @brief An incomplete wrapper for the ring. Use it as a ptr.
+ */
+typedef struct _ring_s Ring;
+
+/**
+ * @brief Creates an empty ring.
+ *
+ * @param capacity max number of queued elements, rounded up to a power of two.
+ * @param elem_size size in bytes of an element.
+ * @return Ring* ptr to the ring, WITH OWNERSHIP, or NULL on error.
+ */
+Ring *ring_new(size_t capacity, size_t elem_size);
+
+/**
+ * @brief Frees the ring. Elements still queued are dropped.
+ *
+ * @param ring a ptr to the ring ptr. It will be set to NULL.
+ */
+void ring_del(Ring **ring);
+
+/**
+ * @brief Copies an element into the ring, waiting while it is full. Producer
+ * side only.
+ *
+ * @param ring ptr to the ring.
+ * @param elem ptr to the element.
+ * @return status_t \c SUCCESS, or \c NUL_ERR.
+ */
+status_t ring_push(Ring *ring, const void *elem);
+
+/**
+ * @brief Copies the oldest element out of the ring, waiting while it is
+ * empty. Consumer side only.
+ *
+ * @param ring ptr to the ring.
+ * @param elem ptr to where the element is copied.
+ * @return status_t \c SUCCESS, \c EOF_ERR if the ring is closed and drained,
+ * or \c NUL_ERR.
+ */
+status_t ring_pop(Ring *ring, void *elem);
+
+/**
+ * @brief Tells the consumer no more elements will be pushed. Producer side
+ * only.
+ *
+ * @param ring ptr to the ring.
+ */
+void ring_close(Ring *ring);
+
+/**
+ * @brief Checks, without waiting, if there is nothing to pop right now.
+ * Consumer side only.
+ *
+ * @param ring ptr to the ring.
+ * @return _Bool 1 if a pop would have to wait (or fail), 0 otherwise.
+ */
+_Bool ring_is_empty(Ring *ring);
+
+#endif // RING_H_INCLUDED
@@ -0,0 +1,64 @@
+/**
+ * @file threadpool.h
+ * @brief Header file for a fixed size pool of worker threads.
+ *
+ * Tasks are plain `void fn(void *arg)` calls executed in FIFO order by the
+ * first free worker. threadpool_wait() blocks until every submitted task has
+ * finished, which is all the synchronization the batch style users need.
+ */
+
+
+#ifndef THREADPOOL_H_INCLUDED
+#define THREADPOOL_H_INCLUDED
+
+#include <pthread.h>
+#include <stdlib.h>
+
+#include "tads/tad_types.h"
+
+/**
+ * @brief An incomplete wrapper for the thread pool. Use it as a ptr.
+ */
+typedef struct _threadpool_s ThreadPool;
+
+/**
+ * @brief Starts a pool with the given number of worker threads.
+ *
+ * @param threads number of workers. Zero is promoted to one.
+ * @return ThreadPool* ptr to the pool, WITH OWNERSHIP, or NULL on error.
+ */
+ThreadPool *threadpool_new(size_t threads);
+
+/**
+ * @brief Waits for the pending tasks, stops the workers and frees the pool.
+ *
+ * @param pool a ptr to the pool ptr. It will be set to NULL.
+ */
+void threadpool_del(ThreadPool **pool);
+
+/**
+ * @brief Queues a task.
+ *
+ * @param pool ptr to the pool.
+ * @param fn the task.
+ * @param arg opaque ptr forwarded to fn.
+ * @return status_t \c SUCCESS, \c NUL_ERR or \c ALLOC_ERR.
+ */
+status_t threadpool_submit(ThreadPool *pool, void (*fn)(void *), void *arg);
+
+/**
+ * @brief Blocks until every task submitted so far has finished.
+ *
+ * @param pool ptr to the pool.
+ */
+void threadpool_wait(ThreadPool *pool);
+
+/**
+ * @brief A getter to the number of workers.
+ *
+ * @param pool ptr to the pool.
+ * @return size_t the number of worker threads.
+ */
+size_t threadpool_size(const ThreadPool *pool);
+
+#endif // THREADPOOL_H_INCLUDED
@@ -0,0 +1,1406 @@
+#include <limits.h>
+
+#include "app/backend.h"
+
+//=============================================================================/
+//=================|    Data Structures     |==================================/
+//=============================================================================/
+
+/**
+ * @brief The writes not applied yet, see backend_buffer_enable(): the net
+ * change of every word written since the last flush, sorted by word.
+ */
+typedef struct {
+    skiplist_op_t *ops; // one per word: what the flush does to the lists
+    size_t count;
+    size_t room; // the flush threshold, 0 when the buffer is off
+} write_buffer_t;
+
+struct _backend_s {
+    backend_kind_t kind;
+    union {
+        SkipList *skiplist;
+        ShardList *shardlist;
+    } as;
+    FrontCoded *base; // words loaded front-coded, see backend_load_sorted()
+    size_t restart;   // entries per block of the base, 0 when it is off
+    item_buf_t found; // the last word found in the base or the value log
+    write_buffer_t buffer;
+    _Bool bounded; // lists with a max_length or max_bytes, see buffer_insert
+    _Bool read_only; // a replica's, see backend_read_only()
+
+    // Descriptions on disk, see backend_cold_enable()
+    ValueLog *log;
+    char *log_dir;
+    size_t cache_bytes;
+    uint64_t live; // size of the log right after its last compaction
+
+    // Told of every applied write, see backend_journal()
+    backend_journal_t journal;
+    void *journal_ctx;
+};
+
+/**
+ * @brief The items of the lists that start with a char, gathered to be
+ * merged with the words of the base.
+ */
+typedef struct {
+    Backend *backend;
+    FILE *out;
+    status_t (*fn)(Item *item, void *ctx); // instead of printing, if set
+    void *ctx;
+    Item **items;
+    size_t length;
+    size_t room;
+    size_t next;  // first item not visited yet
+    size_t count; // items visited
+} merge_t;
+
+/**
+ * @brief The walks of a compaction, see backend_compact(): the first one
+ * copies the descriptions of the cold items to a new log, the second one
+ * points the items to their copies, in the same order.
+ */
+typedef struct {
+    Backend *backend;
+    ValueLog *fresh;
+    uint64_t *refs; // of the copies
+    size_t length;
+    size_t room;
+    size_t next; // first copy not pointed to yet
+} compact_t;
+
+/**
+ * @brief The words gathered by backend_clear(), to be removed once the walk
+ * is over.
+ */
+typedef struct {
+    Item **keys;
+    size_t length;
+    size_t room;
+} clear_t;
+
+//=============================================================================/
+//=================|    Private Function Declarations     |====================/
+//=============================================================================/
+
+static _Bool backend_is_empty(const Backend *backend);
+static _Bool backend_buffering(const Backend *backend);
+static _Bool backend_in_base(const Backend *backend, const Item *item);
+static status_t backend_list_insert(Backend *backend, Item *item);
+static status_t backend_promote(Backend *backend, const Item *item);
+static status_t backend_store_insert(Backend *backend, Item *item);
+static status_t backend_store_update(Backend *backend, Item *item);
+static status_t backend_store_delete(Backend *backend, Item *item);
+static status_t backend_store_commit(Backend *backend, skiplist_op_t *ops,
+                                     size_t n);
+static Item *backend_store_search(Backend *backend, const Item *item);
+static Item *backend_take(Backend *backend, Item *item);
+static void backend_stamp(Backend *backend, Item *item);
+static _Bool backend_expired(const Backend *backend, const Item *item);
+
+static skiplist_op_t *buffer_find(const write_buffer_t *buffer,
+                                  const Item *item, size_t *pos);
+static skiplist_op_t *buffer_live(Backend *backend, const Item *item,
+                                  size_t *pos);
+static status_t buffer_add(Backend *backend, size_t pos,
+                           skiplist_op_kind_t kind, Item *item);
+static void buffer_drop(write_buffer_t *buffer, size_t pos);
+static status_t buffer_insert(Backend *backend, Item *item);
+static status_t buffer_update(Backend *backend, Item *item);
+static status_t buffer_delete(Backend *backend, Item *item);
+static Item *buffer_search(Backend *backend, const Item *item);
+static status_t buffer_replay(Backend *backend, skiplist_op_t *op);
+static status_t backend_merge(Backend *backend, merge_t *merge,
+                              const char c);
+static status_t merge_gather(Item *item, void *ctx);
+static status_t merge_visit(Item *item, void *ctx);
+static status_t merge_print(merge_t *merge, const Item *item);
+
+static _Bool op_applied(status_t flag, const skiplist_op_t *op);
+static status_t backend_chill(Backend *backend, const Item *item, Item **cold);
+static Item *backend_fetch(Backend *backend, const Item *item,
+                           item_buf_t *buf);
+static Item *backend_warm(Backend *backend, Item *item);
+static status_t backend_chill_ops(Backend *backend, skiplist_op_t *ops,
+                                  size_t n, Item **whole);
+static void backend_warm_ops(Backend *backend, status_t flag,
+                             skiplist_op_t *ops, size_t n, Item **whole);
+static void backend_maintain(Backend *backend);
+static status_t backend_lists_foreach(Backend *backend,
+                                      status_t (*fn)(Item *item, void *ctx),
+                                      void *ctx);
+static void backend_record(Backend *backend, skiplist_op_kind_t kind,
+                           const Item *item);
+static void backend_dropped(void *ctx, const Item *item);
+static status_t compact_copy(Item *item, void *ctx);
+static status_t compact_point(Item *item, void *ctx);
+static status_t clear_gather(Item *item, void *ctx);
+
+//=============================================================================/
+//=================|    Public Function Implementations     |==================/
+//=============================================================================/
+
+Backend *backend_new_skiplist(const skiplist_config_t *config) {
+    Backend *backend = (Backend *)malloc(sizeof(Backend));
+    if (NULL == backend) return NULL;
+
+    *backend = (Backend){.kind = BACKEND_SKIPLIST};
+    backend->as.skiplist = skiplist_new_with_config(config);
+    if (backend->as.skiplist) {
+        skiplist_config_t c = skiplist_config(backend->as.skiplist);
+        backend->bounded = c.max_length || c.max_bytes;
+    }
+    if (NULL == backend->as.skiplist) backend_del(&backend);
+    return backend;
+}
+
+Backend *backend_new_sharded(size_t shards, size_t threads,
+                             const skiplist_config_t *config) {
+    Backend *backend = (Backend *)malloc(sizeof(Backend));
+    if (NULL == backend) return NULL;
+
+    skiplist_config_t c = config ? *config : skiplist_config_default();
+    *backend = (Backend){.kind = BACKEND_SHARDED};
+    backend->bounded = c.max_length || c.max_bytes;
+    backend->as.shardlist = shardlist_new(shards, threads, config);
+    if (NULL == backend->as.shardlist) backend_del(&backend);
+    return backend;
+}
+
+void backend_del(Backend **backend) {
+    if (NULL == backend || NULL == *backend) return;
+
+    switch ((*backend)->kind) {
+    case BACKEND_SKIPLIST: skiplist_del(&(*backend)->as.skiplist); break;
+    case BACKEND_SHARDED: shardlist_del(&(*backend)->as.shardlist); break;
+    }
+
+    // Writes still buffered are dropped with the rest
+    write_buffer_t *buffer = &(*backend)->buffer;
+    for (size_t i = 0; i < buffer->count; i++)
+        item_del(&buffer->ops[i].item);
+    free(buffer->ops);
+
+    frontcoded_del(&(*backend)->base);
+    valuelog_del(&(*backend)->log);
+    free((*backend)->log_dir);
+    free(*backend);
+    *backend = NULL;
+}
+
+backend_kind_t backend_kind(const Backend *backend) { return backend->kind; }
+
+skiplist_config_t backend_config(const Backend *backend) {
+    if (NULL == backend) return skiplist_config_default();
+    switch (backend->kind) {
+    case BACKEND_SKIPLIST: return skiplist_config(backend->as.skiplist);
+    case BACKEND_SHARDED: return shardlist_config(backend->as.shardlist);
+    }
+    return skiplist_config_default();
+}
+
+status_t backend_index_enable(Backend *backend) {
+    if (NULL == backend) return NUL_ERR;
+    switch (backend->kind) {
+    case BACKEND_SKIPLIST: return skiplist_index_enable(backend->as.skiplist);
+    case BACKEND_SHARDED: return shardlist_index_enable(backend->as.shardlist);
+    }
+    return CRITICAL_ERR;
+}
+
+status_t backend_bloom_enable(Backend *backend, double fp_rate) {
+    if (NULL == backend) return NUL_ERR;
+    switch (backend->kind) {
+    case BACKEND_SKIPLIST:
+        return skiplist_bloom_enable(backend->as.skiplist, fp_rate);
+    case BACKEND_SHARDED:
+        return shardlist_bloom_enable(backend->as.shardlist, fp_rate);
+    }
+    return CRITICAL_ERR;
+}
+
+status_t backend_adaptive_enable(Backend *backend) {
+    if (NULL == backend) return NUL_ERR;
+    switch (backend->kind) {
+    case BACKEND_SKIPLIST: return skiplist_adaptive_enable(backend->as.skiplist);
+    case BACKEND_SHARDED: return shardlist_adaptive_enable(backend->as.shardlist);
+    }
+    return CRITICAL_ERR;
+}
+
+status_t backend_lazy_enable(Backend *backend, double ratio) {
+    if (NULL == backend) return NUL_ERR;
+    switch (backend->kind) {
+    case BACKEND_SKIPLIST:
+        return skiplist_lazy_enable(backend->as.skiplist, ratio);
+    case BACKEND_SHARDED:
+        return shardlist_lazy_enable(backend->as.shardlist, ratio);
+    }
+    return CRITICAL_ERR;
+}
+
+status_t backend_front_code_enable(Backend *backend, size_t restart) {
+    if (NULL == backend) return NUL_ERR;
+    backend->restart = restart ? restart : FRONTCODED_RESTART;
+    return SUCCESS;
+}
+
+status_t backend_buffer_enable(Backend *backend, size_t size) {
+    if (NULL == backend) return NUL_ERR;
+    if (0 == size) size = BACKEND_BUFFER_SIZE;
+
+    status_t flag = backend_flush(backend);
+    if (SUCCESS != flag) return flag; // err handling
+
+    skiplist_op_t *ops =
+        (skiplist_op_t *)realloc(backend->buffer.ops, size * sizeof(*ops));
+    if (NULL == ops) return ALLOC_ERR; // err handling
+
+    backend->buffer = (write_buffer_t){.ops = ops, .room = size};
+    return SUCCESS;
+}
+
+status_t backend_cold_enable(Backend *backend, const char *dir,
+                             size_t cache_bytes) {
+    if (NULL == backend) return NUL_ERR;
+    if (backend->log) return SUCCESS;
+
+    backend->log_dir = dir ? strdup(dir) : NULL;
+    backend->log = valuelog_new(dir, cache_bytes);
+    if (NULL == backend->log || (dir && NULL == backend->log_dir)) {
+        valuelog_del(&backend->log); // err handling
+        free(backend->log_dir);
+        backend->log_dir = NULL;
+        return ALLOC_ERR;
+    }
+
+    backend->cache_bytes = cache_bytes;
+    backend->live = 0;
+    return SUCCESS;
+}
+
+status_t backend_compact(Backend *backend) {
+    if (NULL == backend) return NUL_ERR;
+    if (NULL == backend->log) return SUCCESS;
+
+    compact_t compact = (compact_t){.backend = backend};
+    compact.fresh = valuelog_new(backend->log_dir, backend->cache_bytes);
+    if (NULL == compact.fresh) return ALLOC_ERR; // err handling
+
+    // PART 1: the live descriptions to the new log, in word order, so the
+    // prints read it sequentially
+    status_t flag = backend_lists_foreach(backend, compact_copy, &compact);
+    if (SUCCESS != flag) { // err handling: the items still use the old log
+        valuelog_del(&compact.fresh);
+        free(compact.refs);
+        return flag;
+    }
+
+    // PART 2: nothing can fail from here on
+    backend_lists_foreach(backend, compact_point, &compact);
+    free(compact.refs);
+
+    valuelog_del(&backend->log);
+    backend->log = compact.fresh;
+    backend->live = valuelog_size(backend->log);
+    return SUCCESS;
+}
+
+status_t backend_flush(Backend *backend) {
+    if (NULL == backend) return NUL_ERR;
+    write_buffer_t *buffer = &backend->buffer;
+
+    // PART 1: the words that expired in the buffer go, as from the lists
+    size_t kept = 0;
+    for (size_t i = 0; i < buffer->count; i++) {
+        skiplist_op_t *op = &buffer->ops[i];
+        if (SKIPLIST_INSERT == op->kind && backend_expired(backend, op->item))
+            item_del(&op->item);
+        else buffer->ops[kept++] = *op;
+    }
+    buffer->count = kept;
+    if (0 == buffer->count) return SUCCESS;
+
+    // PART 2: every word in one sorted sweep of each list
+    status_t flag = backend_store_commit(backend, buffer->ops, buffer->count);
+
+    // PART 3: what the sweep did not apply goes one word at a time. The ops
+    // were checked when they were buffered, but the lists may have changed
+    // since: words expired or evicted. What finds no memory stays.
+    status_t result = SUCCESS;
+    kept = 0;
+    for (size_t i = 0; i < buffer->count; i++) {
+        skiplist_op_t *op = &buffer->ops[i];
+        if (op_applied(flag, op)) {
+            if (SKIPLIST_INSERT != op->kind) item_del(&op->item);
+            item_del(&op->result);
+            continue;
+        }
+
+        status_t status = buffer_replay(backend, op);
+        if (SUCCESS == status) continue;
+        result = status; // err handling
+        if (ALLOC_ERR == status)
+            buffer->ops[kept++] =
+                (skiplist_op_t){.kind = op->kind, .item = op->item};
+    }
+
+    buffer->count = kept;
+    return result;
+}
+
+status_t backend_freeze(Backend *backend) {
+    if (NULL == backend) return NUL_ERR;
+    backend_flush(backend); // a write would thaw the lists right away
+    switch (backend->kind) {
+    case BACKEND_SKIPLIST: return skiplist_freeze(backend->as.skiplist);
+    case BACKEND_SHARDED: return shardlist_freeze(backend->as.shardlist);
+    }
+    return CRITICAL_ERR;
+}
+
+status_t backend_insert(Backend *backend, Item *item) {
+    if (NULL == backend) return NUL_ERR;
+    if (backend->read_only) return READ_ONLY_ERR;
+    backend_maintain(backend);
+
+    // The stored item may be freed by then (see backend_list_insert()): the
+    // journal is told of a copy
+    item_buf_t copy;
+    const Item *told = backend->journal ? item_clone_into(&copy, item) : NULL;
+
+    status_t flag = backend_buffering(backend) ? buffer_insert(backend, item)
+                                         : backend_store_insert(backend, item);
+    if (SUCCESS == flag) backend_record(backend, SKIPLIST_INSERT, told);
+    return flag;
+}
+
+status_t backend_insert_batch(Backend *backend, Item **items,
+                              status_t *results, size_t n) {
+    if (NULL == backend || NULL == items || NULL == results) return NUL_ERR;
+    if (backend->read_only) return READ_ONLY_ERR;
+
+    // A single skiplist has nothing to parallelize, the shards must see the
+    // buffered writes, the value log takes one description at a time, and
+    // the journal is told of every write in order
+    if (BACKEND_SKIPLIST == backend->kind || backend_buffering(backend) ||
+        backend->log || backend->journal) {
+        for (size_t i = 0; i < n; i++)
+            results[i] = backend_insert(backend, items[i]);
+        return SUCCESS;
+    }
+
+    shard_op_t *ops = (shard_op_t *)malloc(n * sizeof(shard_op_t));
+    if (NULL == ops && n > 0) return ALLOC_ERR;
+
+    // Words of the base are repeated: they stay out of the shards
+    size_t m = 0;
+    for (size_t i = 0; i < n; i++)
+        if (!backend_in_base(backend, items[i]))
+            ops[m++] = (shard_op_t){.kind = SHARD_INSERT, .item = items[i]};
+
+    status_t flag = shardlist_apply(backend->as.shardlist, ops, m);
+    for (size_t i = 0, j = 0; SUCCESS == flag && i < n; i++)
+        results[i] = j < m && ops[j].item == items[i] ? ops[j++].status
+                                                      : REPEATED_ENTRY_ERR;
+
+    free(ops);
+    return flag;
+}
+
+status_t backend_load_sorted(Backend *backend, Item **items, size_t n,
+                             ThreadPool *pool) {
+    if (NULL == backend || (NULL == items && n > 0)) return NUL_ERR;
+    backend_flush(backend); // the lists may turn out empty
+
+    // Packed words, the lists are left for the writes
+    if (backend->restart && NULL == backend->base &&
+        backend_is_empty(backend)) {
+        backend->base = frontcoded_new(items, n, backend->restart);
+        if (backend->base) {
+            for (size_t i = 0; i < n; i++) item_del(&items[i]);
+            return SUCCESS;
+        }
+    }
+
+    // Descriptions to the log, in the order of the words. One that cannot
+    // be written stays in its item.
+    for (size_t i = 0; backend->log && i < n; i++) {
+        Item *cold = NULL;
+        if (SUCCESS == backend_chill(backend, items[i], &cold) && cold) {
+            item_del(&items[i]);
+            items[i] = cold;
+        }
+    }
+    if (backend->log) backend->live = valuelog_size(backend->log); // no garbage
+
+    // Bottom-up builds, only possible on empty containers
+    if (BACKEND_SKIPLIST == backend->kind &&
+        skiplist_is_empty(backend->as.skiplist)) {
+        SkipList *built = skiplist_from_sorted(items, n, pool);
+        if (built) {
+            status_t flag =
+                skiplist_inherit_options(built, backend->as.skiplist);
+            skiplist_del(&backend->as.skiplist);
+            backend->as.skiplist = built;
+            return flag;
+        }
+    }
+
+    if (BACKEND_SHARDED == backend->kind &&
+        0 == shardlist_length(backend->as.shardlist))
+        return shardlist_load_sorted(backend->as.shardlist, items, n);
+
+    // Fallback: one by one, past the write buffer
+    status_t result = SUCCESS;
+    for (size_t i = 0; i < n; i++) {
+        status_t flag = backend_store_insert(backend, items[i]);
+        if (SUCCESS != flag) {
+            item_del(&items[i]);
+            result = flag;
+        }
+    }
+    return result;
+}
+
+status_t backend_update(Backend *backend, Item *item) {
+    if (NULL == backend) return NUL_ERR;
+    if (backend->read_only) return READ_ONLY_ERR;
+    backend_maintain(backend);
+
+    status_t flag = backend_buffering(backend) ? buffer_update(backend, item)
+                                         : backend_store_update(backend, item);
+    if (SUCCESS == flag) backend_record(backend, SKIPLIST_UPDATE, item);
+    return flag;
+}
+
+Item *backend_remove(Backend *backend, Item *item) {
+    if (NULL == backend || backend->read_only) return NULL;
+    backend_maintain(backend);
+
+    Item *removed = backend_take(backend, item);
+    if (removed) backend_record(backend, SKIPLIST_REMOVE, item);
+    return removed;
+}
+
+status_t backend_delete(Backend *backend, Item *item) {
+    if (NULL == backend) return NUL_ERR;
+    if (backend->read_only) return READ_ONLY_ERR;
+    backend_maintain(backend);
+
+    status_t flag = backend_buffering(backend) ? buffer_delete(backend, item)
+                                         : backend_store_delete(backend, item);
+    if (SUCCESS == flag) backend_record(backend, SKIPLIST_REMOVE, item);
+    return flag;
+}
+
+status_t backend_commit(Backend *backend, skiplist_op_t *ops, size_t n) {
+    if (NULL == backend || (NULL == ops && n > 0)) return NUL_ERR;
+    if (backend->read_only) return READ_ONLY_ERR;
+
+    // The batch is checked against the lists: they take the buffer first
+    backend_maintain(backend);
+    status_t flag = backend_flush(backend);
+    if (SUCCESS != flag) return flag; // err handling
+
+    // As in backend_insert(), the journal is told of copies of the inserts
+    item_buf_t *copies = NULL;
+    if (backend->journal && n > 0) {
+        copies = (item_buf_t *)malloc(n * sizeof(item_buf_t));
+        if (NULL == copies) return ALLOC_ERR; // err handling
+        for (size_t i = 0; i < n; i++)
+            if (SKIPLIST_INSERT == ops[i].kind)
+                item_clone_into(&copies[i], ops[i].item);
+    }
+
+    flag = backend_store_commit(backend, ops, n);
+    for (size_t i = 0; copies && i < n; i++) {
+        if (!op_applied(flag, &ops[i])) continue;
+        backend_record(backend, ops[i].kind,
+                       SKIPLIST_INSERT == ops[i].kind ? item_in(&copies[i])
+                                                      : ops[i].item);
+    }
+
+    free(copies);
+    return flag;
+}
+
+Item *backend_search(Backend *backend, const Item *item) {
+    if (NULL == backend) return NULL;
+    if (backend->buffer.room) return buffer_search(backend, item);
+    return backend_store_search(backend, item);
+}
+
+status_t backend_foreach(Backend *backend,
+                         status_t (*fn)(Item *item, void *ctx), void *ctx) {
+    if (NULL == backend || NULL == fn) return NUL_ERR;
+    backend_flush(backend);
+    if (NULL == backend->base && NULL == backend->log)
+        return backend_lists_foreach(backend, fn, ctx);
+
+    // Char by char, as the merged prints
+    status_t flag = SUCCESS;
+    for (int c = 1; SUCCESS == flag && c <= UCHAR_MAX; c++) {
+        merge_t merge = (merge_t){.backend = backend, .fn = fn, .ctx = ctx};
+        flag = backend_merge(backend, &merge, (char)c);
+    }
+    return flag;
+}
+
+void backend_journal(Backend *backend, backend_journal_t fn, void *ctx) {
+    if (NULL == backend) return;
+    if (fn) backend_flush(backend); // the writes skip it from now on
+    backend->journal = fn;
+    backend->journal_ctx = ctx;
+
+    // The words the lists drop on their own are removals too
+    void (*drop)(void *, const Item *) = fn ? backend_dropped : NULL;
+    switch (backend->kind) {
+    case BACKEND_SKIPLIST:
+        skiplist_on_drop(backend->as.skiplist, drop, backend);
+        break;
+    case BACKEND_SHARDED:
+        shardlist_on_drop(backend->as.shardlist, drop, backend);
+        break;
+    }
+}
+
+void backend_read_only(Backend *backend, _Bool on) {
+    if (NULL == backend) return;
+    backend->read_only = on;
+}
+
+status_t backend_replay(Backend *backend, skiplist_op_kind_t kind,
+                        Item *item) {
+    if (NULL == backend || NULL == item) return NUL_ERR;
+
+    _Bool read_only = backend->read_only;
+    backend->read_only = 0;
+    status_t flag = CRITICAL_ERR;
+    switch (kind) {
+    case SKIPLIST_INSERT: flag = backend_insert(backend, item); break;
+    case SKIPLIST_UPDATE: flag = backend_update(backend, item); break;
+    case SKIPLIST_REMOVE: flag = backend_delete(backend, item); break;
+    }
+    backend->read_only = read_only;
+    return flag;
+}
+
+status_t backend_clear(Backend *backend) {
+    if (NULL == backend) return NUL_ERR;
+
+    // PART 1: the words, wherever they are. No write during the walk.
+    clear_t clear = (clear_t){0};
+    status_t flag = backend_foreach(backend, clear_gather, &clear);
+
+    // PART 2: each one removed, those that expired meanwhile already are
+    for (size_t i = 0; i < clear.length; i++) {
+        if (SUCCESS == flag) {
+            status_t status =
+                backend_replay(backend, SKIPLIST_REMOVE, clear.keys[i]);
+            if (SUCCESS != status && NOT_FOUND_ERR != status)
+                flag = status; // err handling
+        }
+        item_del(&clear.keys[i]);
+    }
+
+    free(clear.keys);
+    return flag;
+}
+
+status_t backend_print(Backend *backend, FILE *out, const char c) {
+    if (NULL == backend) return NUL_ERR;
+    backend_flush(backend); // the lists print in order, the buffer does not
+    if (backend->base || backend->log) {
+        // An empty dictionary prints nothing, as skiplist_fprint() does
+        if (backend_is_empty(backend) && 0 == frontcoded_length(backend->base))
+            return ERROR;
+        merge_t merge = (merge_t){.backend = backend, .out = out};
+        status_t flag = backend_merge(backend, &merge, c);
+        if (SUCCESS == flag && 0 == merge.count)
+            fprintf(out, "NAO HA PALAVRAS INICIADAS POR %c\n", c);
+        return flag;
+    }
+    switch (backend->kind) {
+    case BACKEND_SKIPLIST: return skiplist_fprint(out, backend->as.skiplist, c);
+    case BACKEND_SHARDED: return shardlist_fprint(out, backend->as.shardlist, c);
+    }
+    return CRITICAL_ERR;
+}
+
+void backend_debug(const Backend *backend, FILE *out) {
+    if (NULL == backend) return;
+    switch (backend->kind) {
+    case BACKEND_SKIPLIST:
+        skiplist_memory_fprint(out, backend->as.skiplist);
+        break;
+    case BACKEND_SHARDED:
+        shardlist_memory_fprint(out, backend->as.shardlist);
+        break;
+    }
+    frontcoded_memory_fprint(out, backend->base);
+    valuelog_memory_fprint(out, backend->log);
+    if (backend->buffer.room)
+        fprintf(out, "write buffer: %zu of %zu words\n", backend->buffer.count,
+                backend->buffer.room);
+}
+
+//=============================================================================/
+//=================|    Private Function Implementations    |==================/
+//=============================================================================/
+
+/**
+ * @brief Inserts an item in the lists, unless its word is in the base.
+ */
+static status_t backend_store_insert(Backend *backend, Item *item) {
+    if (backend_in_base(backend, item)) return REPEATED_ENTRY_ERR;
+    return backend_list_insert(backend, item);
+}
+
+/**
+ * @brief Updates an item in the lists or, moving it to them, in the base.
+ */
+static status_t backend_store_update(Backend *backend, Item *item) {
+    // Cold items only take cold descriptions, see item_raw_update()
+    Item *cold = NULL;
+    status_t flag = backend_chill(backend, item, &cold);
+    if (SUCCESS != flag) return flag; // err handling
+
+    switch (backend->kind) {
+    case BACKEND_SKIPLIST:
+        flag = skiplist_update(backend->as.skiplist, cold ? cold : item);
+        break;
+    case BACKEND_SHARDED:
+        flag = shardlist_update(backend->as.shardlist, cold ? cold : item);
+        break;
+    }
+    item_del(&cold);
+    if (NOT_FOUND_ERR != flag || !backend_in_base(backend, item)) return flag;
+
+    // A word of the base moves to the lists with its new description
+    Item *copy = item_clone(item);
+    if (NULL == copy) return ALLOC_ERR; // err handling
+
+    flag = backend_list_insert(backend, copy);
+    if (SUCCESS != flag) { // err handling
+        item_del(&copy);
+        return flag;
+    }
+    return frontcoded_forget(backend->base, item);
+}
+
+/**
+ * @brief Deletes an item from the lists or, if it is there, from the base.
+ */
+static status_t backend_store_delete(Backend *backend, Item *item) {
+    status_t flag = CRITICAL_ERR;
+    switch (backend->kind) {
+    case BACKEND_SKIPLIST:
+        flag = skiplist_delete(backend->as.skiplist, item);
+        break;
+    case BACKEND_SHARDED:
+        flag = shardlist_delete(backend->as.shardlist, item);
+        break;
+    }
+    if (NOT_FOUND_ERR != flag || NULL == backend->base) return flag;
+
+    return frontcoded_forget(backend->base, item);
+}
+
+/**
+ * @brief Applies a batch to the lists, see backend_commit().
+ */
+static status_t backend_store_commit(Backend *backend, skiplist_op_t *ops,
+                                     size_t n) {
+    // The lists check the whole batch, so the words of the base join them
+    for (size_t i = 0; i < n; i++) {
+        status_t flag = backend_promote(backend, ops[i].item);
+        if (SUCCESS != flag) return flag; // err handling
+    }
+
+    // The lists take cold copies of the new descriptions
+    Item **whole = NULL;
+    if (backend->log && n > 0) {
+        whole = (Item **)malloc(n * sizeof(Item *));
+        if (NULL == whole) return ALLOC_ERR; // err handling
+        status_t flag = backend_chill_ops(backend, ops, n, whole);
+        if (SUCCESS != flag) { // err handling
+            free(whole);
+            return flag;
+        }
+    }
+
+    status_t flag = CRITICAL_ERR;
+    switch (backend->kind) {
+    case BACKEND_SKIPLIST:
+        flag = skiplist_commit(backend->as.skiplist, ops, n);
+        break;
+    case BACKEND_SHARDED:
+        flag = shardlist_commit(backend->as.shardlist, ops, n);
+        break;
+    }
+
+    if (whole) backend_warm_ops(backend, flag, ops, n, whole);
+    free(whole);
+    return flag;
+}
+
+/**
+ * @brief Searches the lists, then the base.
+ */
+static Item *backend_store_search(Backend *backend, const Item *item) {
+    Item *found = NULL;
+    switch (backend->kind) {
+    case BACKEND_SKIPLIST:
+        found = skiplist_lookup(backend->as.skiplist, item);
+        break;
+    case BACKEND_SHARDED:
+        found = shardlist_search(backend->as.shardlist, item);
+        break;
+    }
+    if (found) return backend_fetch(backend, found, &backend->found);
+    if (NULL == backend->base) return NULL;
+
+    return frontcoded_get(backend->base, item, &backend->found);
+}
+
+/**
+ * @brief Checks if the lists of a backend hold no item.
+ */
+static _Bool backend_is_empty(const Backend *backend) {
+    switch (backend->kind) {
+    case BACKEND_SKIPLIST: return skiplist_is_empty(backend->as.skiplist);
+    case BACKEND_SHARDED: return 0 == shardlist_length(backend->as.shardlist);
+    }
+    return 0;
+}
+
+/**
+ * @brief Checks if the word of an item is in the front-coded base.
+ */
+static _Bool backend_in_base(const Backend *backend, const Item *item) {
+    if (NULL == backend->base || NULL == item) return 0;
+    item_buf_t buf;
+    return NULL != frontcoded_get(backend->base, item, &buf);
+}
+
+/**
+ * @brief Inserts an item in the lists, without looking at the base.
+ */
+static status_t backend_list_insert(Backend *backend, Item *item) {
+    Item *cold = NULL;
+    status_t flag = backend_chill(backend, item, &cold);
+    if (SUCCESS != flag) return flag; // err handling
+
+    Item *stored = cold ? cold : item;
+    switch (backend->kind) {
+    case BACKEND_SKIPLIST:
+        flag = skiplist_insert(backend->as.skiplist, stored);
+        break;
+    case BACKEND_SHARDED:
+        flag = shardlist_insert(backend->as.shardlist, stored);
+        break;
+    }
+
+    // The lists own the cold copy, and with it the item
+    if (cold) item_del(SUCCESS == flag ? &item : &cold);
+    return flag;
+}
+
+/**
+ * @brief Moves a word of the base, if the item has one, to the lists with
+ * its description: the dictionary reads the same afterwards.
+ */
+static status_t backend_promote(Backend *backend, const Item *item) {
+    if (!backend_in_base(backend, item)) return SUCCESS;
+
+    item_buf_t buf;
+    Item *copy = item_clone(frontcoded_get(backend->base, item, &buf));
+    if (NULL == copy) return ALLOC_ERR; // err handling
+
+    status_t flag = backend_list_insert(backend, copy);
+    if (SUCCESS != flag) { // err handling
+        item_del(&copy);
+        return flag;
+    }
+    return frontcoded_forget(backend->base, item);
+}
+
+/**
+ * @brief Checks if the writes go through the write buffer. They skip it
+ * while a journal is told of them: the buffer applies them out of order,
+ * after the words the lists drop in the meantime.
+ */
+static _Bool backend_buffering(const Backend *backend) {
+    return backend->buffer.room && !backend->journal;
+}
+
+/**
+ * @brief Removes an item wherever it is: the write buffer, the lists or the
+ * base, see backend_remove().
+ */
+static Item *backend_take(Backend *backend, Item *item) {
+    // The buffered word stays until the flush: the caller gets a copy
+    if (backend_buffering(backend)) {
+        Item *copy = item_clone(buffer_search(backend, item));
+        if (copy && SUCCESS != buffer_delete(backend, item)) item_del(&copy);
+        return copy;
+    }
+
+    Item *removed = NULL;
+    switch (backend->kind) {
+    case BACKEND_SKIPLIST:
+        removed = skiplist_remove(backend->as.skiplist, item);
+        break;
+    case BACKEND_SHARDED:
+        removed = shardlist_remove(backend->as.shardlist, item);
+        break;
+    }
+    if (removed) return backend_warm(backend, removed);
+    if (NULL == backend->base) return NULL;
+
+    // Words of the base leave as copies
+    item_buf_t buf;
+    Item *found = frontcoded_get(backend->base, item, &buf);
+    if (NULL == found) return NULL;
+
+    removed = item_clone(found);
+    if (removed) frontcoded_forget(backend->base, item);
+    return removed;
+}
+
+
+
+/**
+ * @brief Visits the words that start with c, from the lists and the base
+ * alike, in order, see merge_t.
+ */
+static status_t backend_merge(Backend *backend, merge_t *merge,
+                              const char c) {
+    status_t flag = CRITICAL_ERR;
+    switch (backend->kind) {
+    case BACKEND_SKIPLIST:
+        flag = skiplist_foreach_char(backend->as.skiplist, c, merge_gather,
+                                     merge);
+        break;
+    case BACKEND_SHARDED:
+        flag = shardlist_foreach_char(backend->as.shardlist, c, merge_gather,
+                                      merge);
+        break;
+    }
+
+    if (SUCCESS == flag && backend->base)
+        flag = frontcoded_foreach_char(backend->base, c, merge_visit, merge);
+    while (SUCCESS == flag && merge->next < merge->length)
+        flag = merge_print(merge, merge->items[merge->next++]);
+
+    free(merge->items);
+    return flag;
+}
+
+/**
+ * @brief Visitor that gathers the items of the lists, see merge_t.
+ */
+static status_t merge_gather(Item *item, void *ctx) {
+    merge_t *merge = (merge_t *)ctx;
+    if (merge->length == merge->room) {
+        size_t room = merge->room ? 2 * merge->room : 16;
+        Item **items = (Item **)realloc(merge->items, room * sizeof(Item *));
+        if (NULL == items) return ALLOC_ERR; // err handling
+        merge->items = items;
+        merge->room = room;
+    }
+    merge->items[merge->length++] = item;
+    return SUCCESS;
+}
+
+/**
+ * @brief Visitor of the base: prints the gathered items that come before a
+ * word, then the word.
+ */
+static status_t merge_visit(Item *item, void *ctx) {
+    merge_t *merge = (merge_t *)ctx;
+    while (merge->next < merge->length &&
+           item_cmp(merge->items[merge->next], item) < 0) {
+        status_t flag = merge_print(merge, merge->items[merge->next++]);
+        if (SUCCESS != flag) return flag;
+    }
+
+    return merge_print(merge, item);
+}
+
+/**
+ * @brief Prints an item on a line of its own, or hands it to the visitor,
+ * with its description read back from the value log if it is cold.
+ */
+static status_t merge_print(merge_t *merge, const Item *item) {
+    item_buf_t buf;
+    Item *whole = backend_fetch(merge->backend, item, &buf);
+    if (NULL == whole) return CRITICAL_ERR; // err handling
+
+    merge->count++;
+    if (merge->fn) return merge->fn(whole, merge->ctx);
+
+    item_fprint(merge->out, whole);
+    fprintf(merge->out, "\n");
+    return SUCCESS;
+}
+
+/**
+ * @brief Searches the buffered op of a word.
+ *
+ * @param buffer ptr to the buffer.
+ * @param item the key: only its word is read.
+ * @param pos set to the slot of the op, or to where it would go.
+ * @return skiplist_op_t* the op, or NULL if the word has none.
+ */
+static skiplist_op_t *buffer_find(const write_buffer_t *buffer,
+                                  const Item *item, size_t *pos) {
+    size_t lo = 0, hi = buffer->count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        int cmp = item_cmp(buffer->ops[mid].item, item);
+        if (0 == cmp) {
+            *pos = mid;
+            return &buffer->ops[mid];
+        }
+        if (cmp < 0) lo = mid + 1;
+        else hi = mid;
+    }
+
+    *pos = lo;
+    return NULL;
+}
+
+/**
+ * @brief Searches the buffered op of a word, see buffer_find(). An insert
+ * whose word expired is dropped first, as the lists would drop it.
+ */
+static skiplist_op_t *buffer_live(Backend *backend, const Item *item,
+                                  size_t *pos) {
+    skiplist_op_t *op = buffer_find(&backend->buffer, item, pos);
+    if (NULL == op || SKIPLIST_INSERT != op->kind ||
+        !backend_expired(backend, op->item))
+        return op;
+
+    item_del(&op->item);
+    buffer_drop(&backend->buffer, *pos);
+    return NULL;
+}
+
+/**
+ * @brief Buffers the op of a new word, WITH OWNERSHIP of its item, and
+ * flushes the buffer once it is full.
+ *
+ * @return status_t \c SUCCESS, as the op was taken: the ones before it
+ * apply at the flush, or stay buffered out of memory. If those fill the
+ * buffer, the op is refused with the error of the flush instead, and its
+ * item is left to the caller.
+ */
+static status_t buffer_add(Backend *backend, size_t pos,
+                           skiplist_op_kind_t kind, Item *item) {
+    write_buffer_t *buffer = &backend->buffer;
+    if (buffer->count == buffer->room) {
+        status_t flag = backend_flush(backend);
+        if (buffer->count == buffer->room) // err handling
+            return SUCCESS == flag ? ALLOC_ERR : flag;
+        buffer_find(buffer, item, &pos);
+    }
+
+    memmove(buffer->ops + pos + 1, buffer->ops + pos,
+            (buffer->count - pos) * sizeof(skiplist_op_t));
+    buffer->ops[pos] = (skiplist_op_t){.kind = kind, .item = item};
+    buffer->count++;
+
+    if (buffer->count == buffer->room) backend_flush(backend);
+    return SUCCESS;
+}
+
+/**
+ * @brief Takes the op of a slot out of the buffer, without freeing it.
+ */
+static void buffer_drop(write_buffer_t *buffer, size_t pos) {
+    buffer->count--;
+    memmove(buffer->ops + pos, buffer->ops + pos + 1,
+            (buffer->count - pos) * sizeof(skiplist_op_t));
+}
+
+/**
+ * @brief backend_insert() with the buffer on.
+ */
+static status_t buffer_insert(Backend *backend, Item *item) {
+    if (NULL == item) return NUL_ERR;
+
+    size_t pos;
+    skiplist_op_t *op = buffer_live(backend, item, &pos);
+    if (op && SKIPLIST_REMOVE != op->kind) return REPEATED_ENTRY_ERR;
+    if (NULL == op && backend_store_search(backend, item))
+        return REPEATED_ENTRY_ERR;
+
+    // Its time to live starts now, not at the flush
+    backend_stamp(backend, item);
+
+    // Removed and inserted again: the flush only sees the new value. Unless
+    // the old word goes first: an update would keep its deadline, and a
+    // bounded list may evict it in the meantime.
+    if (op && !backend->bounded && 0 == item_expiry(item)) {
+        item_del(&op->item);
+        *op = (skiplist_op_t){.kind = SKIPLIST_UPDATE, .item = item};
+        return SUCCESS;
+    }
+    if (op) {
+        status_t flag = backend_store_delete(backend, op->item);
+        if (SUCCESS != flag && NOT_FOUND_ERR != flag)
+            return flag; // err handling
+        item_del(&op->item);
+        buffer_drop(&backend->buffer, pos);
+    }
+
+    // Only a bounded list knows if it has room for the word: it is asked
+    // now, so that the write is refused, not lost at the flush
+    if (backend->bounded) return backend_store_insert(backend, item);
+    return buffer_add(backend, pos, SKIPLIST_INSERT, item);
+}
+
+/**
+ * @brief backend_update() with the buffer on. Words that are not buffered
+ * are updated in place, without a structural change to buffer.
+ */
+static status_t buffer_update(Backend *backend, Item *item) {
+    if (NULL == item) return NUL_ERR;
+
+    size_t pos;
+    skiplist_op_t *op = buffer_live(backend, item, &pos);
+    if (NULL == op) return backend_store_update(backend, item);
+    if (SKIPLIST_REMOVE == op->kind) return NOT_FOUND_ERR;
+
+    item_raw_update(op->item, item);
+    return SUCCESS;
+}
+
+/**
+ * @brief backend_delete() with the buffer on.
+ */
+static status_t buffer_delete(Backend *backend, Item *item) {
+    if (NULL == item) return NUL_ERR;
+
+    size_t pos;
+    skiplist_op_t *op = buffer_live(backend, item, &pos);
+    if (op) {
+        switch (op->kind) {
+        case SKIPLIST_REMOVE: return NOT_FOUND_ERR;
+        case SKIPLIST_INSERT: // the lists never see the word
+            item_del(&op->item);
+            buffer_drop(&backend->buffer, pos);
+            return SUCCESS;
+        case SKIPLIST_UPDATE: // its item is now only the key
+            op->kind = SKIPLIST_REMOVE;
+            return SUCCESS;
+        }
+    }
+
+    Item *found = backend_store_search(backend, item);
+    if (NULL == found) return NOT_FOUND_ERR;
+
+    const char *word = item_word(found);
+    Item *key = item_new_from(word, strlen(word), NULL, 0);
+    if (NULL == key) return ALLOC_ERR; // err handling
+
+    status_t flag = buffer_add(backend, pos, SKIPLIST_REMOVE, key);
+    if (SUCCESS != flag) item_del(&key); // err handling
+    return flag;
+}
+
+/**
+ * @brief backend_search() with the buffer on.
+ */
+static Item *buffer_search(Backend *backend, const Item *item) {
+    if (NULL == item) return NULL;
+
+    size_t pos;
+    skiplist_op_t *op = buffer_live(backend, item, &pos);
+    if (NULL == op) return backend_store_search(backend, item);
+    return SKIPLIST_REMOVE == op->kind ? NULL : op->item;
+}
+
+/**
+ * @brief Applies, on its own, a buffered op the flush could not commit, and
+ * frees what the lists do not keep.
+ *
+ * @return status_t \c SUCCESS, \c ALLOC_ERR with the op left as it was, or
+ * the error that lost the write.
+ */
+static status_t buffer_replay(Backend *backend, skiplist_op_t *op) {
+    status_t flag = CRITICAL_ERR;
+    switch (op->kind) {
+    case SKIPLIST_INSERT:
+        flag = backend_store_insert(backend, op->item);
+        if (SUCCESS == flag) return flag; // the lists keep the item
+        break;
+
+    case SKIPLIST_UPDATE: // the word may have expired in the meantime
+        flag = backend_store_update(backend, op->item);
+        if (NOT_FOUND_ERR != flag) break;
+        flag = backend_store_insert(backend, op->item);
+        if (SUCCESS == flag) return flag;
+        break;
+
+    case SKIPLIST_REMOVE: // the same
+        flag = backend_store_delete(backend, op->item);
+        if (NOT_FOUND_ERR == flag) flag = SUCCESS;
+        break;
+    }
+
+    if (ALLOC_ERR != flag) item_del(&op->item); // else it is tried again
+    return flag;
+}
+
+/**
+ * @brief Gives an item the expiry the lists would give it now, see
+ * skiplist_stamp().
+ */
+static void backend_stamp(Backend *backend, Item *item) {
+    switch (backend->kind) {
+    case BACKEND_SKIPLIST: skiplist_stamp(backend->as.skiplist, item); break;
+    case BACKEND_SHARDED: shardlist_stamp(backend->as.shardlist, item); break;
+    }
+}
+
+/**
+ * @brief Checks if an item expired on the clock of the lists, see
+ * skiplist_expired().
+ */
+static _Bool backend_expired(const Backend *backend, const Item *item) {
+    switch (backend->kind) {
+    case BACKEND_SKIPLIST:
+        return skiplist_expired(backend->as.skiplist, item);
+    case BACKEND_SHARDED:
+        return shardlist_expired(backend->as.shardlist, item);
+    }
+    return 0;
+}
+
+/**
+ * @brief Checks if a commit applied an op, see skiplist_commit().
+ */
+static _Bool op_applied(status_t flag, const skiplist_op_t *op) {
+    return SUCCESS == flag || (CRITICAL_ERR == flag && SUCCESS == op->status);
+}
+
+/**
+ * @brief Appends the description of a whole item to the value log.
+ *
+ * @param backend ptr to the backend.
+ * @param item the item: only read.
+ * @param cold output, a cold copy of the item WITH OWNERSHIP, or NULL when
+ * there is no log or the item is already cold.
+ * @return status_t \c SUCCESS, or why the copy could not be made.
+ */
+static status_t backend_chill(Backend *backend, const Item *item,
+                              Item **cold) {
+    *cold = NULL;
+    if (NULL == backend->log || NULL == item || item_is_cold(item))
+        return SUCCESS;
+
+    const char *description = item_description(item);
+    uint64_t ref;
+    status_t flag = valuelog_append(backend->log, description,
+                                    strlen(description), &ref);
+    if (SUCCESS != flag) return flag; // err handling
+
+    *cold = item_new_cold(item_word(item), ref);
+    return *cold ? SUCCESS : ALLOC_ERR;
+}
+
+/**
+ * @brief Reads the description of a cold item back from the value log.
+ *
+ * @param backend ptr to the backend.
+ * @param item the item.
+ * @param buf where the whole item is built.
+ * @return Item* the item itself if it is not cold, else a ptr into buf,
+ * WITHOUT OWNERSHIP, or NULL if the log could not be read.
+ */
+static Item *backend_fetch(Backend *backend, const Item *item,
+                           item_buf_t *buf) {
+    if (!item_is_cold(item)) return (Item *)item;
+
+    uint64_t ref = item_cold_ref(item);
+    char description[UINT8_MAX + 1];
+    if (SUCCESS != valuelog_read(backend->log, ref, description))
+        return NULL; // err handling
+
+    const char *word = item_word(item);
+    return item_place(buf, word, strlen(word), description,
+                      valuelog_ref_length(ref));
+}
+
+/**
+ * @brief Turns an item that left the lists into a whole one.
+ *
+ * @param backend ptr to the backend.
+ * @param item the item, WITH OWNERSHIP.
+ * @return Item* the item itself if it is not cold, else a whole copy, WITH
+ * OWNERSHIP, or NULL if the log could not be read.
+ */
+static Item *backend_warm(Backend *backend, Item *item) {
+    if (!item_is_cold(item)) return item;
+
+    item_buf_t buf;
+    Item *whole = item_clone(backend_fetch(backend, item, &buf));
+    item_del(&item);
+    return whole;
+}
+
+/**
+ * @brief Swaps the items of the insertions and updates of a batch for cold
+ * copies, see backend_warm_ops().
+ *
+ * @param backend ptr to the backend.
+ * @param ops the batch.
+ * @param n number of ops.
+ * @param whole output, the item every op came with.
+ * @return status_t \c SUCCESS, or why a copy could not be made, in which
+ * case the batch is left as it came.
+ */
+static status_t backend_chill_ops(Backend *backend, skiplist_op_t *ops,
+                                  size_t n, Item **whole) {
+    for (size_t i = 0; i < n; i++) {
+        whole[i] = ops[i].item;
+        if (SKIPLIST_REMOVE == ops[i].kind) continue;
+
+        Item *cold = NULL;
+        status_t flag = backend_chill(backend, whole[i], &cold);
+        if (SUCCESS != flag) { // err handling
+            for (size_t j = 0; j < i; j++) {
+                if (ops[j].item != whole[j]) item_del(&ops[j].item);
+                ops[j].item = whole[j];
+            }
+            return flag;
+        }
+        if (cold) ops[i].item = cold;
+    }
+    return SUCCESS;
+}
+
+/**
+ * @brief Gives a committed batch back its items: the whole ones the ops came
+ * with, and whole copies of the removed ones. A committed insertion leaves
+ * its cold copy to the lists, and the whole item is freed.
+ */
+static void backend_warm_ops(Backend *backend, status_t flag,
+                             skiplist_op_t *ops, size_t n, Item **whole) {
+    for (size_t i = 0; i < n; i++) {
+        skiplist_op_t *op = &ops[i];
+        op->result = backend_warm(backend, op->result);
+        if (op->item == whole[i]) continue;
+
+        if (SKIPLIST_INSERT == op->kind && op_applied(flag, op)) {
+            item_del(&whole[i]);
+            continue;
+        }
+        item_del(&op->item);
+        op->item = whole[i];
+    }
+}
+
+/**
+ * @brief Compacts the value log once it doubled since its last compaction.
+ * Whatever left the lists, replaced, removed, expired or evicted, is then
+ * reclaimed at a cost of one copy per byte appended, amortized.
+ */
+static void backend_maintain(Backend *backend) {
+    uint64_t size = valuelog_size(backend->log);
+    if (size >= BACKEND_COMPACT_MIN && size >= 2 * backend->live)
+        backend_compact(backend); // on error, the old log stays in use
+}
+
+/**
+ * @brief Calls fn for every item of the lists, in order.
+ */
+static status_t backend_lists_foreach(Backend *backend,
+                                      status_t (*fn)(Item *item, void *ctx),
+                                      void *ctx) {
+    switch (backend->kind) {
+    case BACKEND_SKIPLIST:
+        return skiplist_foreach(backend->as.skiplist, fn, ctx);
+    case BACKEND_SHARDED:
+        return shardlist_foreach(backend->as.shardlist, fn, ctx);
+    }
+    return CRITICAL_ERR;
+}
+
+/**
+ * @brief Visitor that copies the description of a cold item to the new log
+ * of a compaction, see compact_t.
+ */
+static status_t compact_copy(Item *item, void *ctx) {
+    compact_t *compact = (compact_t *)ctx;
+    if (!item_is_cold(item)) return SUCCESS;
+
+    if (compact->length == compact->room) {
+        size_t room = compact->room ? 2 * compact->room : 1024;
+        uint64_t *refs =
+            (uint64_t *)realloc(compact->refs, room * sizeof(uint64_t));
+        if (NULL == refs) return ALLOC_ERR; // err handling
+        compact->refs = refs;
+        compact->room = room;
+    }
+
+    uint64_t ref = item_cold_ref(item);
+    char description[UINT8_MAX + 1];
+    status_t flag = valuelog_read(compact->backend->log, ref, description);
+    if (SUCCESS != flag) return flag; // err handling
+
+    return valuelog_append(compact->fresh, description,
+                           valuelog_ref_length(ref),
+                           &compact->refs[compact->length++]);
+}
+
+/**
+ * @brief Visitor that keeps the word of an item, see clear_t.
+ */
+static status_t clear_gather(Item *item, void *ctx) {
+    clear_t *clear = (clear_t *)ctx;
+    if (clear->length == clear->room) {
+        size_t room = clear->room ? 2 * clear->room : 1024;
+        Item **keys = (Item **)realloc(clear->keys, room * sizeof(Item *));
+        if (NULL == keys) return ALLOC_ERR; // err handling
+        clear->keys = keys;
+        clear->room = room;
+    }
+
+    const char *word = item_word(item);
+    clear->keys[clear->length] = item_new_from(word, strlen(word), NULL, 0);
+    if (NULL == clear->keys[clear->length]) return ALLOC_ERR; // err handling
+    clear->length++;
+    return SUCCESS;
+}
+
+/**
+ * @brief Visitor that points a cold item to its copy in the new log of a
+ * compaction, see compact_t.
+ */
+static status_t compact_point(Item *item, void *ctx) {
+    compact_t *compact = (compact_t *)ctx;
+    if (item_is_cold(item))
+        item_set_cold_ref(item, compact->refs[compact->next++]);
+    return SUCCESS;
+}
+
+/**
+ * @brief Tells the journal, if any, of an applied write.
+ */
+static void backend_record(Backend *backend, skiplist_op_kind_t kind,
+                           const Item *item) {
+    if (backend->journal) backend->journal(backend->journal_ctx, kind, item);
+}
+
+/**
+ * @brief Drop callback of the lists, see skiplist_on_drop(): the journal is
+ * told of a word that expired or was evicted as of a removal.
+ */
+static void backend_dropped(void *ctx, const Item *item) {
+    backend_record((Backend *)ctx, SKIPLIST_REMOVE, item);
+}
@@ -0,0 +1,365 @@
+#include <sys/stat.h>
+
+#include "app/binproto.h"
+
+// Largest encoded entry: two length bytes, a word and a description.
+#define ENTRY_MAX (2 + MAX_WORD_SIZE + MAX_DESCRIPTION_SIZE)
+
+// Response header: frame length, opcode and status.
+#define RESPONSE_HEADER (BINPROTO_HEADER + 2)
+
+//=============================================================================/
+//=================|    Data Structures     |==================================/
+//=============================================================================/
+
+/**
+ * @brief Reading position in a request body. Reads past the end return zeros
+ * and mark the request as broken.
+ */
+typedef struct {
+    const unsigned char *at;
+    size_t left;
+    _Bool broken;
+} cursor_t;
+
+//=============================================================================/
+//=================|    Private Function Declarations     |====================/
+//=============================================================================/
+
+static uint8_t cursor_u8(cursor_t *cur);
+static uint16_t cursor_u16(cursor_t *cur);
+static const char *cursor_str(cursor_t *cur, size_t *len);
+static void put_entry(ByteBuf *out, const Item *item);
+static void put_status(ByteBuf *out, status_t status);
+static status_t execute_mput(Backend *backend, cursor_t *cur, ByteBuf *out);
+static status_t execute_text(Backend *backend, bin_op_t op, char c,
+                             ByteBuf *out);
+
+//=============================================================================/
+//=================|    Public Function Implementations     |==================/
+//=============================================================================/
+
+status_t binproto_frame(const unsigned char *buf, size_t len,
+                        size_t *frame_len) {
+    *frame_len = 0;
+    if (len < BINPROTO_HEADER) return SUCCESS;
+
+    uint32_t body = bytebuf_get_u32(buf);
+    if (body > BINPROTO_MAX_BODY) return TOO_MUCH_ERR;
+    if (len >= BINPROTO_HEADER + body) *frame_len = BINPROTO_HEADER + body;
+    return SUCCESS;
+}
+
+status_t binproto_execute(Backend *backend, const unsigned char *body,
+                          size_t len, ByteBuf *out) {
+    cursor_t cur = (cursor_t){.at = body, .left = len};
+    bin_op_t op = (bin_op_t)cursor_u8(&cur);
+
+    // The fixed part of every response, and one entry, fit in this
+    size_t bound = RESPONSE_HEADER + 2 + ENTRY_MAX;
+    if (SUCCESS != bytebuf_reserve(out, out->len + bound)) return ALLOC_ERR;
+
+    item_buf_t key; // lookups and updates never allocate
+    size_t word_len = 0, desc_len = 0;
+    const char *word = NULL, *desc = NULL;
+
+    size_t start = binproto_begin(out, op);
+    switch (op) {
+    case BIN_INSERT: {
+        word = cursor_str(&cur, &word_len);
+        desc = cursor_str(&cur, &desc_len);
+        if (cur.broken) break;
+        if (!item_is_parsable(word, word_len, desc, desc_len)) {
+            put_status(out, INVALID_ERR);
+            break;
+        }
+
+        Item *item = item_new_from(word, word_len, desc, desc_len);
+        status_t flag = NULL == item ? ALLOC_ERR : backend_insert(backend, item);
+        if (SUCCESS != flag) item_del(&item);
+        put_status(out, flag);
+        break;
+    }
+
+    case BIN_UPDATE:
+        word = cursor_str(&cur, &word_len);
+        desc = cursor_str(&cur, &desc_len);
+        if (cur.broken) break;
+        if (!item_is_parsable(word, word_len, desc, desc_len)) {
+            put_status(out, INVALID_ERR);
+            break;
+        }
+        put_status(out, backend_update(backend, item_place(&key, word, word_len,
+                                                           desc, desc_len)));
+        break;
+
+    case BIN_REMOVE:
+    case BIN_SEARCH: {
+        word = cursor_str(&cur, &word_len);
+        if (cur.broken) break;
+        if (!item_is_parsable(word, word_len, NULL, 0)) {
+            put_status(out, INVALID_ERR);
+            break;
+        }
+
+        Item *k = item_place(&key, word, word_len, NULL, 0);
+        Item *found = BIN_SEARCH == op ? backend_search(backend, k)
+                                       : backend_remove(backend, k);
+        put_status(out, NULL == found ? NOT_FOUND_ERR : SUCCESS);
+        if (NULL != found) put_entry(out, found);
+        if (BIN_REMOVE == op) item_del(&found);
+        break;
+    }
+
+    case BIN_MGET: {
+        uint16_t n = cursor_u16(&cur);
+        if (cur.broken) break;
+        put_status(out, SUCCESS);
+        bytebuf_put_u16(out, n);
+
+        for (uint16_t i = 0; i < n; i++) {
+            word = cursor_str(&cur, &word_len);
+            if (cur.broken) break;
+            if (SUCCESS != bytebuf_reserve(out, out->len + 1 + ENTRY_MAX)) {
+                out->len = start;
+                return ALLOC_ERR;
+            }
+
+            if (!item_is_parsable(word, word_len, NULL, 0)) {
+                put_status(out, INVALID_ERR);
+                continue;
+            }
+
+            Item *k = item_place(&key, word, word_len, NULL, 0);
+            Item *found = backend_search(backend, k);
+            put_status(out, NULL == found ? NOT_FOUND_ERR : SUCCESS);
+            if (NULL != found) put_entry(out, found);
+        }
+
+        // A broken MGET is answered as a whole
+        if (cur.broken) out->len = start + RESPONSE_HEADER - 1;
+        break;
+    }
+
+    case BIN_MPUT:
+        if (SUCCESS != execute_mput(backend, &cur, out)) {
+            out->len = start;
+            return ALLOC_ERR;
+        }
+        break;
+
+    case BIN_PRINT:
+    case BIN_DEBUG: {
+        char c = (char)(BIN_PRINT == op ? cursor_u8(&cur) : 0);
+        if (cur.broken) break;
+        if (SUCCESS != execute_text(backend, op, c, out)) {
+            out->len = start;
+            return ALLOC_ERR;
+        }
+        break;
+    }
+
+    default:
+        put_status(out, cur.broken ? CRITICAL_ERR : NOT_FOUND_ERR);
+        break;
+    }
+
+    if (cur.broken && out->len == start + RESPONSE_HEADER - 1)
+        put_status(out, CRITICAL_ERR);
+
+    binproto_end(out, start);
+    return SUCCESS;
+}
+
+status_t binproto_run(Backend *backend, FILE *in, FILE *out) {
+    if (NULL == backend || NULL == in || NULL == out) return NUL_ERR;
+
+    // A regular input file is read at once: no need to flush each reply
+    struct stat st;
+    _Bool interactive = !(0 == fstat(fileno(in), &st) && S_ISREG(st.st_mode));
+
+    ByteBuf body = (ByteBuf){0}, reply = (ByteBuf){0};
+    status_t result = SUCCESS;
+    unsigned char header[BINPROTO_HEADER];
+
+    for (;;) {
+        size_t got = fread(header, 1, BINPROTO_HEADER, in);
+        if (0 == got) break; // clean end
+        if (BINPROTO_HEADER != got) {
+            result = EOF_ERR;
+            break;
+        }
+
+        uint32_t len = bytebuf_get_u32(header);
+        if (len > BINPROTO_MAX_BODY) {
+            result = TOO_MUCH_ERR;
+            break;
+        }
+
+        if (SUCCESS != bytebuf_reserve(&body, len)) {
+            result = ALLOC_ERR;
+            break;
+        }
+        if (len != fread(body.data, 1, len, in)) {
+            result = EOF_ERR;
+            break;
+        }
+
+        reply.len = 0;
+        result = binproto_execute(backend, body.data, len, &reply);
+        if (SUCCESS != result) break;
+
+        fwrite(reply.data, 1, reply.len, out);
+        if (interactive) fflush(out);
+    }
+
+    fflush(out);
+    bytebuf_free(&body);
+    bytebuf_free(&reply);
+    return result;
+}
+
+size_t binproto_begin(ByteBuf *buf, bin_op_t op) {
+    size_t start = buf->len;
+    bytebuf_put_u32(buf, 0);
+    bytebuf_put_u8(buf, (uint8_t)op);
+    return start;
+}
+
+void binproto_end(ByteBuf *buf, size_t start) {
+    bytebuf_set_u32(buf, start, (uint32_t)(buf->len - start - BINPROTO_HEADER));
+}
+
+status_t binproto_put_str(ByteBuf *buf, const char *s, size_t len) {
+    if (len > UINT8_MAX) len = UINT8_MAX;
+    status_t flag = bytebuf_put_u8(buf, (uint8_t)len);
+    if (SUCCESS != flag) return flag;
+    return bytebuf_append(buf, s, len);
+}
+
+//=============================================================================/
+//=================|    Private Function Implementations    |==================/
+//=============================================================================/
+
+static uint8_t cursor_u8(cursor_t *cur) {
+    if (cur->left < 1) {
+        cur->broken = 1;
+        return 0;
+    }
+    cur->left--;
+    return *cur->at++;
+}
+
+static uint16_t cursor_u16(cursor_t *cur) {
+    if (cur->left < 2) {
+        cur->broken = 1;
+        return 0;
+    }
+    uint16_t value = bytebuf_get_u16(cur->at);
+    cur->at += 2;
+    cur->left -= 2;
+    return value;
+}
+
+/**
+ * @brief Reads a string: returns a ptr into the body, not '\0' terminated.
+ */
+static const char *cursor_str(cursor_t *cur, size_t *len) {
+    *len = cursor_u8(cur);
+    if (cur->broken || cur->left < *len) {
+        cur->broken = 1;
+        *len = 0;
+        return NULL;
+    }
+    const char *s = (const char *)cur->at;
+    cur->at += *len;
+    cur->left -= *len;
+    return s;
+}
+
+static void put_entry(ByteBuf *out, const Item *item) {
+    const char *word = item_word(item);
+    const char *desc = item_description(item);
+    binproto_put_str(out, word, strlen(word));
+    binproto_put_str(out, desc, strlen(desc));
+}
+
+static void put_status(ByteBuf *out, status_t status) {
+    bytebuf_put_u8(out, (uint8_t)(int8_t)status);
+}
+
+/**
+ * @brief Decodes the pairs of an MPUT and inserts them as one batch. The
+ * pairs that are not parsable (see item_is_parsable()) stay out of it and
+ * are answered \c INVALID_ERR.
+ */
+static status_t execute_mput(Backend *backend, cursor_t *cur, ByteBuf *out) {
+    uint16_t n = cursor_u16(cur);
+    if (cur->broken) return SUCCESS; // answered as broken by the caller
+
+    Item **items = (Item **)calloc(n ? n : 1, sizeof(Item *));
+    status_t *results = (status_t *)calloc(n ? n : 1, sizeof(status_t));
+    _Bool *invalid = (_Bool *)calloc(n ? n : 1, sizeof(_Bool));
+    if (NULL == items || NULL == results || NULL == invalid ||
+        SUCCESS != bytebuf_reserve(out, out->len + 3 + n)) { // err handling
+        free(items);
+        free(results);
+        free(invalid);
+        return ALLOC_ERR;
+    }
+
+    // The batch holds the valid pairs only, in order
+    size_t count = 0, valid = 0;
+    for (; count < n; count++) {
+        size_t word_len, desc_len;
+        const char *word = cursor_str(cur, &word_len);
+        const char *desc = cursor_str(cur, &desc_len);
+        if (cur->broken) break;
+        invalid[count] = !item_is_parsable(word, word_len, desc, desc_len);
+        if (!invalid[count])
+            items[valid++] = item_new_from(word, word_len, desc, desc_len);
+    }
+
+    status_t flag = CRITICAL_ERR;
+    if (!cur->broken)
+        flag = backend_insert_batch(backend, items, results, valid);
+
+    put_status(out, flag);
+    if (SUCCESS == flag) bytebuf_put_u16(out, n);
+
+    for (size_t i = 0, j = 0; i < count; i++) {
+        status_t status = invalid[i] ? INVALID_ERR : results[j];
+        if (SUCCESS != flag) status = flag;
+        if (!invalid[i] && SUCCESS != status) item_del(&items[j]);
+        if (!invalid[i]) j++;
+        if (SUCCESS == flag) put_status(out, status);
+    }
+
+    free(items);
+    free(results);
+    free(invalid);
+    return SUCCESS;
+}
+
+/**
+ * @brief Renders the text of a PRINT or DEBUG into the response.
+ */
+static status_t execute_text(Backend *backend, bin_op_t op, char c,
+                             ByteBuf *out) {
+    char *text = NULL;
+    size_t len = 0;
+    FILE *render = open_memstream(&text, &len);
+    if (NULL == render) return ALLOC_ERR; // err handling
+
+    status_t flag = SUCCESS;
+    if (BIN_PRINT == op) flag = backend_print(backend, render, c);
+    else backend_debug(backend, render);
+    fclose(render);
+
+    // backend_print() says ERROR, which is SUCCESS, for an empty list
+    if (SUCCESS == flag && 0 == len) flag = NOT_FOUND_ERR;
+    put_status(out, flag);
+    status_t result = bytebuf_append(out, text, len);
+    free(text);
+    return result;
+}
@@ -0,0 +1,402 @@
+#include "app/command.h"
+
+// Consecutive insertions are handed to the backend in batches of this size, so
+// the sharded backend can spread them across its threads.
+#define INSERT_BATCH_SIZE (4096)
+
+//=============================================================================/
+//=================|    Data Structures     |==================================/
+//=============================================================================/
+
+struct _executor_s {
+    Backend *backend;
+    reply_sink_f sink;
+    void *ctx;
+
+    // Pending insertions, waiting to be applied as a batch
+    Item *items[INSERT_BATCH_SIZE];
+    status_t results[INSERT_BATCH_SIZE];
+    size_t count;
+
+    Block *block; // the writes since inicio, or NULL
+};
+
+struct _block_s {
+    skiplist_op_t *ops;
+    item_buf_t *keys; // the key of each update and removal
+    size_t count;
+    size_t room;
+    status_t status; // ALLOC_ERR once a write could not be kept
+};
+
+//=============================================================================/
+//=================|    Private Function Declarations     |====================/
+//=============================================================================/
+
+static size_t skip_spaces(const char *line, size_t len, size_t i);
+static size_t skip_word(const char *line, size_t len, size_t i);
+static void executor_run(Executor *executor, command_t *cmd, reply_t *reply);
+static void executor_render(Executor *executor, command_t *cmd,
+                            reply_t *reply);
+static void executor_collect(Executor *executor, command_t *cmd);
+static status_t executor_commit(Executor *executor);
+
+//=============================================================================/
+//=================|    Public Function Implementations     |==================/
+//=============================================================================/
+
+status_t command_read(command_t *cmd) {
+    char name[64] = {'\0'};
+    if (EOF == scanf(" %62s", name)) return EOF_ERR; // stop at eof
+
+    *cmd = (command_t){.op = CMD_INVALID};
+
+    if (0 == strcmp(name, "insercao")) {
+        cmd->op = CMD_INSERT;
+        cmd->item = item_read();
+    } else if (0 == strcmp(name, "alteracao")) {
+        cmd->op = CMD_UPDATE;
+        item_read_into(&cmd->key);
+    } else if (0 == strcmp(name, "remocao")) {
+        if (item_read_word_into(&cmd->key)) cmd->op = CMD_REMOVE;
+    } else if (0 == strcmp(name, "busca")) {
+        if (item_read_word_into(&cmd->key)) cmd->op = CMD_SEARCH;
+    } else if (0 == strcmp(name, "impressao")) {
+        // A missing character is an invalid op, and the end of the input
+        if (EOF == scanf(" %c", &cmd->c)) cmd->last = 1;
+        else cmd->op = CMD_PRINT;
+    } else if (0 == strcmp(name, "debug")) {
+        cmd->op = CMD_DEBUG;
+    } else if (0 == strcmp(name, "inicio")) {
+        cmd->op = CMD_BEGIN;
+    } else if (0 == strcmp(name, "confirmacao")) {
+        cmd->op = CMD_COMMIT;
+    }
+
+    return SUCCESS;
+}
+
+status_t command_parse(const char *line, size_t len, command_t *cmd) {
+    size_t start = skip_spaces(line, len, 0);
+    size_t end = skip_word(line, len, start);
+    if (start == end) return EOF_ERR; // blank line
+
+    const char *name = line + start;
+    size_t name_len = end - start;
+    const char *args = line + end;
+    size_t args_len = len - end;
+
+    *cmd = (command_t){.op = CMD_INVALID};
+
+#define IS_CMD(s) (sizeof(s) - 1 == name_len && 0 == strncmp(name, s, name_len))
+    if (IS_CMD("insercao")) {
+        cmd->op = CMD_INSERT;
+        cmd->item = item_parse(args, args_len);
+    } else if (IS_CMD("alteracao")) {
+        if (item_parse_into(&cmd->key, args, args_len)) cmd->op = CMD_UPDATE;
+    } else if (IS_CMD("remocao") || IS_CMD("busca")) {
+        size_t word = skip_spaces(args, args_len, 0);
+        if (item_parse_into(&cmd->key, args + word,
+                            skip_word(args, args_len, word) - word))
+            cmd->op = IS_CMD("busca") ? CMD_SEARCH : CMD_REMOVE;
+    } else if (IS_CMD("impressao")) {
+        size_t c = skip_spaces(args, args_len, 0);
+        if (c < args_len) {
+            cmd->op = CMD_PRINT;
+            cmd->c = args[c];
+        }
+    } else if (IS_CMD("debug")) {
+        cmd->op = CMD_DEBUG;
+    } else if (IS_CMD("inicio")) {
+        cmd->op = CMD_BEGIN;
+    } else if (IS_CMD("confirmacao")) {
+        cmd->op = CMD_COMMIT;
+    }
+#undef IS_CMD
+
+    return SUCCESS;
+}
+
+Executor *executor_new(Backend *backend, reply_sink_f sink, void *ctx) {
+    if (NULL == backend || NULL == sink) return NULL; // err handling
+
+    Executor *executor = (Executor *)malloc(sizeof(Executor));
+    if (NULL == executor) return NULL; // err handling
+
+    executor->backend = backend;
+    executor->sink = sink;
+    executor->ctx = ctx;
+    executor->count = 0;
+    executor->block = NULL;
+    return executor;
+}
+
+void executor_del(Executor **executor) {
+    if (NULL == executor || NULL == *executor) return;
+    executor_flush(*executor);
+    block_del(&(*executor)->block); // never committed
+    free(*executor);
+    *executor = NULL;
+}
+
+void executor_submit(Executor *executor, command_t *cmd) {
+    if (NULL == executor || NULL == cmd) return;
+
+    // Writes inside a block wait for its commit
+    if (executor->block && (CMD_INSERT == cmd->op || CMD_UPDATE == cmd->op ||
+                            CMD_REMOVE == cmd->op)) {
+        executor_collect(executor, cmd);
+        return;
+    }
+
+    // Operation: Insertion (batched)
+    if (CMD_INSERT == cmd->op) {
+        executor->items[executor->count++] = cmd->item;
+        cmd->item = NULL;
+        if (INSERT_BATCH_SIZE == executor->count) executor_flush(executor);
+        return;
+    }
+
+    // Every other command sees the pending insertions
+    executor_flush(executor);
+
+    reply_t reply = (reply_t){.op = cmd->op};
+    executor_run(executor, cmd, &reply);
+    executor->sink(&reply, executor->ctx);
+}
+
+void executor_flush(Executor *executor) {
+    if (NULL == executor || 0 == executor->count) return;
+
+    status_t flag = backend_insert_batch(executor->backend, executor->items,
+                                         executor->results, executor->count);
+
+    for (size_t i = 0; i < executor->count; i++) {
+        reply_t reply = (reply_t){.op = CMD_INSERT, .status = flag};
+        if (SUCCESS == flag) reply.status = executor->results[i];
+        if (SUCCESS != reply.status) item_del(&executor->items[i]);
+        executor->sink(&reply, executor->ctx);
+    }
+
+    executor->count = 0;
+}
+
+void executor_swap_block(Executor *executor, Block **block) {
+    if (NULL == executor || NULL == block) return;
+    Block *temp = executor->block;
+    executor->block = *block;
+    *block = temp;
+}
+
+void block_del(Block **block) {
+    if (NULL == block || NULL == *block) return;
+    for (size_t i = 0; i < (*block)->count; i++)
+        if (SKIPLIST_INSERT == (*block)->ops[i].kind)
+            item_del(&(*block)->ops[i].item);
+    free((*block)->ops);
+    free((*block)->keys);
+    free(*block);
+    *block = NULL;
+}
+
+void reply_write(const reply_t *reply, FILE *out) {
+    if (NULL == reply) return;
+
+    switch (reply->op) {
+    case CMD_SEARCH:
+        if (SUCCESS == reply->status) {
+            item_fprint(out, item_in(&reply->found));
+            fputs("\n", out);
+            return;
+        }
+        break;
+    case CMD_PRINT:
+    case CMD_DEBUG:
+        if (NULL != reply->text) fwrite(reply->text, 1, reply->len, out);
+        break;
+    default:
+        break;
+    }
+
+    if (SUCCESS != reply->status) fputs(INVALID_OP_MSG, out);
+}
+
+void reply_clear(reply_t *reply) {
+    if (NULL == reply) return;
+    free(reply->text);
+    reply->text = NULL;
+    reply->len = 0;
+}
+
+//=============================================================================/
+//=================|    Private Function Implementations    |==================/
+//=============================================================================/
+
+/**
+ * @brief Returns the index of the first non space character from i on.
+ */
+static size_t skip_spaces(const char *line, size_t len, size_t i) {
+    while (i < len && strutils_isspace(line[i])) i++;
+    return i;
+}
+
+/**
+ * @brief Returns the index of the first space character from i on.
+ */
+static size_t skip_word(const char *line, size_t len, size_t i) {
+    while (i < len && !strutils_isspace(line[i])) i++;
+    return i;
+}
+
+/**
+ * @brief Executes a command other than an insertion, filling its reply.
+ */
+static void executor_run(Executor *executor, command_t *cmd, reply_t *reply) {
+    Backend *backend = executor->backend;
+    Item *key = item_in(&cmd->key); // the ring may have moved the command
+
+    switch (cmd->op) {
+    // Operation: Update
+    case CMD_UPDATE:
+        reply->status = backend_update(backend, key);
+        break;
+
+    // Operation: Remove
+    case CMD_REMOVE:
+        reply->status = SUCCESS == backend_delete(backend, key)
+                            ? SUCCESS
+                            : NOT_FOUND_ERR;
+        break;
+
+    // Operation: Search. The found item is copied: the writer may print it
+    // after later commands changed the backend.
+    case CMD_SEARCH: {
+        Item *result = backend_search(backend, key); // borrowed
+        reply->status = NOT_FOUND_ERR;
+        if (NULL != result) {
+            item_clone_into(&reply->found, result);
+            reply->status = SUCCESS;
+        }
+        break;
+    }
+
+    // Operation: Print and Debug (memory summary)
+    case CMD_PRINT:
+    case CMD_DEBUG:
+        executor_render(executor, cmd, reply);
+        break;
+
+    // Operation: Begin a block, which can not be nested
+    case CMD_BEGIN:
+        reply->status = REPEATED_ENTRY_ERR;
+        if (NULL == executor->block) {
+            executor->block = (Block *)calloc(1, sizeof(Block));
+            reply->status = executor->block ? SUCCESS : ALLOC_ERR;
+        }
+        break;
+
+    // Operation: Commit the block
+    case CMD_COMMIT:
+        reply->status = executor_commit(executor);
+        break;
+
+    // Operation: Operation not identified
+    default:
+        reply->status = NOT_FOUND_ERR;
+        break;
+    }
+
+    item_del(&cmd->item);
+}
+
+/**
+ * @brief Renders the output of a print or debug command into the reply text,
+ * as it has to reflect the backend at this point of the command stream.
+ */
+static void executor_render(Executor *executor, command_t *cmd,
+                            reply_t *reply) {
+    FILE *out = open_memstream(&reply->text, &reply->len);
+    if (NULL == out) { // err handling
+        reply->status = ALLOC_ERR;
+        return;
+    }
+
+    if (CMD_PRINT == cmd->op) {
+        reply->status = backend_print(executor->backend, out, cmd->c);
+    } else {
+        fprintf(out, "SKIPLIST:\n");
+        backend_debug(executor->backend, out);
+        fprintf(out, "\n\n");
+        reply->status = SUCCESS;
+    }
+
+    fclose(out);
+}
+
+/**
+ * @brief Keeps a write of the open block for its commit. The item of an
+ * insertion is taken; the key of the other writes is copied.
+ */
+static void executor_collect(Executor *executor, command_t *cmd) {
+    Block *block = executor->block;
+
+    if (block->count == block->room) {
+        size_t room = block->room ? 2 * block->room : 16;
+        skiplist_op_t *ops =
+            (skiplist_op_t *)realloc(block->ops, room * sizeof(skiplist_op_t));
+        if (ops) block->ops = ops;
+        item_buf_t *keys =
+            (item_buf_t *)realloc(block->keys, room * sizeof(item_buf_t));
+        if (keys) block->keys = keys;
+
+        if (NULL == ops || NULL == keys) { // err handling: refuse the block
+            block->status = ALLOC_ERR;
+            item_del(&cmd->item);
+            return;
+        }
+        block->room = room;
+    }
+
+    skiplist_op_t *op = &block->ops[block->count];
+    *op = (skiplist_op_t){.kind = SKIPLIST_INSERT, .item = cmd->item};
+    if (CMD_UPDATE == cmd->op) op->kind = SKIPLIST_UPDATE;
+    if (CMD_REMOVE == cmd->op) op->kind = SKIPLIST_REMOVE;
+    if (CMD_INSERT != cmd->op) block->keys[block->count] = cmd->key;
+
+    cmd->item = NULL;
+    block->count++;
+}
+
+/**
+ * @brief Commits the open block and closes it.
+ *
+ * @return status_t \c SUCCESS, \c NOT_FOUND_ERR if no block is open, or why
+ * the block was refused (see backend_commit()).
+ */
+static status_t executor_commit(Executor *executor) {
+    Block *block = executor->block;
+    if (NULL == block) return NOT_FOUND_ERR;
+    executor->block = NULL;
+
+    // The keys moved with the array: they are pointed at only now
+    for (size_t i = 0; i < block->count; i++)
+        if (SKIPLIST_INSERT != block->ops[i].kind)
+            block->ops[i].item = item_in(&block->keys[i]);
+
+    status_t flag = block->status;
+    if (SUCCESS == flag)
+        flag = backend_commit(executor->backend, block->ops, block->count);
+
+    // Committed insertions belong to the backend, and removals to us
+    if (SUCCESS == flag || CRITICAL_ERR == flag) {
+        for (size_t i = 0; i < block->count; i++) {
+            skiplist_op_t *op = &block->ops[i];
+            item_del(&op->result);
+            if (SKIPLIST_INSERT == op->kind && SUCCESS == op->status)
+                op->item = NULL;
+        }
+    }
+
+    block_del(&block);
+    return flag;
+}
@@ -0,0 +1,319 @@
+#include "app/loader.h"
+
+//=============================================================================/
+//=================|    Data Structures     |==================================/
+//=============================================================================/
+
+/**
+ * @brief A chunk of the input, parsed by one thread.
+ */
+typedef struct {
+    const char *text;
+    size_t len;
+    Item **items;
+    size_t count;
+    size_t capacity;
+    status_t status;
+} parse_task_t;
+
+/**
+ * @brief A run of the array sorted, or two runs merged, by one thread.
+ */
+typedef struct {
+    Item **src;
+    Item **dst;
+    size_t lo;
+    size_t mid;
+    size_t hi;
+} sort_task_t;
+
+//=============================================================================/
+//=================|    Private Function Declarations     |====================/
+//=============================================================================/
+
+static char *read_all(FILE *in, size_t *len);
+static void parse_run(void *arg);
+static void merge(Item **src, Item **dst, size_t lo, size_t mid, size_t hi);
+static void sort_run(void *arg);
+static void merge_run(void *arg);
+static status_t parallel_sort(Item **items, size_t n, ThreadPool *pool);
+static void run_all(ThreadPool *pool, void (*fn)(void *), void *tasks,
+                    size_t size, size_t count);
+
+//=============================================================================/
+//=================|    Public Function Implementations     |==================/
+//=============================================================================/
+
+status_t loader_read_sorted(FILE *in, ThreadPool *pool, Item ***items,
+                            size_t *n) {
+    if (NULL == in || NULL == items || NULL == n) return NUL_ERR;
+    *items = NULL;
+    *n = 0;
+
+    // PART 1: read everything
+    size_t len = 0;
+    char *text = read_all(in, &len);
+    if (NULL == text) return ALLOC_ERR;
+
+    // PART 2: parse in chunks cut at line boundaries
+    size_t chunks = pool ? threadpool_size(pool) : 1;
+    parse_task_t *tasks = (parse_task_t *)calloc(chunks, sizeof(parse_task_t));
+    if (NULL == tasks) {
+        free(text);
+        return ALLOC_ERR;
+    }
+
+    size_t start = 0;
+    for (size_t i = 0; i < chunks; i++) {
+        size_t end = i + 1 == chunks ? len : (i + 1) * len / chunks;
+        if (end < start) end = start;
+        while (end < len && '\n' != text[end]) end++;
+        if (end < len) end++; // keep the '\n' in this chunk
+        tasks[i] = (parse_task_t){.text = text + start, .len = end - start};
+        start = end;
+    }
+
+    run_all(pool, parse_run, tasks, sizeof(parse_task_t), chunks);
+    free(text);
+
+    // PART 3: concatenate the chunks, in input order
+    status_t flag = SUCCESS;
+    size_t total = 0;
+    for (size_t i = 0; i < chunks; i++) {
+        total += tasks[i].count;
+        if (SUCCESS != tasks[i].status) flag = tasks[i].status;
+    }
+
+    Item **all = (Item **)malloc((total + 1) * sizeof(Item *));
+    if (NULL == all) flag = ALLOC_ERR;
+
+    size_t k = 0;
+    for (size_t i = 0; i < chunks; i++) {
+        for (size_t j = 0; j < tasks[i].count; j++) {
+            if (SUCCESS == flag) all[k++] = tasks[i].items[j];
+            else item_del(&tasks[i].items[j]); // err handling
+        }
+        free(tasks[i].items);
+    }
+    free(tasks);
+
+    // PART 4: sort (stable) and drop repeated words
+    if (SUCCESS == flag) flag = parallel_sort(all, total, pool);
+
+    if (SUCCESS != flag) {
+        for (size_t i = 0; all && i < total; i++) item_del(&all[i]);
+        free(all);
+        return flag;
+    }
+
+    size_t unique = 0;
+    for (size_t i = 0; i < total; i++) {
+        if (unique > 0 && 0 == item_raw_cmp(all[unique - 1], all[i]))
+            item_del(&all[i]); // the first occurrence wins
+        else all[unique++] = all[i];
+    }
+
+    *items = all;
+    *n = unique;
+    return SUCCESS;
+}
+
+//=============================================================================/
+//=================|    Private Function Implementations    |==================/
+//=============================================================================/
+
+/**
+ * @brief Reads a stream until EOF into a heap buffer.
+ *
+ * @param in the stream.
+ * @param len output, number of bytes read.
+ * @return char* the buffer, WITH OWNERSHIP, or NULL on error.
+ */
+static char *read_all(FILE *in, size_t *len) {
+    size_t capacity = 1 << 16;
+    char *text = (char *)malloc(capacity);
+    if (NULL == text) return NULL;
+
+    *len = 0;
+    for (;;) {
+        if (*len == capacity) {
+            char *temp = (char *)realloc(text, 2 * capacity);
+            if (NULL == temp) {
+                free(text);
+                return NULL;
+            }
+            text = temp;
+            capacity *= 2;
+        }
+        size_t got = fread(text + *len, 1, capacity - *len, in);
+        if (0 == got) break;
+        *len += got;
+    }
+
+    return text;
+}
+
+/**
+ * @brief Parses every line of a chunk.
+ *
+ * @param arg ptr to a parse_task_t.
+ */
+static void parse_run(void *arg) {
+    parse_task_t *task = (parse_task_t *)arg;
+    task->status = SUCCESS;
+
+    size_t i = 0;
+    while (i < task->len) {
+        size_t end = i;
+        while (end < task->len && '\n' != task->text[end]) end++;
+
+        Item *item = item_parse(task->text + i, end - i);
+        i = end + 1;
+        if (NULL == item) continue; // blank line
+
+        if (task->count == task->capacity) {
+            size_t capacity = task->capacity ? 2 * task->capacity : 1024;
+            Item **temp =
+                (Item **)realloc(task->items, capacity * sizeof(Item *));
+            if (NULL == temp) { // err handling
+                item_del(&item);
+                task->status = ALLOC_ERR;
+                return;
+            }
+            task->items = temp;
+            task->capacity = capacity;
+        }
+        task->items[task->count++] = item;
+    }
+}
+
+/**
+ * @brief Merges src[lo, mid) and src[mid, hi) into dst[lo, hi). Ties keep the
+ * item of the left run first, which makes the sort stable.
+ */
+static void merge(Item **src, Item **dst, size_t lo, size_t mid, size_t hi) {
+    size_t i = lo, j = mid, k = lo;
+    while (i < mid && j < hi)
+        dst[k++] = item_raw_cmp(src[j], src[i]) < 0 ? src[j++] : src[i++];
+    while (i < mid) dst[k++] = src[i++];
+    while (j < hi) dst[k++] = src[j++];
+}
+
+/**
+ * @brief Sorts src[lo, hi) with a bottom-up merge sort. The sorted run ends in
+ * src; dst is used as scratch space.
+ *
+ * @param arg ptr to a sort_task_t.
+ */
+static void sort_run(void *arg) {
+    sort_task_t *task = (sort_task_t *)arg;
+    Item **a = task->src, **b = task->dst;
+
+    for (size_t width = 1; width < task->hi - task->lo; width *= 2) {
+        for (size_t lo = task->lo; lo < task->hi; lo += 2 * width) {
+            size_t mid = lo + width < task->hi ? lo + width : task->hi;
+            size_t hi = mid + width < task->hi ? mid + width : task->hi;
+            merge(a, b, lo, mid, hi);
+        }
+        Item **temp = a;
+        a = b;
+        b = temp;
+    }
+
+    if (a != task->src)
+        memcpy(task->src + task->lo, a + task->lo,
+               (task->hi - task->lo) * sizeof(Item *));
+}
+
+/**
+ * @brief Thread pool entry point for merge().
+ *
+ * @param arg ptr to a sort_task_t.
+ */
+static void merge_run(void *arg) {
+    sort_task_t *t = (sort_task_t *)arg;
+    merge(t->src, t->dst, t->lo, t->mid, t->hi);
+}
+
+/**
+ * @brief Stable parallel merge sort: one run per worker sorted in parallel,
+ * then rounds of pairwise merges, each merge on its own worker.
+ *
+ * @param items the array.
+ * @param n its length.
+ * @param pool the workers, or NULL.
+ * @return status_t \c SUCCESS or \c ALLOC_ERR.
+ */
+static status_t parallel_sort(Item **items, size_t n, ThreadPool *pool) {
+    if (n < 2) return SUCCESS;
+
+    size_t runs = pool ? threadpool_size(pool) : 1;
+    if (runs > n) runs = n;
+
+    Item **scratch = (Item **)malloc(n * sizeof(Item *));
+    sort_task_t *tasks = (sort_task_t *)calloc(runs, sizeof(sort_task_t));
+    size_t *bounds = (size_t *)malloc((runs + 1) * sizeof(size_t));
+    if (NULL == scratch || NULL == tasks || NULL == bounds) {
+        free(scratch);
+        free(tasks);
+        free(bounds);
+        return ALLOC_ERR;
+    }
+
+    // Sort each run
+    for (size_t i = 0; i <= runs; i++) bounds[i] = i * n / runs;
+    for (size_t i = 0; i < runs; i++) {
+        tasks[i] = (sort_task_t){
+            .src = items, .dst = scratch, .lo = bounds[i], .hi = bounds[i + 1]};
+    }
+    run_all(pool, sort_run, tasks, sizeof(sort_task_t), runs);
+
+    // Merge them pairwise, ping-ponging between the two arrays
+    Item **src = items, **dst = scratch;
+    while (runs > 1) {
+        size_t merged = 0;
+        for (size_t i = 0; i < runs; i += 2) {
+            size_t lo = bounds[i];
+            size_t mid = bounds[i + 1];
+            size_t hi = i + 2 <= runs ? bounds[i + 2] : mid;
+            tasks[merged] = (sort_task_t){
+                .src = src, .dst = dst, .lo = lo, .mid = mid, .hi = hi};
+            bounds[merged++] = lo;
+        }
+        bounds[merged] = n;
+        run_all(pool, merge_run, tasks, sizeof(sort_task_t), merged);
+
+        Item **temp = src;
+        src = dst;
+        dst = temp;
+        runs = merged;
+    }
+
+    if (src != items) memcpy(items, src, n * sizeof(Item *));
+
+    free(scratch);
+    free(tasks);
+    free(bounds);
+    return SUCCESS;
+}
+
+/**
+ * @brief Runs fn on every element of an array of tasks, on the pool if there
+ * is one, and waits for all of them.
+ *
+ * @param pool the workers, or NULL.
+ * @param fn the task function.
+ * @param tasks the array of task arguments.
+ * @param size the size of one element.
+ * @param count the number of elements.
+ */
+static void run_all(ThreadPool *pool, void (*fn)(void *), void *tasks,
+                    size_t size, size_t count) {
+    char *base = (char *)tasks;
+    for (size_t i = 0; i < count; i++) {
+        void *arg = base + i * size;
+        if (NULL == pool || SUCCESS != threadpool_submit(pool, fn, arg))
+            fn(arg); // err handling: do it ourselves
+    }
+    threadpool_wait(pool);
+}
@@ -0,0 +1,500 @@
+#include <errno.h>
+#include <math.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "app/binproto.h"
+#include "app/loadgen.h"
+#include "utils/bytebuf.h"
+#include "utils/mathutils.h"
+#include "utils/netutils.h"
+
+// Longest generated word or text command, and bytes read at a time.
+#define LOADGEN_LINE (64)
+#define LOADGEN_CHUNK (64 * 1024)
+
+// Pairs per MPUT frame while prefilling with the binary protocol.
+#define LOADGEN_MPUT (1024)
+
+// The server may still be starting: connection attempts and the wait between.
+#define LOADGEN_CONNECT_TRIES (100)
+#define LOADGEN_CONNECT_NAP_NS (20000000L)
+
+//=============================================================================/
+//=================|    Data Structures     |==================================/
+//=============================================================================/
+
+/**
+ * @brief A measured connection.
+ */
+typedef struct {
+    int fd;
+    unsigned int seed;
+    size_t remaining; // commands not sent yet
+
+    ByteBuf req;      // the running window, not sent yet from req_sent on
+    size_t req_sent;
+    ByteBuf updates;  // binary protocol: the UPDATE frames of the window
+    ByteBuf partial;  // binary protocol: a partially received response
+    size_t expected;  // replies of the window not received yet
+    struct timespec started;
+    const double *cdf; // Zipfian popularity of the keys, NULL for uniform
+} client_t;
+
+/**
+ * @brief Window latencies, in microseconds.
+ */
+typedef struct {
+    double *us;
+    size_t count;
+} samples_t;
+
+//=============================================================================/
+//=================|    Private Function Declarations     |====================/
+//=============================================================================/
+
+static int loadgen_connect(const char *addr);
+static status_t loadgen_prefill(const loadgen_config_t *config,
+                                size_t *rejected);
+static status_t count_replies(const loadgen_config_t *config, ByteBuf *partial,
+                              const unsigned char *data, size_t len,
+                              size_t *replies, size_t *rejected);
+static double *zipf_cdf(size_t keys, double skew);
+static size_t pick_key(client_t *client, size_t keys);
+static void client_next_window(client_t *client,
+                               const loadgen_config_t *config);
+static status_t client_on_event(client_t *client, samples_t *samples,
+                                const loadgen_config_t *config, int epfd);
+static double elapsed_us(const struct timespec *from);
+static int cmp_double(const void *a, const void *b);
+static void loadgen_report(FILE *report, const loadgen_config_t *config,
+                           samples_t *samples, double prefill_us,
+                           size_t rejected, double total_us);
+
+//=============================================================================/
+//=================|    Public Function Implementations     |==================/
+//=============================================================================/
+
+status_t loadgen_run(const loadgen_config_t *in, FILE *report) {
+    if (NULL == in || NULL == report) return NUL_ERR;
+
+    loadgen_config_t config = *in;
+    if (0 == config.clients) config.clients = LOADGEN_CLIENTS;
+    if (0 == config.requests) config.requests = LOADGEN_REQUESTS;
+    if (0 == config.window) config.window = LOADGEN_WINDOW;
+    if (config.window > UINT16_MAX) config.window = UINT16_MAX; // MGET count
+    if (0 == config.keys) config.keys = LOADGEN_KEYS;
+    if (config.writes > 100) config.writes = 100;
+
+    struct rlimit lim;
+    if (0 == getrlimit(RLIMIT_NOFILE, &lim)) {
+        lim.rlim_cur = lim.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &lim);
+    }
+
+    // Prefill
+    struct timespec t0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    size_t rejected = 0;
+    status_t result = loadgen_prefill(&config, &rejected);
+    if (SUCCESS != result) return result; // err handling
+    double prefill_us = elapsed_us(&t0);
+
+    // Measured run
+    double *cdf = config.zipf > 0 ? zipf_cdf(config.keys, config.zipf) : NULL;
+    client_t *clients = (client_t *)calloc(config.clients, sizeof(client_t));
+    samples_t samples = {
+        .us = (double *)malloc((config.requests / config.window + 1 +
+                                config.clients) * sizeof(double)),
+    };
+    int epfd = epoll_create1(0);
+    if (NULL == clients || NULL == samples.us || epfd < 0 ||
+        (config.zipf > 0 && NULL == cdf))
+        result = ALLOC_ERR; // err handling
+
+    size_t active = 0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (size_t i = 0; SUCCESS == result && i < config.clients; i++) {
+        client_t *client = &clients[i];
+        client->fd = loadgen_connect(config.addr);
+        client->seed = 2654435761u * (unsigned int)(i + 1) | 1u;
+        client->remaining = config.requests / config.clients +
+                            (i < config.requests % config.clients);
+        client->cdf = cdf;
+
+        struct epoll_event ev = {.events = EPOLLIN | EPOLLOUT,
+                                 .data.ptr = client};
+        if (client->fd < 0 || SUCCESS != netutils_set_nonblocking(client->fd) ||
+            0 != epoll_ctl(epfd, EPOLL_CTL_ADD, client->fd, &ev)) {
+            result = CRITICAL_ERR; // err handling
+            break;
+        }
+
+        if (client->remaining > 0) {
+            client_next_window(client, &config);
+            active++;
+        }
+    }
+
+    struct epoll_event events[256];
+    while (SUCCESS == result && active > 0) {
+        int n = epoll_wait(epfd, events, 256, -1);
+        if (n < 0 && EINTR != errno) result = CRITICAL_ERR;
+
+        for (int i = 0; SUCCESS == result && i < n; i++) {
+            client_t *client = (client_t *)events[i].data.ptr;
+            result = client_on_event(client, &samples, &config, epfd);
+            if (EOF_ERR == result) { // this client is done
+                result = SUCCESS;
+                active--;
+            }
+        }
+    }
+    double total_us = elapsed_us(&t0);
+
+    if (SUCCESS == result)
+        loadgen_report(report, &config, &samples, prefill_us, rejected,
+                       total_us);
+
+    // Clean up
+    for (size_t i = 0; NULL != clients && i < config.clients; i++) {
+        if (clients[i].fd > 0) close(clients[i].fd);
+        bytebuf_free(&clients[i].req);
+        bytebuf_free(&clients[i].updates);
+        bytebuf_free(&clients[i].partial);
+    }
+    free(clients);
+    free(cdf);
+    free(samples.us);
+    if (epfd >= 0) close(epfd);
+
+    return result;
+}
+
+//=============================================================================/
+//=================|    Private Function Implementations    |==================/
+//=============================================================================/
+
+/**
+ * @brief Connects to the server, retrying for a while if it is not up yet.
+ */
+static int loadgen_connect(const char *addr) {
+    for (int i = 0; i < LOADGEN_CONNECT_TRIES; i++) {
+        int fd = netutils_connect(addr);
+        if (fd >= 0) return fd;
+        if (ENOENT != errno && ECONNREFUSED != errno) return -1;
+        nanosleep(&(struct timespec){.tv_nsec = LOADGEN_CONNECT_NAP_NS}, NULL);
+    }
+    return -1;
+}
+
+/**
+ * @brief Inserts the keys through one connection. The replies (one per
+ * rejected insertion, e.g. words left by a previous run) are read while
+ * sending, so neither side blocks on a full buffer.
+ */
+static status_t loadgen_prefill(const loadgen_config_t *config,
+                                size_t *rejected) {
+    ByteBuf req = (ByteBuf){0}, partial = (ByteBuf){0};
+    char line[3 * LOADGEN_LINE];
+
+    for (size_t k = 0; k < config->keys; k += LOADGEN_MPUT) {
+        size_t n = config->keys - k < LOADGEN_MPUT ? config->keys - k
+                                                   : LOADGEN_MPUT;
+        size_t start = 0;
+        if (config->binary) {
+            start = binproto_begin(&req, BIN_MPUT);
+            bytebuf_put_u16(&req, (uint16_t)n);
+        }
+
+        for (size_t i = k; i < k + n; i++) {
+            if (config->binary) {
+                int len = sprintf(line, "k%08zu", i);
+                binproto_put_str(&req, line, len);
+                len = sprintf(line, "value of k%08zu", i);
+                binproto_put_str(&req, line, len);
+            } else {
+                int len = sprintf(line, "insercao k%08zu value of k%08zu\n", i, i);
+                bytebuf_append(&req, line, len);
+            }
+        }
+
+        if (config->binary) binproto_end(&req, start);
+    }
+
+    unsigned char *buf = (unsigned char *)malloc(LOADGEN_CHUNK);
+    int fd = loadgen_connect(config->addr);
+    status_t result = SUCCESS;
+    if (NULL == buf || fd < 0 || (config->keys > 0 && NULL == req.data))
+        result = NOT_FOUND_ERR; // err handling
+
+    size_t sent = 0, replies = 0;
+    _Bool closed = 0;
+    while (SUCCESS == result) {
+        struct pollfd p = {.fd = fd, .events = POLLIN};
+        if (sent < req.len) p.events |= POLLOUT;
+        if (poll(&p, 1, -1) < 0 && EINTR != errno) {
+            result = CRITICAL_ERR;
+            break;
+        }
+
+        if (p.revents & POLLOUT) {
+            ssize_t n = send(fd, req.data + sent, req.len - sent,
+                             MSG_NOSIGNAL | MSG_DONTWAIT);
+            if (n > 0) sent += (size_t)n;
+        }
+        if (sent == req.len && !closed) {
+            shutdown(fd, SHUT_WR); // the server answers all, then closes
+            closed = 1;
+        }
+
+        if (p.revents & (POLLIN | POLLHUP)) {
+            ssize_t n = recv(fd, buf, LOADGEN_CHUNK, MSG_DONTWAIT);
+            if (0 == n) break; // done
+            if (n < 0 && EAGAIN != errno && EINTR != errno) {
+                result = CRITICAL_ERR;
+                break;
+            }
+            if (n > 0)
+                result = count_replies(config, &partial, buf, (size_t)n,
+                                       &replies, rejected);
+        }
+    }
+
+    // Text insertions only answer when rejected
+    if (!config->binary) *rejected = replies;
+
+    free(buf);
+    bytebuf_free(&req);
+    bytebuf_free(&partial);
+    if (fd >= 0) close(fd);
+    return result;
+}
+
+/**
+ * @brief Counts the complete replies in received data: lines for the text
+ * protocol, frames for the binary one. For the latter, the statuses other
+ * than \c SUCCESS are counted as rejected as well.
+ */
+static status_t count_replies(const loadgen_config_t *config, ByteBuf *partial,
+                              const unsigned char *data, size_t len,
+                              size_t *replies, size_t *rejected) {
+    if (!config->binary) {
+        for (size_t i = 0; i < len; i++) *replies += '\n' == data[i];
+        return SUCCESS;
+    }
+
+    if (SUCCESS != bytebuf_append(partial, data, len)) return ALLOC_ERR;
+
+    size_t start = 0, frame = 0;
+    for (;;) {
+        if (SUCCESS != binproto_frame(partial->data + start,
+                                      partial->len - start, &frame))
+            return CRITICAL_ERR;
+        if (0 == frame) break;
+
+        // body: opcode, status[, u16 n, n statuses for an MPUT]
+        const unsigned char *body = partial->data + start + BINPROTO_HEADER;
+        size_t body_len = frame - BINPROTO_HEADER;
+        if (body_len >= 2 && SUCCESS != (int8_t)body[1]) (*rejected)++;
+        if (body_len >= 4 && BIN_MPUT == body[0] && SUCCESS == (int8_t)body[1])
+            for (size_t i = 4; i < body_len; i++)
+                *rejected += SUCCESS != (int8_t)body[i];
+
+        (*replies)++;
+        start += frame;
+    }
+
+    bytebuf_consume(partial, start);
+    return SUCCESS;
+}
+
+/**
+ * @brief Builds the cumulative distribution of a Zipfian popularity: the key
+ * of rank r is picked with a probability proportional to 1 / r^skew.
+ *
+ * @return double* the distribution, WITH OWNERSHIP, or NULL on error.
+ */
+static double *zipf_cdf(size_t keys, double skew) {
+    double *cdf = (double *)malloc(keys * sizeof(double));
+    if (NULL == cdf) return NULL; // err handling
+
+    double sum = 0;
+    for (size_t r = 0; r < keys; r++) cdf[r] = sum += pow(r + 1.0, -skew);
+    for (size_t r = 0; r < keys; r++) cdf[r] /= sum;
+    return cdf;
+}
+
+/**
+ * @brief Draws the key of the next command: uniformly, or by rank from the
+ * Zipfian distribution. Ranks are scattered over the keys, so the popular
+ * words are not all neighbours.
+ */
+static size_t pick_key(client_t *client, size_t keys) {
+    double u = rnd_normalized_r(&client->seed);
+    if (NULL == client->cdf) {
+        size_t k = (size_t)(u * keys);
+        return k < keys ? k : keys - 1;
+    }
+
+    // First rank whose cumulative probability reaches u
+    size_t lo = 0, hi = keys - 1;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (client->cdf[mid] < u) lo = mid + 1;
+        else hi = mid;
+    }
+    return (size_t)((lo * 2654435761ull) % keys);
+}
+
+/**
+ * @brief Prepares the next window of commands of a client. With the binary
+ * protocol, its searches travel in a single MGET.
+ */
+static void client_next_window(client_t *client,
+                               const loadgen_config_t *config) {
+    size_t n = client->remaining < config->window ? client->remaining
+                                                  : config->window;
+    client->remaining -= n;
+    client->req.len = client->req_sent = 0;
+    client->updates.len = 0;
+    client->expected = 0;
+
+    size_t mget = 0, searches = 0;
+    if (config->binary) {
+        mget = binproto_begin(&client->req, BIN_MGET);
+        bytebuf_put_u16(&client->req, 0);
+    }
+
+    char line[2 * LOADGEN_LINE];
+    for (size_t i = 0; i < n; i++) {
+        size_t k = pick_key(client, config->keys);
+
+        // Text writes never end a window: their success has no reply
+        _Bool write = i + 1 < n && rnd_normalized_r(&client->seed) * 100 <
+                                       (float)config->writes;
+        int len;
+        if (config->binary && write) {
+            size_t start = binproto_begin(&client->updates, BIN_UPDATE);
+            len = sprintf(line, "k%08zu", k);
+            binproto_put_str(&client->updates, line, len);
+            binproto_put_str(&client->updates, "updated", 7);
+            binproto_end(&client->updates, start);
+            client->expected++;
+        } else if (config->binary) {
+            len = sprintf(line, "k%08zu", k);
+            binproto_put_str(&client->req, line, len);
+            searches++;
+        } else if (write) {
+            len = sprintf(line, "alteracao k%08zu updated\n", k);
+            bytebuf_append(&client->req, line, len);
+        } else {
+            len = sprintf(line, "busca k%08zu\n", k);
+            bytebuf_append(&client->req, line, len);
+            client->expected++;
+        }
+    }
+
+    if (config->binary) {
+        client->req.data[mget + BINPROTO_HEADER + 1] = searches & 0xff;
+        client->req.data[mget + BINPROTO_HEADER + 2] = searches >> 8;
+        binproto_end(&client->req, mget);
+        bytebuf_append(&client->req, client->updates.data, client->updates.len);
+        client->expected++;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &client->started);
+}
+
+/**
+ * @brief Sends what is pending and counts the replies of a client.
+ *
+ * @return status_t \c SUCCESS, \c EOF_ERR once the client has no more
+ * commands, or \c CRITICAL_ERR if the connection broke or got more replies
+ * than expected.
+ */
+static status_t client_on_event(client_t *client, samples_t *samples,
+                                const loadgen_config_t *config, int epfd) {
+    if (client->req_sent < client->req.len) {
+        ssize_t n = send(client->fd, client->req.data + client->req_sent,
+                         client->req.len - client->req_sent, MSG_NOSIGNAL);
+        if (n < 0 && EAGAIN != errno && EINTR != errno) return CRITICAL_ERR;
+        if (n > 0) client->req_sent += (size_t)n;
+
+        // Everything sent: only replies are awaited now
+        if (client->req_sent == client->req.len) {
+            struct epoll_event ev = {.events = EPOLLIN, .data.ptr = client};
+            epoll_ctl(epfd, EPOLL_CTL_MOD, client->fd, &ev);
+        }
+    }
+
+    unsigned char buf[LOADGEN_CHUNK / 4];
+    ssize_t n = recv(client->fd, buf, sizeof(buf), MSG_DONTWAIT);
+    if (0 == n) return CRITICAL_ERR; // the server closed
+    if (n < 0) return (EAGAIN == errno || EINTR == errno) ? SUCCESS
+                                                          : CRITICAL_ERR;
+
+    size_t replies = 0, rejected = 0;
+    status_t flag = count_replies(config, &client->partial, buf, (size_t)n,
+                                  &replies, &rejected);
+    if (SUCCESS != flag) return flag;
+    if (replies > client->expected) return CRITICAL_ERR; // out of sync
+    client->expected -= replies;
+
+    if (client->expected > 0 || client->req_sent < client->req.len)
+        return SUCCESS;
+
+    // Window complete
+    samples->us[samples->count++] = elapsed_us(&client->started);
+    if (0 == client->remaining) return EOF_ERR;
+
+    client_next_window(client, config);
+    struct epoll_event ev = {.events = EPOLLIN | EPOLLOUT, .data.ptr = client};
+    epoll_ctl(epfd, EPOLL_CTL_MOD, client->fd, &ev);
+    return SUCCESS;
+}
+
+static double elapsed_us(const struct timespec *from) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - from->tv_sec) * 1e6 +
+           (now.tv_nsec - from->tv_nsec) / 1e3;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Writes the benchmark report.
+ */
+static void loadgen_report(FILE *report, const loadgen_config_t *config,
+                           samples_t *samples, double prefill_us,
+                           size_t rejected, double total_us) {
+    qsort(samples->us, samples->count, sizeof(double), cmp_double);
+    double *us = samples->us;
+    size_t last = samples->count ? samples->count - 1 : 0;
+
+    fprintf(report, "prefill: %zu keys in %.3f s (%zu rejected)\n",
+            config->keys, prefill_us / 1e6, rejected);
+    fprintf(report,
+            "requests: %zu (%zu clients, window %zu, %u%% writes, %s)\n",
+            config->requests, config->clients, config->window,
+            config->writes, config->binary ? "binary" : "text");
+    if (config->zipf > 0)
+        fprintf(report, "keys: zipfian, skew %.2f\n", config->zipf);
+    fprintf(report, "elapsed: %.3f s\n", total_us / 1e6);
+    fprintf(report, "throughput: %.0f req/s\n",
+            total_us > 0 ? config->requests / (total_us / 1e6) : 0.0);
+    if (0 == samples->count) return;
+    fprintf(report,
+            "window latency (us): p50 %.0f, p90 %.0f, p99 %.0f, max %.0f\n",
+            us[last * 50 / 100], us[last * 90 / 100], us[last * 99 / 100],
+            us[last]);
+}
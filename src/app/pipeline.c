@@ -0,0 +1,126 @@
+#include <pthread.h>
+
+#include "app/pipeline.h"
+#include "utils/ring.h"
+
+//=============================================================================/
+//=================|    Data Structures     |==================================/
+//=============================================================================/
+
+/**
+ * @brief State shared by the stages.
+ */
+typedef struct {
+    Backend *backend;
+    Ring *commands; // parser -> executor, of command_t
+    Ring *replies;  // executor -> writer, of reply_t
+} pipeline_t;
+
+//=============================================================================/
+//=================|    Private Function Declarations     |====================/
+//=============================================================================/
+
+static void *parser_loop(void *arg);
+static void *executor_loop(void *arg);
+static void reply_push(reply_t *reply, void *ctx);
+
+//=============================================================================/
+//=================|    Public Function Implementations     |==================/
+//=============================================================================/
+
+status_t pipeline_run(Backend *backend, FILE *out, size_t depth) {
+    if (NULL == backend || NULL == out) return NUL_ERR;
+    if (0 == depth) depth = PIPELINE_DEPTH;
+
+    pipeline_t pipeline = (pipeline_t){
+        .backend = backend,
+        .commands = ring_new(depth, sizeof(command_t)),
+        .replies = ring_new(depth, sizeof(reply_t)),
+    };
+
+    status_t result = SUCCESS;
+    pthread_t parser, executor;
+
+    if (NULL == pipeline.commands || NULL == pipeline.replies) {
+        result = ALLOC_ERR;
+    } else if (0 != pthread_create(&executor, NULL, executor_loop,
+                                   &pipeline)) {
+        result = CRITICAL_ERR;
+    } else if (0 != pthread_create(&parser, NULL, parser_loop, &pipeline)) {
+        // err handling: nothing was read yet, let the executor finish
+        ring_close(pipeline.commands);
+        pthread_join(executor, NULL);
+        result = CRITICAL_ERR;
+    } else {
+        // Writer stage
+        reply_t reply;
+        while (SUCCESS == ring_pop(pipeline.replies, &reply)) {
+            reply_write(&reply, out);
+            reply_clear(&reply);
+        }
+
+        pthread_join(parser, NULL);
+        pthread_join(executor, NULL);
+    }
+
+    ring_del(&pipeline.commands);
+    ring_del(&pipeline.replies);
+    return result;
+}
+
+//=============================================================================/
+//=================|    Private Function Implementations    |==================/
+//=============================================================================/
+
+/**
+ * @brief Parser stage: reads the commands until eof (or a last command).
+ */
+static void *parser_loop(void *arg) {
+    pipeline_t *pipeline = (pipeline_t *)arg;
+
+    command_t cmd;
+    while (SUCCESS == command_read(&cmd)) {
+        ring_push(pipeline->commands, &cmd);
+        if (cmd.last) break;
+    }
+
+    ring_close(pipeline->commands);
+    return NULL;
+}
+
+/**
+ * @brief Executor stage: applies the commands in order. Pending insertions
+ * are flushed whenever the parser falls behind, so an interactive session
+ * still sees its replies right away.
+ */
+static void *executor_loop(void *arg) {
+    pipeline_t *pipeline = (pipeline_t *)arg;
+
+    Executor *executor = executor_new(pipeline->backend, reply_push,
+                                      pipeline->replies);
+
+    command_t cmd;
+    while (NULL != executor) {
+        if (ring_is_empty(pipeline->commands)) executor_flush(executor);
+        if (SUCCESS != ring_pop(pipeline->commands, &cmd)) break;
+        executor_submit(executor, &cmd);
+    }
+
+    // err handling: without an executor, drain the commands unexecuted
+    while (NULL == executor && SUCCESS == ring_pop(pipeline->commands, &cmd)) {
+        reply_t reply = (reply_t){.op = cmd.op, .status = ALLOC_ERR};
+        item_del(&cmd.item);
+        reply_push(&reply, pipeline->replies);
+    }
+
+    executor_del(&executor);
+    ring_close(pipeline->replies);
+    return NULL;
+}
+
+/**
+ * @brief Reply sink of the executor: hands the reply to the writer.
+ */
+static void reply_push(reply_t *reply, void *ctx) {
+    ring_push((Ring *)ctx, reply);
+}
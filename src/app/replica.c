@@ -0,0 +1,694 @@
+#include <errno.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "app/binproto.h"
+#include "app/replica.h"
+#include "utils/bytebuf.h"
+#include "utils/netutils.h"
+
+// Bytes read from a socket at a time, and max events per epoll_wait.
+#define REPLICA_CHUNK (64 * 1024)
+#define REPLICA_EVENTS (64)
+
+// Bytes of a frame before its strings: length, opcode and number.
+#define REPLICA_HEADER (BINPROTO_HEADER + 1 + 8)
+
+//=============================================================================/
+//=================|    Data Structures     |==================================/
+//=============================================================================/
+
+/**
+ * @brief A follower, as the leader sees it.
+ */
+typedef struct _peer_s {
+    int fd;
+    uint32_t events; // current epoll interest
+    struct _peer_s *prev;
+    struct _peer_s *next;
+
+    ByteBuf in;  // the hello, until it is complete
+    ByteBuf out; // frames not sent yet, from out_sent on
+    size_t out_sent;
+
+    uint64_t next_seq; // next frame of the backlog to queue, 0 before hello
+    _Bool closing;     // hang up once out is sent
+} peer_t;
+
+struct _leader_s {
+    Backend *backend;
+    char *addr;
+    int listen_fd;
+    int epfd;
+    peer_t *peers;
+
+    // The backlog: frames first to seq, back to back
+    ByteBuf log;
+    size_t *starts; // where every frame starts in log
+    size_t count;
+    size_t room;
+    size_t max_bytes;
+    uint64_t first; // number of the first frame of the backlog
+    uint64_t seq;   // number of the last frame recorded
+};
+
+struct _follower_s {
+    Backend *backend;
+    int fd;
+    ByteBuf in;      // received bytes not applied yet (a partial frame)
+    uint64_t seq;    // number of the last frame applied
+    status_t error;  // why it stopped, SUCCESS while it goes on
+    _Bool resyncing; // dropping the old stream, see follower_resync()
+};
+
+/**
+ * @brief A reader of a received frame body.
+ */
+typedef struct {
+    const unsigned char *at;
+    size_t left;
+    _Bool broken; // read past the end
+} cursor_t;
+
+//=============================================================================/
+//=================|    Private Function Declarations     |====================/
+//=============================================================================/
+
+static void leader_record(void *ctx, skiplist_op_kind_t kind,
+                          const Item *item);
+static void leader_trim(Leader *leader);
+static void leader_accept(Leader *leader);
+static status_t leader_hello(Leader *leader, peer_t *peer);
+static status_t leader_snapshot(Leader *leader, peer_t *peer);
+static status_t leader_flush(Leader *leader, peer_t *peer);
+static void leader_close(Leader *leader, peer_t *peer);
+static status_t snapshot_put(Item *item, void *ctx);
+static status_t put_frame(ByteBuf *buf, replica_op_t op, uint64_t seq,
+                          const Item *item);
+static status_t follower_hello(Follower *follower, uint64_t from);
+static status_t follower_apply(Follower *follower, const unsigned char *body,
+                               size_t len);
+static status_t follower_write(Follower *follower, uint8_t op,
+                               const char *word, size_t word_len,
+                               const char *desc, size_t desc_len);
+static uint8_t cursor_u8(cursor_t *cur);
+static uint64_t cursor_u64(cursor_t *cur);
+static const char *cursor_str(cursor_t *cur, size_t *len);
+
+//=============================================================================/
+//=================|    Public Function Implementations     |==================/
+//=============================================================================/
+
+Leader *leader_new(Backend *backend, const char *addr, size_t backlog) {
+    if (NULL == backend || NULL == addr) return NULL;
+
+    Leader *leader = (Leader *)malloc(sizeof(Leader));
+    if (NULL == leader) return NULL; // err handling
+
+    *leader = (Leader){
+        .backend = backend,
+        .addr = strdup(addr),
+        .epfd = epoll_create1(0),
+        .max_bytes = backlog ? backlog : REPLICA_BACKLOG,
+        .first = 1,
+    };
+    leader->listen_fd = netutils_listen(addr, SOMAXCONN);
+
+    struct epoll_event ev = {.events = EPOLLIN, .data.ptr = NULL};
+    if (NULL == leader->addr || leader->epfd < 0 || leader->listen_fd < 0 ||
+        0 != epoll_ctl(leader->epfd, EPOLL_CTL_ADD, leader->listen_fd,
+                       &ev)) { // err handling
+        leader_del(&leader);
+        return NULL;
+    }
+
+    backend_journal(backend, leader_record, leader);
+    return leader;
+}
+
+void leader_del(Leader **leader) {
+    if (NULL == leader || NULL == *leader) return;
+    Leader *self = *leader;
+
+    while (NULL != self->peers) leader_close(self, self->peers);
+    if (self->listen_fd >= 0) {
+        backend_journal(self->backend, NULL, NULL);
+        close(self->listen_fd);
+        netutils_unlink(self->addr);
+    }
+    if (self->epfd >= 0) close(self->epfd);
+    bytebuf_free(&self->log);
+    free(self->starts);
+    free(self->addr);
+    free(self);
+    *leader = NULL;
+}
+
+int leader_fd(const Leader *leader) { return leader ? leader->epfd : -1; }
+
+status_t leader_pump(Leader *leader) {
+    if (NULL == leader) return NUL_ERR;
+
+    // An accept is followed by a hello: both go on until neither comes
+    for (_Bool busy = 1; busy;) {
+        busy = 0;
+
+        // PART 1: new followers and hellos
+        struct epoll_event events[REPLICA_EVENTS];
+        int n = epoll_wait(leader->epfd, events, REPLICA_EVENTS, 0);
+        for (int i = 0; i < n; i++) {
+            peer_t *peer = (peer_t *)events[i].data.ptr;
+            if (NULL == peer) {
+                leader_accept(leader);
+                busy = 1;
+                continue;
+            }
+            if (!(events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)))
+                continue;
+
+            // A follower only ever sends hellos, see follower_resync()
+            char chunk[REPLICA_CHUNK];
+            ssize_t got = read(peer->fd, chunk, sizeof(chunk));
+            if (0 == got || (got < 0 && EAGAIN != errno && EINTR != errno)) {
+                leader_close(leader, peer);
+                continue;
+            }
+            if (got > 0) busy = 1;
+            if (got > 0 && !peer->closing &&
+                (SUCCESS != bytebuf_append(&peer->in, chunk, (size_t)got) ||
+                 SUCCESS != leader_hello(leader, peer)))
+                leader_close(leader, peer); // err handling
+        }
+
+        // PART 2: what was recorded since, to everyone
+        for (peer_t *peer = leader->peers, *next = NULL; NULL != peer;
+             peer = next) {
+            next = peer->next;
+            if (SUCCESS != leader_flush(leader, peer))
+                leader_close(leader, peer);
+        }
+    }
+
+    return SUCCESS;
+}
+
+size_t leader_drain(Leader *leader, int timeout_ms) {
+    if (NULL == leader) return 0;
+
+    struct timespec start, now;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (;;) {
+        leader_pump(leader);
+
+        size_t behind = 0;
+        for (peer_t *peer = leader->peers; NULL != peer; peer = peer->next)
+            behind += 0 == peer->next_seq || peer->next_seq <= leader->seq ||
+                      peer->out_sent < peer->out.len;
+        if (0 == behind) return 0;
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        long spent = (now.tv_sec - start.tv_sec) * 1000 +
+                     (now.tv_nsec - start.tv_nsec) / 1000000;
+        if (spent >= timeout_ms) return behind;
+
+        struct epoll_event ev;
+        epoll_wait(leader->epfd, &ev, 1, (int)(timeout_ms - spent));
+    }
+}
+
+uint64_t leader_seq(const Leader *leader) { return leader ? leader->seq : 0; }
+
+Follower *follower_new(Backend *backend, const char *addr, uint64_t from) {
+    if (NULL == backend || NULL == addr) return NULL;
+
+    // Its words only go away with the stream, see replica.h
+    skiplist_config_t config = backend_config(backend);
+    if (config.max_length || config.max_bytes || config.ttl) return NULL;
+
+    Follower *follower = (Follower *)malloc(sizeof(Follower));
+    if (NULL == follower) return NULL; // err handling
+
+    *follower = (Follower){
+        .backend = backend,
+        .fd = netutils_connect(addr),
+        .seq = from ? from - 1 : 0,
+    };
+
+    // The hello goes out on the blocking socket
+    if (follower->fd < 0 || SUCCESS != follower_hello(follower, from) ||
+        SUCCESS != netutils_set_nonblocking(follower->fd)) { // err handling
+        follower_del(&follower);
+        return NULL;
+    }
+
+    backend_read_only(backend, 1);
+    return follower;
+}
+
+void follower_del(Follower **follower) {
+    if (NULL == follower || NULL == *follower) return;
+    if ((*follower)->fd >= 0) close((*follower)->fd);
+    bytebuf_free(&(*follower)->in);
+    free(*follower);
+    *follower = NULL;
+}
+
+int follower_fd(const Follower *follower) {
+    return follower ? follower->fd : -1;
+}
+
+status_t follower_pump(Follower *follower) {
+    if (NULL == follower) return NUL_ERR;
+    if (SUCCESS != follower->error) return follower->error;
+
+    // PART 1: whatever arrived
+    _Bool eof = 0;
+    for (;;) {
+        if (SUCCESS != bytebuf_reserve(&follower->in,
+                                       follower->in.len + REPLICA_CHUNK))
+            return follower->error = ALLOC_ERR; // err handling
+
+        ssize_t n = read(follower->fd, follower->in.data + follower->in.len,
+                         REPLICA_CHUNK);
+        if (n > 0) {
+            follower->in.len += (size_t)n;
+            continue;
+        }
+        if (0 == n) eof = 1;
+        else if (EINTR == errno) continue;
+        else if (EAGAIN != errno) eof = 1; // the connection broke
+        break;
+    }
+
+    // PART 2: every complete frame, in order
+    size_t start = 0, len = 0;
+    status_t flag = SUCCESS;
+    while (SUCCESS == flag) {
+        flag = binproto_frame(follower->in.data + start,
+                              follower->in.len - start, &len);
+        if (SUCCESS != flag || 0 == len) break;
+
+        flag = follower_apply(follower,
+                              follower->in.data + start + BINPROTO_HEADER,
+                              len - BINPROTO_HEADER);
+        start += len;
+    }
+    bytebuf_consume(&follower->in, start);
+
+    if (SUCCESS == flag && eof) flag = EOF_ERR;
+    return follower->error = flag;
+}
+
+status_t follower_resync(Follower *follower) {
+    if (NULL == follower) return NUL_ERR;
+
+    status_t flag = backend_clear(follower->backend);
+    if (SUCCESS == flag) flag = follower_hello(follower, 0);
+    if (SUCCESS != flag) return follower->error = flag; // err handling
+
+    follower->seq = 0;
+    follower->error = SUCCESS;
+    follower->resyncing = 1;
+    return SUCCESS;
+}
+
+uint64_t follower_seq(const Follower *follower) {
+    return follower ? follower->seq : 0;
+}
+
+//=============================================================================/
+//=================|    Private Function Implementations    |==================/
+//=============================================================================/
+
+/**
+ * @brief Journal of the backend, see backend_journal(): appends the write
+ * to the backlog as the next frame.
+ */
+static void leader_record(void *ctx, skiplist_op_kind_t kind,
+                          const Item *item) {
+    Leader *leader = (Leader *)ctx;
+    replica_op_t op = SKIPLIST_INSERT == kind   ? REPLICA_INSERT
+                      : SKIPLIST_UPDATE == kind ? REPLICA_UPDATE
+                                                : REPLICA_REMOVE;
+    leader->seq++;
+
+    status_t flag = SUCCESS;
+    if (leader->count == leader->room) {
+        size_t room = leader->room ? 2 * leader->room : 1024;
+        size_t *starts =
+            (size_t *)realloc(leader->starts, room * sizeof(size_t));
+        if (NULL == starts) flag = ALLOC_ERR; // err handling
+        else {
+            leader->starts = starts;
+            leader->room = room;
+        }
+    }
+
+    size_t start = leader->log.len;
+    if (SUCCESS == flag) flag = put_frame(&leader->log, op, leader->seq, item);
+
+    // A frame that could not be kept breaks the stream: the backlog starts
+    // over after it, and the followers go
+    if (SUCCESS != flag) {
+        leader->log.len = leader->count = 0;
+        leader->first = leader->seq + 1;
+        for (peer_t *peer = leader->peers, *next = NULL; NULL != peer;
+             peer = next) {
+            next = peer->next;
+            if (peer->next_seq) leader_close(leader, peer);
+        }
+        return;
+    }
+
+    leader->starts[leader->count++] = start;
+    if (leader->log.len > leader->max_bytes) leader_trim(leader);
+}
+
+/**
+ * @brief Drops the older half of the backlog, and the followers that did not
+ * get it yet.
+ */
+static void leader_trim(Leader *leader) {
+    size_t k = 1;
+    while (k < leader->count - 1 && leader->starts[k] < leader->log.len / 2)
+        k++;
+    if (k >= leader->count) return; // a single frame
+
+    size_t cut = leader->starts[k];
+    bytebuf_consume(&leader->log, cut);
+    leader->count -= k;
+    for (size_t i = 0; i < leader->count; i++)
+        leader->starts[i] = leader->starts[i + k] - cut;
+    leader->first += k;
+
+    for (peer_t *peer = leader->peers, *next = NULL; NULL != peer;
+         peer = next) {
+        next = peer->next;
+        if (peer->next_seq && peer->next_seq < leader->first)
+            leader_close(leader, peer);
+    }
+}
+
+/**
+ * @brief Accepts every pending follower.
+ */
+static void leader_accept(Leader *leader) {
+    for (;;) {
+        int fd = accept(leader->listen_fd, NULL, NULL);
+        if (fd < 0) return; // EAGAIN: no more pending connections
+
+        peer_t *peer = NULL;
+        if (SUCCESS == netutils_set_nonblocking(fd))
+            peer = (peer_t *)calloc(1, sizeof(peer_t));
+
+        struct epoll_event ev = {.events = EPOLLIN, .data.ptr = peer};
+        if (NULL == peer ||
+            0 != epoll_ctl(leader->epfd, EPOLL_CTL_ADD, fd, &ev)) {
+            close(fd); // err handling
+            free(peer);
+            continue;
+        }
+
+        peer->fd = fd;
+        peer->events = EPOLLIN;
+        peer->next = leader->peers;
+        if (NULL != leader->peers) leader->peers->prev = peer;
+        leader->peers = peer;
+    }
+}
+
+/**
+ * @brief Answers the hello of a follower, once it is complete: the limits of
+ * the backend, then a snapshot, the backlog from the number asked for, or
+ * \c GONE.
+ *
+ * @return status_t \c SUCCESS, or an error if the follower must go.
+ */
+static status_t leader_hello(Leader *leader, peer_t *peer) {
+    size_t len = 0;
+    if (SUCCESS != binproto_frame(peer->in.data, peer->in.len, &len))
+        return CRITICAL_ERR; // err handling
+    if (0 == len) return SUCCESS; // not all here yet
+
+    cursor_t cur = (cursor_t){.at = peer->in.data + BINPROTO_HEADER,
+                              .left = len - BINPROTO_HEADER};
+    uint8_t op = cursor_u8(&cur);
+    uint64_t from = cursor_u64(&cur);
+    bytebuf_free(&peer->in);
+    if (cur.broken || REPLICA_HELLO != op) return CRITICAL_ERR;
+
+    if (0 == from) return leader_snapshot(leader, peer);
+    if (from >= leader->first && from <= leader->seq + 1) {
+        peer->next_seq = from;
+        return SUCCESS;
+    }
+
+    peer->closing = 1;
+    return put_frame(&peer->out, REPLICA_GONE, leader->first, NULL);
+}
+
+/**
+ * @brief Queues the whole dictionary for a follower, then points it to the
+ * frames that come after.
+ */
+static status_t leader_snapshot(Leader *leader, peer_t *peer) {
+    status_t flag = put_frame(&peer->out, REPLICA_SNAPSHOT, leader->seq, NULL);
+    if (SUCCESS == flag)
+        flag = backend_foreach(leader->backend, snapshot_put, &peer->out);
+    if (SUCCESS != flag) return flag; // err handling
+
+    peer->next_seq = leader->seq + 1;
+    return SUCCESS;
+}
+
+/**
+ * @brief Visitor that queues an item of a snapshot.
+ */
+static status_t snapshot_put(Item *item, void *ctx) {
+    return put_frame((ByteBuf *)ctx, REPLICA_INSERT, 0, item);
+}
+
+/**
+ * @brief Queues the frames of the backlog a follower did not get yet, up to
+ * REPLICA_OUT_HIGH pending bytes, and sends as much as its socket takes.
+ *
+ * @return status_t \c SUCCESS, or an error if the follower must go.
+ */
+static status_t leader_flush(Leader *leader, peer_t *peer) {
+    // PART 1: queue
+    while (peer->next_seq && peer->next_seq <= leader->seq &&
+           peer->out.len - peer->out_sent < REPLICA_OUT_HIGH) {
+        size_t k = (size_t)(peer->next_seq - leader->first);
+        size_t end = k + 1 < leader->count ? leader->starts[k + 1]
+                                           : leader->log.len;
+        if (SUCCESS != bytebuf_append(&peer->out,
+                                      leader->log.data + leader->starts[k],
+                                      end - leader->starts[k]))
+            return ALLOC_ERR; // err handling
+        peer->next_seq++;
+    }
+
+    // PART 2: send
+    while (peer->out_sent < peer->out.len) {
+        ssize_t n = send(peer->fd, peer->out.data + peer->out_sent,
+                         peer->out.len - peer->out_sent, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (EAGAIN == errno || EINTR == errno) break;
+            return CRITICAL_ERR;
+        }
+        peer->out_sent += (size_t)n;
+    }
+    if (peer->out_sent == peer->out.len) {
+        peer->out.len = peer->out_sent = 0;
+        if (peer->closing) return EOF_ERR;
+    }
+
+    // PART 3: wait for the socket while something is pending
+    uint32_t events = EPOLLIN;
+    if (peer->out.len > 0) events |= EPOLLOUT;
+    if (events == peer->events) return SUCCESS;
+
+    peer->events = events;
+    struct epoll_event ev = {.events = events, .data.ptr = peer};
+    if (0 != epoll_ctl(leader->epfd, EPOLL_CTL_MOD, peer->fd, &ev))
+        return CRITICAL_ERR;
+    return SUCCESS;
+}
+
+static void leader_close(Leader *leader, peer_t *peer) {
+    if (NULL != peer->prev) peer->prev->next = peer->next;
+    else leader->peers = peer->next;
+    if (NULL != peer->next) peer->next->prev = peer->prev;
+
+    epoll_ctl(leader->epfd, EPOLL_CTL_DEL, peer->fd, NULL);
+    close(peer->fd);
+    bytebuf_free(&peer->in);
+    bytebuf_free(&peer->out);
+    free(peer);
+}
+
+/**
+ * @brief Appends a frame: a write with its item, or a bare number.
+ *
+ * @param buf where it goes.
+ * @param op the opcode.
+ * @param seq the number.
+ * @param item the item of an \c INSERT or an \c UPDATE, the key of a
+ * \c REMOVE, NULL otherwise.
+ * @return status_t \c SUCCESS, or \c ALLOC_ERR (buf is unchanged).
+ */
+static status_t put_frame(ByteBuf *buf, replica_op_t op, uint64_t seq,
+                          const Item *item) {
+    size_t start = buf->len;
+    status_t flag = bytebuf_put_u32(buf, 0);
+    if (SUCCESS == flag) flag = bytebuf_put_u8(buf, (uint8_t)op);
+    if (SUCCESS == flag) flag = bytebuf_put_u64(buf, seq);
+
+    if (SUCCESS == flag && NULL != item) {
+        const char *word = item_word(item);
+        flag = binproto_put_str(buf, word, strlen(word));
+    }
+    if (SUCCESS == flag && NULL != item && REPLICA_REMOVE != op) {
+        const char *description = item_description(item);
+        flag = binproto_put_str(buf, description, strlen(description));
+    }
+
+    if (SUCCESS != flag) { // err handling
+        buf->len = start;
+        return flag;
+    }
+    binproto_end(buf, start);
+    return SUCCESS;
+}
+
+/**
+ * @brief Sends a hello, see replica.h. It is small enough for any socket
+ * that takes it at all.
+ *
+ * @return status_t \c SUCCESS, \c ALLOC_ERR, or \c CRITICAL_ERR if it could
+ * not be sent whole.
+ */
+static status_t follower_hello(Follower *follower, uint64_t from) {
+    ByteBuf hello = (ByteBuf){0};
+    size_t start = hello.len;
+    bytebuf_put_u32(&hello, 0);
+    bytebuf_put_u8(&hello, REPLICA_HELLO);
+    bytebuf_put_u64(&hello, from);
+    binproto_end(&hello, start);
+
+    ssize_t sent = hello.len != REPLICA_HEADER
+                       ? -1
+                       : send(follower->fd, hello.data, hello.len,
+                              MSG_NOSIGNAL);
+    status_t flag = hello.len != REPLICA_HEADER ? ALLOC_ERR
+                    : (size_t)sent != REPLICA_HEADER ? CRITICAL_ERR
+                                                     : SUCCESS;
+    bytebuf_free(&hello);
+    return flag;
+}
+
+/**
+ * @brief Applies a frame received by a follower.
+ *
+ * @return status_t \c SUCCESS, or why the follower must stop, see
+ * follower_pump().
+ */
+static status_t follower_apply(Follower *follower, const unsigned char *body,
+                               size_t len) {
+    cursor_t cur = (cursor_t){.at = body, .left = len};
+    uint8_t op = cursor_u8(&cur);
+    uint64_t seq = cursor_u64(&cur);
+    size_t word_len = 0, desc_len = 0;
+    const char *word = cursor_str(&cur, &word_len);
+    const char *desc = REPLICA_REMOVE == op ? "" : cursor_str(&cur, &desc_len);
+
+    // Until the snapshot of follower_resync(), the frames are the old ones
+    if (follower->resyncing && REPLICA_SNAPSHOT != op) return SUCCESS;
+
+    switch (op) {
+    case REPLICA_SNAPSHOT:
+        follower->seq = seq;
+        follower->resyncing = 0;
+        return SUCCESS;
+    case REPLICA_GONE:
+        return NOT_FOUND_ERR;
+    case REPLICA_INSERT:
+    case REPLICA_UPDATE:
+    case REPLICA_REMOVE:
+        break;
+    default:
+        return CRITICAL_ERR;
+    }
+
+    // The items of a snapshot are numbered 0, the writes one after the other
+    if (cur.broken || (0 != seq && follower->seq + 1 != seq))
+        return CRITICAL_ERR; // err handling
+
+    // A write that does not apply leaves the backend off the stream
+    if (SUCCESS != follower_write(follower, op, word, word_len, desc, desc_len))
+        return CRITICAL_ERR; // err handling
+
+    if (0 != seq) follower->seq = seq;
+    return SUCCESS;
+}
+
+/**
+ * @brief Replays a write on the backend of a follower. Its words only change
+ * with the stream (see replica.h), so every write applies as it is.
+ *
+ * @return status_t \c SUCCESS, or why the write did not apply.
+ */
+static status_t follower_write(Follower *follower, uint8_t op,
+                               const char *word, size_t word_len,
+                               const char *desc, size_t desc_len) {
+    item_buf_t key; // updates and removals never allocate
+    if (REPLICA_REMOVE == op)
+        return backend_replay(follower->backend, SKIPLIST_REMOVE,
+                              item_place(&key, word, word_len, NULL, 0));
+    if (REPLICA_UPDATE == op)
+        return backend_replay(follower->backend, SKIPLIST_UPDATE,
+                              item_place(&key, word, word_len, desc, desc_len));
+
+    Item *item = item_new_from(word, word_len, desc, desc_len);
+    if (NULL == item) return ALLOC_ERR; // err handling
+    status_t flag = backend_replay(follower->backend, SKIPLIST_INSERT, item);
+    if (SUCCESS != flag) item_del(&item); // err handling
+    return flag;
+}
+
+static uint8_t cursor_u8(cursor_t *cur) {
+    if (cur->left < 1) {
+        cur->broken = 1;
+        return 0;
+    }
+    cur->left--;
+    return *cur->at++;
+}
+
+static uint64_t cursor_u64(cursor_t *cur) {
+    if (cur->left < 8) {
+        cur->broken = 1;
+        return 0;
+    }
+    uint64_t value = bytebuf_get_u64(cur->at);
+    cur->at += 8;
+    cur->left -= 8;
+    return value;
+}
+
+static const char *cursor_str(cursor_t *cur, size_t *len) {
+    *len = cursor_u8(cur);
+    if (cur->broken || cur->left < *len) {
+        cur->broken = 1;
+        *len = 0;
+        return "";
+    }
+    const char *s = (const char *)cur->at;
+    cur->at += *len;
+    cur->left -= *len;
+    return s;
+}
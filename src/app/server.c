@@ -0,0 +1,380 @@
+#include <errno.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "app/binproto.h"
+#include "app/command.h"
+#include "app/server.h"
+#include "utils/bytebuf.h"
+#include "utils/netutils.h"
+
+// Bytes read from a socket at a time, and max events per epoll_wait.
+#define SERVER_CHUNK (64 * 1024)
+#define SERVER_EVENTS (256)
+
+//=============================================================================/
+//=================|    Data Structures     |==================================/
+//=============================================================================/
+
+/**
+ * @brief A client connection.
+ */
+typedef struct _conn_s {
+    int fd;
+    uint32_t events; // current epoll interest
+    struct _conn_s *prev;
+    struct _conn_s *next;
+
+    ByteBuf in;      // received bytes not executed yet (a partial request)
+    ByteBuf out;     // replies, not sent yet from out_sent on
+    size_t out_sent;
+
+    _Bool eof;  // the client will not send anything else
+    _Bool skip; // the rest of a cut line is being dropped
+
+    Block *block; // its writes since inicio, see executor_swap_block()
+} conn_t;
+
+/**
+ * @brief The server state.
+ */
+typedef struct {
+    Backend *backend;
+    _Bool binary; // see binproto.h
+    int epfd;
+    int listen_fd;
+    size_t clients;
+    size_t max_clients;
+    conn_t *conns; // every open connection
+
+    Executor *executor;
+    FILE *render; // the replies of the running burst are written here
+    char *render_buf;
+    size_t render_len;
+} server_t;
+
+static volatile sig_atomic_t server_stopping = 0;
+
+// Tells the events of server_config_t::watch_fd apart.
+static char server_watch;
+
+//=============================================================================/
+//=================|    Private Function Declarations     |====================/
+//=============================================================================/
+
+static void server_on_signal(int sig);
+static void server_raise_fd_limit(void);
+static void server_accept(server_t *server);
+static void server_on_event(server_t *server, conn_t *conn, uint32_t events);
+static void server_execute(server_t *server, conn_t *conn);
+static status_t server_execute_binary(server_t *server, conn_t *conn);
+static void server_close(server_t *server, conn_t *conn);
+static void server_sink(reply_t *reply, void *ctx);
+static status_t conn_read(conn_t *conn);
+static status_t conn_write(conn_t *conn);
+static status_t conn_watch(server_t *server, conn_t *conn);
+
+//=============================================================================/
+//=================|    Public Function Implementations     |==================/
+//=============================================================================/
+
+status_t server_run(Backend *backend, const server_config_t *config) {
+    if (NULL == backend || NULL == config) return NUL_ERR;
+
+    server_t server = (server_t){
+        .backend = backend,
+        .binary = config->binary,
+        .epfd = -1,
+        .max_clients = config->max_clients ? config->max_clients
+                                           : SERVER_MAX_CLIENTS,
+    };
+
+    server_raise_fd_limit();
+
+    server.listen_fd = netutils_listen(config->addr, SOMAXCONN);
+    if (server.listen_fd < 0) return NOT_FOUND_ERR; // err handling
+
+    status_t result = SUCCESS;
+    server.epfd = epoll_create1(0);
+    server.render = open_memstream(&server.render_buf, &server.render_len);
+    server.executor = executor_new(backend, server_sink, &server);
+
+    struct epoll_event ev = {.events = EPOLLIN, .data.ptr = NULL};
+    if (server.epfd < 0 || NULL == server.render || NULL == server.executor ||
+        0 != epoll_ctl(server.epfd, EPOLL_CTL_ADD, server.listen_fd, &ev))
+        result = CRITICAL_ERR; // err handling
+
+    _Bool watching = NULL != config->on_watch;
+    struct epoll_event wev = {.events = EPOLLIN, .data.ptr = &server_watch};
+    if (SUCCESS == result && watching &&
+        0 != epoll_ctl(server.epfd, EPOLL_CTL_ADD, config->watch_fd, &wev))
+        result = CRITICAL_ERR; // err handling
+
+    // Stop on SIGINT/SIGTERM; a peer closing early must not kill us
+    struct sigaction sa = {.sa_handler = server_on_signal};
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    struct epoll_event events[SERVER_EVENTS];
+    while (SUCCESS == result && !server_stopping) {
+        int n = epoll_wait(server.epfd, events, SERVER_EVENTS, -1);
+        if (n < 0 && EINTR != errno) result = CRITICAL_ERR;
+
+        for (int i = 0; i < n; i++) {
+            if (NULL == events[i].data.ptr) server_accept(&server);
+            else if (&server_watch == events[i].data.ptr) continue; // below
+            else server_on_event(&server, events[i].data.ptr, events[i].events);
+        }
+
+        if (watching && SUCCESS != config->on_watch(config->watch_ctx)) {
+            epoll_ctl(server.epfd, EPOLL_CTL_DEL, config->watch_fd, NULL);
+            watching = 0;
+        }
+    }
+
+    // Clean up
+    while (NULL != server.conns) server_close(&server, server.conns);
+    executor_del(&server.executor);
+    if (server.render) fclose(server.render);
+    free(server.render_buf);
+    if (server.epfd >= 0) close(server.epfd);
+    close(server.listen_fd);
+    netutils_unlink(config->addr);
+
+    return result;
+}
+
+//=============================================================================/
+//=================|    Private Function Implementations    |==================/
+//=============================================================================/
+
+static void server_on_signal(int sig) {
+    (void)sig;
+    server_stopping = 1;
+}
+
+/**
+ * @brief Lets the process open as many sockets as the hard limit allows.
+ */
+static void server_raise_fd_limit(void) {
+    struct rlimit lim;
+    if (0 != getrlimit(RLIMIT_NOFILE, &lim)) return;
+    lim.rlim_cur = lim.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &lim);
+}
+
+/**
+ * @brief Accepts every pending connection. Over the client limit, they are
+ * closed right away.
+ */
+static void server_accept(server_t *server) {
+    for (;;) {
+        int fd = accept(server->listen_fd, NULL, NULL);
+        if (fd < 0) return; // EAGAIN: no more pending connections
+
+        conn_t *conn = NULL;
+        if (server->clients < server->max_clients &&
+            SUCCESS == netutils_set_nonblocking(fd))
+            conn = (conn_t *)calloc(1, sizeof(conn_t));
+
+        if (NULL == conn) { // err handling
+            close(fd);
+            continue;
+        }
+
+        conn->fd = fd;
+        conn->events = EPOLLIN;
+        struct epoll_event ev = {.events = conn->events, .data.ptr = conn};
+        if (0 != epoll_ctl(server->epfd, EPOLL_CTL_ADD, fd, &ev)) {
+            close(fd);
+            free(conn);
+            continue;
+        }
+        conn->next = server->conns;
+        if (NULL != server->conns) server->conns->prev = conn;
+        server->conns = conn;
+        server->clients++;
+    }
+}
+
+/**
+ * @brief Reads, executes and answers what a connection is ready for.
+ */
+static void server_on_event(server_t *server, conn_t *conn, uint32_t events) {
+    status_t flag = SUCCESS;
+
+    if (events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+        flag = conn_read(conn);
+        if (SUCCESS == flag && server->binary)
+            flag = server_execute_binary(server, conn);
+        else if (SUCCESS == flag)
+            server_execute(server, conn);
+    }
+
+    if (SUCCESS == flag) flag = conn_write(conn);
+    if (SUCCESS == flag) flag = conn_watch(server, conn);
+    if (SUCCESS != flag) server_close(server, conn);
+}
+
+/**
+ * @brief Executes every complete line of the read buffer (and the last,
+ * unterminated one once the client is done) and queues the replies.
+ */
+static void server_execute(server_t *server, conn_t *conn) {
+    size_t start = 0;
+    executor_swap_block(server->executor, &conn->block);
+
+    while (start < conn->in.len) {
+        char *nl = memchr(conn->in.data + start, '\n', conn->in.len - start);
+        size_t end = nl ? (size_t)(nl - (char *)conn->in.data) : conn->in.len;
+
+        // The tail of a line that was already cut and executed
+        if (conn->skip) {
+            conn->skip = NULL == nl;
+            start = nl ? end + 1 : end;
+            continue;
+        }
+
+        // Partial line: wait for the rest, unless it can never fit
+        if (NULL == nl && !conn->eof && end - start < SERVER_LINE_MAX) break;
+
+        size_t len = end - start;
+        if (len > SERVER_LINE_MAX) len = SERVER_LINE_MAX;
+
+        command_t cmd;
+        if (SUCCESS == command_parse((char *)conn->in.data + start, len, &cmd))
+            executor_submit(server->executor, &cmd);
+
+        conn->skip = NULL == nl;
+        start = nl ? end + 1 : end;
+    }
+
+    bytebuf_consume(&conn->in, start);
+
+    // The replies of this burst belong to this connection: move them over
+    executor_flush(server->executor);
+    executor_swap_block(server->executor, &conn->block);
+    fflush(server->render);
+    bytebuf_append(&conn->out, server->render_buf, server->render_len);
+    fseek(server->render, 0, SEEK_SET);
+}
+
+/**
+ * @brief Executes every complete frame of the read buffer and queues the
+ * responses, see binproto.h.
+ *
+ * @return status_t \c SUCCESS, or an error if the stream is broken.
+ */
+static status_t server_execute_binary(server_t *server, conn_t *conn) {
+    size_t start = 0, len = 0;
+    status_t flag = SUCCESS;
+
+    while (SUCCESS == flag) {
+        flag = binproto_frame(conn->in.data + start, conn->in.len - start, &len);
+        if (SUCCESS != flag || 0 == len) break;
+
+        flag = binproto_execute(server->backend,
+                                conn->in.data + start + BINPROTO_HEADER,
+                                len - BINPROTO_HEADER, &conn->out);
+        start += len;
+    }
+
+    bytebuf_consume(&conn->in, start);
+
+    // A truncated frame at the end of the stream is an error as well
+    if (SUCCESS == flag && conn->eof && conn->in.len > 0) flag = EOF_ERR;
+    return flag;
+}
+
+static void server_close(server_t *server, conn_t *conn) {
+    if (NULL != conn->prev) conn->prev->next = conn->next;
+    else server->conns = conn->next;
+    if (NULL != conn->next) conn->next->prev = conn->prev;
+
+    epoll_ctl(server->epfd, EPOLL_CTL_DEL, conn->fd, NULL);
+    close(conn->fd);
+    bytebuf_free(&conn->in);
+    bytebuf_free(&conn->out);
+    block_del(&conn->block); // never committed
+    free(conn);
+    server->clients--;
+}
+
+/**
+ * @brief Reply sink of the executor: renders the reply for the connection
+ * being executed.
+ */
+static void server_sink(reply_t *reply, void *ctx) {
+    server_t *server = (server_t *)ctx;
+    reply_write(reply, server->render);
+    reply_clear(reply);
+}
+
+/**
+ * @brief Reads what is available, unless the client is done or too far
+ * behind on its replies.
+ *
+ * @return status_t \c SUCCESS, or \c CRITICAL_ERR if the connection broke.
+ */
+static status_t conn_read(conn_t *conn) {
+    if (conn->eof || conn->out.len - conn->out_sent > SERVER_OUT_HIGH)
+        return SUCCESS;
+
+    if (SUCCESS != bytebuf_reserve(&conn->in, conn->in.len + SERVER_CHUNK))
+        return ALLOC_ERR; // err handling
+
+    ssize_t n = read(conn->fd, conn->in.data + conn->in.len, SERVER_CHUNK);
+    if (n > 0) conn->in.len += (size_t)n;
+    else if (0 == n) conn->eof = 1;
+    else if (EAGAIN != errno && EINTR != errno) return CRITICAL_ERR;
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Sends as much of the pending replies as the socket takes.
+ *
+ * @return status_t \c SUCCESS, or \c CRITICAL_ERR if the connection broke.
+ */
+static status_t conn_write(conn_t *conn) {
+    while (conn->out_sent < conn->out.len) {
+        ssize_t n = send(conn->fd, conn->out.data + conn->out_sent,
+                         conn->out.len - conn->out_sent, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (EAGAIN == errno || EINTR == errno) return SUCCESS;
+            return CRITICAL_ERR;
+        }
+        conn->out_sent += (size_t)n;
+    }
+
+    conn->out.len = conn->out_sent = 0;
+    return SUCCESS;
+}
+
+/**
+ * @brief Updates the epoll interest of a connection: read while it keeps up
+ * with its replies, write while some are pending.
+ *
+ * @return status_t \c SUCCESS, or \c EOF_ERR if the connection is done.
+ */
+static status_t conn_watch(server_t *server, conn_t *conn) {
+    size_t pending = conn->out.len - conn->out_sent;
+    if (conn->eof && 0 == pending) return EOF_ERR;
+
+    uint32_t events = 0;
+    if (!conn->eof && pending <= SERVER_OUT_HIGH) events |= EPOLLIN;
+    if (pending > 0) events |= EPOLLOUT;
+    if (events == conn->events) return SUCCESS;
+
+    conn->events = events;
+    struct epoll_event ev = {.events = events, .data.ptr = conn};
+    if (0 != epoll_ctl(server->epfd, EPOLL_CTL_MOD, conn->fd, &ev))
+        return CRITICAL_ERR;
+    return SUCCESS;
+}
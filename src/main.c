@@ -1,104 +1,427 @@
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
 #include <stdio.h>
+#include <string.h>
 #include <time.h>
+#include <unistd.h>
 
+#include "app/backend.h"
+#include "app/binproto.h"
+#include "app/command.h"
+#include "app/loader.h"
+#include "app/loadgen.h"
+#include "app/pipeline.h"
+#include "app/replica.h"
+#include "app/server.h"
 #include "tads/item.h"
-#include "tads/skiplist.h"
 #include "utils/strutils.h"
 
-#define INVALID_OP_MSG "OPERACAO INVALIDA\n"
+// Milliseconds the pump thread of the serial loop waits for the leader
+// before it looks at its stop flag again, see pump_loop().
+#define MAIN_PUMP_MS (100)
 
-int main() {
+/**
+ * @brief What the serial loop shares with its pump thread: the lock that
+ * keeps the two off the backend at once.
+ */
+typedef struct {
+    Leader *leader;
+    pthread_mutex_t lock;
+    _Bool stop; // under the lock
+} pump_t;
+
+/**
+ * @brief Reply sink of the serial loop: writes the reply right away.
+ */
+static void reply_print(reply_t *reply, void *ctx) {
+    reply_write(reply, (FILE *)ctx);
+    reply_clear(reply);
+}
+
+/**
+ * @brief Checks if a `--name` command line flag is present.
+ */
+static _Bool arg_flag(int argc, char *argv[], const char *name) {
+    for (int i = 1; i < argc; i++)
+        if (0 == strcmp(argv[i], name)) return 1;
+    return 0;
+}
+
+/**
+ * @brief Returns the value of a `--name value` command line option.
+ *
+ * @return const char* the value, or NULL if the option is absent.
+ */
+static const char *arg_value(int argc, char *argv[], const char *name) {
+    for (int i = 1; i + 1 < argc; i++)
+        if (0 == strcmp(argv[i], name)) return argv[i + 1];
+    return NULL;
+}
+
+/**
+ * @brief Reads the command line options and creates the matching backend.
+ *
+ * `--shards N` selects the sharded backend with N shards and `--threads T`
+ * sets the size of its thread pool (defaults to N). `--deterministic` keeps
+ * the lanes 1-2-3 balanced instead of flipping coins; otherwise `--prob P`
+ * and `--max-height H` shape the towers, `--autotune` lets every list pick
+ * them from its workload and `--rebalance` evens the towers out, in steps,
+ * as insertions and removals pile up. `--index` adds a hash
+ * index for the exact-key lookups, `--bloom P` a Bloom filter with a
+ * false positive rate P for the lookups of absent words, `--adaptive`
+ * raises the towers of the most searched words, and `--lazy R` turns
+ * removals into tombstones, compacted once they are a share R of the list.
+ * `--ttl S` makes the inserted words expire after S seconds, and
+ * `--max-entries N` and `--max-bytes B` bound the whole dictionary,
+ * evicting words to make room. `--front-code N` packs the
+ * words of `--load` in front-coded blocks of N, see
+ * backend_front_code_enable(). `--freeze` has the lists frozen after the
+ * load and again after every long enough run of lookups, see
+ * skiplist_freeze(). `--write-buffer N` holds up to N written words before
+ * they are applied together, see backend_buffer_enable(). `--cold DIR`
+ * keeps the descriptions in a value log in DIR, behind a page cache of
+ * `--cold-cache B` bytes, see backend_cold_enable(). With `--follow`, the
+ * `--ttl`, `--max-entries` and `--max-bytes` are ignored: the leader's
+ * stream decides what goes away, see replica.h.
+ *
+ * @return Backend* ptr WITH OWNERSHIP, or NULL on error.
+ */
+static Backend *backend_from_args(int argc, char *argv[]) {
+    const char *shards_arg = arg_value(argc, argv, "--shards");
+    const char *threads_arg = arg_value(argc, argv, "--threads");
+    size_t shards = shards_arg ? strtoul(shards_arg, 0, 10) : 0;
+    size_t threads = threads_arg ? strtoul(threads_arg, 0, 10) : 0;
+    const char *prob_arg = arg_value(argc, argv, "--prob");
+    const char *height_arg = arg_value(argc, argv, "--max-height");
+    const char *ttl_arg = arg_value(argc, argv, "--ttl");
+    const char *entries_arg = arg_value(argc, argv, "--max-entries");
+    const char *bytes_arg = arg_value(argc, argv, "--max-bytes");
+    if (NULL != arg_value(argc, argv, "--follow"))
+        ttl_arg = entries_arg = bytes_arg = NULL;
+
+    skiplist_config_t config = skiplist_config_default();
+    if (arg_flag(argc, argv, "--deterministic"))
+        config.mode = SKIPLIST_DETERMINISTIC;
+    if (prob_arg) config.prob = strtod(prob_arg, NULL);
+    if (height_arg) config.max_height = strtoul(height_arg, 0, 10);
+    config.auto_tune = arg_flag(argc, argv, "--autotune");
+    config.rebalance = arg_flag(argc, argv, "--rebalance");
+    config.freeze = arg_flag(argc, argv, "--freeze");
+    if (ttl_arg) config.ttl = (uint32_t)strtoul(ttl_arg, 0, 10);
+    if (entries_arg) config.max_length = strtoul(entries_arg, 0, 10);
+    if (bytes_arg) config.max_bytes = strtoul(bytes_arg, 0, 10);
+    config.evict = NULL != entries_arg || NULL != bytes_arg;
+
+    Backend *backend =
+        shards > 1
+            ? backend_new_sharded(shards, threads ? threads : shards, &config)
+            : backend_new_skiplist(&config);
+
+    if (NULL != backend && arg_flag(argc, argv, "--index") &&
+        SUCCESS != backend_index_enable(backend))
+        backend_del(&backend); // err handling
+
+    const char *bloom_arg = arg_value(argc, argv, "--bloom");
+    if (NULL != backend && NULL != bloom_arg &&
+        SUCCESS != backend_bloom_enable(backend, strtod(bloom_arg, NULL)))
+        backend_del(&backend); // err handling
+
+    if (NULL != backend && arg_flag(argc, argv, "--adaptive") &&
+        SUCCESS != backend_adaptive_enable(backend))
+        backend_del(&backend); // err handling
+
+    const char *lazy_arg = arg_value(argc, argv, "--lazy");
+    if (NULL != backend && NULL != lazy_arg &&
+        SUCCESS != backend_lazy_enable(backend, strtod(lazy_arg, NULL)))
+        backend_del(&backend); // err handling
+
+    const char *front_arg = arg_value(argc, argv, "--front-code");
+    if (NULL != backend && NULL != front_arg &&
+        SUCCESS != backend_front_code_enable(backend,
+                                             strtoul(front_arg, 0, 10)))
+        backend_del(&backend); // err handling
+
+    const char *cold_arg = arg_value(argc, argv, "--cold");
+    const char *cache_arg = arg_value(argc, argv, "--cold-cache");
+    if (NULL != backend && NULL != cold_arg &&
+        SUCCESS != backend_cold_enable(backend, cold_arg,
+                                       cache_arg ? strtoul(cache_arg, 0, 10)
+                                                 : 0)) { // err handling
+        fprintf(stderr, "could not use --cold %s: %s\n", cold_arg,
+                strerror(errno));
+        backend_del(&backend);
+    }
+
+    const char *buffer_arg = arg_value(argc, argv, "--write-buffer");
+    if (NULL != backend && NULL != buffer_arg &&
+        SUCCESS != backend_buffer_enable(backend,
+                                         strtoul(buffer_arg, 0, 10)))
+        backend_del(&backend); // err handling
+
+    return backend;
+}
+
+/**
+ * @brief Handles `--load FILE`: the `{W} {D}` lines of the file are parsed,
+ * sorted and deduplicated in parallel (`--threads T`, defaults to the number
+ * of cores) and the backend is built from them before any command is read.
+ * With `--freeze`, it is frozen right after, see backend_freeze().
+ *
+ * @return status_t \c SUCCESS if there was nothing to load or it was loaded.
+ */
+static status_t load_from_args(Backend *backend, int argc, char *argv[]) {
+    const char *path = arg_value(argc, argv, "--load");
+    if (NULL == path) return SUCCESS;
+
+    FILE *in = fopen(path, "r");
+    if (NULL == in) return NOT_FOUND_ERR;
+
+    const char *threads_arg = arg_value(argc, argv, "--threads");
+    long threads = threads_arg ? (long)strtoul(threads_arg, 0, 10)
+                               : sysconf(_SC_NPROCESSORS_ONLN);
+    ThreadPool *pool = threads > 1 ? threadpool_new(threads) : NULL;
+
+    Item **items = NULL;
+    size_t n = 0;
+    status_t flag = loader_read_sorted(in, pool, &items, &n);
+    if (SUCCESS == flag) flag = backend_load_sorted(backend, items, n, pool);
+    if (SUCCESS == flag && arg_flag(argc, argv, "--freeze"))
+        backend_freeze(backend); // without it, the lanes serve the lookups
+
+    free(items);
+    threadpool_del(&pool);
+    fclose(in);
+    return flag;
+}
+
+/**
+ * @brief Handles `--loadgen ADDR`: benchmarks the server at ADDR with
+ * `--clients C`, `--requests N`, `--window W`, `--keys K`, `--writes P` and
+ * `--zipf S`, over the binary protocol with `--binary` (see loadgen.h).
+ *
+ * @return int the exit code.
+ */
+static int loadgen_from_args(int argc, char *argv[]) {
+    const char *clients = arg_value(argc, argv, "--clients");
+    const char *requests = arg_value(argc, argv, "--requests");
+    const char *window = arg_value(argc, argv, "--window");
+    const char *keys = arg_value(argc, argv, "--keys");
+    const char *writes = arg_value(argc, argv, "--writes");
+    const char *zipf = arg_value(argc, argv, "--zipf");
+
+    loadgen_config_t config = (loadgen_config_t){
+        .addr = arg_value(argc, argv, "--loadgen"),
+        .clients = clients ? strtoul(clients, 0, 10) : 0,
+        .requests = requests ? strtoul(requests, 0, 10) : 0,
+        .window = window ? strtoul(window, 0, 10) : 0,
+        .keys = keys ? strtoul(keys, 0, 10) : 0,
+        .writes = writes ? (unsigned int)strtoul(writes, 0, 10) : 0,
+        .binary = arg_flag(argc, argv, "--binary"),
+        .zipf = zipf ? strtod(zipf, NULL) : 0,
+    };
+
+    if (SUCCESS != loadgen_run(&config, stdout)) {
+        fprintf(stderr, "load generation against %s failed\n", config.addr);
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Handles `--leader ADDR`, which streams the writes to the followers
+ * that connect to ADDR and keeps the last `--backlog B` bytes of them for
+ * the ones that lag behind, and `--follow ADDR`, which replays the stream
+ * of the leader at ADDR from write `--from N` on, or from a snapshot without
+ * it (see replica.h). A process does not do both.
+ *
+ * @return status_t \c SUCCESS if there was nothing to start or it started.
+ */
+static status_t replica_from_args(Backend *backend, int argc, char *argv[],
+                                  Leader **leader, Follower **follower) {
+    const char *leader_addr = arg_value(argc, argv, "--leader");
+    const char *follow_addr = arg_value(argc, argv, "--follow");
+    if (NULL != leader_addr && NULL != follow_addr) return TOO_MUCH_ERR;
+
+    if (NULL != leader_addr) {
+        const char *backlog = arg_value(argc, argv, "--backlog");
+        *leader = leader_new(backend, leader_addr,
+                             backlog ? strtoul(backlog, 0, 10) : 0);
+        if (NULL == *leader) return NOT_FOUND_ERR;
+    }
+
+    if (NULL != follow_addr) {
+        const char *from = arg_value(argc, argv, "--from");
+        *follower = follower_new(backend, follow_addr,
+                                 from ? strtoull(from, 0, 10) : 0);
+        if (NULL == *follower) return NOT_FOUND_ERR;
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Server hook of a leader: sends the new writes to the followers.
+ */
+static status_t leader_watch(void *ctx) { return leader_pump((Leader *)ctx); }
+
+/**
+ * @brief Server hook of a follower, also run before every command of the
+ * serial loop: applies the writes received so far, and tells why once it
+ * stops, or starts it over from a snapshot if a write did not apply.
+ */
+static status_t follower_watch(void *ctx) {
+    Follower *follower = (Follower *)ctx;
+    status_t flag = follower_pump(follower);
+    unsigned long long seq = follower_seq(follower);
+
+    if (EOF_ERR == flag)
+        fprintf(stderr, "the leader hung up after write %llu\n", seq);
+    else if (NOT_FOUND_ERR == flag)
+        fprintf(stderr, "the leader no longer has write %llu\n", seq + 1);
+    else if (CRITICAL_ERR == flag) {
+        fprintf(stderr, "broken replication stream after write %llu, starting "
+                        "over from a snapshot\n",
+                seq);
+        flag = follower_resync(follower);
+    } else if (SUCCESS != flag)
+        fprintf(stderr, "broken replication stream after write %llu\n", seq);
+    return flag;
+}
+
+/**
+ * @brief Pump thread of the serial loop: answers the followers of the leader
+ * while stdin is quiet, as the server does from its own loop.
+ */
+static void *pump_loop(void *arg) {
+    pump_t *pump = (pump_t *)arg;
+    struct pollfd pfd = {.fd = leader_fd(pump->leader), .events = POLLIN};
+
+    for (_Bool stop = 0; !stop;) {
+        poll(&pfd, 1, MAIN_PUMP_MS);
+        pthread_mutex_lock(&pump->lock);
+        stop = pump->stop;
+        if (!stop) leader_pump(pump->leader);
+        pthread_mutex_unlock(&pump->lock);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Sends the followers the last writes, within REPLICA_DRAIN_MS, and
+ * stops the replication.
+ */
+static void replica_stop(Leader **leader, Follower **follower) {
+    size_t behind = leader_drain(*leader, REPLICA_DRAIN_MS);
+    if (behind > 0)
+        fprintf(stderr, "%zu followers did not get every write\n", behind);
+    leader_del(leader);
+    follower_del(follower);
+}
+
+int main(int argc, char *argv[]) {
 
     // Randomize
     srand(time(NULL));
 
+    // Load generator: a client, no dictionary of its own
+    if (NULL != arg_value(argc, argv, "--loadgen"))
+        return loadgen_from_args(argc, argv);
+
     // Initializations
-    char cmd[64] = {'\0'};
-
-    SkipList *skiplist = skiplist_new();
-
-    // Execution loop
-    while (EOF != scanf(" %62s", cmd)) { // stop at eof
-
-        // Operation: Insertion
-        if (0 == strcmp(cmd, "insercao")) {
-            Item *item = item_read();
-
-            if (SUCCESS != skiplist_insert(skiplist, item)) {
-                item_del(&item);
-                printf(INVALID_OP_MSG);
-            }
-        }
-
-        // Operation: Update
-        else if (0 == strcmp(cmd, "alteracao")) {
-            Item *item = item_read();
-
-            if (SUCCESS != skiplist_update(skiplist, item))
-                printf(INVALID_OP_MSG);
-
-            item_del(&item);
-        }
-
-        // Operation: Remove
-        else if (0 == strcmp(cmd, "remocao")) {
-            Item *item = item_read_word();
-
-            Item *removed = skiplist_remove(skiplist, item);
-
-            if (NULL == removed) printf(INVALID_OP_MSG);
-
-            item_del(&item);
-            item_del(&removed);
-        }
-
-        // Operation: Search
-        else if (0 == strcmp(cmd, "busca")) {
-            Item *item = item_read_word();                  // owned
-            Item *result = skiplist_search(skiplist, item); // borrowed
-
-            // Print and error handling
-            if (NULL == item || NULL == result) {
-                printf(INVALID_OP_MSG);
-            } else {
-                item_print(result);
-                printf("\n");
-            }
-
-            item_del(&item);
-        }
-
-        // Operation: Print
-        else if (0 == strcmp(cmd, "impressao")) {
-            // Input
-            char c = 0;
-            int _flag = scanf(" %c", &c);
-
-            // Error handling
-            if (EOF == _flag) {
-                printf(INVALID_OP_MSG);
-                break;
-            }
-
-            // output
-            status_t _flag_2 = skiplist_print(skiplist, c);
-            if (SUCCESS != _flag_2) printf(INVALID_OP_MSG);
-        }
-
-        else if (0 == strcmp(cmd, "debug")) {
-            printf("SKIPLIST:\n");
-            skiplist_debug_print(skiplist);
-            printf("\n\n");
-        }
-
-        // Operation: Operation not identified
-        else {
-            printf(INVALID_OP_MSG);
-        }
+    Backend *backend = backend_from_args(argc, argv);
+    if (NULL == backend) return 1;
+
+    if (SUCCESS != load_from_args(backend, argc, argv)) {
+        fprintf(stderr, "could not load %s\n", arg_value(argc, argv, "--load"));
+        backend_del(&backend);
+        return 1;
+    }
+
+    Leader *leader = NULL;
+    Follower *follower = NULL;
+    if (SUCCESS != replica_from_args(backend, argc, argv, &leader,
+                                     &follower)) {
+        fprintf(stderr, "could not start the replication\n");
+        replica_stop(&leader, &follower);
+        backend_del(&backend);
+        return 1;
+    }
+
+    // Server mode: the commands come from the socket clients
+    const char *listen_addr = arg_value(argc, argv, "--listen");
+    if (NULL != listen_addr) {
+        server_config_t config = (server_config_t){
+            .addr = listen_addr,
+            .binary = arg_flag(argc, argv, "--binary"),
+            .watch_fd = leader ? leader_fd(leader) : follower_fd(follower),
+            .on_watch = leader     ? leader_watch
+                        : follower ? follower_watch
+                                   : NULL,
+            .watch_ctx = leader ? (void *)leader : (void *)follower,
+        };
+        status_t flag = server_run(backend, &config);
+        if (SUCCESS != flag) fprintf(stderr, "could not serve %s\n", listen_addr);
+        replica_stop(&leader, &follower);
+        backend_del(&backend);
+        return SUCCESS == flag ? 0 : 1;
+    }
+
+    // Binary protocol over stdin and stdout
+    if (arg_flag(argc, argv, "--binary")) {
+        status_t flag = binproto_run(backend, stdin, stdout);
+        if (SUCCESS != flag) fprintf(stderr, "broken binary request stream\n");
+        replica_stop(&leader, &follower);
+        backend_del(&backend);
+        return SUCCESS == flag ? 0 : 1;
+    }
+
+    // Pipelined execution: parser, executor and writer threads
+    if (arg_flag(argc, argv, "--pipeline") &&
+        SUCCESS == pipeline_run(backend, stdout, 0)) {
+        replica_stop(&leader, &follower);
+        backend_del(&backend);
+        return 0;
+    }
+
+    // Serial execution loop
+    Executor *executor = executor_new(backend, reply_print, stdout);
+    if (NULL == executor) {
+        replica_stop(&leader, &follower);
+        backend_del(&backend);
+        return 1;
+    }
+
+    // A leader is also pumped between the commands
+    pump_t pump = (pump_t){.leader = leader};
+    pthread_t pumper;
+    pthread_mutex_init(&pump.lock, NULL);
+    _Bool pumping =
+        leader && 0 == pthread_create(&pumper, NULL, pump_loop, &pump);
+
+    command_t cmd;
+    while (SUCCESS == command_read(&cmd)) { // stop at eof
+        if (follower && SUCCESS != follower_watch(follower))
+            follower_del(&follower); // the reads go on, as of its last write
+        pthread_mutex_lock(&pump.lock);
+        executor_submit(executor, &cmd);
+        leader_pump(leader);
+        pthread_mutex_unlock(&pump.lock);
+        if (cmd.last) break;
+    }
+
+    if (pumping) {
+        pthread_mutex_lock(&pump.lock);
+        pump.stop = 1;
+        pthread_mutex_unlock(&pump.lock);
+        pthread_join(pumper, NULL);
     }
+    pthread_mutex_destroy(&pump.lock);
 
     // Clean up
-    skiplist_del(&skiplist);
+    executor_del(&executor);
+    replica_stop(&leader, &follower);
+    backend_del(&backend);
 
     return 0;
-}
\ No newline at end of file
+}
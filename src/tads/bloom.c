@@ -0,0 +1,148 @@
+/**
+ * @file bloom.c
+ * @brief Implementation of a blocked Bloom filter of key hashes.
+ */
+
+#include <string.h>
+
+#include "tads/bloom.h"
+
+// Bits of a block: one 64 byte cache line.
+#define BLOCK_BITS (512)
+#define BLOCK_WORDS (BLOCK_BITS / 64)
+
+// Most bits a key sets.
+#define BLOOM_MAX_K (16)
+
+//=============================================================================/
+//=================|    Data Structures     |==================================/
+//=============================================================================/
+
+/**
+ * @brief A block of the filter, aligned to a cache line.
+ */
+typedef struct {
+    _Alignas(64) uint64_t words[BLOCK_WORDS];
+} block_t;
+
+/**
+ * @brief Blocked Bloom filter.
+ */
+struct _bloom_s {
+    block_t *blocks;
+    size_t n_blocks;
+    unsigned int k; // bits set per key
+    double fp_rate;
+    size_t capacity;
+    size_t added; // keys added since the last clear
+    size_t stale; // keys forgotten since the last clear
+};
+
+//=============================================================================/
+//=================|    Private Function Declarations     |====================/
+//=============================================================================/
+
+static inline block_t *block_of(const Bloom *bloom, uint64_t hash);
+
+//=============================================================================/
+//=================|    Public Function Implementations     |==================/
+//=============================================================================/
+
+Bloom *bloom_new(size_t capacity, double fp_rate) {
+    if (!(fp_rate > 0 && fp_rate < 1)) fp_rate = BLOOM_FP_RATE;
+    if (capacity < BLOOM_MIN_CAPACITY) capacity = BLOOM_MIN_CAPACITY;
+
+    // The best k is log2(1 / fp_rate), with k / ln 2 bits per key. Blocking
+    // needs a few more, so 7k / 4 bits are given to each key.
+    unsigned int k = 1;
+    for (double p = 0.5; p > fp_rate && k < BLOOM_MAX_K; p /= 2) k++;
+    size_t bits = capacity * (7 * k / 4 + 1);
+
+    Bloom *bloom = (Bloom *)malloc(sizeof(Bloom));
+    if (NULL == bloom) return NULL; // err handling
+
+    *bloom = (Bloom){
+        .n_blocks = (bits + BLOCK_BITS - 1) / BLOCK_BITS,
+        .k = k,
+        .fp_rate = fp_rate,
+        .capacity = capacity,
+    };
+    bloom->blocks = (block_t *)aligned_alloc(_Alignof(block_t),
+                                             bloom->n_blocks * sizeof(block_t));
+    if (NULL == bloom->blocks) { // err handling
+        free(bloom);
+        return NULL;
+    }
+
+    bloom_clear(bloom);
+    return bloom;
+}
+
+void bloom_del(Bloom **bloom) {
+    if (NULL == bloom || NULL == *bloom) return;
+    free((*bloom)->blocks);
+    free(*bloom);
+    *bloom = NULL;
+}
+
+void bloom_add(Bloom *bloom, uint64_t hash) {
+    if (NULL == bloom) return;
+
+    block_t *block = block_of(bloom, hash);
+    uint32_t h1 = (uint32_t)hash, h2 = (uint32_t)(hash >> 32) | 1u;
+    for (unsigned int i = 0; i < bloom->k; i++, h1 += h2) {
+        unsigned int bit = h1 % BLOCK_BITS;
+        block->words[bit / 64] |= 1ull << (bit % 64);
+    }
+    bloom->added++;
+}
+
+_Bool bloom_may_contain(const Bloom *bloom, uint64_t hash) {
+    if (NULL == bloom) return 1;
+
+    const block_t *block = block_of(bloom, hash);
+    uint32_t h1 = (uint32_t)hash, h2 = (uint32_t)(hash >> 32) | 1u;
+    for (unsigned int i = 0; i < bloom->k; i++, h1 += h2) {
+        unsigned int bit = h1 % BLOCK_BITS;
+        if (!(block->words[bit / 64] & 1ull << (bit % 64))) return 0;
+    }
+    return 1;
+}
+
+void bloom_forget(Bloom *bloom, size_t n) {
+    if (bloom) bloom->stale += n;
+}
+
+_Bool bloom_is_saturated(const Bloom *bloom) {
+    if (NULL == bloom) return 0;
+    return bloom->added > bloom->capacity ||
+           (bloom->stale > BLOOM_MIN_CAPACITY / 2 &&
+            bloom->stale > bloom->added / 2);
+}
+
+void bloom_clear(Bloom *bloom) {
+    if (NULL == bloom) return;
+    memset(bloom->blocks, 0, bloom->n_blocks * sizeof(block_t));
+    bloom->added = bloom->stale = 0;
+}
+
+double bloom_fp_rate(const Bloom *bloom) {
+    return bloom ? bloom->fp_rate : BLOOM_FP_RATE;
+}
+
+size_t bloom_bytes(const Bloom *bloom) {
+    return bloom ? sizeof(Bloom) + bloom->n_blocks * sizeof(block_t) : 0;
+}
+
+//=============================================================================/
+//=================|    Private Function Implementations    |==================/
+//=============================================================================/
+
+/**
+ * @brief Picks the block of a key. The hash is mixed first, so the block does
+ * not depend on the same bits as the positions inside it.
+ */
+static inline block_t *block_of(const Bloom *bloom, uint64_t hash) {
+    uint64_t mixed = (hash ^ hash >> 29) * 0x9e3779b97f4a7c15ull;
+    return &bloom->blocks[((mixed >> 32) * bloom->n_blocks) >> 32];
+}
@@ -0,0 +1,120 @@
+/**
+ * @file freqsketch.c
+ * @brief Implementation of an aging count-min sketch of key accesses.
+ */
+
+#include "tads/freqsketch.h"
+
+// Smallest row, in counters.
+#define FREQSKETCH_MIN_WIDTH (64)
+
+// Accesses per column counted before the sketch ages.
+#define FREQSKETCH_AGE_AFTER (10)
+
+//=============================================================================/
+//=================|    Data Structures     |==================================/
+//=============================================================================/
+
+/**
+ * @brief Count-min sketch: FREQSKETCH_ROWS rows of mask + 1 counters.
+ */
+struct _freqsketch_s {
+    uint16_t *counters;
+    size_t mask;
+    size_t total;
+};
+
+//=============================================================================/
+//=================|    Private Function Declarations     |====================/
+//=============================================================================/
+
+static inline size_t column_of(const FreqSketch *sketch, uint64_t hash,
+                               size_t row);
+static void freqsketch_age(FreqSketch *sketch);
+
+//=============================================================================/
+//=================|    Public Function Implementations     |==================/
+//=============================================================================/
+
+FreqSketch *freqsketch_new(size_t width) {
+    size_t w = FREQSKETCH_MIN_WIDTH;
+    while (w < width) w *= 2;
+
+    FreqSketch *sketch = (FreqSketch *)malloc(sizeof(FreqSketch));
+    if (NULL == sketch) return NULL; // err handling
+
+    *sketch = (FreqSketch){
+        .counters = (uint16_t *)calloc(FREQSKETCH_ROWS * w, sizeof(uint16_t)),
+        .mask = w - 1,
+    };
+    if (NULL == sketch->counters) freqsketch_del(&sketch); // err handling
+    return sketch;
+}
+
+void freqsketch_del(FreqSketch **sketch) {
+    if (NULL == sketch || NULL == *sketch) return;
+    free((*sketch)->counters);
+    free(*sketch);
+    *sketch = NULL;
+}
+
+uint32_t freqsketch_touch(FreqSketch *sketch, uint64_t hash) {
+    if (NULL == sketch) return 0;
+
+    uint16_t *cell[FREQSKETCH_ROWS];
+    uint16_t min = UINT16_MAX;
+    for (size_t row = 0; row < FREQSKETCH_ROWS; row++) {
+        cell[row] = &sketch->counters[row * (sketch->mask + 1) +
+                                      column_of(sketch, hash, row)];
+        if (*cell[row] < min) min = *cell[row];
+    }
+
+    // Conservative update: only the counters holding the estimate grow
+    if (min < UINT16_MAX) {
+        for (size_t row = 0; row < FREQSKETCH_ROWS; row++)
+            if (*cell[row] == min) (*cell[row])++;
+        min++;
+    }
+
+    if (++sketch->total >= FREQSKETCH_AGE_AFTER * (sketch->mask + 1))
+        freqsketch_age(sketch);
+    return min;
+}
+
+size_t freqsketch_total(const FreqSketch *sketch) {
+    return sketch ? sketch->total : 0;
+}
+
+size_t freqsketch_bytes(const FreqSketch *sketch) {
+    if (NULL == sketch) return 0;
+    return sizeof(FreqSketch) +
+           FREQSKETCH_ROWS * (sketch->mask + 1) * sizeof(uint16_t);
+}
+
+//=============================================================================/
+//=================|    Private Function Implementations    |==================/
+//=============================================================================/
+
+/**
+ * @brief The column of a key in a row: each row multiplies the hash by its
+ * own odd constant and keeps the high bits.
+ */
+static inline size_t column_of(const FreqSketch *sketch, uint64_t hash,
+                               size_t row) {
+    static const uint64_t seeds[FREQSKETCH_ROWS] = {
+        0x9e3779b97f4a7c15ull,
+        0xc2b2ae3d27d4eb4full,
+        0x165667b19e3779f9ull,
+        0xd6e8feb86659fd93ull,
+    };
+    return (size_t)((hash * seeds[row]) >> 40) & sketch->mask;
+}
+
+/**
+ * @brief Halves every counter and the total.
+ */
+static void freqsketch_age(FreqSketch *sketch) {
+    size_t n = FREQSKETCH_ROWS * (sketch->mask + 1);
+    for (size_t i = 0; i < n; i++) sketch->counters[i] >>= 1;
+    sketch->total /= 2;
+}
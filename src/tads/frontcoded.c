@@ -0,0 +1,302 @@
+/**
+ * @file frontcoded.c
+ * @brief Implementation of a read-only, front-coded set of items.
+ *
+ * An entry is laid out as `[shared][suffix length][suffix][description
+ * length][description]`, one byte per length: words and descriptions are
+ * shorter than the entry buffers (see tad_constants.h).
+ */
+
+#include "tads/frontcoded.h"
+
+//=============================================================================/
+//=================|    Data Structures     |==================================/
+//=============================================================================/
+
+/**
+ * @brief The set: \c length entries in blocks of \c restart, one after the
+ * other in \c data.
+ */
+struct _frontcoded_s {
+    unsigned char *data;
+    uint32_t *restarts;  // offset in data of the first entry of each block
+    unsigned char *gone; // one bit per entry, set once it is forgotten
+    size_t length;
+    size_t alive;
+    size_t blocks;
+    size_t restart;
+    size_t bytes;     // of data
+    size_t key_bytes; // of data spent on the words and their lengths
+};
+
+/**
+ * @brief Walks the entries of a block, rebuilding every word from the
+ * previous one.
+ */
+typedef struct {
+    const unsigned char *at; // the next entry
+    char word[MAX_WORD_SIZE + 1];
+    size_t word_len;
+    const char *description;
+    size_t description_len;
+} fc_cursor_t;
+
+//=============================================================================/
+//=================|    Private Function Declarations     |====================/
+//=============================================================================/
+
+static size_t shared_prefix(const char *a, const char *b);
+static int word_cmp(const char *a, size_t a_len, const char *b, size_t b_len);
+static int restart_cmp(const FrontCoded *fc, size_t block, const char *word,
+                       size_t len);
+static void cursor_next(fc_cursor_t *cur);
+static _Bool frontcoded_find(const FrontCoded *fc, const Item *item,
+                             fc_cursor_t *cur, size_t *pos);
+
+//=============================================================================/
+//=================|    Public Function Implementations     |==================/
+//=============================================================================/
+
+FrontCoded *frontcoded_new(Item *const *items, size_t n, size_t restart) {
+    if (NULL == items && n > 0) return NULL;
+    if (0 == restart) restart = FRONTCODED_RESTART;
+
+    FrontCoded *fc = (FrontCoded *)malloc(sizeof(FrontCoded));
+    if (NULL == fc) return NULL; // err handling
+
+    *fc = (FrontCoded){
+        .length = n,
+        .alive = n,
+        .blocks = (n + restart - 1) / restart,
+        .restart = restart,
+    };
+
+    // PART 1: measuring, so the entries take a single allocation
+    const char *prev = "";
+    for (size_t i = 0; i < n; i++) {
+        const char *word = item_word(items[i]);
+        size_t shared = i % restart ? shared_prefix(prev, word) : 0;
+        size_t key = 2 + strlen(word) - shared;
+        fc->key_bytes += key;
+        fc->bytes += key + 1 + strlen(item_description(items[i]));
+        prev = word;
+    }
+
+    fc->data = (unsigned char *)malloc(fc->bytes ? fc->bytes : 1);
+    fc->restarts =
+        (uint32_t *)malloc((fc->blocks ? fc->blocks : 1) * sizeof(uint32_t));
+    fc->gone = (unsigned char *)calloc(n / 8 + 1, 1);
+    if (NULL == fc->data || NULL == fc->restarts || NULL == fc->gone ||
+        fc->bytes > UINT32_MAX) { // err handling
+        frontcoded_del(&fc);
+        return NULL;
+    }
+
+    // PART 2: encoding
+    unsigned char *at = fc->data;
+    prev = "";
+    for (size_t i = 0; i < n; i++) {
+        const char *word = item_word(items[i]);
+        const char *description = item_description(items[i]);
+
+        size_t shared = 0;
+        if (0 == i % restart)
+            fc->restarts[i / restart] = (uint32_t)(at - fc->data);
+        else
+            shared = shared_prefix(prev, word);
+
+        size_t suffix = strlen(word) - shared;
+        size_t description_len = strlen(description);
+        *at++ = (unsigned char)shared;
+        *at++ = (unsigned char)suffix;
+        memcpy(at, word + shared, suffix);
+        at += suffix;
+        *at++ = (unsigned char)description_len;
+        memcpy(at, description, description_len);
+        at += description_len;
+        prev = word;
+    }
+
+    return fc;
+}
+
+void frontcoded_del(FrontCoded **fc) {
+    if (NULL == fc || NULL == *fc) return;
+    free((*fc)->data);
+    free((*fc)->restarts);
+    free((*fc)->gone);
+    free(*fc);
+    *fc = NULL;
+}
+
+Item *frontcoded_get(const FrontCoded *fc, const Item *item, item_buf_t *buf) {
+    if (NULL == fc || NULL == item || NULL == buf) return NULL;
+
+    fc_cursor_t cur;
+    size_t pos;
+    if (!frontcoded_find(fc, item, &cur, &pos)) return NULL;
+
+    return item_place(buf, cur.word, cur.word_len, cur.description,
+                      cur.description_len);
+}
+
+status_t frontcoded_forget(FrontCoded *fc, const Item *item) {
+    if (NULL == fc || NULL == item) return NUL_ERR;
+
+    fc_cursor_t cur;
+    size_t pos;
+    if (!frontcoded_find(fc, item, &cur, &pos)) return NOT_FOUND_ERR;
+
+    fc->gone[pos / 8] |= (unsigned char)(1u << (pos % 8));
+    fc->alive--;
+    return SUCCESS;
+}
+
+status_t frontcoded_foreach_char(const FrontCoded *fc, const char c,
+                                 status_t (*fn)(Item *item, void *ctx),
+                                 void *ctx) {
+    if (NULL == fc || NULL == fn) return NUL_ERR;
+
+    // PART 1: the last block starting before the words with c
+    unsigned char first = (unsigned char)c;
+    size_t lo = 0, hi = fc->blocks;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        const unsigned char *key = fc->data + fc->restarts[mid];
+        if ((key[1] ? key[2] : 0) < first)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    size_t block = lo ? lo - 1 : 0;
+
+    // PART 2: decoding from there, up to the first word after c
+    fc_cursor_t cur = (fc_cursor_t){0};
+    if (fc->blocks > 0) cur.at = fc->data + fc->restarts[block];
+    for (size_t pos = block * fc->restart; pos < fc->length; pos++) {
+        cursor_next(&cur);
+        unsigned char head = cur.word_len ? (unsigned char)cur.word[0] : 0;
+        if (head < first) continue;
+        if (head > first) break;
+        if (fc->gone[pos / 8] & (1u << (pos % 8))) continue;
+
+        item_buf_t buf;
+        Item *item = item_place(&buf, cur.word, cur.word_len, cur.description,
+                                cur.description_len);
+        status_t flag = fn(item, ctx);
+        if (SUCCESS != flag) return flag;
+    }
+
+    return SUCCESS;
+}
+
+size_t frontcoded_length(const FrontCoded *fc) { return fc ? fc->alive : 0; }
+
+size_t frontcoded_bytes(const FrontCoded *fc) {
+    if (NULL == fc) return 0;
+    return sizeof(FrontCoded) + fc->bytes + fc->blocks * sizeof(uint32_t) +
+           fc->length / 8 + 1;
+}
+
+void frontcoded_memory_fprint(FILE *out, const FrontCoded *fc) {
+    if (NULL == fc) return;
+    fprintf(out, "front-coded: %zu words, %zu blocks of %zu\n", fc->alive,
+            fc->blocks, fc->restart);
+    fprintf(out, "front-coded keys: %zu bytes (%zu in item buffers)\n",
+            fc->key_bytes + fc->blocks * sizeof(uint32_t),
+            fc->length * (MAX_WORD_SIZE + 1));
+    fprintf(out, "front-coded: %zu bytes (%zu as items)\n",
+            frontcoded_bytes(fc), fc->length * item_size());
+}
+
+//=============================================================================/
+//=================|    Private Function Implementations    |==================/
+//=============================================================================/
+
+/**
+ * @brief Length of the common prefix of two words.
+ */
+static size_t shared_prefix(const char *a, const char *b) {
+    size_t n = 0;
+    while (a[n] && a[n] == b[n]) n++;
+    return n;
+}
+
+/**
+ * @brief Compares two words that are not '\0' terminated, in the order of
+ * strcmp().
+ */
+static int word_cmp(const char *a, size_t a_len, const char *b, size_t b_len) {
+    int cmp = memcmp(a, b, a_len < b_len ? a_len : b_len);
+    if (cmp) return cmp;
+    return (a_len > b_len) - (a_len < b_len);
+}
+
+/**
+ * @brief Compares the restart key of a block with a word.
+ */
+static int restart_cmp(const FrontCoded *fc, size_t block, const char *word,
+                       size_t len) {
+    const unsigned char *entry = fc->data + fc->restarts[block];
+    return word_cmp((const char *)entry + 2, entry[1], word, len);
+}
+
+/**
+ * @brief Decodes the next entry: the first of a block must be a restart.
+ */
+static void cursor_next(fc_cursor_t *cur) {
+    const unsigned char *at = cur->at;
+    size_t shared = at[0], suffix = at[1];
+    memcpy(cur->word + shared, at + 2, suffix);
+    cur->word_len = shared + suffix;
+    cur->word[cur->word_len] = '\0';
+
+    at += 2 + suffix;
+    cur->description_len = at[0];
+    cur->description = (const char *)at + 1;
+    cur->at = at + 1 + cur->description_len;
+}
+
+/**
+ * @brief Searches the restart keys for the block of a word, then decodes
+ * the block up to it.
+ *
+ * @param fc ptr to the set.
+ * @param item the key.
+ * @param cur output, the decoded entry when it is found.
+ * @param pos output, the position of the entry.
+ * @return _Bool \c 1 if the word is present and not forgotten.
+ */
+static _Bool frontcoded_find(const FrontCoded *fc, const Item *item,
+                             fc_cursor_t *cur, size_t *pos) {
+    const char *word = item_word(item);
+    size_t len = strlen(word);
+
+    // PART 1: the last block whose restart key is not after the word
+    size_t lo = 0, hi = fc->blocks;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (restart_cmp(fc, mid, word, len) <= 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (0 == lo) return 0;
+
+    // PART 2: the block, entry by entry
+    size_t block = lo - 1;
+    size_t end = (block + 1) * fc->restart;
+    if (end > fc->length) end = fc->length;
+
+    cur->at = fc->data + fc->restarts[block];
+    for (size_t i = block * fc->restart; i < end; i++) {
+        cursor_next(cur);
+        int cmp = word_cmp(cur->word, cur->word_len, word, len);
+        if (cmp > 0) return 0;
+        if (0 == cmp) {
+            *pos = i;
+            return !(fc->gone[i / 8] & (1u << (i % 8)));
+        }
+    }
+    return 0;
+}
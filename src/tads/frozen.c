@@ -0,0 +1,194 @@
+/**
+ * @file frozen.c
+ * @brief Implementation of an immutable index of items in Eytzinger order.
+ *
+ * Slots are numbered from 1, slot 0 is left unused: the children of slot k
+ * are then 2k and 2k + 1, and the 8 slots three levels below it, 8k to
+ * 8k + 7, are one cache line of keys.
+ */
+
+#include "tads/frozen.h"
+
+// Bytes of a cache line, the alignment of the keys.
+#define FROZEN_LINE (64)
+
+// Slots of keys per cache line: the descendants of slot k that many slots
+// down the array are fetched while k is compared.
+#define FROZEN_AHEAD (FROZEN_LINE / sizeof(uint64_t))
+
+//=============================================================================/
+//=================|    Data Structures     |==================================/
+//=============================================================================/
+
+/**
+ * @brief The index: \c length slots, from 1, in two parallel arrays.
+ */
+struct _frozen_s {
+    uint64_t *keys; // the first 8 bytes of every word, big endian
+    Item **items;
+    size_t length;
+    size_t key_bytes; // of keys, rounded to whole cache lines
+};
+
+//=============================================================================/
+//=================|    Private Function Declarations     |====================/
+//=============================================================================/
+
+static inline uint64_t key_of(const char *word);
+static size_t frozen_fill(Frozen *frozen, Item *const *items, size_t next,
+                          size_t k);
+static size_t frozen_lower_bound(const Frozen *frozen, const char *word);
+static size_t frozen_next(const Frozen *frozen, size_t k);
+
+//=============================================================================/
+//=================|    Public Function Implementations     |==================/
+//=============================================================================/
+
+Frozen *frozen_new(Item *const *items, size_t n) {
+    if (NULL == items && n > 0) return NULL;
+
+    Frozen *frozen = (Frozen *)malloc(sizeof(Frozen));
+    if (NULL == frozen) return NULL; // err handling
+
+    size_t lines = ((n + 1) * sizeof(uint64_t) + FROZEN_LINE - 1) / FROZEN_LINE;
+    *frozen = (Frozen){.length = n, .key_bytes = lines * FROZEN_LINE};
+    frozen->keys = (uint64_t *)aligned_alloc(FROZEN_LINE, frozen->key_bytes);
+    frozen->items = (Item **)malloc((n + 1) * sizeof(Item *));
+    if (NULL == frozen->keys || NULL == frozen->items) { // err handling
+        frozen_del(&frozen);
+        return NULL;
+    }
+
+    frozen->keys[0] = 0;
+    frozen->items[0] = NULL;
+    frozen_fill(frozen, items, 0, 1);
+    return frozen;
+}
+
+void frozen_del(Frozen **frozen) {
+    if (NULL == frozen || NULL == *frozen) return;
+    free((*frozen)->keys);
+    free((*frozen)->items);
+    free(*frozen);
+    *frozen = NULL;
+}
+
+Item *frozen_get(const Frozen *frozen, const Item *item) {
+    if (NULL == frozen || NULL == item) return NULL;
+
+    size_t k = frozen_lower_bound(frozen, item_word(item));
+    if (0 == k || 0 != item_cmp(frozen->items[k], item)) return NULL;
+    return frozen->items[k];
+}
+
+status_t frozen_foreach_char(const Frozen *frozen, const char c,
+                             status_t (*fn)(Item *item, void *ctx),
+                             void *ctx) {
+    if (NULL == frozen || NULL == fn) return NUL_ERR;
+
+    // The words that start with c follow the first word not before c
+    const char first[2] = {c, '\0'};
+    for (size_t k = frozen_lower_bound(frozen, first);
+         k && 0 == item_raw_char_cmp(frozen->items[k], c);
+         k = frozen_next(frozen, k)) {
+        status_t flag = fn(frozen->items[k], ctx);
+        if (SUCCESS != flag) return flag;
+    }
+
+    return SUCCESS;
+}
+
+size_t frozen_length(const Frozen *frozen) {
+    return frozen ? frozen->length : 0;
+}
+
+size_t frozen_bytes(const Frozen *frozen) {
+    if (NULL == frozen) return 0;
+    return sizeof(Frozen) + frozen->key_bytes +
+           (frozen->length + 1) * sizeof(Item *);
+}
+
+//=============================================================================/
+//=================|    Private Function Implementations    |==================/
+//=============================================================================/
+
+/**
+ * @brief The first 8 bytes of a word, big endian and padded with zeros, so
+ * keys compare as the words do with strcmp() up to their 8th byte.
+ */
+static inline uint64_t key_of(const char *word) {
+    uint64_t key = 0;
+    for (size_t i = 0; i < sizeof(uint64_t); i++) {
+        key = key << 8 | (unsigned char)*word;
+        if (*word) word++;
+    }
+    return key;
+}
+
+/**
+ * @brief Places the sorted items in the subtree of slot k, in order: its left
+ * subtree, k, then its right subtree.
+ *
+ * @param frozen ptr to the index.
+ * @param items the sorted items.
+ * @param next the first item not placed yet.
+ * @param k the root of the subtree.
+ * @return size_t the first item not placed once the subtree is full.
+ */
+static size_t frozen_fill(Frozen *frozen, Item *const *items, size_t next,
+                          size_t k) {
+    if (k > frozen->length) return next;
+
+    next = frozen_fill(frozen, items, next, 2 * k);
+    frozen->keys[k] = key_of(item_word(items[next]));
+    frozen->items[k] = items[next++];
+    return frozen_fill(frozen, items, next, 2 * k + 1);
+}
+
+/**
+ * @brief Finds the first word not before the given one.
+ *
+ * Every level picks a child with the result of the comparison instead of a
+ * branch; only words whose first 8 bytes tie are compared in full. The walk
+ * ends past a leaf, and the right turns it took since its last left turn
+ * lead back to the slot of that turn: the answer.
+ *
+ * @param frozen ptr to the index.
+ * @param word the key.
+ * @return size_t the slot, or \c 0 if every word is before the key.
+ */
+static size_t frozen_lower_bound(const Frozen *frozen, const char *word) {
+    const uint64_t key = key_of(word);
+    const size_t n = frozen->length;
+
+    size_t k = 1;
+    while (k <= n) {
+        if (FROZEN_AHEAD * k <= n)
+            __builtin_prefetch(frozen->keys + FROZEN_AHEAD * k);
+
+        uint64_t at = frozen->keys[k];
+        _Bool before = (at < key) |
+                       ((at == key) &&
+                        strcmp(item_word(frozen->items[k]), word) < 0);
+        k = 2 * k + before;
+    }
+
+    return k >> __builtin_ffsll((long long)~k);
+}
+
+/**
+ * @brief The slot of the next word: the leftmost slot of the right subtree,
+ * or else the slot of the last left turn on the way down to k.
+ *
+ * @param frozen ptr to the index.
+ * @param k a slot.
+ * @return size_t the next slot, or \c 0 after the last one.
+ */
+static size_t frozen_next(const Frozen *frozen, size_t k) {
+    if (2 * k + 1 <= frozen->length) {
+        k = 2 * k + 1;
+        while (2 * k <= frozen->length) k = 2 * k;
+        return k;
+    }
+    return k >> __builtin_ffsll((long long)~k);
+}
@@ -0,0 +1,179 @@
+/**
+ * @file hashindex.c
+ * @brief Implementation of an open addressing hash index of items by key.
+ */
+
+#include "tads/hashindex.h"
+
+// Smallest table, in slots.
+#define HASHINDEX_MIN_SLOTS (16)
+
+//=============================================================================/
+//=================|    Data Structures     |==================================/
+//=============================================================================/
+
+/**
+ * @brief A slot of the table. It is empty when item is NULL.
+ */
+typedef struct {
+    uint64_t hash;
+    Item *item;
+} slot_t;
+
+/**
+ * @brief Hash index: a power of two table of slots.
+ */
+struct _hashindex_s {
+    slot_t *slots;
+    size_t mask; // number of slots minus one
+    size_t length;
+};
+
+//=============================================================================/
+//=================|    Private Function Declarations     |====================/
+//=============================================================================/
+
+static size_t slots_for(size_t capacity);
+static status_t hashindex_resize(HashIndex *index, size_t n_slots);
+static size_t hashindex_find(const HashIndex *index, const Item *key,
+                             uint64_t hash);
+
+//=============================================================================/
+//=================|    Public Function Implementations     |==================/
+//=============================================================================/
+
+HashIndex *hashindex_new(size_t capacity) {
+    HashIndex *index = (HashIndex *)malloc(sizeof(HashIndex));
+    if (NULL == index) return NULL; // err handling
+
+    size_t n = slots_for(capacity);
+    *index = (HashIndex){
+        .slots = (slot_t *)calloc(n, sizeof(slot_t)),
+        .mask = n - 1,
+    };
+    if (NULL == index->slots) hashindex_del(&index); // err handling
+    return index;
+}
+
+void hashindex_del(HashIndex **index) {
+    if (NULL == index || NULL == *index) return;
+    free((*index)->slots);
+    free(*index);
+    *index = NULL;
+}
+
+status_t hashindex_reserve(HashIndex *index, size_t capacity) {
+    if (NULL == index) return NUL_ERR;
+    size_t n = slots_for(capacity);
+    return n > index->mask + 1 ? hashindex_resize(index, n) : SUCCESS;
+}
+
+status_t hashindex_put(HashIndex *index, Item *item) {
+    if (NULL == index || NULL == item) return NUL_ERR;
+
+    status_t flag = hashindex_reserve(index, index->length + 1);
+    if (SUCCESS != flag) return flag; // err handling
+
+    uint64_t hash = item_hash(item);
+    size_t i = hashindex_find(index, item, hash);
+    if (NULL == index->slots[i].item) index->length++;
+    index->slots[i] = (slot_t){.hash = hash, .item = item};
+    return SUCCESS;
+}
+
+Item *hashindex_get(const HashIndex *index, const Item *key) {
+    if (NULL == index || NULL == key) return NULL;
+    return index->slots[hashindex_find(index, key, item_hash(key))].item;
+}
+
+Item *hashindex_take(HashIndex *index, const Item *key) {
+    if (NULL == index || NULL == key) return NULL;
+
+    size_t i = hashindex_find(index, key, item_hash(key));
+    Item *taken = index->slots[i].item;
+    if (NULL == taken) return NULL;
+
+    // Shift back the slots that probed past the hole, until an empty one
+    for (size_t j = (i + 1) & index->mask; NULL != index->slots[j].item;
+         j = (j + 1) & index->mask) {
+        size_t home = index->slots[j].hash & index->mask;
+
+        // The slot stays if its home lies cyclically in (i, j]
+        _Bool stays = i <= j ? (i < home && home <= j) : (i < home || home <= j);
+        if (stays) continue;
+
+        index->slots[i] = index->slots[j];
+        i = j;
+    }
+
+    index->slots[i] = (slot_t){0};
+    index->length--;
+    return taken;
+}
+
+void hashindex_clear(HashIndex *index) {
+    if (NULL == index) return;
+    memset(index->slots, 0, (index->mask + 1) * sizeof(slot_t));
+    index->length = 0;
+}
+
+size_t hashindex_length(const HashIndex *index) {
+    return index ? index->length : 0;
+}
+
+size_t hashindex_bytes(const HashIndex *index) {
+    if (NULL == index) return 0;
+    return sizeof(HashIndex) + (index->mask + 1) * sizeof(slot_t);
+}
+
+//=============================================================================/
+//=================|    Private Function Implementations    |==================/
+//=============================================================================/
+
+/**
+ * @brief The number of slots that holds capacity items at most three quarters
+ * full: a power of two.
+ */
+static size_t slots_for(size_t capacity) {
+    size_t n = HASHINDEX_MIN_SLOTS;
+    while (n - n / 4 < capacity) n *= 2;
+    return n;
+}
+
+/**
+ * @brief Moves every item to a new table of n_slots slots.
+ *
+ * @return status_t \c SUCCESS or \c ALLOC_ERR, in which case the index is
+ * left as it was.
+ */
+static status_t hashindex_resize(HashIndex *index, size_t n_slots) {
+    slot_t *slots = (slot_t *)calloc(n_slots, sizeof(slot_t));
+    if (NULL == slots) return ALLOC_ERR; // err handling
+
+    size_t mask = n_slots - 1;
+    for (size_t i = 0; i <= index->mask; i++) {
+        if (NULL == index->slots[i].item) continue;
+        size_t j = index->slots[i].hash & mask;
+        while (NULL != slots[j].item) j = (j + 1) & mask;
+        slots[j] = index->slots[i];
+    }
+
+    free(index->slots);
+    index->slots = slots;
+    index->mask = mask;
+    return SUCCESS;
+}
+
+/**
+ * @brief Probes for the slot of key: the one holding it or the empty slot
+ * where it would go.
+ */
+static size_t hashindex_find(const HashIndex *index, const Item *key,
+                             uint64_t hash) {
+    size_t i = hash & index->mask;
+    while (NULL != index->slots[i].item &&
+           (index->slots[i].hash != hash ||
+            0 != item_raw_cmp(index->slots[i].item, key)))
+        i = (i + 1) & index->mask;
+    return i;
+}
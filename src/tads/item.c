@@ -16,15 +16,26 @@ typedef struct {
 } entry_t;
 
 struct _item_s {
+    _Bool tombstone;  // see item_set_tombstone()
+    _Bool referenced; // see item_set_referenced()
+    _Bool cold;       // see item_new_cold()
+    _Bool cut;        // allocated without the description buffer
+    uint32_t expires; // see item_set_expiry()
+    uint32_t timer;   // see item_set_timer()
+
+    // NOTE (b): it must come last, cold items are cut right after the word
+    // and its reference.
     entry_t val;
 };
 
+_Static_assert(sizeof(Item) <= sizeof(item_buf_t), "item_buf_t is too small");
+
 //============================================================================//
 //=================|    Private Function Declarations    |====================//
 //============================================================================//
 
-Item *item_from_entry(const entry_t entry);
 Item *item_from_strings(const char w[], const char d[]);
+static size_t item_cold_entry(const Item *item);
 status_t read_word(char s[]);
 status_t read_description(char s[]);
 
@@ -39,10 +50,23 @@ Item *item_new(void) {
     // Initialization
     item->val.word[0] = '\0';
     item->val.description[0] = '\0';
+    item->tombstone = 0;
+    item->referenced = 0;
+    item->cold = 0;
+    item->cut = 0;
+    item->expires = 0;
+    item->timer = 0;
 
     return item;
 }
 
+Item *item_clone(const Item *item) {
+    if (NULL == item) return NULL; // err handling
+    Item *clone = (Item *)malloc(item_bytes(item));
+    if (clone) memcpy(clone, item, item_bytes(item));
+    return clone;
+}
+
 void item_del(Item **item) {
     if (NULL == item) return; // err handling
     // NOTE: free(NULL) is fine, so no need to check *item.
@@ -55,15 +79,29 @@ int item_raw_cmp(const Item *item_1, const Item *item_2) {
     return strcmp(item_1->val.word, item_2->val.word);
 }
 
+uint64_t item_hash(const Item *item) {
+    uint64_t hash = 14695981039346656037ull; // FNV offset basis
+    for (const unsigned char *c = (const unsigned char *)item->val.word; *c; c++)
+        hash = (hash ^ *c) * 1099511628211ull; // FNV prime
+    return hash;
+}
+
 int item_cmp(const Item *item_1, const Item *item_2) {
     if (NULL == item_1 || NULL == item_2) return 0;
     return item_raw_cmp(item_1, item_2);
 }
 
 void item_print(const Item *item) {
-    item_print_word(item);
-    printf(" ");
-    item_print_description(item);
+    item_fprint(stdout, item);
+}
+
+void item_fprint(FILE *out, const Item *item) {
+#ifdef RELEASE
+    fprintf(out, "%s %s", item->val.word, item_description(item));
+#else
+    fprintf(out, "%s %s", item ? item->val.word : "<NULL>",
+            item ? item_description(item) : "<NULL>");
+#endif
 }
 
 void item_print_word(const Item *item) {
@@ -76,62 +114,177 @@ void item_print_word(const Item *item) {
 
 void item_print_description(const Item *item) {
 #ifdef RELEASE
-    printf("%s", item->val.description); // if release, trust and optimize
+    printf("%s", item_description(item)); // if release, trust and optimize
 #else
-    printf("%s", item ? item->val.description : "<NULL>");
+    printf("%s", item ? item_description(item) : "<NULL>");
 #endif
 }
 
 Item *item_read(void) {
-    entry_t e = (entry_t){0};
+    Item *item = (Item *)malloc(sizeof(Item)); // allocation
+    if (NULL == item) return NULL;             // err handling
+    return item_read_into((item_buf_t *)item);
+}
 
-    if (EOF == scanf("%50s %140[^\n]", e.word, e.description)) {
-        return item_from_entry(e);
-    } else {
-        return item_from_entry(e);
-    }
+Item *item_read_into(item_buf_t *buf) {
+    // The entry is read in place, not through a copy on the stack
+    Item *item = item_place(buf, NULL, 0, NULL, 0);
+    if (EOF == scanf("%50s %140[^\n]", item->val.word, item->val.description))
+        item->val.word[0] = '\0'; // the end of the input: an empty word
+    return item;
+}
+
+Item *item_read_word(void) {
+    Item *item = (Item *)malloc(sizeof(Item)); // allocation
+    if (NULL == item) return NULL;             // err handling
+    if (NULL == item_read_word_into((item_buf_t *)item)) item_del(&item);
+    return item;
+}
 
-    status_t flag = read_word(e.word);
+Item *item_read_word_into(item_buf_t *buf) {
+    Item *item = item_place(buf, NULL, 0, NULL, 0);
+    status_t flag = read_word(item->val.word);
 
     // WARNING (b): if RECOVER_FROM_BIG_INPUT is not set to a truthy value, then
     // you must deal with the error elsewhere or it will cause reading
     // misbehaviour.
+    // clang-format off
     #if RECOVER_FROM_BIG_INPUT
         if (TOO_MUCH_ERR == flag) strutils_consume_word();
         else if (EOF_ERR == flag) return NULL;
     #else
         if (TOO_MUCH_ERR == flag || EOF_ERR == flag) return NULL;
     #endif
+    // clang-format on
+
+    return item;
+}
 
-        flag = read_description(e.description);
+Item *item_new_from(const char *word, size_t word_len,
+                    const char *description, size_t description_len) {
+    Item *item = (Item *)malloc(sizeof(Item)); // allocation
+    if (NULL == item) return NULL;             // err handling
+    return item_place((item_buf_t *)item, word, word_len, description,
+                      description_len);
+}
 
-    #if RECOVER_FROM_BIG_INPUT
-        if (TOO_MUCH_ERR == flag) strutils_consume_line();
-        else if (EOF_ERR == flag) return NULL;
-    #else
-        if (TOO_MUCH_ERR == flag || EOF_ERR == flag) return NULL;
-    #endif
+Item *item_place(item_buf_t *buf, const char *word, size_t word_len,
+                 const char *description, size_t description_len) {
+    if (NULL == buf || (NULL == word && word_len > 0)) return NULL;
+
+    Item *item = (Item *)buf;
+    if (word_len > MAX_WORD_SIZE) word_len = MAX_WORD_SIZE;
+    if (description_len > MAX_DESCRIPTION_SIZE)
+        description_len = MAX_DESCRIPTION_SIZE;
+    if (NULL == description) description_len = 0;
+
+    if (word_len > 0) memcpy(item->val.word, word, word_len);
+    item->val.word[word_len] = '\0';
+    if (description_len > 0)
+        memcpy(item->val.description, description, description_len);
+    item->val.description[description_len] = '\0';
+    item->tombstone = 0;
+    item->referenced = 0;
+    item->cold = 0;
+    item->cut = 0;
+    item->expires = 0;
+    item->timer = 0;
+    return item;
+}
 
-    return item_from_entry(e);
+Item *item_clone_into(item_buf_t *buf, const Item *item) {
+    if (NULL == buf || NULL == item) return NULL; // err handling
+    Item *copy = (Item *)buf;
+    memcpy(copy, item, item_bytes(item));
+    return copy;
 }
 
-Item *item_read_word(void) {
-    entry_t e = (entry_t){0};
-    status_t flag = read_word(e.word);
+Item *item_in(const item_buf_t *buf) { return (Item *)buf; }
 
-    // WARNING (b): if RECOVER_FROM_BIG_INPUT is not set to a truthy value, then
-    // you must deal with the error elsewhere or it will cause reading
-    // misbehaviour.
-    // clang-format off
-    #if RECOVER_FROM_BIG_INPUT
-        if (TOO_MUCH_ERR == flag) strutils_consume_word();
-        else if (EOF_ERR == flag) return NULL;
-    #else
-        if (TOO_MUCH_ERR == flag || EOF_ERR == flag) return NULL;
-    #endif
-    // clang-format on
+const char *item_word(const Item *item) { return item->val.word; }
 
-    return item_from_entry(e);
+const char *item_description(const Item *item) {
+    return item->cold ? "" : item->val.description;
+}
+
+Item *item_new_cold(const char *word, uint64_t ref) {
+    if (NULL == word) return NULL; // err handling
+
+    size_t word_len = strnlen(word, MAX_WORD_SIZE);
+    size_t bytes =
+        offsetof(Item, val.word) + word_len + 1 + sizeof(uint64_t);
+    Item *item = (Item *)malloc(bytes); // allocation
+    if (NULL == item) return NULL;      // err handling
+
+    memcpy(item->val.word, word, word_len);
+    item->val.word[word_len] = '\0';
+    item->tombstone = 0;
+    item->referenced = 0;
+    item->cold = 1;
+    item->cut = 1;
+    item->expires = 0;
+    item->timer = 0;
+    item_set_cold_ref(item, ref);
+    return item;
+}
+
+_Bool item_is_cold(const Item *item) { return item && item->cold; }
+
+uint64_t item_cold_ref(const Item *item) {
+    uint64_t ref;
+    memcpy(&ref, item->val.word + strlen(item->val.word) + 1, sizeof(ref));
+    return ref;
+}
+
+void item_set_cold_ref(Item *item, uint64_t ref) {
+    memcpy(item->val.word + strlen(item->val.word) + 1, &ref, sizeof(ref));
+}
+
+Item *item_parse(const char *line, size_t len) {
+    Item *item = (Item *)malloc(sizeof(Item)); // allocation
+    if (NULL == item) return NULL;             // err handling
+    if (NULL == item_parse_into((item_buf_t *)item, line, len)) item_del(&item);
+    return item;
+}
+
+Item *item_parse_into(item_buf_t *buf, const char *line, size_t len) {
+    Item *item = item_place(buf, NULL, 0, NULL, 0);
+    if (NULL == item || NULL == line) return NULL; // err handling
+
+    size_t i = 0;
+    while (i < len && strutils_isspace(line[i])) i++; // leading spaces
+
+    // Word: everything up to the next white space
+    size_t start = i;
+    while (i < len && !strutils_isspace(line[i])) i++;
+    size_t word_len = i - start;
+    if (0 == word_len) return NULL;
+    if (word_len > MAX_WORD_SIZE) word_len = MAX_WORD_SIZE;
+    memcpy(item->val.word, line + start, word_len);
+    item->val.word[word_len] = '\0';
+
+    // Description: the rest of the line, without the leading spaces (the same
+    // the "%140[^\n]" of item_read keeps)
+    while (i < len && strutils_isspace(line[i])) i++;
+    size_t desc_len = len - i;
+    if (desc_len > MAX_DESCRIPTION_SIZE) desc_len = MAX_DESCRIPTION_SIZE;
+    memcpy(item->val.description, line + i, desc_len);
+    item->val.description[desc_len] = '\0';
+
+    return item;
+}
+
+_Bool item_is_parsable(const char *word, size_t word_len,
+                       const char *description, size_t description_len) {
+    if (NULL == word || 0 == word_len) return 0;
+    for (size_t i = 0; i < word_len; i++)
+        if ('\0' == word[i] || strutils_isspace(word[i])) return 0;
+
+    if (0 == description_len) return 1;
+    if (NULL == description || strutils_isspace(description[0])) return 0;
+    for (size_t i = 0; i < description_len; i++)
+        if ('\0' == description[i] || '\n' == description[i]) return 0;
+    return 1;
 }
 
 int item_raw_char_cmp(const Item *item, const char c) {
@@ -142,21 +295,6 @@ int item_raw_char_cmp(const Item *item, const char c) {
 //=================|    Private Function Implementations    |=================//
 //============================================================================//
 
-/**
- * @brief Creates a new item on the heap and returns a ptr to it.
- *
- * @param entry
- * @return Item*
- *
- * @warning: now you have ownership of the item.
- */
-Item *item_from_entry(const entry_t entry) {
-    Item *item = (Item *)malloc(sizeof(Item));
-    if (NULL == item) printf ("COULD NOT ALLOC ITEM!\n");
-    if (item) item->val = entry;
-    return item;
-}
-
 /**
  * @brief Creates a item based on two strings.
  *
@@ -171,6 +309,12 @@ Item *item_from_strings(const char w[], const char d[]) {
     if (NULL == item) return NULL;
     memcpy(&item->val.word, w, MAX_WORD_SIZE);
     memcpy(&item->val.description, d, MAX_DESCRIPTION_SIZE);
+    item->tombstone = 0;
+    item->referenced = 0;
+    item->cold = 0;
+    item->cut = 0;
+    item->expires = 0;
+    item->timer = 0;
     return item;
 }
 
@@ -245,5 +389,62 @@ status_t read_description(char s[]) {
 }
 
 void item_raw_update(Item *destiny, const Item *reference) {
-    destiny->val = reference->val;
-}
\ No newline at end of file
+    // A cut item only has room for its own word and a reference
+    if (destiny->cut &&
+        (!reference->cold || item_raw_cmp(destiny, reference)))
+        return;
+
+    if (reference->cold)
+        memcpy(destiny->val.word, reference->val.word,
+               item_cold_entry(reference));
+    else destiny->val = reference->val;
+    destiny->cold = reference->cold;
+}
+
+void item_set_tombstone(Item *item, _Bool tombstone) {
+    if (item) item->tombstone = tombstone;
+}
+
+_Bool item_is_tombstone(const Item *item) { return item && item->tombstone; }
+
+void item_set_referenced(Item *item, _Bool referenced) {
+    if (item) item->referenced = referenced;
+}
+
+_Bool item_is_referenced(const Item *item) {
+    return item && item->referenced;
+}
+
+void item_set_expiry(Item *item, uint32_t expires) {
+    if (item) item->expires = expires;
+}
+
+uint32_t item_expiry(const Item *item) { return item ? item->expires : 0; }
+
+void item_set_timer(Item *item, uint32_t timer) {
+    if (item) item->timer = timer;
+}
+
+uint32_t item_timer(const Item *item) { return item ? item->timer : 0; }
+
+size_t item_size(void) { return sizeof(Item); }
+
+size_t item_bytes(const Item *item) {
+    if (NULL == item) return 0;
+    if (item->cut) return offsetof(Item, val.word) + item_cold_entry(item);
+    return sizeof(Item);
+}
+
+size_t item_padding(const Item *item) {
+    if (NULL == item || item->cold) return 0;
+    size_t used = strlen(item->val.word) + strlen(item->val.description) + 2;
+    return sizeof(entry_t) - used;
+}
+
+/**
+ * @brief The bytes a cold item keeps of its entry: the word, its '\0' and
+ * the reference.
+ */
+static size_t item_cold_entry(const Item *item) {
+    return strlen(item->val.word) + 1 + sizeof(uint64_t);
+}
@@ -0,0 +1,840 @@
+/**
+ * @file shardlist.c
+ * @brief Implementation of a key-range sharded container of skiplists.
+ */
+
+#include "tads/shardlist.h"
+
+//=============================================================================/
+//=================|    Data Structures     |==================================/
+//=============================================================================/
+
+/**
+ * @brief Sharded list. Shard i holds the keys in [bounds[i - 1], bounds[i]).
+ * Only the first \c n_bounds boundaries are valid; shards after them are
+ * empty until the next rebalance.
+ */
+struct _shardlist_s {
+    size_t n_shards;
+    SkipList **shards;
+    Item **bounds;   // n_shards - 1 owned copies of the boundary keys
+    size_t n_bounds; // how many of the bounds are in use
+    size_t balanced_length; // total length at the last rebalance
+    ThreadPool *pool;
+    size_t max_length; // limit of the whole length, or 0, see shardlist_new
+    size_t max_bytes;  // limit of the whole heap bytes, or 0
+    _Bool evict;       // make room past the limits instead of refusing
+};
+
+/**
+ * @brief The work given to one thread: a run of operations of one shard.
+ */
+typedef struct {
+    SkipList *shard;
+    shard_op_t *ops;
+    size_t *indexes; // positions in ops, in batch order
+    size_t count;
+} shard_task_t;
+
+/**
+ * @brief The work given to one thread during a rebalance.
+ */
+typedef struct {
+    const SkipList *shard; // the current one, whose settings are copied
+    SkipList *built;       // the new one
+    Item **items;
+    size_t count;
+    status_t status;
+} refill_task_t;
+
+/**
+ * @brief Accumulator used to collect the items of every shard in order.
+ */
+typedef struct {
+    Item **items;
+    size_t count;
+} gather_t;
+
+/**
+ * @brief State of a print: where to write and how many items were written.
+ */
+typedef struct {
+    FILE *out;
+    size_t count;
+} print_t;
+
+//=============================================================================/
+//=================|    Private Function Declarations     |====================/
+//=============================================================================/
+
+static size_t shard_of(const ShardList *shardlist, const Item *item);
+static void shard_op_apply(SkipList *shard, shard_op_t *op);
+static void shard_task_run(void *arg);
+static void refill_task_run(void *arg);
+static status_t shardlist_fill(ShardList *shardlist, Item **items,
+                               size_t total);
+static status_t gather_visit(Item *item, void *ctx);
+static status_t print_visit(Item *item, void *ctx);
+static void shardlist_maybe_rebalance(ShardList *shardlist);
+static _Bool shardlist_bounded(const ShardList *shardlist);
+static size_t shardlist_bytes(const ShardList *shardlist);
+static status_t shardlist_evict(ShardList *shardlist, size_t except);
+static status_t shardlist_room(ShardList *shardlist, size_t i);
+static status_t shardlist_share(ShardList *shardlist,
+                                const skiplist_op_t *runs,
+                                const size_t *starts);
+static status_t shardlist_fit(ShardList *shardlist);
+
+//=============================================================================/
+//=================|    Public Function Implementations     |==================/
+//=============================================================================/
+
+ShardList *shardlist_new(size_t shards, size_t threads,
+                         const skiplist_config_t *config) {
+    if (0 == shards) shards = 1;
+
+    ShardList *shardlist = (ShardList *)calloc(1, sizeof(ShardList));
+    if (NULL == shardlist) return NULL; // err handling
+    shardlist->n_shards = shards;
+
+    // The limits are the list's: the shards get theirs from it, see
+    // shardlist_room()
+    skiplist_config_t shard = config ? *config : skiplist_config_default();
+    shardlist->max_length = shard.max_length;
+    shardlist->max_bytes = shard.max_bytes;
+    shardlist->evict = shard.evict;
+    shard.max_length = shard.max_bytes = 0;
+
+    shardlist->shards = (SkipList **)calloc(shards, sizeof(SkipList *));
+    shardlist->bounds = (Item **)calloc(shards, sizeof(Item *));
+    if (NULL == shardlist->shards || NULL == shardlist->bounds) {
+        shardlist_del(&shardlist);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < shards; i++) {
+        shardlist->shards[i] = skiplist_new_with_config(&shard);
+        if (NULL == shardlist->shards[i]) {
+            shardlist_del(&shardlist);
+            return NULL;
+        }
+    }
+
+    // NOTE (b): a failing pool is not fatal, batches just run serially.
+    if (threads > 0) shardlist->pool = threadpool_new(threads);
+
+    return shardlist;
+}
+
+void shardlist_del(ShardList **shardlist) {
+    if (NULL == shardlist || NULL == *shardlist) return;
+    ShardList *s = *shardlist;
+
+    threadpool_del(&s->pool);
+
+    if (s->shards)
+        for (size_t i = 0; i < s->n_shards; i++) skiplist_del(&s->shards[i]);
+
+    if (s->bounds)
+        for (size_t i = 0; i < s->n_bounds; i++) item_del(&s->bounds[i]);
+
+    free(s->shards);
+    free(s->bounds);
+    free(s);
+    *shardlist = NULL;
+}
+
+skiplist_config_t shardlist_config(const ShardList *shardlist) {
+    if (NULL == shardlist) return skiplist_config_default();
+    skiplist_config_t config = skiplist_config(shardlist->shards[0]);
+    config.max_length = shardlist->max_length;
+    config.max_bytes = shardlist->max_bytes;
+    config.evict = shardlist->evict;
+    return config;
+}
+
+void shardlist_on_drop(ShardList *shardlist,
+                       void (*fn)(void *ctx, const Item *item), void *ctx) {
+    if (NULL == shardlist) return;
+    for (size_t i = 0; i < shardlist->n_shards; i++)
+        skiplist_on_drop(shardlist->shards[i], fn, ctx);
+    if (fn) threadpool_del(&shardlist->pool);
+}
+
+status_t shardlist_insert(ShardList *shardlist, Item *item) {
+    if (NULL == shardlist || NULL == item) return NUL_ERR;
+    size_t i = shard_of(shardlist, item);
+    SkipList *shard = shardlist->shards[i];
+
+    // A word already there is refused before anything is evicted for it
+    status_t flag = SUCCESS;
+    if (shardlist_bounded(shardlist)) {
+        if (skiplist_search(shard, item)) return REPEATED_ENTRY_ERR;
+        flag = shardlist_room(shardlist, i);
+    }
+    if (SUCCESS == flag) flag = skiplist_insert(shard, item);
+
+    // A shard that can not make room by itself gets it from the others
+    while (ARR_IS_FULL_ERR == flag && SUCCESS == shardlist_evict(shardlist, i)) {
+        flag = shardlist_room(shardlist, i);
+        if (SUCCESS == flag) flag = skiplist_insert(shard, item);
+    }
+
+    if (SUCCESS == flag) shardlist_maybe_rebalance(shardlist);
+    return flag;
+}
+
+status_t shardlist_update(ShardList *shardlist, Item *item) {
+    if (NULL == shardlist || NULL == item) return NUL_ERR;
+    return skiplist_update(shardlist->shards[shard_of(shardlist, item)], item);
+}
+
+Item *shardlist_remove(ShardList *shardlist, Item *item) {
+    if (NULL == shardlist || NULL == item) return NULL;
+    return skiplist_remove(shardlist->shards[shard_of(shardlist, item)], item);
+}
+
+status_t shardlist_delete(ShardList *shardlist, Item *item) {
+    if (NULL == shardlist || NULL == item) return NUL_ERR;
+    return skiplist_delete(shardlist->shards[shard_of(shardlist, item)], item);
+}
+
+void shardlist_stamp(const ShardList *shardlist, Item *item) {
+    if (NULL == shardlist) return;
+    skiplist_stamp(shardlist->shards[0], item); // they share the clock
+}
+
+_Bool shardlist_expired(const ShardList *shardlist, const Item *item) {
+    if (NULL == shardlist) return 0;
+    return skiplist_expired(shardlist->shards[0], item);
+}
+
+Item *shardlist_search(ShardList *shardlist, const Item *item) {
+    if (NULL == shardlist || NULL == item) return NULL;
+    return skiplist_lookup(shardlist->shards[shard_of(shardlist, item)], item);
+}
+
+status_t shardlist_print(const ShardList *shardlist, const char c) {
+    return shardlist_fprint(stdout, shardlist, c);
+}
+
+status_t shardlist_fprint(FILE *out, const ShardList *shardlist, const char c) {
+    if (NULL == shardlist || 0 == shardlist_length(shardlist)) return ERROR;
+
+    // Shards are ordered, so concatenating them keeps the order.
+    print_t print = (print_t){.out = out};
+    for (size_t i = 0; i < shardlist->n_shards; i++)
+        skiplist_foreach_char(shardlist->shards[i], c, print_visit, &print);
+
+    if (0 == print.count) fprintf(out, "NAO HA PALAVRAS INICIADAS POR %c\n", c);
+
+    return SUCCESS;
+}
+
+status_t shardlist_foreach(const ShardList *shardlist,
+                           status_t (*fn)(Item *item, void *ctx), void *ctx) {
+    if (NULL == shardlist || NULL == fn) return NUL_ERR;
+
+    for (size_t i = 0; i < shardlist->n_shards; i++) {
+        status_t flag = skiplist_foreach(shardlist->shards[i], fn, ctx);
+        if (SUCCESS != flag) return flag;
+    }
+
+    return SUCCESS;
+}
+
+status_t shardlist_foreach_char(const ShardList *shardlist, const char c,
+                                status_t (*fn)(Item *item, void *ctx),
+                                void *ctx) {
+    if (NULL == shardlist || NULL == fn) return NUL_ERR;
+
+    for (size_t i = 0; i < shardlist->n_shards; i++) {
+        status_t flag =
+            skiplist_foreach_char(shardlist->shards[i], c, fn, ctx);
+        if (SUCCESS != flag) return flag;
+    }
+
+    return SUCCESS;
+}
+
+status_t shardlist_apply(ShardList *shardlist, shard_op_t *ops, size_t n) {
+    if (NULL == shardlist || (NULL == ops && n > 0)) return NUL_ERR;
+    if (0 == n) return SUCCESS;
+
+    // Within limits, each insertion needs the room the ones before it left
+    if (shardlist_bounded(shardlist)) {
+        for (size_t i = 0; i < n; i++) {
+            if (SHARD_INSERT != ops[i].kind) {
+                SkipList *shard = shardlist->shards[shard_of(shardlist,
+                                                             ops[i].item)];
+                shard_op_apply(shard, &ops[i]);
+                continue;
+            }
+            ops[i].result = NULL;
+            ops[i].status = shardlist_insert(shardlist, ops[i].item);
+        }
+        return SUCCESS;
+    }
+
+    size_t s = shardlist->n_shards;
+
+    // Counting sort of the op indexes by shard; stable, so ops on the same key
+    // keep their batch order.
+    size_t *indexes = (size_t *)malloc(n * sizeof(size_t));
+    size_t *shard_ids = (size_t *)malloc(n * sizeof(size_t));
+    size_t *starts = (size_t *)calloc(s + 1, sizeof(size_t));
+    shard_task_t *tasks = (shard_task_t *)calloc(s, sizeof(shard_task_t));
+
+    if (NULL == indexes || NULL == shard_ids || NULL == starts ||
+        NULL == tasks) {
+        free(indexes);
+        free(shard_ids);
+        free(starts);
+        free(tasks);
+        return ALLOC_ERR;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        shard_ids[i] = shard_of(shardlist, ops[i].item);
+        starts[shard_ids[i] + 1]++;
+    }
+    for (size_t i = 0; i < s; i++) starts[i + 1] += starts[i];
+    for (size_t i = 0; i < s; i++) {
+        tasks[i] = (shard_task_t){
+            .shard = shardlist->shards[i],
+            .ops = ops,
+            .indexes = indexes + starts[i],
+        };
+    }
+    for (size_t i = 0; i < n; i++) {
+        shard_task_t *t = &tasks[shard_ids[i]];
+        t->indexes[t->count++] = i;
+    }
+
+    // One task per non empty shard
+    for (size_t i = 0; i < s; i++) {
+        if (0 == tasks[i].count) continue;
+        if (NULL == shardlist->pool ||
+            SUCCESS != threadpool_submit(shardlist->pool, shard_task_run,
+                                         &tasks[i]))
+            shard_task_run(&tasks[i]); // err handling: do it ourselves
+    }
+    threadpool_wait(shardlist->pool);
+
+    free(indexes);
+    free(shard_ids);
+    free(starts);
+    free(tasks);
+
+    shardlist_maybe_rebalance(shardlist);
+    return SUCCESS;
+}
+
+status_t shardlist_commit(ShardList *shardlist, skiplist_op_t *ops, size_t n) {
+    if (NULL == shardlist || (NULL == ops && n > 0)) return NUL_ERR;
+    if (0 == n) return SUCCESS;
+
+    size_t s = shardlist->n_shards;
+
+    // PART 1: the ops of each shard side by side, in batch order
+    skiplist_op_t *runs = (skiplist_op_t *)malloc(n * sizeof(skiplist_op_t));
+    size_t *indexes = (size_t *)malloc(n * sizeof(size_t));
+    size_t *starts = (size_t *)calloc(s + 2, sizeof(size_t));
+
+    if (NULL == runs || NULL == indexes || NULL == starts) { // err handling
+        free(runs);
+        free(indexes);
+        free(starts);
+        return ALLOC_ERR;
+    }
+
+    for (size_t i = 0; i < n; i++)
+        starts[shard_of(shardlist, ops[i].item) + 2]++;
+    for (size_t i = 0; i < s; i++) starts[i + 2] += starts[i + 1];
+    for (size_t i = 0; i < n; i++) {
+        size_t at = starts[shard_of(shardlist, ops[i].item) + 1]++;
+        runs[at] = ops[i];
+        indexes[at] = i;
+    }
+
+    // PART 2: every shard checked before any is changed, within its share
+    // of the room
+    status_t flag = shardlist_bounded(shardlist)
+                        ? shardlist_share(shardlist, runs, starts)
+                        : SUCCESS;
+    for (size_t i = 0; SUCCESS == flag && i < s; i++)
+        if (starts[i + 1] > starts[i])
+            flag = skiplist_commit_check(shardlist->shards[i],
+                                         runs + starts[i],
+                                         starts[i + 1] - starts[i]);
+
+    // PART 3: then committed, one after the other
+    _Bool changed = 0;
+    for (size_t i = 0; SUCCESS == flag && i < s; i++) {
+        size_t count = starts[i + 1] - starts[i];
+        if (0 == count) continue;
+
+        flag = skiplist_commit(shardlist->shards[i], runs + starts[i], count);
+        if (SUCCESS != flag) // err handling: the ops left out say why
+            for (size_t j = starts[i]; j < n; j++)
+                if (SUCCESS == runs[j].status) runs[j].status = flag;
+        if (SUCCESS != flag && changed) flag = CRITICAL_ERR;
+        changed = 1;
+    }
+
+    for (size_t i = 0; i < n; i++) ops[indexes[i]] = runs[i];
+
+    free(runs);
+    free(indexes);
+    free(starts);
+
+    if (SUCCESS == flag) shardlist_maybe_rebalance(shardlist);
+    return flag;
+}
+
+status_t shardlist_rebalance(ShardList *shardlist) {
+    if (NULL == shardlist) return NUL_ERR;
+
+    size_t total = shardlist_length(shardlist);
+
+    gather_t all = {.items = (Item **)malloc((total + 1) * sizeof(Item *))};
+    if (NULL == all.items) return ALLOC_ERR;
+
+    shardlist_foreach(shardlist, gather_visit, &all);
+    status_t flag = shardlist_fill(shardlist, all.items, total);
+
+    free(all.items);
+    return flag;
+}
+
+status_t shardlist_load_sorted(ShardList *shardlist, Item **items, size_t n) {
+    if (NULL == shardlist || (NULL == items && n > 0)) return NUL_ERR;
+    if (shardlist_length(shardlist) > 0) return ARR_IS_FULL_ERR;
+
+    status_t flag = shardlist_fill(shardlist, items, n);
+    for (size_t i = 0; SUCCESS != flag && i < n; i++) item_del(&items[i]);
+    return flag;
+}
+
+status_t shardlist_index_enable(ShardList *shardlist) {
+    if (NULL == shardlist) return NUL_ERR;
+    for (size_t i = 0; i < shardlist->n_shards; i++) {
+        status_t flag = skiplist_index_enable(shardlist->shards[i]);
+        if (SUCCESS != flag) return flag; // err handling
+    }
+    return SUCCESS;
+}
+
+status_t shardlist_bloom_enable(ShardList *shardlist, double fp_rate) {
+    if (NULL == shardlist) return NUL_ERR;
+    for (size_t i = 0; i < shardlist->n_shards; i++) {
+        status_t flag = skiplist_bloom_enable(shardlist->shards[i], fp_rate);
+        if (SUCCESS != flag) return flag; // err handling
+    }
+    return SUCCESS;
+}
+
+status_t shardlist_adaptive_enable(ShardList *shardlist) {
+    if (NULL == shardlist) return NUL_ERR;
+    for (size_t i = 0; i < shardlist->n_shards; i++) {
+        status_t flag = skiplist_adaptive_enable(shardlist->shards[i]);
+        if (SUCCESS != flag) return flag; // err handling
+    }
+    return SUCCESS;
+}
+
+status_t shardlist_lazy_enable(ShardList *shardlist, double ratio) {
+    if (NULL == shardlist) return NUL_ERR;
+    for (size_t i = 0; i < shardlist->n_shards; i++) {
+        status_t flag = skiplist_lazy_enable(shardlist->shards[i], ratio);
+        if (SUCCESS != flag) return flag; // err handling
+    }
+    return SUCCESS;
+}
+
+status_t shardlist_freeze(ShardList *shardlist) {
+    if (NULL == shardlist) return NUL_ERR;
+    for (size_t i = 0; i < shardlist->n_shards; i++) {
+        status_t flag = skiplist_freeze(shardlist->shards[i]);
+        if (SUCCESS != flag) return flag; // err handling
+    }
+    return SUCCESS;
+}
+
+size_t shardlist_length(const ShardList *shardlist) {
+    if (NULL == shardlist) return 0;
+    size_t total = 0;
+    for (size_t i = 0; i < shardlist->n_shards; i++)
+        total += skiplist_length(shardlist->shards[i]);
+    return total;
+}
+
+size_t shardlist_shards(const ShardList *shardlist) {
+    return shardlist ? shardlist->n_shards : 0;
+}
+
+void shardlist_memory_print(const ShardList *shardlist) {
+    shardlist_memory_fprint(stdout, shardlist);
+}
+
+void shardlist_memory_fprint(FILE *out, const ShardList *shardlist) {
+    if (NULL == shardlist) { // err handling
+        fprintf(out, "ERROR: shardlist ptr is NULL. \n");
+        return;
+    }
+
+    for (size_t i = 0; i < shardlist->n_shards; i++) {
+        fprintf(out, "shard %zu)\n", i);
+        skiplist_memory_fprint(out, shardlist->shards[i]);
+    }
+}
+
+//=============================================================================/
+//=================|    Private Function Implementations    |==================/
+//=============================================================================/
+
+/**
+ * @brief Finds the shard responsible for a key with a binary search over the
+ * boundaries.
+ *
+ * @param shardlist ptr to the list.
+ * @param item ptr to an item containing the key.
+ * @return size_t the shard index.
+ */
+static size_t shard_of(const ShardList *shardlist, const Item *item) {
+    if (NULL == item) return 0;
+
+    // First boundary strictly greater than the key
+    size_t lo = 0, hi = shardlist->n_bounds;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (item_raw_cmp(item, shardlist->bounds[mid]) < 0) hi = mid;
+        else lo = mid + 1;
+    }
+    return lo;
+}
+
+/**
+ * @brief Applies a single operation to a shard, filling its outputs.
+ *
+ * @param shard ptr to the skiplist of the shard.
+ * @param op ptr to the operation.
+ */
+static void shard_op_apply(SkipList *shard, shard_op_t *op) {
+    op->result = NULL;
+    switch (op->kind) {
+    case SHARD_INSERT:
+        op->status = skiplist_insert(shard, op->item);
+        break;
+    case SHARD_UPDATE:
+        op->status = skiplist_update(shard, op->item);
+        break;
+    case SHARD_REMOVE:
+        op->result = skiplist_remove(shard, op->item);
+        op->status = op->result ? SUCCESS : NOT_FOUND_ERR;
+        break;
+    case SHARD_SEARCH:
+        op->result = skiplist_lookup(shard, op->item);
+        op->status = op->result ? SUCCESS : NOT_FOUND_ERR;
+        break;
+    default:
+        op->status = CRITICAL_ERR;
+    }
+}
+
+/**
+ * @brief Thread pool entry point: runs the ops of one shard in batch order.
+ *
+ * @param arg ptr to a shard_task_t.
+ */
+static void shard_task_run(void *arg) {
+    shard_task_t *task = (shard_task_t *)arg;
+    for (size_t i = 0; i < task->count; i++)
+        shard_op_apply(task->shard, &task->ops[task->indexes[i]]);
+}
+
+/**
+ * @brief Thread pool entry point: builds a shard from its sorted run, next
+ * to the current one.
+ *
+ * @param arg ptr to a refill_task_t.
+ */
+static void refill_task_run(void *arg) {
+    refill_task_t *task = (refill_task_t *)arg;
+
+    // NOTE (b): nested pools would deadlock, so the build runs inline.
+    task->built = skiplist_from_sorted(task->items, task->count, NULL);
+
+    // A shard keeps its hash index, Bloom filter and adaptive mode
+    task->status = NULL == task->built
+                       ? ALLOC_ERR
+                       : skiplist_inherit_options(task->built, task->shard);
+}
+
+/**
+ * @brief Sets the boundaries from the quantiles of a sorted run of items and
+ * builds every shard from its range, in parallel. The new shards are built
+ * next to the current ones, which are only emptied, without deleting their
+ * items, once every new shard is ready.
+ *
+ * @param shardlist ptr to the list.
+ * @param items every item the list will hold, sorted and unique.
+ * @param total number of items.
+ * @return status_t \c SUCCESS or \c ALLOC_ERR, in which case the list is
+ * left as it was.
+ */
+static status_t shardlist_fill(ShardList *shardlist, Item **items,
+                               size_t total) {
+    size_t s = shardlist->n_shards;
+
+    // PART 1: allocations, so nothing is touched if they fail
+    Item **bounds = (Item **)calloc(s, sizeof(Item *));
+    refill_task_t *tasks = (refill_task_t *)calloc(s, sizeof(refill_task_t));
+    if (NULL == bounds || NULL == tasks) {
+        free(bounds);
+        free(tasks);
+        return ALLOC_ERR;
+    }
+
+    // PART 2: the new boundaries are the quantiles of the keys
+    size_t n_bounds = total >= s ? s - 1 : 0;
+    for (size_t i = 0; i < n_bounds; i++) {
+        bounds[i] = item_clone(items[(i + 1) * total / s]);
+        if (NULL == bounds[i]) { // err handling
+            while (i > 0) item_del(&bounds[--i]);
+            free(bounds);
+            free(tasks);
+            return ALLOC_ERR;
+        }
+    }
+
+    // PART 3: build every shard from its range, in parallel. Empty ones are
+    // built as well, to get the settings.
+    for (size_t i = 0; i < s; i++) {
+        size_t lo = 0 == n_bounds ? 0 : i * total / s;
+        size_t hi = 0 == n_bounds ? (0 == i ? total : 0) : (i + 1) * total / s;
+        tasks[i] = (refill_task_t){
+            .shard = shardlist->shards[i],
+            .items = items + lo,
+            .count = hi - lo,
+        };
+        if (NULL == shardlist->pool ||
+            SUCCESS != threadpool_submit(shardlist->pool, refill_task_run,
+                                         &tasks[i]))
+            refill_task_run(&tasks[i]);
+    }
+    threadpool_wait(shardlist->pool);
+
+    status_t result = SUCCESS;
+    for (size_t i = 0; i < s; i++)
+        if (SUCCESS != tasks[i].status) result = tasks[i].status;
+
+    // Err handling: the new shards go, and the items go back to the timer
+    // wheels of the current ones
+    if (SUCCESS != result) {
+        for (size_t i = 0; i < s; i++) skiplist_abandon(&tasks[i].built);
+        for (size_t i = 0; i < s; i++)
+            skiplist_timers_reclaim(shardlist->shards[i]);
+        for (size_t i = 0; i < n_bounds; i++) item_del(&bounds[i]);
+        free(bounds);
+        free(tasks);
+        return result;
+    }
+
+    // PART 4: nothing can fail from here on. Empty the current shards
+    // (keeping the items) and swap everything.
+    for (size_t i = 0; i < s; i++) {
+        skiplist_shallow_clear(shardlist->shards[i]);
+        skiplist_del(&shardlist->shards[i]);
+        shardlist->shards[i] = tasks[i].built;
+    }
+    for (size_t i = 0; i < shardlist->n_bounds; i++)
+        item_del(&shardlist->bounds[i]);
+    free(shardlist->bounds);
+    shardlist->bounds = bounds;
+    shardlist->n_bounds = n_bounds;
+    shardlist->balanced_length = total;
+
+    free(tasks);
+    return SUCCESS;
+}
+
+/**
+ * @brief Visitor that appends the items to a gather_t.
+ */
+static status_t gather_visit(Item *item, void *ctx) {
+    gather_t *all = (gather_t *)ctx;
+    all->items[all->count++] = item;
+    return SUCCESS;
+}
+
+/**
+ * @brief Visitor that prints an item per line and counts them, see print_t.
+ */
+static status_t print_visit(Item *item, void *ctx) {
+    print_t *print = (print_t *)ctx;
+    item_fprint(print->out, item);
+    fprintf(print->out, "\n");
+    print->count++;
+    return SUCCESS;
+}
+
+/**
+ * @brief Rebalances the shards when they have grown enough since the last
+ * rebalance and one of them holds much more than its share.
+ *
+ * @param shardlist ptr to the list.
+ */
+static void shardlist_maybe_rebalance(ShardList *shardlist) {
+    if (shardlist->n_shards < 2) return;
+
+    size_t total = shardlist_length(shardlist);
+    if (total < SHARDLIST_REBALANCE_MIN) return;
+    if (total < 2 * shardlist->balanced_length) return;
+
+    size_t biggest = 0;
+    for (size_t i = 0; i < shardlist->n_shards; i++) {
+        size_t len = skiplist_length(shardlist->shards[i]);
+        if (len > biggest) biggest = len;
+    }
+
+    // NOTE (b): on error, the shards stay as they are. Otherwise the towers
+    // were drawn again, and may take more room.
+    if (biggest * shardlist->n_shards > SHARDLIST_IMBALANCE * total &&
+        SUCCESS == shardlist_rebalance(shardlist))
+        shardlist_fit(shardlist);
+}
+
+/**
+ * @brief Checks if the list has a limit, see shardlist_new().
+ */
+static _Bool shardlist_bounded(const ShardList *shardlist) {
+    return shardlist->max_length || shardlist->max_bytes;
+}
+
+/**
+ * @brief The heap bytes of the list without a walk: the ones of every shard
+ * (see skiplist_bytes()), plus the list itself and its boundaries.
+ */
+static size_t shardlist_bytes(const ShardList *shardlist) {
+    size_t s = shardlist->n_shards;
+    size_t bytes = memutils_alloc_size(sizeof(ShardList)) +
+                   memutils_alloc_size(s * sizeof(SkipList *)) +
+                   memutils_alloc_size(s * sizeof(Item *)) +
+                   shardlist->n_bounds * memutils_alloc_size(item_size());
+    for (size_t i = 0; i < s; i++)
+        bytes += skiplist_bytes(shardlist->shards[i]);
+    return bytes;
+}
+
+/**
+ * @brief Frees an item of the biggest shard, see skiplist_evict().
+ *
+ * @param shardlist ptr to the list.
+ * @param except a shard left alone, or \c n_shards for none.
+ * @return status_t \c SUCCESS, \c ARR_IS_FULL_ERR if the list does not
+ * evict, or what skiplist_evict() says.
+ */
+static status_t shardlist_evict(ShardList *shardlist, size_t except) {
+    if (!shardlist->evict) return ARR_IS_FULL_ERR;
+
+    size_t victim = except, biggest = 0;
+    for (size_t i = 0; i < shardlist->n_shards; i++) {
+        size_t len = skiplist_length(shardlist->shards[i]);
+        if (i != except && len > biggest) {
+            biggest = len;
+            victim = i;
+        }
+    }
+    if (0 == biggest) return NOT_FOUND_ERR;
+    return skiplist_evict(shardlist->shards[victim], NULL);
+}
+
+/**
+ * @brief Gives shard i, before an insertion, the limits the other shards
+ * leave, making them leave some first if they hold all of it. The shard
+ * then makes room in itself, see skiplist_new_with_config().
+ *
+ * @param shardlist ptr to the bounded list.
+ * @param i the shard.
+ * @return status_t \c SUCCESS, or \c ARR_IS_FULL_ERR if the others could
+ * not leave any.
+ */
+static status_t shardlist_room(ShardList *shardlist, size_t i) {
+    SkipList *shard = shardlist->shards[i];
+    size_t length, bytes;
+    for (;;) {
+        length = shardlist_length(shardlist) - skiplist_length(shard);
+        bytes = shardlist_bytes(shardlist) - skiplist_bytes(shard);
+        if ((0 == shardlist->max_length || length < shardlist->max_length) &&
+            (0 == shardlist->max_bytes || bytes < shardlist->max_bytes))
+            break;
+        if (SUCCESS != shardlist_evict(shardlist, i)) return ARR_IS_FULL_ERR;
+    }
+
+    skiplist_limit(shard,
+                   shardlist->max_length ? shardlist->max_length - length : 0,
+                   shardlist->max_bytes ? shardlist->max_bytes - bytes : 0);
+    return SUCCESS;
+}
+
+/**
+ * @brief Gives every shard of a batch, before a commit, its share of the
+ * room left: in proportion to its insertions, so that together they can not
+ * take more than all of it.
+ *
+ * @param shardlist ptr to the bounded list.
+ * @param runs the ops, side by side by shard.
+ * @param starts where the ops of each shard start in runs, see
+ * shardlist_commit().
+ * @return status_t \c SUCCESS, or \c ARR_IS_FULL_ERR if a shard gets no
+ * room for its insertions.
+ */
+static status_t shardlist_share(ShardList *shardlist,
+                                const skiplist_op_t *runs,
+                                const size_t *starts) {
+    size_t length = shardlist_length(shardlist);
+    size_t bytes = shardlist_bytes(shardlist);
+    size_t max_length = shardlist->max_length, max_bytes = shardlist->max_bytes;
+    double room_length = max_length > length ? max_length - length : 0;
+    double room_bytes = max_bytes > bytes ? max_bytes - bytes : 0;
+
+    size_t inserts = 0;
+    for (size_t j = 0; j < starts[shardlist->n_shards]; j++)
+        inserts += SKIPLIST_INSERT == runs[j].kind;
+
+    for (size_t i = 0; i < shardlist->n_shards; i++) {
+        size_t mine = 0;
+        for (size_t j = starts[i]; j < starts[i + 1]; j++)
+            mine += SKIPLIST_INSERT == runs[j].kind;
+        if (0 == mine) continue;
+
+        SkipList *shard = shardlist->shards[i];
+        double share = (double)mine / inserts;
+        size_t limit = skiplist_length(shard) + (size_t)(room_length * share);
+        if (max_length && 0 == limit) return ARR_IS_FULL_ERR; // 0 is no limit
+        skiplist_limit(shard, max_length ? limit : 0,
+                       max_bytes ? skiplist_bytes(shard) +
+                                       (size_t)(room_bytes * share)
+                                 : 0);
+    }
+    return SUCCESS;
+}
+
+/**
+ * @brief Frees items of the biggest shards while the list is past its
+ * limits, see shardlist_evict().
+ *
+ * @param shardlist ptr to the list.
+ * @return status_t \c SUCCESS, or why an item could not be freed.
+ */
+static status_t shardlist_fit(ShardList *shardlist) {
+    while ((shardlist->max_length &&
+            shardlist_length(shardlist) > shardlist->max_length) ||
+           (shardlist->max_bytes &&
+            shardlist_bytes(shardlist) > shardlist->max_bytes)) {
+        status_t flag = shardlist_evict(shardlist, shardlist->n_shards);
+        if (SUCCESS != flag) return flag; // err handling
+    }
+    return SUCCESS;
+}
@@ -5,6 +5,8 @@
 
 #include "tads/skiplist.h"
 
+#include <time.h>
+
 //=============================================================================/
 //=================|    Data Structures     |==================================/
 //=============================================================================/
@@ -18,6 +20,15 @@ typedef struct _node_s {
     struct _node_s *down;
 } Node;
 
+/**
+ * @brief A main lane node of a list with back links (see
+ * skiplist_backlinks_enable()). It starts with a Node, so it is used as one.
+ */
+typedef struct {
+    Node node;
+    Node *prev; // the node before, on the main lane, or NULL for the first
+} BackNode;
+
 /**
  * @brief Skip List data structure.
  */
@@ -25,15 +36,186 @@ struct _skiplist_s {
     Node *top;
     size_t length;
     size_t height;
+    unsigned int seed; // private rng state, so lists do not share rand()
+    skiplist_config_t config;
+    HashIndex *index;  // optional exact-key index, see skiplist_index_enable
+    Bloom *bloom;      // optional negative filter, see skiplist_bloom_enable
+    FreqSketch *freq;  // access counts, see skiplist_adaptive_enable
+    size_t dead;       // tombstones still linked, see skiplist_lazy_enable
+    double lazy_ratio; // tombstone share that starts a compaction, or 0
+    Item *cursor;      // word where the next compaction step starts
+    _Bool compacting;
+    size_t reads;  // lookups since the last tuning, see skiplist_autotune
+    size_t writes; // insertions and removals since the last tuning
+    size_t drift;  // insertions and removals since the last rebalance
+    Item *balance_at;      // word where the next rebalance step starts
+    size_t balance_pos;    // position of that word on the main lane
+    size_t balance_height; // height the running rebalance aims at, or 0
+    TimerWheel *wheel; // the expiring items, see skiplist_insert_ttl
+    uint32_t now;      // tick of the clock read by the last operation
+    Item *hand;        // word the CLOCK hand of the eviction stands at
+    size_t expired;    // items freed once expired
+    size_t evicted;    // items freed to make room
+    Snapshot *snap;    // the newest open snapshot, see skiplist_snapshot
+    _Bool back;        // linked both ways, see skiplist_backlinks_enable
+    Frozen *frozen;    // read-only copy of the order, see skiplist_freeze
+    size_t streak;     // lookups since the last write
+    size_t nodes;      // nodes of every lane, see skiplist_bytes
+};
+
+/**
+ * @brief A snapshot: the words written since it was taken, and not since the
+ * next one was, as they were (see skiplist_snapshot()). The snapshots of a
+ * list are chained from the newest one.
+ */
+struct _snapshot_s {
+    SkipList *list;  // NULL once the list is deleted
+    SkipList *kept;  // copies of the items, tombstones for absent words
+    Snapshot *older; // taken before this one
+    Snapshot *newer; // taken after this one
+    size_t length;
+    uint32_t now; // clock of the list, for the items that expire
+    _Bool timed;  // whether items could expire then
 };
 
+/**
+ * @brief The share of a bottom-up build given to one thread.
+ */
+typedef struct {
+    Item **items;
+    unsigned char *heights; // tower height of each item
+    size_t count;
+    size_t height; // tallest tower of the segment, then of the whole list
+    size_t nodes;  // nodes built so far
+    Node **first;  // first node of the segment on each lane
+    Node **last;   // last node of the segment on each lane
+    unsigned int seed;
+    double prob;       // p of the tower heights
+    size_t max_height; // cap of the tower heights
+    status_t status;
+} build_segment_t;
+
+/**
+ * @brief State of a print: where to write and how many items were written.
+ */
+typedef struct {
+    FILE *out;
+    size_t count;
+} print_t;
+
+/**
+ * @brief A walk of the frozen index that skips the items that expired since
+ * it was built, see skiplist_foreach_char().
+ */
+typedef struct {
+    const SkipList *skiplist;
+    status_t (*fn)(Item *item, void *ctx);
+    void *ctx;
+} frozen_walk_t;
+
+/**
+ * @brief The ops of one word of a batch, see skiplist_commit().
+ */
+typedef struct {
+    skiplist_op_t **ops; // in batch order
+    size_t count;
+    Item *raw;   // the item of the word in the list, gone or not, or NULL
+    Item *last;  // the item the batch leaves for the word, or NULL
+    _Bool alive; // raw was visible
+    _Bool done;  // its column was changed, see commit_undo()
+} commit_word_t;
+
+/**
+ * @brief A batch checked against a list, word by word, see commit_plan().
+ */
+typedef struct {
+    skiplist_op_t **order; // the ops, by word and then in batch order
+    commit_word_t *words;
+    size_t count;   // of words
+    size_t links;   // words that need a new column
+    size_t unlinks; // words whose column goes
+    Node **trace;   // the trace of the sweep, see trace_seek()
+    size_t lanes;   // the room in trace
+} commit_plan_t;
+
+// Segments of a bottom-up build are never smaller than this, so small lists
+// are not split in tasks that cost more than they save.
+#define BUILD_MIN_SEGMENT (4096)
+
+// Towers drawn by skiplist_from_sorted and skiplist_reshape are capped to this
+// height when the list has no lower max height.
+#define BUILD_MAX_HEIGHT (64)
+
+// Lanes an adaptive lookup traces on the stack; taller lists are searched
+// without adapting.
+#define ADAPT_MAX_HEIGHT (64)
+
+// Counters per row of the access sketch of the adaptive mode.
+#define ADAPT_SKETCH_WIDTH (1 << 14)
+
+// Lookups a word needs before it may rise above its drawn height, so words
+// seen once or twice do not crowd the fast lanes.
+#define ADAPT_MIN_HITS (4)
+
+// Lookups counted before any word may rise: the first shares are noise.
+#define ADAPT_WARMUP (ADAPT_SKETCH_WIDTH)
+
+// Operations an auto-tuned list counts before it may pick its shape again,
+// whatever its length.
+#define TUNE_MIN_OPS (1024)
+
+// Shares of lookups above which an auto-tuned list takes p = 1/e, and below
+// which it takes p = 1/4. In between it keeps its p, so it does not flap.
+#define TUNE_READ_HEAVY (0.8)
+#define TUNE_WRITE_HEAVY (0.6)
+
+// The p an auto-tuned list takes for each kind of workload: 1/e minimizes
+// the comparisons of a search, 1/4 the nodes of a tower for the same
+// comparisons as 1/2.
+#define TUNE_PROB_READS (0.36787944117144233)
+#define TUNE_PROB_WRITES (0.25)
+
+// Main lane nodes visited by the rebalance step that follows an operation.
+#define REBALANCE_STEP (32)
+
+// Share of the length that the insertions and removals since the last
+// rebalance must reach before a list with \c rebalance starts another one.
+#define REBALANCE_DRIFT (0.5)
+
+// Main lane nodes visited by the compaction step of a lazy removal.
+#define LAZY_COMPACT_BATCH (256)
+
+// Slots of the timer wheel of a list with expiring items, one tick each: the
+// items of a shorter TTL are all due when the wheel reaches their slot.
+#define TTL_WHEEL_SLOTS (1024)
+
+// Expired items an operation unlinks and frees, at most.
+#define EXPIRE_STEP (16)
+
+// Main lane nodes the CLOCK hand passes before it takes the next item even
+// if it was looked up, so an eviction costs O(log n) at worst.
+#define EVICT_MAX_SCAN (64)
+
+// Widest gap of a deterministic list: between two consecutive nodes of a
+// lane, at most this many nodes on the lane below (and at least one).
+#define DET_MAX_GAP (3)
+
 //=============================================================================/
 //=================|    Private Function Declarations     |====================/
 //=============================================================================/
 
-static Node *node_new(const Node base);
-static void node_shallow_del(Node *node);
-static void node_deep_del(Node *node);
+static void build_run(ThreadPool *pool, build_segment_t *seg, size_t segs,
+                      void (*fn)(void *));
+static void build_heights_run(void *arg);
+static void build_lanes_run(void *arg);
+
+static Node *node_new(SkipList *skiplist, const Node base);
+static Node *bottom_new(SkipList *skiplist, const Node base);
+static inline void back_set(const SkipList *skiplist, Node *node, Node *prev);
+static Node *node_before(const SkipList *skiplist, const Node *node);
+static Node *last_not_after(const SkipList *skiplist, const Item *key);
+static void node_shallow_del(SkipList *skiplist, Node *node);
+static void node_deep_del(SkipList *skiplist, Node *node);
 
 static inline Node *mainlane_search(Node *sentinel, const Item *item);
 static inline Node *fastlane_search(Node *sentinel, const Item *item);
@@ -41,21 +223,140 @@ static inline Node *express_search(Node *sentinel, const Item *item);
 
 static status_t skiplist_raw_push_front(SkipList *skiplist, Item *item);
 static _Bool skiplist_includes(const SkipList *skiplist, const Item *item);
+static Item *skiplist_find(const SkipList *skiplist, const Item *item);
+static inline _Bool item_gone(const SkipList *skiplist, const Item *item);
+static status_t skiplist_put(SkipList *skiplist, Item *item);
+static status_t skiplist_link(SkipList *skiplist, Item *item);
+static status_t skiplist_link_at(SkipList *skiplist, Node **updates,
+                                 Item *item);
+static Item *skiplist_unlink(SkipList *skiplist, Item *item);
+static Item *skiplist_unlink_at(SkipList *skiplist, Node **updates);
+static void skiplist_drop(SkipList *skiplist, Item **item);
+static Item *skiplist_adaptive_search(SkipList *skiplist, const Item *item);
+
+static void skiplist_indexes_add(SkipList *skiplist, Item *item);
+static void skiplist_indexes_drop(SkipList *skiplist, Item *item);
+static status_t skiplist_bloom_rebuild(SkipList *skiplist, double fp_rate);
+static void skiplist_adapt(SkipList *skiplist, Node **trace, size_t lv,
+                           uint64_t hash);
+static size_t drawn_height(uint64_t hash, size_t max, double prob);
+static size_t deserved_height(uint32_t hits, size_t total, size_t length,
+                              double prob);
+static size_t tower_height(SkipList *skiplist, Item *item, size_t max);
+static void skiplist_maintain(SkipList *skiplist, _Bool write);
+static _Bool skiplist_autotune(SkipList *skiplist);
+static size_t ideal_height(size_t pos, size_t base, size_t max);
 
 static Node **skiplist_raw_trace(SkipList *skiplist, Item *item);
 static Item *skiplist_raw_pop_front(SkipList *skiplist);
+void skiplist_trim(SkipList *skiplist);
 
 static _Bool valid_column(Node *n);
+static _Bool valid_gaps(const SkipList *skiplist);
+
+static size_t gap_size(Node *from, Node *until);
+static Node *lane_split(SkipList *skiplist, Node *sentinel);
+static Node *lane_widen(SkipList *skiplist, Node *sentinel, Node *prev,
+                        Node *above);
+static status_t skiplist_det_insert(SkipList *skiplist, Item *item);
+static Item *skiplist_det_remove(SkipList *skiplist, const Item *item);
+static Item *skiplist_det_pop_front(SkipList *skiplist);
+static status_t skiplist_relane(SkipList *skiplist);
+static Node *skiplist_drop_lanes(SkipList *skiplist);
+static status_t skiplist_raise_head(SkipList *skiplist, size_t h,
+                                    Node **last);
+
+static status_t skiplist_revive(SkipList *skiplist, Item *item);
+static Item *column_swap(SkipList *skiplist, Item *item);
+static Item *trace_seek(const SkipList *skiplist, Node **trace, _Bool fresh,
+                        const Item *item);
+static int op_cmp(const void *a, const void *b);
+static status_t commit_plan(const SkipList *skiplist, skiplist_op_t *ops,
+                            size_t n, commit_plan_t *plan);
+static void commit_plan_free(commit_plan_t *plan);
+static status_t commit_word(SkipList *skiplist, commit_word_t *word,
+                            Node **trace, _Bool *fresh);
+static status_t commit_undo(SkipList *skiplist, commit_word_t *word);
+static void commit_results(SkipList *skiplist, commit_word_t *word);
+static status_t skiplist_bury(SkipList *skiplist, Item *item);
+static void cursor_rewind(SkipList *skiplist);
+
+static Node *main_lane(const SkipList *skiplist);
+static size_t lanes_count(const Node *top);
+static Item *last_item(const SkipList *skiplist);
+static status_t lanes_join(SkipList *skiplist, Node **top, size_t *height,
+                           Node *right, size_t right_height);
+static status_t skiplist_join(SkipList *skiplist, SkipList *other);
+static void skiplist_interleave(SkipList *skiplist, SkipList *other,
+                                skiplist_merge_t policy);
+
+static status_t print_visit(Item *item, void *ctx);
+static status_t frozen_visit(Item *item, void *ctx);
+
+static status_t skiplist_preserve(SkipList *skiplist, const Item *item);
+static void kept_fold(SkipList *into, SkipList *from);
+static inline _Bool snapshot_sees(const Snapshot *snapshot, const Item *item);
+static Node *lane_from_char(const SkipList *skiplist, const char c);
+static status_t snapshot_walk(const Snapshot *snapshot, _Bool whole,
+                              const char c,
+                              status_t (*fn)(Item *item, void *ctx),
+                              void *ctx);
+
+static uint32_t skiplist_clock(const SkipList *skiplist);
+static uint32_t skiplist_deadline(const SkipList *skiplist, uint32_t ttl);
+static status_t skiplist_timers_start(SkipList *skiplist);
+static void skiplist_expire(SkipList *skiplist);
+static status_t skiplist_fit(SkipList *skiplist, const Item *spare);
+static size_t skiplist_bytes_at(const SkipList *skiplist,
+                                      size_t length);
+static _Bool skiplist_full_at(const SkipList *skiplist, size_t length);
 
 //=============================================================================/
 //=================|    Public Function Implementations     |==================/
 //=============================================================================/
 SkipList *skiplist_new(void) {
+    return skiplist_new_with_mode(SKIPLIST_RANDOMIZED);
+}
+
+SkipList *skiplist_new_with_mode(skiplist_mode_t mode) {
+    skiplist_config_t config = skiplist_config_default();
+    config.mode = mode;
+    return skiplist_new_with_config(&config);
+}
+
+skiplist_config_t skiplist_config_default(void) {
+    // clang-format off
+    return (skiplist_config_t){
+        .mode = SKIPLIST_RANDOMIZED,
+        .prob = SKIPLIST_PROB,
+        #ifdef SKIPLIST_MAX_HEIGHT
+            .max_height = SKIPLIST_MAX_HEIGHT,
+        #endif
+        #ifdef SKIPLIST_MAX_LENGTH
+            .max_length = SKIPLIST_MAX_LENGTH,
+        #endif
+        .raise_once = RAISE_ONLY_ONCE,
+    };
+    // clang-format on
+}
+
+SkipList *skiplist_new_with_config(const skiplist_config_t *config) {
     SkipList *skiplist = (SkipList *)malloc(sizeof(SkipList));
-    if (skiplist) *skiplist = (SkipList){0};
+    if (NULL == skiplist) return NULL;
+
+    *skiplist = (SkipList){
+        .seed = (unsigned int)rand() | 1u,
+        .config = config ? *config : skiplist_config_default(),
+    };
+    if (!(skiplist->config.prob > 0 && skiplist->config.prob < 1))
+        skiplist->config.prob = SKIPLIST_PROB;
     return skiplist;
 }
 
+skiplist_config_t skiplist_config(const SkipList *skiplist) {
+    return skiplist ? skiplist->config : skiplist_config_default();
+}
+
 void skiplist_del(SkipList **skiplist) {
     if (NULL == skiplist || NULL == (*skiplist)) return;
 
@@ -67,7 +368,7 @@ void skiplist_del(SkipList **skiplist) {
         Node *car = titanic;
         while (NULL != car) {           // loop throw the nodes in a row
             Node *temp_car = car->next; // temp ptr
-            node_shallow_del(car);
+            node_shallow_del(NULL, car);
             car = temp_car; // go to next
         }
         titanic = temp_titanic; // go to bellow
@@ -79,119 +380,49 @@ void skiplist_del(SkipList **skiplist) {
     //  the end is near.
     while (NULL != titanic) {               // loop throw the nodes in a row
         Node *temp_titanic = titanic->next; // temp ptr
-        node_deep_del(titanic);
+        node_deep_del(NULL, titanic);
         titanic = temp_titanic; // go to bellow
     }
 
+    hashindex_del(&(*skiplist)->index);
+    bloom_del(&(*skiplist)->bloom);
+    freqsketch_del(&(*skiplist)->freq);
+    item_del(&(*skiplist)->cursor);
+    item_del(&(*skiplist)->balance_at);
+    timerwheel_del(&(*skiplist)->wheel);
+    item_del(&(*skiplist)->hand);
+    frozen_del(&(*skiplist)->frozen);
+    for (Snapshot *s = (*skiplist)->snap; s; s = s->older) s->list = NULL;
     free(*skiplist);
     *skiplist = NULL;
 }
 
 status_t skiplist_insert(SkipList *skiplist, Item *item) {
-    // PART 1: Basic checks and trivial cases
-    // Error handling
     if (NULL == skiplist || NULL == item) return NUL_ERR;
-    if (skiplist_includes(skiplist, item)) return REPEATED_ENTRY_ERR;
-    if (skiplist_is_full(skiplist)) return ARR_IS_FULL_ERR;
-
-    // Trivial case: the list is empty
-    if (skiplist_is_empty(skiplist)) {
-        skiplist->top = node_new((Node){.item = item});
-
-        skiplist->length = 1;
-        skiplist->height = 1;
-
-        return SUCCESS;
-    }
-
-    // Trivial case: insertion at the begginig
-    if (item_cmp(skiplist->top->item, item) >= 0) {
-        return skiplist_raw_push_front(skiplist, item);
-    }
-
-    // PART 2: Tracing the skiplist
-    // Getting the update trace
-    Node **updates = skiplist_raw_trace(skiplist, item); // ownership
-    if (NULL == updates) return NUL_ERR;                 // err handling
-    size_t h = skiplist->height; // mem access optimization
-
-    if (NULL == updates[h - 1]) { // err handling
-        free(updates);
-        return NUL_ERR;
-    }
-
-    // PART 3: Insertion at the main lane
-    // Creating the new node
-    Node *new_node = node_new((Node){
-        .item = item,
-        .next = updates[h - 1]->next,
-    });
-
-    // Error handling
-    if (NULL == new_node) {
-        free(updates);
-        return ALLOC_ERR;
-    }
-
-    // Inserting the new node
-    updates[h - 1]->next = new_node;
-
-    // PART 4: Insertion at the existing fast lanes
-    long long lv = h - 2;
-    for (; (lv >= 0) && (rnd_normalized() <= SKIPLIST_PROB); lv--) {
-        // TODO: Add error handling here
-        new_node = node_new((Node){
-            .item = item,
-            .next = updates[lv]->next,
-            .down = new_node,
-        });
-        if (new_node) updates[lv]->next = new_node;
-        else break; // err handling: recoverable error
-        // NOTE: no need for a more complex error handling here. A fail here
-        // only stops us from clibimbing a level. Thats fine.
-    }
-
-    // Raising the level of the node above the current level of the skiplist
-    if (lv < 0 && new_node) {
-        lv = h;
-        for (; (rnd_normalized() <= SKIPLIST_PROB);) {
-            // clang-format off
-            #ifdef SKIPLIST_MAX_HEIGHT
-                if (lv++ >= SKIPLIST_MAX_HEIGHT) break;
-            #endif
-            // clang-format on
-
-            // New node
-            new_node = node_new((Node){
-                .item = item,
-                .down = new_node,
-            });
 
-            // Error handling
-            if (NULL == new_node) break;
+    skiplist_stamp(skiplist, item);
+    return skiplist_put(skiplist, item);
+}
 
-            // New top
-            Node *temp = node_new((Node){
-                .item = skiplist->top->item,
-                .next = new_node,
-                .down = skiplist->top,
-            });
+status_t skiplist_insert_ttl(SkipList *skiplist, Item *item, uint32_t ttl) {
+    if (NULL == skiplist || NULL == item) return NUL_ERR;
+    item_set_expiry(item, ttl ? skiplist_deadline(skiplist, ttl) : 0);
+    return skiplist_put(skiplist, item);
+}
 
-            // Err handling
-            if (NULL == temp) {
-                node_shallow_del(new_node);
-                break;
-            }
+void skiplist_stamp(const SkipList *skiplist, Item *item) {
+    if (NULL == skiplist || NULL == item) return;
 
-            skiplist->top = temp;
-            skiplist->height++;
-        }
-    }
+    // Items that carry an expiry keep it, e.g. when moved between lists
+    uint32_t ttl = skiplist->config.ttl;
+    if (ttl && 0 == item_expiry(item))
+        item_set_expiry(item, skiplist_deadline(skiplist, ttl));
+}
 
-    // PART 6: cleanup and finishing it
-    skiplist->length++;
-    free(updates);
-    return SUCCESS;
+_Bool skiplist_expired(const SkipList *skiplist, const Item *item) {
+    if (NULL == skiplist || NULL == item) return 0;
+    uint32_t expires = item_expiry(item);
+    return expires && (int32_t)(expires - skiplist_clock(skiplist)) <= 0;
 }
 
 _Bool skiplist_debug_validate(const SkipList *skiplist) {
@@ -216,6 +447,13 @@ _Bool skiplist_debug_validate(const SkipList *skiplist) {
     // if ((1 + depth) != skiplist->height) return 0;
     // if ((1 + len) != skiplist->height) return 0;
 
+    if (skiplist->back)
+        for (Node *prev = NULL, *n = main_lane(skiplist); n;
+             prev = n, n = n->next)
+            if (((BackNode *)n)->prev != prev) return 0;
+
+    if (SKIPLIST_DETERMINISTIC == skiplist->config.mode)
+        return valid_gaps(skiplist);
     return 1;
 }
 
@@ -243,11 +481,172 @@ void skiplist_debug_print(const SkipList *skiplist) {
     }
 }
 
+status_t skiplist_memory_usage(const SkipList *skiplist, skiplist_mem_t *usage) {
+    if (NULL == skiplist || NULL == usage) return NUL_ERR; // err handling
+
+    *usage = (skiplist_mem_t){.levels = skiplist->height};
+
+    if (usage->levels > 0) {
+        usage->level_nodes = (size_t *)calloc(usage->levels, sizeof(size_t));
+        if (NULL == usage->level_nodes) return ALLOC_ERR; // err handling
+    }
+
+    // Loop throw all the lanes, from the top one to the main lane
+    size_t lv = usage->levels;
+    for (Node *digger = skiplist->top; NULL != digger && lv > 0;
+         digger = digger->down) {
+        lv--;
+        for (Node *runner = digger; NULL != runner; runner = runner->next) {
+            usage->level_nodes[lv]++;
+
+            // Items are only counted once, at the main lane
+            if (NULL != digger->down) continue;
+            usage->item_bytes += item_bytes(runner->item);
+            usage->overhead_bytes +=
+                memutils_alloc_overhead(item_bytes(runner->item));
+            usage->padding_bytes += item_padding(runner->item);
+        }
+        size_t node = NULL == digger->down && skiplist->back ? sizeof(BackNode)
+                                                             : sizeof(Node);
+        usage->node_bytes += usage->level_nodes[lv] * node;
+        usage->overhead_bytes +=
+            usage->level_nodes[lv] * memutils_alloc_overhead(node);
+    }
+
+    usage->index_bytes = hashindex_bytes(skiplist->index);
+    usage->bloom_bytes = bloom_bytes(skiplist->bloom);
+    usage->sketch_bytes = freqsketch_bytes(skiplist->freq);
+    usage->timer_bytes = timerwheel_bytes(skiplist->wheel);
+    usage->frozen_bytes = frozen_bytes(skiplist->frozen);
+
+    usage->total_bytes = sizeof(SkipList) +
+                         memutils_alloc_overhead(sizeof(SkipList)) +
+                         usage->node_bytes + usage->item_bytes +
+                         usage->index_bytes + usage->bloom_bytes +
+                         usage->sketch_bytes + usage->timer_bytes +
+                         usage->frozen_bytes + usage->overhead_bytes;
+
+    return SUCCESS;
+}
+
+void skiplist_memory_usage_del(skiplist_mem_t *usage) {
+    if (NULL == usage) return;
+    free(usage->level_nodes);
+    *usage = (skiplist_mem_t){0};
+}
+
+size_t skiplist_bytes(const SkipList *skiplist) {
+    if (NULL == skiplist) return 0;
+
+    size_t node = memutils_alloc_size(sizeof(Node));
+    size_t bytes = memutils_alloc_size(sizeof(SkipList)) +
+                   skiplist->nodes * node +
+                   skiplist->length * memutils_alloc_size(item_size());
+    if (skiplist->back) // the main lane nodes are BackNodes
+        bytes += skiplist->length * (memutils_alloc_size(sizeof(BackNode)) - node);
+
+    return bytes + hashindex_bytes(skiplist->index) +
+           bloom_bytes(skiplist->bloom) + freqsketch_bytes(skiplist->freq) +
+           timerwheel_bytes(skiplist->wheel) + frozen_bytes(skiplist->frozen);
+}
+
+void skiplist_memory_print(const SkipList *skiplist) {
+    skiplist_memory_fprint(stdout, skiplist);
+}
+
+void skiplist_memory_fprint(FILE *out, const SkipList *skiplist) {
+    skiplist_mem_t usage;
+    status_t flag = skiplist_memory_usage(skiplist, &usage);
+    if (SUCCESS != flag) { // err handling
+        fprintf(out, "ERROR: could not measure the skiplist memory. \n");
+        return;
+    }
+
+    fprintf(out, "length: %zu, height: %zu\n", skiplist_length(skiplist),
+            skiplist->height);
+    const skiplist_config_t *config = &skiplist->config;
+    if (SKIPLIST_DETERMINISTIC == config->mode) {
+        fprintf(out, "lanes: deterministic, gaps of 1 to %d nodes\n",
+                DET_MAX_GAP);
+    } else if (SKIPLIST_PROB != config->prob || config->max_height ||
+               config->auto_tune || config->rebalance) {
+        fprintf(out, "lanes: p = %.3f", config->prob);
+        if (config->max_height)
+            fprintf(out, ", max height: %zu", config->max_height);
+        if (config->auto_tune) fprintf(out, ", auto-tuned");
+        if (config->rebalance) fprintf(out, ", rebalanced");
+        if (skiplist->balance_height)
+            fprintf(out, " (rebalancing, at node %zu)", skiplist->balance_pos);
+        fprintf(out, "\n");
+    }
+
+    // One line per lane, from the top one to the main lane
+    for (size_t lv = usage.levels; lv > 0; lv--) {
+        size_t n = usage.level_nodes[lv - 1];
+        size_t node = 1 == lv && skiplist->back ? sizeof(BackNode)
+                                                : sizeof(Node);
+        fprintf(out, "lv %zu) nodes: %zu, bytes: %zu\n", lv, n, n * node);
+    }
+
+    fprintf(out, "nodes: %zu bytes\n", usage.node_bytes);
+    fprintf(out, "items: %zu bytes\n", usage.item_bytes);
+    fprintf(out, "allocator overhead: %zu bytes\n", usage.overhead_bytes);
+    fprintf(out, "entry padding: %zu bytes\n", usage.padding_bytes);
+    if (skiplist->index)
+        fprintf(out, "hash index: %zu bytes\n", usage.index_bytes);
+    if (skiplist->bloom)
+        fprintf(out, "bloom filter: %zu bytes\n", usage.bloom_bytes);
+    if (skiplist->freq)
+        fprintf(out, "access sketch: %zu bytes\n", usage.sketch_bytes);
+    if (skiplist->frozen)
+        fprintf(out, "frozen index: %zu bytes, %zu words\n",
+                usage.frozen_bytes, frozen_length(skiplist->frozen));
+    if (skiplist->back && usage.levels)
+        fprintf(out, "back links: %zu bytes\n",
+                usage.level_nodes[0] * sizeof(Node *));
+    if (skiplist->cursor) fprintf(out, "tombstones: %zu\n", skiplist->dead);
+    if (skiplist->wheel)
+        fprintf(out, "timer wheel: %zu bytes, %zu timers\n", usage.timer_bytes,
+                timerwheel_length(skiplist->wheel));
+    if (skiplist->wheel || config->evict)
+        fprintf(out, "expired: %zu, evicted: %zu\n", skiplist->expired,
+                skiplist->evicted);
+    if (skiplist->snap) {
+        size_t open = 0, kept = 0;
+        for (Snapshot *s = skiplist->snap; s; s = s->older, open++)
+            kept += s->kept->length;
+        fprintf(out, "snapshots: %zu open, %zu versions kept\n", open, kept);
+    }
+    fprintf(out, "total: %zu bytes\n", usage.total_bytes);
+
+    skiplist_memory_usage_del(&usage);
+}
+
 Item *skiplist_search(const SkipList *skiplist, const Item *item) {
+    Item *found = skiplist_find(skiplist, item);
+    return item_gone(skiplist, found) ? NULL : found;
+}
+
+/**
+ * @brief Finds the item of a word, tombstones and expired items included,
+ * except through the index, which does not hold the tombstones.
+ *
+ * @param skiplist ptr to the skiplist.
+ * @param item ptr to an item with the word.
+ * @return Item* the item WITHOUT OWNERSHIP, or NULL.
+ */
+static Item *skiplist_find(const SkipList *skiplist, const Item *item) {
     // Err handling when null poiter
     // WARNING: other erros such as invalid ptr will not be caught.
     if (NULL == skiplist || NULL == item) return NULL;
 
+    // Surely absent keys do not need the lanes, nor do exact keys when there
+    // is an index or the list is frozen
+    if (skiplist->bloom && !bloom_may_contain(skiplist->bloom, item_hash(item)))
+        return NULL;
+    if (skiplist->index) return hashindex_get(skiplist->index, item);
+    if (skiplist->frozen) return frozen_get(skiplist->frozen, item);
+
     // Declarations and initializations
     Node *sentinel = skiplist->top;
 
@@ -267,6 +666,17 @@ Item *skiplist_search(const SkipList *skiplist, const Item *item) {
 status_t skiplist_update(SkipList *skiplist, Item *item) {
     // Err handling
     if (NULL == skiplist || NULL == item) return NUL_ERR;
+    skiplist_maintain(skiplist, 0); // no node changes: a lookup
+    if (SUCCESS != skiplist_preserve(skiplist, item)) return ALLOC_ERR;
+
+    // Every node of a column shares the item: updating it is enough
+    if (skiplist->index) {
+        Item *found = hashindex_get(skiplist->index, item);
+        if (NULL == found || item_gone(skiplist, found)) return NOT_FOUND_ERR;
+        item_raw_update(found, item);
+        return SUCCESS;
+    }
+
     if (skiplist_is_empty(skiplist) || !skiplist_includes(skiplist, item))
         return NOT_FOUND_ERR;
 
@@ -307,433 +717,3397 @@ status_t skiplist_update(SkipList *skiplist, Item *item) {
 Item *skiplist_remove(SkipList *skiplist, Item *item) {
     // Err handling
     if (NULL == skiplist || NULL == item) return NULL;
+    skiplist_maintain(skiplist, 1);
+
+    // Lazy removal: the item stays in the lanes, the caller gets a copy
+    if (skiplist->lazy_ratio > 0) {
+        Item *found = skiplist_search(skiplist, item);
+        Item *copy = item_clone(found);
+        if (NULL == copy) return NULL; // err handling: not found or no memory
+        if (SUCCESS != skiplist_bury(skiplist, found)) item_del(&copy);
+        return copy;
+    }
     if (skiplist_is_empty(skiplist) || !skiplist_includes(skiplist, item)) {
         return NULL;
     }
+    return skiplist_unlink(skiplist, item);
+}
 
-    // Trivial case: remove first item
-    if (0 == item_cmp(skiplist->top->item, item)) {
-        return skiplist_raw_pop_front(skiplist);
+status_t skiplist_delete(SkipList *skiplist, Item *item) {
+    if (NULL == skiplist || NULL == item) return NUL_ERR;
+
+    if (skiplist->lazy_ratio > 0) {
+        skiplist_maintain(skiplist, 1);
+        Item *found = skiplist_search(skiplist, item);
+        if (NULL == found) return NOT_FOUND_ERR;
+        return skiplist_bury(skiplist, found);
     }
 
-    // Shortcuts
-    size_t h = skiplist->height;
+    Item *removed = skiplist_remove(skiplist, item);
+    if (NULL == removed) return NOT_FOUND_ERR;
+    item_del(&removed);
+    return SUCCESS;
+}
 
-    // Getting node trace
-    Node **updates = skiplist_raw_trace(skiplist, item);
-    if (NULL == updates) return NULL; // err handling
+status_t skiplist_commit(SkipList *skiplist, skiplist_op_t *ops, size_t n) {
+    if (NULL == skiplist || (NULL == ops && n > 0)) return NUL_ERR;
+    skiplist_maintain(skiplist, 1);
 
-    // Error handling
-    if (NULL == updates[h - 1] || NULL == updates[h - 1]->next ||
-        NULL == updates[h - 1]->next->item) {
-        free(updates);
-        return NULL;
+    // PART 1: every op checked, in one sweep, before any change
+    commit_plan_t plan;
+    status_t flag = commit_plan(skiplist, ops, n, &plan);
+
+    // PART 2: what can fail without a change: the versions of the open
+    // snapshots and the room in the index
+    for (size_t i = 0; SUCCESS == flag && i < plan.count; i++)
+        if (SUCCESS != skiplist_preserve(skiplist, plan.words[i].ops[0]->item))
+            flag = ALLOC_ERR;
+    if (SUCCESS == flag && skiplist->index &&
+        SUCCESS != hashindex_reserve(skiplist->index,
+                                     skiplist->length + plan.count))
+        flag = ALLOC_ERR;
+    if (SUCCESS != flag) { // err handling
+        commit_plan_free(&plan);
+        return flag;
     }
 
-    // Saving the result
-    Item *result = updates[h - 1]->next->item;
+    // PART 3: the columns, in a second sweep; its trace is made again only
+    // when the height changes or another path moved the lanes
+    _Bool fresh = 1;
+    size_t done = 0;
+    for (; SUCCESS == flag && done < plan.count; done++) {
+        if (skiplist->height > plan.lanes) {
+            Node **grown = (Node **)realloc(
+                plan.trace, skiplist->height * sizeof(Node *));
+            if (NULL == grown) { // err handling
+                flag = ALLOC_ERR;
+                break;
+            }
+            plan.trace = grown;
+            plan.lanes = skiplist->height;
+        }
+        flag = commit_word(skiplist, &plan.words[done], plan.trace, &fresh);
+    }
 
-    // Removing
-    long long i = skiplist->height - 1;
-    for (; i >= 0 && updates[i] && updates[i]->next &&
-           result == updates[i]->next->item;
-         i--) {
-        if (NULL == updates[i] || NULL == updates[i]->next) continue;
+    // The towers drawn may take more than the room checked
+    size_t max = skiplist->config.max_bytes;
+    if (SUCCESS == flag && max && max < skiplist_bytes(skiplist))
+        flag = ARR_IS_FULL_ERR;
 
-        Node *temp = updates[i]->next->next;
+    // A failure undoes the columns changed so far, from the last one
+    if (SUCCESS != flag) {
+        while (done-- > 0)
+            if (SUCCESS != commit_undo(skiplist, &plan.words[done]))
+                flag = CRITICAL_ERR;
+        commit_plan_free(&plan);
+        return flag;
+    }
 
-        *(updates[i]->next) = (Node){0};
-        node_shallow_del(updates[i]->next);
-        updates[i]->next = NULL;
+    // PART 4: the updates and the results, which can not fail
+    for (size_t i = 0; i < plan.count; i++)
+        commit_results(skiplist, &plan.words[i]);
 
-        updates[i]->next = temp;
-    }
+    commit_plan_free(&plan);
+    return SUCCESS;
+}
 
-    // Reduce level
-    if (NULL == skiplist->top->next && skiplist->height > 1) {
-        Node *temp = skiplist->top->down;
-        node_shallow_del(skiplist->top);
-        skiplist->top = temp;
-        skiplist->height--;
-    }
+status_t skiplist_commit_check(const SkipList *skiplist, skiplist_op_t *ops,
+                               size_t n) {
+    if (NULL == skiplist || (NULL == ops && n > 0)) return NUL_ERR;
 
-    // Cleanup and exit
-    free(updates);
-    skiplist->length--;
-    return result;
+    commit_plan_t plan;
+    status_t flag = commit_plan(skiplist, ops, n, &plan);
+    commit_plan_free(&plan);
+    return flag;
 }
 
 status_t skiplist_print(const SkipList *skiplist, const char c) {
+    return skiplist_fprint(stdout, skiplist, c);
+}
+
+status_t skiplist_fprint(FILE *out, const SkipList *skiplist, const char c) {
     if (NULL == skiplist || skiplist_is_empty(skiplist)) return ERROR;
 
-    Node *sentinel = skiplist->top;
+    // Through the lanes, or the frozen index if there is one
+    print_t print = (print_t){.out = out};
+    skiplist_foreach_char(skiplist, c, print_visit, &print);
 
-    if (sentinel)
-        while (sentinel->down) {
-            while (sentinel->next &&
-                   item_raw_char_cmp(sentinel->next->item, c) < 0)
-                sentinel = sentinel->next;
-            sentinel = sentinel->down;
-        }
+    if (0 == print.count) fprintf(out, "NAO HA PALAVRAS INICIADAS POR %c\n", c);
 
-    while (sentinel && item_raw_char_cmp(sentinel->item, c) < 0)
-        sentinel = sentinel->next;
+    return SUCCESS;
+}
 
-    size_t counter = 0;
-    while (sentinel && item_raw_char_cmp(sentinel->item, c) == 0) {
-        item_print(sentinel->item);
-        printf("\n");
-        sentinel = sentinel->next;
-        counter++;
-    }
+status_t skiplist_foreach(const SkipList *skiplist,
+                          status_t (*fn)(Item *item, void *ctx), void *ctx) {
+    if (NULL == skiplist || NULL == fn) return NUL_ERR; // err handling
 
-    if (0 == counter) printf("NAO HA PALAVRAS INICIADAS POR %c\n", c);
+    // Go to the main lane
+    Node *sentinel = skiplist->top;
+    while (sentinel && sentinel->down) sentinel = sentinel->down;
+
+    for (; sentinel; sentinel = sentinel->next) {
+        if (item_gone(skiplist, sentinel->item)) continue;
+        status_t flag = fn(sentinel->item, ctx);
+        if (SUCCESS != flag) return flag;
+    }
+
+    return SUCCESS;
+}
+
+status_t skiplist_foreach_char(const SkipList *skiplist, const char c,
+                               status_t (*fn)(Item *item, void *ctx),
+                               void *ctx) {
+    if (NULL == skiplist || NULL == fn) return NUL_ERR; // err handling
+
+    if (skiplist->frozen) {
+        frozen_walk_t walk = {.skiplist = skiplist, .fn = fn, .ctx = ctx};
+        return frozen_foreach_char(skiplist->frozen, c, frozen_visit, &walk);
+    }
+
+    Node *sentinel = skiplist->top;
+
+    if (sentinel)
+        while (sentinel->down) {
+            while (sentinel->next &&
+                   item_raw_char_cmp(sentinel->next->item, c) < 0)
+                sentinel = sentinel->next;
+            sentinel = sentinel->down;
+        }
+
+    while (sentinel && item_raw_char_cmp(sentinel->item, c) < 0)
+        sentinel = sentinel->next;
+
+    for (; sentinel && item_raw_char_cmp(sentinel->item, c) == 0;
+         sentinel = sentinel->next) {
+        if (item_gone(skiplist, sentinel->item)) continue;
+        status_t flag = fn(sentinel->item, ctx);
+        if (SUCCESS != flag) return flag;
+    }
+
+    return SUCCESS;
+}
+
+status_t skiplist_foreach_reverse(const SkipList *skiplist, const Item *from,
+                                  status_t (*fn)(Item *item, void *ctx),
+                                  void *ctx) {
+    if (NULL == skiplist || NULL == fn) return NUL_ERR; // err handling
+
+    for (Node *node = last_not_after(skiplist, from); node;
+         node = node_before(skiplist, node)) {
+        if (item_gone(skiplist, node->item)) continue;
+        status_t flag = fn(node->item, ctx);
+        if (SUCCESS != flag) return flag;
+    }
+
+    return SUCCESS;
+}
+
+void skiplist_shallow_clear(SkipList *skiplist) {
+    if (NULL == skiplist) return; // err handling
+    skiplist_thaw(skiplist);
+
+    // Same walk as skiplist_del, but every lane is shallow. Only the
+    // tombstones and expired items, which nobody else can reach (walks skip
+    // them), are freed.
+    Node *titanic = skiplist->top;
+    while (NULL != titanic) {
+        Node *temp_titanic = titanic->down;
+        Node *car = titanic;
+        while (NULL != car) {
+            Node *temp_car = car->next;
+            if (NULL == temp_titanic && item_gone(skiplist, car->item))
+                skiplist_drop(skiplist, &car->item);
+            node_shallow_del(skiplist, car);
+            car = temp_car;
+        }
+        titanic = temp_titanic;
+    }
+
+    hashindex_clear(skiplist->index);
+    bloom_clear(skiplist->bloom);
+    timerwheel_clear(skiplist->wheel, skiplist->now);
+    *skiplist = (SkipList){
+        .seed = skiplist->seed,
+        .config = skiplist->config,
+        .index = skiplist->index,
+        .bloom = skiplist->bloom,
+        .freq = skiplist->freq,
+        .lazy_ratio = skiplist->lazy_ratio,
+        .cursor = skiplist->cursor,
+        .balance_at = skiplist->balance_at,
+        .wheel = skiplist->wheel,
+        .now = skiplist->now,
+        .hand = skiplist->hand,
+        .expired = skiplist->expired,
+        .evicted = skiplist->evicted,
+        .snap = skiplist->snap,
+        .back = skiplist->back,
+    };
+    cursor_rewind(skiplist);
+}
+
+void skiplist_abandon(SkipList **skiplist) {
+    if (NULL == skiplist || NULL == *skiplist) return;
+
+    // Without a wheel, nothing but the tombstones is gone
+    timerwheel_del(&(*skiplist)->wheel);
+    skiplist_shallow_clear(*skiplist);
+    skiplist_del(skiplist);
+}
+
+SkipList *skiplist_from_sorted(Item **items, size_t n, ThreadPool *pool) {
+    if (NULL == items && n > 0) return NULL; // err handling
+
+    SkipList *skiplist = skiplist_new();
+    if (NULL == skiplist || 0 == n) return skiplist;
+
+    // PART 1: split the items in segments, one or two per worker
+    size_t segs = pool ? 2 * threadpool_size(pool) : 1;
+    if (segs > 1 + n / BUILD_MIN_SEGMENT) segs = 1 + n / BUILD_MIN_SEGMENT;
+
+    build_segment_t *seg =
+        (build_segment_t *)calloc(segs, sizeof(build_segment_t));
+    unsigned char *heights = (unsigned char *)malloc(n);
+    if (NULL == seg || NULL == heights) {
+        free(seg);
+        free(heights);
+        skiplist_del(&skiplist);
+        return NULL;
+    }
+
+    size_t max_height = skiplist->config.max_height;
+    if (0 == max_height || max_height > BUILD_MAX_HEIGHT)
+        max_height = BUILD_MAX_HEIGHT;
+
+    for (size_t i = 0; i < segs; i++) {
+        size_t lo = i * n / segs, hi = (i + 1) * n / segs;
+        seg[i] = (build_segment_t){
+            .items = items + lo,
+            .heights = heights + lo,
+            .count = hi - lo,
+            .seed = (unsigned int)rand() | 1u,
+            .prob = skiplist->config.prob,
+            .max_height = max_height,
+        };
+    }
+
+    // PART 2: draw the tower heights; the first item gets the tallest one,
+    // since its column is the head of every lane.
+    build_run(pool, seg, segs, build_heights_run);
+
+    size_t h = 1;
+    for (size_t i = 0; i < segs; i++)
+        if (seg[i].height > h) h = seg[i].height;
+    heights[0] = (unsigned char)h;
+
+    // PART 3: build the columns and link the lanes inside each segment
+    Node **ends = (Node **)calloc(2 * segs * h, sizeof(Node *));
+    if (NULL == ends) {
+        free(seg);
+        free(heights);
+        skiplist_del(&skiplist);
+        return NULL;
+    }
+
+    status_t flag = SUCCESS;
+    for (size_t i = 0; i < segs; i++) {
+        seg[i].height = h;
+        seg[i].first = ends + 2 * i * h;
+        seg[i].last = ends + (2 * i + 1) * h;
+    }
+    build_run(pool, seg, segs, build_lanes_run);
+    for (size_t i = 0; i < segs; i++)
+        if (SUCCESS != seg[i].status) flag = seg[i].status;
+
+    // Err handling: every node is reachable from its segment lanes
+    if (SUCCESS != flag) {
+        for (size_t i = 0; i < segs; i++)
+            for (size_t lv = 0; lv < h; lv++) {
+                Node *car = seg[i].first[lv];
+                while (car) {
+                    Node *temp = car->next;
+                    node_shallow_del(NULL, car);
+                    car = temp;
+                }
+            }
+        free(ends);
+        free(seg);
+        free(heights);
+        skiplist_del(&skiplist);
+        return NULL;
+    }
+
+    // PART 4: stitch the segments together, lane by lane
+    for (size_t lv = 0; lv < h; lv++) {
+        Node *tail = NULL;
+        for (size_t i = 0; i < segs; i++) {
+            if (NULL == seg[i].first[lv]) continue;
+            if (tail) tail->next = seg[i].first[lv];
+            tail = seg[i].last[lv];
+        }
+    }
+
+    skiplist->top = seg[0].first[h - 1];
+    skiplist->length = n;
+    skiplist->height = h;
+    for (size_t i = 0; i < segs; i++) skiplist->nodes += seg[i].nodes;
+
+    free(ends);
+    free(seg);
+    free(heights);
+    return skiplist;
+}
+
+status_t skiplist_merge(SkipList *skiplist, SkipList *other,
+                        skiplist_merge_t policy) {
+    if (NULL == skiplist || NULL == other) return NUL_ERR;
+    if (skiplist == other || NULL == other->top) return SUCCESS;
+
+    // PART 1: the snapshots of both lists keep the words of other, and the
+    // index makes room for them: the only things that can fail go first
+    if (skiplist->snap || other->snap)
+        for (Node *car = main_lane(other); car; car = car->next)
+            if (SUCCESS != skiplist_preserve(skiplist, car->item) ||
+                SUCCESS != skiplist_preserve(other, car->item))
+                return ALLOC_ERR; // err handling
+    if (skiplist->index &&
+        SUCCESS != hashindex_reserve(skiplist->index,
+                                     skiplist->length + other->length))
+        return ALLOC_ERR; // err handling
+    if (skiplist->back && SUCCESS != skiplist_backlinks_enable(other))
+        return ALLOC_ERR; // err handling: its nodes need room for the links
+
+    // PART 2: ranges apart are joined, lane by lane
+    skiplist_thaw(skiplist);
+    skiplist_thaw(other);
+    status_t flag = skiplist_join(skiplist, other);
+    if (NOT_FOUND_ERR != flag) return flag;
+
+    // PART 3: otherwise the main lanes are merged and the fast lanes rebuilt
+    skiplist_interleave(skiplist, other, policy);
+
+    if (skiplist->bloom &&
+        SUCCESS != skiplist_bloom_rebuild(skiplist,
+                                          bloom_fp_rate(skiplist->bloom)))
+        bloom_del(&skiplist->bloom); // err handling: it lacks the new words
+    if (skiplist->wheel) { // scheduled again, with the items of other
+        timerwheel_del(&skiplist->wheel);
+        skiplist_timers_start(skiplist);
+    }
+
+    if (SKIPLIST_DETERMINISTIC == skiplist->config.mode)
+        skiplist_relane(skiplist);
+    else
+        skiplist_reshape(skiplist, skiplist->config.prob,
+                         skiplist->config.max_height);
+    return SUCCESS;
+}
+
+SkipList *skiplist_split(SkipList *skiplist, const Item *key) {
+    if (NULL == skiplist || NULL == key) return NULL;
+
+    // The lanes come as they are, the mode is taken afterwards
+    skiplist_config_t config = skiplist->config;
+    config.mode = SKIPLIST_RANDOMIZED;
+    SkipList *right = skiplist_new_with_config(&config);
+    if (NULL == right) return NULL; // err handling
+
+    // The open snapshots keep the words that move
+    if (skiplist->snap && skiplist->top)
+        for (Node *car = mainlane_search(express_search(skiplist->top, key),
+                                         key);
+             car; car = car->next)
+            if (SUCCESS != skiplist_preserve(skiplist, car->item)) {
+                skiplist_del(&right); // err handling
+                return NULL;
+            }
+
+    // PART 1: the whole list moves, or nothing does
+    skiplist_thaw(skiplist);
+    Node **trace = NULL;
+    size_t h = skiplist->height;
+    if (skiplist->top && item_cmp(skiplist->top->item, key) >= 0) {
+        *right = (SkipList){
+            .top = skiplist->top,
+            .length = skiplist->length,
+            .height = h,
+            .seed = right->seed,
+            .config = config,
+            .dead = skiplist->dead,
+            .back = skiplist->back,
+            .nodes = skiplist->nodes,
+        };
+        skiplist->top = NULL;
+        skiplist_shallow_clear(skiplist);
+    } else if (skiplist->top) {
+        trace = skiplist_raw_trace(skiplist, (Item *)key);
+        if (NULL == trace) { // err handling
+            skiplist_del(&right);
+            return NULL;
+        }
+    }
+
+    if (trace && trace[h - 1]->next) {
+        // PART 2: the head column of the new list. The first item moved has
+        // a column of col lanes; the lanes above, up to the last one with
+        // nodes to move (rh), get new nodes.
+        Item *first = trace[h - 1]->next->item;
+        size_t rh = 0, col = 0;
+        while (rh < h && trace[h - 1 - rh]->next) rh++;
+        while (col < rh && first == trace[h - 1 - col]->next->item) col++;
+
+        Node *top = trace[h - col]->next;
+        for (size_t k = col; k < rh; k++) {
+            Node *node = node_new(right, (Node){
+                .item = first,
+                .next = trace[h - 1 - k]->next,
+                .down = top,
+            });
+            if (NULL == node) { // err handling: undo the new nodes
+                while (top != trace[h - col]->next) {
+                    Node *temp = top->down;
+                    node_shallow_del(right, top);
+                    top = temp;
+                }
+                free(trace);
+                skiplist_del(&right);
+                return NULL;
+            }
+            top = node;
+        }
+
+        // PART 3: cut every lane at the trace
+        for (size_t k = 0; k < rh; k++) trace[h - 1 - k]->next = NULL;
+        right->top = top;
+        right->height = rh;
+        right->back = skiplist->back; // the nodes moved have room for it
+        back_set(right, main_lane(right), NULL);
+        skiplist_trim(skiplist);
+
+        // PART 4: count both parts, side by side, up to the shorter end
+        size_t n = 0, dead = 0;
+        Node *l = main_lane(skiplist), *r = main_lane(right);
+        for (; l && r; l = l->next, r = r->next, n++)
+            dead += item_is_tombstone(l->item);
+        _Bool left_done = NULL == l;
+        if (!left_done) { // the right part ended first: count it instead
+            n = dead = 0;
+            for (r = main_lane(right); r; r = r->next, n++)
+                dead += item_is_tombstone(r->item);
+        }
+        right->length = left_done ? skiplist->length - n : n;
+        right->dead = left_done ? skiplist->dead - dead : dead;
+        skiplist->length -= right->length;
+        skiplist->dead -= right->dead;
+        bloom_forget(skiplist->bloom, right->length - right->dead);
+
+        // The nodes too, on every lane of the same part
+        size_t moved = left_done ? skiplist->nodes - lanes_count(skiplist->top)
+                                 : lanes_count(right->top) - right->nodes;
+        skiplist->nodes -= moved;
+        right->nodes += moved;
+
+        // PART 5: the moved items leave the index and the timer wheel
+        if (skiplist->index || skiplist->wheel)
+            for (r = main_lane(right); r; r = r->next) {
+                if (item_is_tombstone(r->item)) continue;
+                hashindex_take(skiplist->index, r->item);
+                timerwheel_cancel(skiplist->wheel, r->item);
+            }
+
+        skiplist->balance_height = 0; // positions of a running rebalance
+        if (SKIPLIST_DETERMINISTIC == skiplist->config.mode)
+            skiplist_relane(skiplist);
+    }
+    free(trace);
+
+    // NOTE (b): a list that could not get every setting is still valid.
+    skiplist_inherit_options(right, skiplist);
+    return right;
+}
+
+Snapshot *skiplist_snapshot(SkipList *skiplist) {
+    if (NULL == skiplist) return NULL;
+
+    Snapshot *snapshot = (Snapshot *)malloc(sizeof(Snapshot));
+    if (NULL == snapshot) return NULL; // err handling
+
+    *snapshot = (Snapshot){
+        .list = skiplist,
+        .kept = skiplist_new(),
+        .older = skiplist->snap,
+        .length = skiplist_length(skiplist),
+        .now = skiplist->now,
+        .timed = NULL != skiplist->wheel,
+    };
+    if (NULL == snapshot->kept) { // err handling
+        free(snapshot);
+        return NULL;
+    }
+
+    if (skiplist->snap) skiplist->snap->newer = snapshot;
+    skiplist->snap = snapshot;
+    return snapshot;
+}
+
+void skiplist_snapshot_del(Snapshot **snapshot) {
+    if (NULL == snapshot || NULL == *snapshot) return;
+    Snapshot *s = *snapshot;
+
+    // The older snapshot reads through this one: what it kept, the older one
+    // would have kept for the words it did not
+    if (s->older) {
+        kept_fold(s->older->kept, s->kept);
+        s->older->newer = s->newer;
+    }
+    if (s->newer) s->newer->older = s->older;
+    else if (s->list) s->list->snap = s->older;
+
+    skiplist_del(&s->kept);
+    free(s);
+    *snapshot = NULL;
+}
+
+Item *skiplist_snapshot_search(const Snapshot *snapshot, const Item *item,
+                               item_buf_t *buf) {
+    if (NULL == snapshot || NULL == snapshot->list || NULL == item ||
+        NULL == buf)
+        return NULL;
+
+    // The first version kept since the snapshot, or the item of the list
+    Item *found = NULL;
+    _Bool kept = 0;
+    for (const Snapshot *s = snapshot; s && !kept; s = s->newer)
+        kept = NULL != (found = skiplist_find(s->kept, item));
+    if (!kept) found = skiplist_find(snapshot->list, item);
+    if (!snapshot_sees(snapshot, found)) return NULL;
+
+    const char *word = item_word(found);
+    const char *description = item_description(found);
+    return item_place(buf, word, strlen(word), description,
+                      strlen(description));
+}
+
+status_t skiplist_snapshot_foreach(const Snapshot *snapshot,
+                                   status_t (*fn)(Item *item, void *ctx),
+                                   void *ctx) {
+    return snapshot_walk(snapshot, 1, '\0', fn, ctx);
+}
+
+status_t skiplist_snapshot_foreach_char(const Snapshot *snapshot, const char c,
+                                        status_t (*fn)(Item *item, void *ctx),
+                                        void *ctx) {
+    return snapshot_walk(snapshot, 0, c, fn, ctx);
+}
+
+size_t skiplist_snapshot_length(const Snapshot *snapshot) {
+    return snapshot && snapshot->list ? snapshot->length : 0;
+}
+
+status_t skiplist_index_enable(SkipList *skiplist) {
+    if (NULL == skiplist) return NUL_ERR;
+    if (skiplist->index) return SUCCESS;
+
+    HashIndex *index = hashindex_new(skiplist->length);
+    if (NULL == index) return ALLOC_ERR; // err handling
+
+    // Go to the main lane
+    Node *sentinel = skiplist->top;
+    while (sentinel && sentinel->down) sentinel = sentinel->down;
+
+    for (; sentinel; sentinel = sentinel->next)
+        if (!item_is_tombstone(sentinel->item))
+            hashindex_put(index, sentinel->item); // reserved, can not fail
+
+    skiplist->index = index;
+    return SUCCESS;
+}
+
+void skiplist_index_disable(SkipList *skiplist) {
+    if (NULL == skiplist) return;
+    hashindex_del(&skiplist->index);
+}
+
+_Bool skiplist_is_indexed(const SkipList *skiplist) {
+    return skiplist && skiplist->index;
+}
+
+status_t skiplist_bloom_enable(SkipList *skiplist, double fp_rate) {
+    if (NULL == skiplist) return NUL_ERR;
+    return skiplist_bloom_rebuild(skiplist, fp_rate);
+}
+
+void skiplist_bloom_disable(SkipList *skiplist) {
+    if (NULL == skiplist) return;
+    bloom_del(&skiplist->bloom);
+}
+
+status_t skiplist_adaptive_enable(SkipList *skiplist) {
+    if (NULL == skiplist) return NUL_ERR;
+    if (skiplist->freq || SKIPLIST_DETERMINISTIC == skiplist->config.mode)
+        return SUCCESS;
+
+    skiplist->freq = freqsketch_new(ADAPT_SKETCH_WIDTH);
+    return skiplist->freq ? SUCCESS : ALLOC_ERR;
+}
+
+void skiplist_adaptive_disable(SkipList *skiplist) {
+    if (NULL == skiplist) return;
+    freqsketch_del(&skiplist->freq);
+}
+
+Item *skiplist_lookup(SkipList *skiplist, const Item *item) {
+    if (NULL == skiplist) return NULL;
+    skiplist_maintain(skiplist, 0);
+
+    // The CLOCK hand of the eviction spares what was looked up
+    Item *found = skiplist_adaptive_search(skiplist, item);
+    if (found && skiplist->config.evict) item_set_referenced(found, 1);
+    return found;
+}
+
+status_t skiplist_lazy_enable(SkipList *skiplist, double ratio) {
+    if (NULL == skiplist) return NUL_ERR;
+    if (!(ratio > 0 && ratio <= 1)) ratio = LAZY_RATIO;
+
+    if (NULL == skiplist->cursor) {
+        skiplist->cursor = item_new(); // the empty word: the start of the list
+        if (NULL == skiplist->cursor) return ALLOC_ERR; // err handling
+    }
+
+    skiplist->lazy_ratio = ratio;
+    return SUCCESS;
+}
+
+void skiplist_lazy_disable(SkipList *skiplist) {
+    if (NULL == skiplist) return;
+    skiplist_compact(skiplist, 0);
+    item_del(&skiplist->cursor);
+    skiplist->lazy_ratio = 0;
+    skiplist->compacting = 0;
+}
+
+size_t skiplist_tombstones(const SkipList *skiplist) {
+    return skiplist ? skiplist->dead : 0;
+}
+
+size_t skiplist_compact(SkipList *skiplist, size_t budget) {
+    if (NULL == skiplist || NULL == skiplist->cursor || 0 == skiplist->dead)
+        return 0;
+
+    size_t freed = 0;
+    if (0 == budget) { // everything, from the start
+        cursor_rewind(skiplist);
+        budget = SIZE_MAX;
+    }
+
+    // PART 1: the head column starts every lane, a dead head is popped
+    while (budget > 0 && item_is_tombstone(skiplist->top->item)) {
+        Item *head = SKIPLIST_DETERMINISTIC == skiplist->config.mode
+                         ? skiplist_det_pop_front(skiplist)
+                         : skiplist_raw_pop_front(skiplist);
+        if (NULL == head) return freed; // err handling
+
+        item_del(&head);
+        skiplist->dead--;
+        freed++;
+        budget--;
+        if (NULL == skiplist->top) return freed;
+    }
+    if (0 == budget || 0 == skiplist->dead) return freed;
+
+    // PART 2: walk the columns from the cursor, unlinking the dead ones
+    Node **trace = skiplist_raw_trace(skiplist, skiplist->cursor);
+    if (NULL == trace) return freed; // err handling
+    size_t h = skiplist->height;
+
+    for (; budget > 0 && skiplist->dead > 0; budget--) {
+        Node *column = trace[h - 1]->next;
+        if (NULL == column) break;
+        Item *it = column->item;
+
+        if (!item_is_tombstone(it)) { // step over it, on every lane
+            for (size_t lv = h; lv-- > 0 && trace[lv]->next &&
+                                trace[lv]->next->item == it;)
+                trace[lv] = trace[lv]->next;
+            continue;
+        }
+
+        if (SKIPLIST_DETERMINISTIC == skiplist->config.mode) {
+            // Unlinked top-down, which keeps the gaps, then traced again
+            item_raw_update(skiplist->cursor, it);
+            free(trace);
+            if (it != skiplist_det_remove(skiplist, it)) return freed;
+
+            trace = skiplist_raw_trace(skiplist, skiplist->cursor);
+            h = skiplist->height;
+        } else {
+            for (size_t lv = h; lv-- > 0 && trace[lv]->next &&
+                                trace[lv]->next->item == it;) {
+                Node *gone = trace[lv]->next;
+                trace[lv]->next = gone->next;
+                node_shallow_del(skiplist, gone);
+            }
+            back_set(skiplist, trace[h - 1]->next, trace[h - 1]);
+            skiplist->length--;
+        }
+
+        item_del(&it);
+        skiplist->dead--;
+        freed++;
+        if (NULL == trace) return freed; // err handling
+    }
+
+    // PART 3: the next step starts at the first column not visited
+    if (trace[h - 1]->next)
+        item_raw_update(skiplist->cursor, trace[h - 1]->next->item);
+    else cursor_rewind(skiplist);
+
+    free(trace);
+    skiplist_trim(skiplist);
+    return freed;
+}
+
+status_t skiplist_backlinks_enable(SkipList *skiplist) {
+    if (NULL == skiplist) return NUL_ERR;
+    if (skiplist->back) return SUCCESS;
+
+    // Every main lane node moves to a BackNode, walking the lane above along
+    // with it to move the down links. A failure leaves the list valid, with
+    // some nodes moved already: they only have room for a link unused yet.
+    Node *above = skiplist->top, *prev = NULL;
+    while (above && above->down && above->down->down) above = above->down;
+    if (above && NULL == above->down) above = NULL; // a single lane
+
+    for (Node *car = main_lane(skiplist); car;) {
+        BackNode *moved = (BackNode *)malloc(sizeof(BackNode));
+        if (NULL == moved) return ALLOC_ERR; // err handling
+        *moved = (BackNode){.node = *car, .prev = prev};
+
+        if (prev) prev->next = &moved->node;
+        else if (NULL == above) skiplist->top = &moved->node;
+        if (above && above->down == car) {
+            above->down = &moved->node;
+            above = above->next;
+        }
+
+        node_shallow_del(NULL, car); // the count stays, moved takes its place
+        prev = &moved->node;
+        car = prev->next;
+    }
+
+    skiplist->back = 1;
+    return SUCCESS;
+}
+
+void skiplist_backlinks_disable(SkipList *skiplist) {
+    if (skiplist) skiplist->back = 0;
+}
+
+status_t skiplist_freeze(SkipList *skiplist) {
+    if (NULL == skiplist) return NUL_ERR;
+    if (skiplist->frozen) return SUCCESS;
+    skiplist->streak = 0;
+
+    // PART 1: the visible items, in order
+    size_t room = skiplist->length - skiplist->dead;
+    Item **items = (Item **)malloc((room ? room : 1) * sizeof(Item *));
+    if (NULL == items) return ALLOC_ERR; // err handling
+
+    size_t n = 0;
+    for (Node *car = main_lane(skiplist); car && n < room; car = car->next)
+        if (!item_gone(skiplist, car->item)) items[n++] = car->item;
+
+    // PART 2: laid out for the searches
+    skiplist->frozen = frozen_new(items, n);
+    free(items);
+    return skiplist->frozen ? SUCCESS : ALLOC_ERR;
+}
+
+void skiplist_thaw(SkipList *skiplist) {
+    if (skiplist) frozen_del(&skiplist->frozen);
+}
+
+status_t skiplist_inherit_options(SkipList *skiplist, const SkipList *model) {
+    if (NULL == skiplist || NULL == model) return NUL_ERR;
+
+    const skiplist_config_t *config = &model->config;
+    status_t flag = SUCCESS;
+    if (SKIPLIST_DETERMINISTIC == config->mode &&
+        SKIPLIST_DETERMINISTIC != skiplist->config.mode)
+        flag = skiplist_relane(skiplist);
+    else if (SKIPLIST_RANDOMIZED == skiplist->config.mode &&
+             (config->prob != skiplist->config.prob ||
+              (config->max_height && config->max_height < skiplist->height)))
+        flag = skiplist_reshape(skiplist, config->prob, config->max_height);
+
+    skiplist_mode_t mode = skiplist->config.mode; // the one it has now
+    skiplist->config = *config;
+    skiplist->config.mode = mode;
+
+    if (SUCCESS == flag && model->index) flag = skiplist_index_enable(skiplist);
+    if (SUCCESS == flag && model->bloom)
+        flag = skiplist_bloom_rebuild(skiplist, bloom_fp_rate(model->bloom));
+    if (SUCCESS == flag && model->freq) flag = skiplist_adaptive_enable(skiplist);
+    if (SUCCESS == flag && model->cursor)
+        flag = skiplist_lazy_enable(skiplist, model->lazy_ratio);
+    if (SUCCESS == flag && model->wheel) flag = skiplist_timers_start(skiplist);
+    if (SUCCESS == flag && model->back)
+        flag = skiplist_backlinks_enable(skiplist);
+    return flag;
+}
+
+void skiplist_timers_reclaim(SkipList *skiplist) {
+    if (skiplist) timerwheel_renumber(skiplist->wheel);
+}
+
+void skiplist_limit(SkipList *skiplist, size_t max_length, size_t max_bytes) {
+    if (NULL == skiplist) return;
+    skiplist->config.max_length = max_length;
+    skiplist->config.max_bytes = max_bytes;
+}
+
+void skiplist_on_drop(SkipList *skiplist,
+                      void (*fn)(void *ctx, const Item *item), void *ctx) {
+    if (NULL == skiplist) return;
+    skiplist->config.drop = fn;
+    skiplist->config.drop_ctx = ctx;
+}
+
+_Bool skiplist_is_full(const SkipList *skiplist) {
+    return skiplist ? skiplist_full_at(skiplist, skiplist->length) : 0;
+}
+
+status_t skiplist_evict(SkipList *skiplist, const Item *spare) {
+    if (NULL == skiplist) return NUL_ERR;
+    skiplist_thaw(skiplist); // it must not keep a freed item
+    if (skiplist->dead > 0 && skiplist_compact(skiplist, 0) > 0)
+        return SUCCESS;
+    if (skiplist_length(skiplist) <= (spare ? 1 : 0)) return NOT_FOUND_ERR;
+
+    // The hand starts at the empty word: the start of the list
+    if (NULL == skiplist->hand) skiplist->hand = item_new();
+
+    Node *bottom = skiplist->top;
+    while (bottom->down) bottom = bottom->down;
+    Node *car = skiplist->hand
+                    ? mainlane_search(express_search(skiplist->top,
+                                                     skiplist->hand),
+                                      skiplist->hand)
+                    : bottom;
+
+    // Around the main lane, sparing once what was looked up
+    Item *victim = NULL;
+    for (size_t seen = 0; NULL == victim; seen++, car = car->next) {
+        if (NULL == car) car = bottom;
+        Item *it = car->item;
+        if (item_is_tombstone(it) || it == spare) continue;
+
+        if (item_gone(skiplist, it) || !item_is_referenced(it) ||
+            seen >= EVICT_MAX_SCAN)
+            victim = it;
+        else item_set_referenced(it, 0);
+    }
+
+    if (skiplist->hand) {
+        if (car) item_raw_update(skiplist->hand, car->item);
+        else item_place((item_buf_t *)skiplist->hand, "", 0, NULL, 0);
+    }
+
+    Item *gone = skiplist_unlink(skiplist, victim);
+    if (NULL == gone) return ALLOC_ERR; // err handling
+    skiplist_drop(skiplist, &gone);
+    skiplist->evicted++;
+    return SUCCESS;
+}
+
+_Bool skiplist_is_empty(const SkipList *skiplist) {
+    return skiplist ? skiplist->length <= skiplist->dead : 0;
+}
+
+size_t skiplist_length(const SkipList *skiplist) {
+    return skiplist ? skiplist->length - skiplist->dead : 0;
+}
+
+size_t skiplist_height(const SkipList *skiplist) {
+    return skiplist ? skiplist->height : 0;
+}
+
+skiplist_mode_t skiplist_mode(const SkipList *skiplist) {
+    return skiplist ? skiplist->config.mode : SKIPLIST_RANDOMIZED;
+}
+
+status_t skiplist_reshape(SkipList *skiplist, double prob, size_t max_height) {
+    if (NULL == skiplist) return NUL_ERR;
+    if (!(prob > 0 && prob < 1)) prob = SKIPLIST_PROB;
+
+    skiplist->config.prob = prob;
+    skiplist->config.max_height = max_height;
+    if (SKIPLIST_DETERMINISTIC == skiplist->config.mode) return SUCCESS;
+
+    Node *bottom = skiplist_drop_lanes(skiplist);
+    if (NULL == bottom) return SUCCESS;
+
+    size_t cap = 0 == max_height || max_height > BUILD_MAX_HEIGHT
+                     ? BUILD_MAX_HEIGHT
+                     : max_height;
+
+    // The head column is as tall as the tallest tower: the towers are drawn
+    // once to find it, then again from the same seed to build them.
+    unsigned int seed = skiplist->seed;
+    size_t h = 1;
+    for (Node *car = bottom->next; car; car = car->next) {
+        size_t height = tower_height(skiplist, car->item, cap);
+        if (height > h) h = height;
+    }
+    skiplist->seed = seed;
+
+    Node *last[BUILD_MAX_HEIGHT]; // last node of every lane
+    status_t flag = skiplist_raise_head(skiplist, h, last);
+
+    for (Node *car = bottom->next; SUCCESS == flag && car; car = car->next) {
+        size_t height = tower_height(skiplist, car->item, cap);
+        Node *below = car;
+        for (size_t lv = 1; lv < height; lv++) {
+            Node *node = node_new(skiplist, (Node){.item = car->item, .down = below});
+            if (NULL == node) { // err handling
+                flag = ALLOC_ERR;
+                break;
+            }
+            last[lv] = last[lv]->next = node;
+            below = node;
+        }
+    }
+
+    skiplist_trim(skiplist); // a failed build may leave empty lanes on top
+    return flag;
+}
+
+_Bool skiplist_rebalance(SkipList *skiplist, size_t budget) {
+    if (NULL == skiplist || NULL == skiplist->top ||
+        SKIPLIST_DETERMINISTIC == skiplist->config.mode)
+        return 1;
+
+    // Without a cursor to resume from, the pass runs to its end
+    if (NULL == skiplist->balance_at) skiplist->balance_at = item_new();
+    if (0 == budget || NULL == skiplist->balance_at) budget = SIZE_MAX;
+
+    size_t base = (size_t)(1 / skiplist->config.prob + 0.5);
+    if (base < 2) base = 2;
+
+    // PART 1: a new pass aims at the ideal height for the length, which the
+    // head column reaches first
+    if (0 == skiplist->balance_height) {
+        size_t cap = skiplist->config.max_height;
+        if (0 == cap || cap > BUILD_MAX_HEIGHT) cap = BUILD_MAX_HEIGHT;
+
+        size_t height = 1;
+        for (size_t m = skiplist->length - 1; m >= base && height < cap;
+             m /= base)
+            height++;
+
+        while (skiplist->height < height) {
+            Node *node = node_new(skiplist, (Node){
+                .item = skiplist->top->item,
+                .down = skiplist->top,
+            });
+            if (NULL == node) break; // err handling: a lower list is valid
+            skiplist->top = node;
+            skiplist->height++;
+        }
+
+        skiplist->balance_height = height;
+        skiplist->balance_pos = 1;
+    }
+
+    // PART 2: the node before the first column of the step, on every lane
+    size_t h = skiplist->height;
+    Node **trace = NULL;
+    if (1 == skiplist->balance_pos) { // the head column
+        trace = (Node **)malloc(h * sizeof(Node *));
+        Node *sentinel = skiplist->top;
+        for (size_t lv = 0; trace && lv < h; lv++, sentinel = sentinel->down)
+            trace[lv] = sentinel;
+    } else {
+        trace = skiplist_raw_trace(skiplist, skiplist->balance_at);
+    }
+    if (NULL == trace) return 0; // err handling: the next step retries
+
+    // PART 3: move every column of the step to its height, one lane at a
+    // time. Lane h - k is the k-th of a column, from the bottom.
+    size_t top = skiplist->balance_height < h ? skiplist->balance_height : h;
+    for (; budget > 0; budget--, skiplist->balance_pos++) {
+        Node *column = trace[h - 1]->next;
+        if (NULL == column) break;
+        Item *it = column->item;
+
+        size_t height = 1;
+        while (height < h && trace[h - 1 - height]->next &&
+               it == trace[h - 1 - height]->next->item)
+            height++;
+
+        size_t target =
+            skiplist->freq
+                ? drawn_height(item_hash(it), top, skiplist->config.prob)
+                : ideal_height(skiplist->balance_pos, base, top);
+
+        for (; height < target; height++) { // promote, bottom-up
+            size_t lv = h - 1 - height;
+            Node *node = node_new(skiplist, (Node){
+                .item = it,
+                .next = trace[lv]->next,
+                .down = trace[lv + 1]->next,
+            });
+            if (NULL == node) break; // err handling: it stays lower
+            trace[lv]->next = node;
+        }
+        for (; height > target; height--) { // demote, top-down
+            Node *gone = trace[h - height]->next;
+            trace[h - height]->next = gone->next;
+            node_shallow_del(skiplist, gone);
+        }
+
+        // Step over the column on the lanes that hold it
+        for (size_t lv = h - height; lv < h; lv++) trace[lv] = trace[lv]->next;
+    }
+
+    // PART 4: the next step starts at the first column not visited
+    Node *next = trace[h - 1]->next;
+    free(trace);
+    if (next) {
+        item_raw_update(skiplist->balance_at, next->item);
+        return 0;
+    }
+
+    skiplist->balance_height = 0;
+    skiplist->drift = 0;
+    skiplist_trim(skiplist);
+    return 1;
+}
+
+//=============================================================================/
+//=================|    Private Function Implementations    |==================/
+//=============================================================================/
+
+/**
+ * @brief Creates a heap allocated skiplist node based on a stack allocated skip
+ * list.
+ *
+ * @param skiplist ptr to the skiplist the node is for, which counts it, or
+ * NULL if it is counted elsewhere.
+ * @param base a stack allocated node that will be copied into the heap.
+ * @return Node* ptr to the heap allocated node, WITH OWNERSHIP, or NULL on
+ * error.
+ */
+static Node *node_new(SkipList *skiplist, const Node base) {
+    Node *n = (Node *)malloc(sizeof(Node)); // mem alloc
+    if (n) *n = base;                       // if no error, init
+    if (n && skiplist) skiplist->nodes++;
+    return n; // return ptr, might be null
+}
+
+/**
+ * @brief Creates a main lane node: a BackNode, with no node before it yet,
+ * if the skiplist has back links, a Node otherwise.
+ *
+ * @param skiplist ptr to the skiplist the node is for.
+ * @param base a stack allocated node that will be copied into the heap.
+ * @return Node* see node_new().
+ */
+static Node *bottom_new(SkipList *skiplist, const Node base) {
+    if (!skiplist->back) return node_new(skiplist, base);
+
+    BackNode *n = (BackNode *)malloc(sizeof(BackNode));
+    if (n) *n = (BackNode){.node = base};
+    if (n) skiplist->nodes++;
+    return (Node *)n;
+}
+
+/**
+ * @brief Sets the back link of a main lane node, if the skiplist keeps them.
+ *
+ * @param skiplist ptr to the skiplist.
+ * @param node the node, or NULL after the last one (then nothing is done).
+ * @param prev the node now before it, or NULL if it is the first.
+ */
+static inline void back_set(const SkipList *skiplist, Node *node, Node *prev) {
+    if (skiplist->back && node) ((BackNode *)node)->prev = prev;
+}
+
+/**
+ * @brief The node before a main lane node: its back link, or a descent
+ * from the top if the skiplist has none.
+ *
+ * @param skiplist ptr to the skiplist.
+ * @param node a node of its main lane.
+ * @return Node* the node before, or NULL if node is the first.
+ */
+static Node *node_before(const SkipList *skiplist, const Node *node) {
+    if (skiplist->back) return ((const BackNode *)node)->prev;
+    if (item_cmp(skiplist->top->item, node->item) >= 0) return NULL;
+    return fastlane_search(express_search(skiplist->top, node->item),
+                           node->item);
+}
+
+/**
+ * @brief The last main lane node whose word is not after the one of key.
+ *
+ * @param skiplist ptr to the skiplist.
+ * @param key ptr to the key, or NULL for the last node of the list.
+ * @return Node* the node, or NULL if the list is empty or every word comes
+ * after the key.
+ */
+static Node *last_not_after(const SkipList *skiplist, const Item *key) {
+    Node *sentinel = skiplist->top;
+    if (NULL == sentinel || (key && item_cmp(sentinel->item, key) > 0))
+        return NULL;
+
+    for (;;) {
+        while (sentinel->next &&
+               (NULL == key || item_cmp(sentinel->next->item, key) <= 0))
+            sentinel = sentinel->next;
+        if (NULL == sentinel->down) return sentinel;
+        sentinel = sentinel->down;
+    }
+}
+
+/**
+ * @brief frees the memory used to store a node on the heap without freeing
+ the
+ *  memory used to store the node contents.
+ * @warning if item is not freed elsewhere, this function will cause a memory
+ *  leak.
+ *
+ * @param skiplist ptr to the skiplist the node leaves, or NULL, see
+ * node_new().
+ * @param node
+ */
+static void node_shallow_del(SkipList *skiplist, Node *node) {
+    if (node && skiplist) skiplist->nodes--;
+    free(node);
+}
+
+/**
+ * @brief frees the memory used to store a node and its contetns.
+ *
+ * @warning if item is used elsewhere after a node containing a reference to it
+ * if deleted using this function, a segfault by dangling ptr access may occur.
+ *
+ * @param skiplist ptr to the skiplist the node leaves, or NULL, see
+ * node_new().
+ * @param node the node that will be destroyed.
+ */
+static void node_deep_del(SkipList *skiplist, Node *node) {
+    if (node) item_del(&node->item);
+    node_shallow_del(skiplist, node);
+}
+
+/**
+ * @brief Checks if the skiplist contains a item.
+ *
+ * @param skiplist a pointer to the skiplist.
+ * @param item a pointer to the item.
+ * @return _Bool \c 1 if the skiplist contains the item, \c 0 otherwise.
+ */
+_Bool skiplist_includes(const SkipList *skiplist, const Item *item) {
+    Item *it = skiplist_search(skiplist, item);
+    return it && 0 == item_cmp(it, item) ? 1 : 0;
+}
+
+/**
+ * @brief Runs the checks of an insertion and makes room for it: the item is
+ * refused if its word is alive in the list, replaces the expired item of its
+ * word, if any, and is refused or evicts (see skiplist_config_t) when the
+ * list is full. Then it is scheduled, if it expires, and linked.
+ *
+ * @param skiplist ptr to the skiplist.
+ * @param item ptr to the item, with its expiry set.
+ * @return status_t see skiplist_insert().
+ */
+static status_t skiplist_put(SkipList *skiplist, Item *item) {
+    // PART 1: Basic checks and trivial cases
+    skiplist_maintain(skiplist, 1);
+    Item *same = skiplist_find(skiplist, item);
+    if (same && !item_gone(skiplist, same)) return REPEATED_ENTRY_ERR;
+
+    // An expired item of the word, not freed yet, leaves first
+    if (same && !item_is_tombstone(same)) {
+        Item *expired = skiplist_unlink(skiplist, same);
+        if (NULL == expired) return ALLOC_ERR; // err handling
+        skiplist_drop(skiplist, &expired);
+        skiplist->expired++;
+    }
+
+    while (skiplist_is_full(skiplist))
+        if (!skiplist->config.evict ||
+            SUCCESS != skiplist_evict(skiplist, NULL))
+            return ARR_IS_FULL_ERR;
+
+    // Room in the index first, so linking can not fail to index it
+    if (skiplist->index &&
+        SUCCESS != hashindex_reserve(skiplist->index, skiplist->length + 1))
+        return ALLOC_ERR;
+
+    // Then the timer, cancelled if the item can not be linked
+    if (item_expiry(item) &&
+        (SUCCESS != skiplist_timers_start(skiplist) ||
+         SUCCESS != timerwheel_add(skiplist->wheel, item)))
+        return ALLOC_ERR;
+
+    status_t flag = skiplist_link(skiplist, item);
+    if (SUCCESS != flag) {
+        timerwheel_cancel(skiplist->wheel, item);
+        return flag;
+    }
+
+    // PART 2: the towers drawn may take more than the room made
+    if (SUCCESS == skiplist_fit(skiplist, item)) return SUCCESS;
+    if (item != skiplist_unlink(skiplist, item))
+        return SUCCESS; // err handling: it stays, past the limit
+    return ARR_IS_FULL_ERR;
+}
+
+/**
+ * @brief Links an item whose word is not alive in the list: in the column of
+ * its tombstone if there is one, in a new column otherwise.
+ *
+ * @param skiplist ptr to the skiplist, with room in its index.
+ * @param item ptr to the item.
+ * @return status_t \c SUCCESS, \c NUL_ERR or \c ALLOC_ERR.
+ */
+static status_t skiplist_link(SkipList *skiplist, Item *item) {
+    if (SUCCESS != skiplist_preserve(skiplist, item)) return ALLOC_ERR;
+
+    // A tombstone of the word gives its column back
+    if (skiplist->dead > 0) {
+        status_t flag = skiplist_revive(skiplist, item);
+        if (NOT_FOUND_ERR != flag) return flag;
+    }
+
+    // Trivial case: the list is empty
+    if (NULL == skiplist->top) {
+        skiplist->top = bottom_new(skiplist, (Node){.item = item});
+        if (NULL == skiplist->top) return ALLOC_ERR; // err handling
+
+        skiplist->length = 1;
+        skiplist->height = 1;
+
+        skiplist_indexes_add(skiplist, item);
+        return SUCCESS;
+    }
+
+    // Deterministic lists keep their gaps on the way down instead
+    if (SKIPLIST_DETERMINISTIC == skiplist->config.mode) {
+        status_t flag = skiplist_det_insert(skiplist, item);
+        if (SUCCESS == flag) skiplist_indexes_add(skiplist, item);
+        return flag;
+    }
+
+    // Trivial case: insertion at the begginig
+    if (item_cmp(skiplist->top->item, item) >= 0) {
+        status_t flag = skiplist_raw_push_front(skiplist, item);
+        if (SUCCESS == flag) skiplist_indexes_add(skiplist, item);
+        return flag;
+    }
+
+    // PART 2: Tracing the skiplist
+    // Getting the update trace
+    Node **updates = skiplist_raw_trace(skiplist, item); // ownership
+    if (NULL == updates) return NUL_ERR;                 // err handling
+    size_t h = skiplist->height; // mem access optimization
+
+    if (NULL == updates[h - 1]) { // err handling
+        free(updates);
+        return NUL_ERR;
+    }
+
+    status_t flag = skiplist_link_at(skiplist, updates, item);
+    free(updates);
+    return flag;
+}
+
+/**
+ * @brief Links a new column for an item where a trace of its word crosses
+ * the lanes, and draws its height.
+ *
+ * @param skiplist ptr to the skiplist, with room in its index.
+ * @param updates the trace of the word, see skiplist_raw_trace(). It stays
+ * valid for the words after it unless the height of the list changes.
+ * @param item ptr to the item, after the first one.
+ * @return status_t \c SUCCESS or \c ALLOC_ERR.
+ */
+static status_t skiplist_link_at(SkipList *skiplist, Node **updates,
+                                 Item *item) {
+    size_t h = skiplist->height; // mem access optimization
+
+    // PART 3: Insertion at the main lane
+    // Creating the new node
+    Node *new_node = bottom_new(skiplist, (Node){
+        .item = item,
+        .next = updates[h - 1]->next,
+    });
+
+    // Error handling
+    if (NULL == new_node) return ALLOC_ERR;
+
+    // Inserting the new node
+    updates[h - 1]->next = new_node;
+    back_set(skiplist, new_node, updates[h - 1]);
+    back_set(skiplist, new_node->next, new_node);
+
+    // PART 4: Insertion at the existing fast lanes
+    long long lv = h - 2;
+    double prob = skiplist->config.prob;
+    for (; (lv >= 0) && (rnd_normalized_r(&skiplist->seed) <= prob); lv--) {
+        // TODO: Add error handling here
+        new_node = node_new(skiplist, (Node){
+            .item = item,
+            .next = updates[lv]->next,
+            .down = new_node,
+        });
+        if (new_node) updates[lv]->next = new_node;
+        else break; // err handling: recoverable error
+        // NOTE: no need for a more complex error handling here. A fail here
+        // only stops us from clibimbing a level. Thats fine.
+    }
+
+    // Raising the level of the node above the current level of the skiplist
+    if (lv < 0 && new_node) {
+        lv = h;
+        size_t max = skiplist->config.max_height;
+        for (; (rnd_normalized_r(&skiplist->seed) <= prob);) {
+            if (max && (size_t)lv++ >= max) break;
+
+            // New node
+            new_node = node_new(skiplist, (Node){
+                .item = item,
+                .down = new_node,
+            });
+
+            // Error handling
+            if (NULL == new_node) break;
+
+            // New top
+            Node *temp = node_new(skiplist, (Node){
+                .item = skiplist->top->item,
+                .next = new_node,
+                .down = skiplist->top,
+            });
+
+            // Err handling
+            if (NULL == temp) {
+                node_shallow_del(skiplist, new_node);
+                break;
+            }
+
+            skiplist->top = temp;
+            skiplist->height++;
+            if (skiplist->config.raise_once) break;
+        }
+    }
+
+    // PART 6: cleanup and finishing it
+    skiplist->length++;
+    skiplist_indexes_add(skiplist, item);
+    return SUCCESS;
+}
+
+/**
+ * @brief Unlinks the column of an item, with no visibility check: it may be a
+ * tombstone or expired.
+ *
+ * @param skiplist ptr to the skiplist.
+ * @param item ptr to an item with a word in the list.
+ * @return Item* the removed item, WITH OWNERSHIP, or NULL on error.
+ */
+static Item *skiplist_unlink(SkipList *skiplist, Item *item) {
+    if (SUCCESS != skiplist_preserve(skiplist, item)) return NULL;
+
+    // Deterministic lists keep their gaps on the way down instead
+    if (SKIPLIST_DETERMINISTIC == skiplist->config.mode) {
+        Item *removed = 0 == item_cmp(skiplist->top->item, item)
+                            ? skiplist_det_pop_front(skiplist)
+                            : skiplist_det_remove(skiplist, item);
+        if (removed) skiplist_indexes_drop(skiplist, removed);
+        return removed;
+    }
+
+    // Trivial case: remove first item
+    if (0 == item_cmp(skiplist->top->item, item)) {
+        Item *first = skiplist_raw_pop_front(skiplist);
+        if (first) skiplist_indexes_drop(skiplist, first);
+        return first;
+    }
+
+    // Shortcuts
+    size_t h = skiplist->height;
+
+    // Getting node trace
+    Node **updates = skiplist_raw_trace(skiplist, item);
+    if (NULL == updates) return NULL; // err handling
+
+    // Error handling
+    if (NULL == updates[h - 1] || NULL == updates[h - 1]->next ||
+        NULL == updates[h - 1]->next->item) {
+        free(updates);
+        return NULL;
+    }
+
+    Item *result = skiplist_unlink_at(skiplist, updates);
+    free(updates);
+    return result;
+}
+
+/**
+ * @brief Unlinks the column that follows a trace, see skiplist_unlink().
+ *
+ * @param skiplist ptr to the skiplist.
+ * @param updates the trace of the word, whose item is not the first one. It
+ * stays valid for the words after it unless the height of the list changes.
+ * @return Item* the removed item, WITH OWNERSHIP.
+ */
+static Item *skiplist_unlink_at(SkipList *skiplist, Node **updates) {
+    size_t h = skiplist->height;
+
+    // Saving the result
+    Item *result = updates[h - 1]->next->item;
+
+    // Removing
+    long long i = skiplist->height - 1;
+    for (; i >= 0 && updates[i] && updates[i]->next &&
+           result == updates[i]->next->item;
+         i--) {
+        if (NULL == updates[i] || NULL == updates[i]->next) continue;
+
+        Node *temp = updates[i]->next->next;
+
+        *(updates[i]->next) = (Node){0};
+        node_shallow_del(skiplist, updates[i]->next);
+        updates[i]->next = NULL;
+
+        updates[i]->next = temp;
+    }
+    back_set(skiplist, updates[h - 1]->next, updates[h - 1]);
+
+    // Reduce level
+    if (NULL == skiplist->top->next && skiplist->height > 1) {
+        Node *temp = skiplist->top->down;
+        node_shallow_del(skiplist, skiplist->top);
+        skiplist->top = temp;
+        skiplist->height--;
+    }
+
+    skiplist->length--;
+    skiplist_indexes_drop(skiplist, result);
+    return result;
+}
+
+/**
+ * @brief Frees an item that left the list on its own (see skiplist_on_drop()),
+ * telling the callback first unless it is a tombstone: its removal was a
+ * write of its own.
+ *
+ * @param skiplist ptr to the skiplist the item left.
+ * @param item a ptr to the item ptr. It will be set to NULL.
+ */
+static void skiplist_drop(SkipList *skiplist, Item **item) {
+    if (skiplist->config.drop && *item && !item_is_tombstone(*item))
+        skiplist->config.drop(skiplist->config.drop_ctx, *item);
+    item_del(item);
+}
+
+/**
+ * @brief Searches an item like skiplist_search(), but in the adaptive mode
+ * it also counts the access and adjusts the tower found (see
+ * skiplist_adaptive_enable()).
+ *
+ * @param skiplist ptr to the skiplist.
+ * @param item ptr to the item.
+ * @return Item* see skiplist_search().
+ */
+static Item *skiplist_adaptive_search(SkipList *skiplist, const Item *item) {
+    if (NULL == skiplist->freq || skiplist->index || skiplist->frozen ||
+        skiplist->height > ADAPT_MAX_HEIGHT)
+        return skiplist_search(skiplist, item);
+    if (NULL == item || NULL == skiplist->top) return NULL;
+
+    uint64_t hash = item_hash(item);
+    if (skiplist->bloom && !bloom_may_contain(skiplist->bloom, hash))
+        return NULL;
+
+    // The head tower is as tall as the list already
+    if (0 == item_cmp(skiplist->top->item, item))
+        return item_gone(skiplist, skiplist->top->item) ? NULL
+                                                        : skiplist->top->item;
+
+    // Descend until the first node of the word: the top of its tower
+    Node *trace[ADAPT_MAX_HEIGHT];
+    Node *sentinel = skiplist->top;
+    for (size_t lv = 0; sentinel; lv++, sentinel = sentinel->down) {
+        int cmp = 1; // the last comparison is reused: no extra one per lane
+        while (sentinel->next &&
+               (cmp = item_cmp(sentinel->next->item, item)) < 0)
+            sentinel = sentinel->next;
+        trace[lv] = sentinel;
+
+        if (0 == cmp) {
+            Item *found = sentinel->next->item;
+            if (item_gone(skiplist, found)) return NULL;
+            skiplist_adapt(skiplist, trace, lv, hash);
+            return found;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Records a new item in the index and in the filter, rebuilding the
+ * filter if it got saturated.
+ *
+ * @note the index must have room for it, see hashindex_reserve().
+ */
+static void skiplist_indexes_add(SkipList *skiplist, Item *item) {
+    hashindex_put(skiplist->index, item);
+    if (NULL == skiplist->bloom) return;
+
+    bloom_add(skiplist->bloom, item_hash(item));
+    if (bloom_is_saturated(skiplist->bloom))
+        skiplist_bloom_rebuild(skiplist, bloom_fp_rate(skiplist->bloom));
+}
+
+/**
+ * @brief Forgets a removed item in the index, in the filter and on the timer
+ * wheel, rebuilding the filter if too many of its keys are gone.
+ */
+static void skiplist_indexes_drop(SkipList *skiplist, Item *item) {
+    hashindex_take(skiplist->index, item);
+    timerwheel_cancel(skiplist->wheel, item);
+    if (NULL == skiplist->bloom) return;
+
+    bloom_forget(skiplist->bloom, 1);
+    if (bloom_is_saturated(skiplist->bloom))
+        skiplist_bloom_rebuild(skiplist, bloom_fp_rate(skiplist->bloom));
+}
+
+/**
+ * @brief Replaces the filter by a new one sized for twice the current length
+ * and filled with every item.
+ *
+ * @return status_t \c SUCCESS or \c ALLOC_ERR, in which case the old filter
+ * (if any) is kept: it is still correct, only less selective.
+ */
+static status_t skiplist_bloom_rebuild(SkipList *skiplist, double fp_rate) {
+    Bloom *bloom = bloom_new(2 * skiplist->length, fp_rate);
+    if (NULL == bloom) return ALLOC_ERR; // err handling
+
+    // Go to the main lane
+    Node *sentinel = skiplist->top;
+    while (sentinel && sentinel->down) sentinel = sentinel->down;
+
+    for (; sentinel; sentinel = sentinel->next)
+        if (!item_is_tombstone(sentinel->item))
+            bloom_add(bloom, item_hash(sentinel->item));
+
+    bloom_del(&skiplist->bloom);
+    skiplist->bloom = bloom;
+    return SUCCESS;
+}
+
+/**
+ * @brief Searches the main lane of the skiplist for a item.
+ *
+ * @param sentinel a pointer to the first node of the main lane.
+ * @param item a pointer to the item.
+ * @return Node* a pointer to the node that preceeds the node that contains the
+ * item, or NULL if the item is not in the skiplist.
+ */
+static inline Node *mainlane_search(Node *sentinel, const Item *item) {
+    while (sentinel && item_cmp(sentinel->item, item) < 0) {
+        sentinel = sentinel->next;
+    }
+    return sentinel;
+}
+
+/**
+ * @brief Searches the fast lane of the skiplist for a item.
+ *
+ * @param sentinel a pointer to the first node of the fast lane.
+ * @param item a pointer to the item.
+ * @return Node* a pointer to the node that preceeds the node that contains the
+ * item, or NULL if the item is not in the skiplist.
+ */
+static inline Node *fastlane_search(Node *sentinel, const Item *item) {
+    // WARNING: We assume `NULL != sentinel` and `NULL != item`
+    if (NULL == sentinel) return NULL;
+    while (sentinel->next && item_cmp(sentinel->next->item, item) < 0) {
+        sentinel = sentinel->next;
+    }
+    return sentinel;
+}
+
+/**
+ * @brief Searches the skiplist for a item, except for the main lane.
+ *
+ * @param sentinel a pointer to the first node of the skiplist.
+ * @param item a pointer to the item.
+ * @return Node* a pointer to the node that preceeds the node that contains the
+ */
+static inline Node *express_search(Node *sentinel, const Item *item) {
+    // WARNING: We assume `NULL != sentinel` and `NULL != item`
+    if (NULL == sentinel) return NULL;
+    while (sentinel->down) { // while sentinel.level > 0
+        while (sentinel->next && item_cmp(sentinel->next->item, item) < 0) {
+            sentinel = sentinel->next;
+        }
+        sentinel = sentinel->down;
+    }
+    return sentinel;
+}
+
+/**
+ * @brief Searched the skiplist and returns every node, one for each level, that
+ * preceeds a node equal o grater than the target item.
+ *
+ * @note this function assumes that skiplist and item are valid pointers and it
+ * also assumes that the list is not empty.
+ *
+ * @param skiplist a ptr to the skiplist.
+ * @param item ptr to an item containing the target key.
+ * @return Node** vector of pointers to Nodes that were found dyring the trace
+ * search. You have ownership.
+ */
+Node **skiplist_raw_trace(SkipList *skiplist, Item *item) {
+    if (NULL == skiplist || item == NULL || skiplist->top == NULL) return NULL;
+
+    Node **updates = (Node **)calloc(skiplist->height, sizeof(Node *));
+    if (NULL == updates) return NULL;
+
+    size_t depth = 0;
+    Node *sentinel = skiplist->top;
+
+    if (sentinel)
+        while (sentinel->down) { // while sentinel.level > 0
+            while (sentinel->next && item_cmp(sentinel->next->item, item) < 0) {
+                sentinel = sentinel->next;
+            }
+            updates[depth++] = sentinel;
+            sentinel = sentinel->down;
+        }
+
+    if (sentinel)
+        while (sentinel->next && item_cmp(sentinel->next->item, item) < 0) {
+            sentinel = sentinel->next;
+        }
+
+    updates[depth++] = sentinel;
+    // printf("<trace depth(%lu)>\n", depth);
+
+    return updates;
+}
+
+/**
+ * @brief Inserts a item on the start of the skiplist.
+ *
+ * @param skiplist ptr to the skiplist.
+ * @param item ptr to the item that will be inserted. You lose ownership on a
+ * successiful push.
+ * @return status_t \c SUCCESS if we succeded on the push, \c ALLOC_ERR if we
+ * fail to allocate memory for the new node.
+ */
+static status_t skiplist_raw_push_front(SkipList *skiplist, Item *item) {
+    // New top
+    Node base = (Node){.item = item, .next = skiplist->top};
+    Node *new_node = skiplist->top->down ? node_new(skiplist, base)
+                                         : bottom_new(skiplist, base);
+    if (NULL == new_node) return ALLOC_ERR; // Error handling
+    Node *sentinel = skiplist->top->down;
+    skiplist->top = new_node;
+
+    // Creating the new nodes for each level
+    Node *previous = new_node;
+    while (sentinel) {
+        // Creating the new node
+        base = (Node){.item = item, .next = sentinel};
+        new_node = sentinel->down ? node_new(skiplist, base) : bottom_new(skiplist, base);
+
+        // Error handling: revert all to recover
+        if (NULL == new_node) {
+            Node *previous_top = skiplist->top->next;
+
+            sentinel = skiplist->top; // current top
+            while (sentinel) {
+                Node *temp = sentinel->down;
+                node_shallow_del(skiplist, sentinel);
+                sentinel = temp;
+            }
+
+            skiplist->top = previous_top;
+            return ALLOC_ERR;
+        }
+
+        // Adding the new node
+        previous->down = new_node;
+        previous = new_node;
+
+        sentinel = sentinel->down;
+    }
+    back_set(skiplist, previous->next, previous); // the main lane node
+
+    skiplist->length++;
+    return SUCCESS;
+}
+
+/**
+ * @brief Reduces the height of the skiplist if it has small lanes on the top.
+ *
+ * Every lane above the main lane (the bottom lane, aka: the true lane), if they
+ * exist, should have at least 2 itens. Otherwise, there would be no peformance
+ * gain provided by the lane ;)
+ *
+ * @param skiplist a pointer to the skiplist.
+ */
+void skiplist_trim(SkipList *skiplist) {
+    if (NULL == skiplist || NULL == skiplist->top) return; // err handling
+
+    // Loop from top to bottom untill we reach the bottom or until a valid top
+    // lane is stabilished.
+    while (skiplist->height > 1 && NULL == skiplist->top->next) {
+        // Destroy the lane
+        Node *temp = skiplist->top->down;
+        node_shallow_del(skiplist, skiplist->top);
+        skiplist->top = temp;
+
+        skiplist->height--; // dec the height
+    }
+}
+
+/**
+ * @brief removes the first element of the skiplist.
+ *
+ * @param skiplist ptr to skiplist.
+ * @return Item* ptr to the the removed item or NULL. You have ownership.
+ */
+Item *skiplist_raw_pop_front(SkipList *skiplist) {
+    Item *return_item = skiplist->top->item;
+    Node *sentinel = skiplist->top;
+
+    // Trivial case: list has only one
+    if (1 == skiplist->length) {
+        // Cleanup loop
+        while (sentinel) {
+            Node *temp = sentinel->down;
+            node_shallow_del(skiplist, sentinel);
+            sentinel = temp;
+        }
+
+        // Set zeros
+        *skiplist = (SkipList){
+            .seed = skiplist->seed,
+            .config = skiplist->config,
+            .index = skiplist->index,
+            .bloom = skiplist->bloom,
+            .freq = skiplist->freq,
+            .dead = skiplist->dead, // the caller accounts for the item
+            .lazy_ratio = skiplist->lazy_ratio,
+            .cursor = skiplist->cursor,
+            .balance_at = skiplist->balance_at,
+            .wheel = skiplist->wheel,
+            .now = skiplist->now,
+            .hand = skiplist->hand,
+            .expired = skiplist->expired,
+            .evicted = skiplist->evicted,
+            .snap = skiplist->snap,
+            .back = skiplist->back,
+        };
+
+        return return_item;
+    }
+
+    // Tracing next
+    size_t h = skiplist->height;
+    Node **updates = (Node **)calloc(h, sizeof(Node *));
+    if (NULL == updates) return NULL; // err handling
+
+    // Going down and tracing
+    size_t depth = 0;
+    while (sentinel) {
+        updates[depth++] = sentinel->next;
+        sentinel = sentinel->down;
+    }
+
+    // The new start of the main lane (bottom lane):
+    Node *new_bottom = updates[h - 1];
+
+    if (NULL == new_bottom) { // err handling
+        free(updates);
+        return NULL;
+    }
+
+    Item *bottom_item = new_bottom->item;
+
+    // Making shure the first object is tall enought
+    Node *temp = updates[h - 1];
+    long long i = h - 2;
+    for (; i >= 0 && updates[i] && updates[i]->item == bottom_item; i--)
+        temp = updates[i];
+
+    // Raise level of the new first object if needed
+    // NOTE (b): `i` can only be inside [-1, h - 2] here.
+    Node *column = temp;
+    for (; i >= 0; i--) {
+        Node *raised = node_new(skiplist, (Node){
+            .item = bottom_item,
+            .next = updates[i],
+            .down = temp,
+        });
+
+        if (NULL == raised) { // err handling: the list is left as it was
+            while (temp != column) {
+                Node *below = temp->down;
+                node_shallow_del(skiplist, temp);
+                temp = below;
+            }
+            free(updates);
+            return NULL;
+        }
+        temp = raised;
+    }
+    back_set(skiplist, new_bottom, NULL);
+
+    // Setting new top
+    sentinel = skiplist->top;
+    skiplist->top = temp;
+
+    // Deleting the old first
+    while (sentinel) {
+        temp = sentinel->down;
+        node_shallow_del(skiplist, sentinel);
+        sentinel = temp;
+    }
+
+    // Trimming the skiplist: it might be taller than needed.
+    skiplist_trim(skiplist);
+
+    // Cleanup and exit
+    skiplist->length--;
+    free(updates);
+    return return_item;
+}
+
+/**
+ * @brief Checks if all the nodes in a column is are valid.
+ *
+ * @param n a pointer to the node.
+ * @return _Bool \c 1 if the column is valid, \c 0 if it contains one o more
+ * detectable errors.
+ */
+static _Bool valid_column(Node *n) {
+    Node *sentinel = n;
+    if (sentinel)
+        while (sentinel->down) {
+            if (sentinel->down->item != sentinel->item) return 0;
+            sentinel = sentinel->down;
+        }
+    return 1;
+}
+/**
+ * @brief Runs fn once per segment of a bottom-up build, on the pool if there
+ * is one, and waits for all of them.
+ *
+ * @param pool the workers, or NULL.
+ * @param seg the segments.
+ * @param segs number of segments.
+ * @param fn the task.
+ */
+static void build_run(ThreadPool *pool, build_segment_t *seg, size_t segs,
+                      void (*fn)(void *)) {
+    for (size_t i = 0; i < segs; i++)
+        if (NULL == pool || SUCCESS != threadpool_submit(pool, fn, &seg[i]))
+            fn(&seg[i]); // err handling: do it ourselves
+    threadpool_wait(pool);
+}
+
+/**
+ * @brief Draws the tower height of every item of a segment.
+ *
+ * @param arg ptr to a build_segment_t.
+ */
+static void build_heights_run(void *arg) {
+    build_segment_t *seg = (build_segment_t *)arg;
+
+    int max = (int)seg->max_height;
+
+    seg->height = 1;
+    for (size_t i = 0; i < seg->count; i++) {
+        int h = 1 + geometric_dist_test_r(seg->prob, max - 1, &seg->seed);
+        seg->heights[i] = (unsigned char)h;
+        if ((size_t)h > seg->height) seg->height = h;
+    }
+}
+
+/**
+ * @brief Builds the columns of a segment and links them on every lane.
+ *
+ * @param arg ptr to a build_segment_t.
+ */
+static void build_lanes_run(void *arg) {
+    build_segment_t *seg = (build_segment_t *)arg;
+    seg->status = SUCCESS;
+
+    for (size_t i = 0; i < seg->count; i++) {
+        Node *below = NULL;
+        for (size_t lv = 0; lv < seg->heights[i]; lv++) {
+            Node *node =
+                node_new(NULL, (Node){.item = seg->items[i], .down = below});
+            if (NULL == node) { // err handling
+                seg->status = ALLOC_ERR;
+                return;
+            }
+            seg->nodes++;
+
+            // Link right away, so the node is reachable for the cleanup
+            if (seg->last[lv]) seg->last[lv]->next = node;
+            else seg->first[lv] = node;
+            seg->last[lv] = node;
+            below = node;
+        }
+    }
+}
+
+/**
+ * @brief Counts a lookup of the word whose tower top was found on lane lv
+ * (0 is the top lane) and moves the tower one lane towards the height the
+ * word deserves: the taller of its drawn height and the one its popularity
+ * asks for, never taller than the list.
+ *
+ * @param skiplist ptr to the skiplist.
+ * @param trace the node before the tower on every lane down to lv.
+ * @param lv lane of the top of the tower.
+ * @param hash hash of the word.
+ */
+static void skiplist_adapt(SkipList *skiplist, Node **trace, size_t lv,
+                           uint64_t hash) {
+    uint32_t hits = freqsketch_touch(skiplist->freq, hash);
+
+    size_t h = skiplist->height;
+    size_t height = h - lv;
+    double prob = skiplist->config.prob;
+    size_t target = drawn_height(hash, h, prob);
+    size_t hot = hits < ADAPT_MIN_HITS
+                     ? 0
+                     : deserved_height(hits, freqsketch_total(skiplist->freq),
+                                       skiplist->length, prob);
+    if (hot > target) target = hot < h ? hot : h;
+
+    Node *tower = trace[lv]->next;
+    if (target > height) { // promote: lv > 0, as the tower is not full height
+        Node *node = node_new(skiplist, (Node){
+            .item = tower->item,
+            .next = trace[lv - 1]->next,
+            .down = tower,
+        });
+        if (node) trace[lv - 1]->next = node;
+        // NOTE (b): a failed promotion is simply retried on a later lookup.
+    } else if (target < height) { // demote: height > 1, there is a node below
+        trace[lv]->next = tower->next;
+        node_shallow_del(skiplist, tower);
+        skiplist_trim(skiplist);
+    }
+}
+
+/**
+ * @brief The height the insertion coin flips would give a word, drawn from
+ * its hash instead, so it is the same every time.
+ *
+ * @param hash hash of the word.
+ * @param max the height of the list.
+ * @param prob p of the list.
+ * @return size_t a height in [1, max].
+ */
+static size_t drawn_height(uint64_t hash, size_t max, double prob) {
+    unsigned int seed = (unsigned int)(hash ^ hash >> 32) | 1u;
+    int cap = max > 1 ? (int)(max - 1) : 0;
+    return 1 + geometric_dist_test_r(prob, cap, &seed);
+}
+
+/**
+ * @brief The lowest lane with about 1 / share nodes, where share is the part
+ * of the lookups that went to a word. Lane L holds length * p^(L - 1) nodes.
+ *
+ * @param hits estimated lookups of the word.
+ * @param total lookups counted.
+ * @param length number of items.
+ * @param prob p of the list.
+ * @return size_t the height, or 0 if the word is not popular at all.
+ */
+static size_t deserved_height(uint32_t hits, size_t total, size_t length,
+                              double prob) {
+    if (total < ADAPT_WARMUP) return 0; // a few early lookups prove nothing
+
+    double nodes = (double)length * hits / total; // of the lane, times share
+    size_t height = 0;
+    for (; nodes >= 1; nodes *= prob) height++;
+    return height;
+}
+
+/**
+ * @brief Counts the nodes between two nodes of the same lane, up to one more
+ * than DET_MAX_GAP.
+ *
+ * @param from the node before the gap.
+ * @param until the node after the gap, or NULL for the end of the lane.
+ * @return size_t the nodes strictly between them, at most DET_MAX_GAP + 1.
+ */
+static size_t gap_size(Node *from, Node *until) {
+    size_t size = 0;
+    for (Node *n = from->next; n != until && size <= DET_MAX_GAP; n = n->next)
+        size++;
+    return size;
+}
+
+/**
+ * @brief Splits the gap below sentinel if it is full, by raising its middle
+ * node to the lane of sentinel, so an insertion under it can not overfill it.
+ *
+ * @param skiplist ptr to the skiplist of sentinel.
+ * @param sentinel a node of a fast lane.
+ * @return Node* the raised node, or NULL if nothing was raised.
+ *
+ * @note if the node can not be allocated the gap is left as it is: one
+ * insertion longer than DET_MAX_GAP, the list is still valid.
+ */
+static Node *lane_split(SkipList *skiplist, Node *sentinel) {
+    Node *until = sentinel->next ? sentinel->next->down : NULL;
+    if (gap_size(sentinel->down, until) < DET_MAX_GAP) return NULL;
+
+    Node *middle = sentinel->down->next->next;
+    Node *node = node_new(skiplist, (Node){
+        .item = middle->item,
+        .next = sentinel->next,
+        .down = middle,
+    });
+    if (node) sentinel->next = node;
+    return node;
+}
+
+/**
+ * @brief Makes the gap below sentinel hold 2 nodes at least, so a removal
+ * under it can not empty it.
+ *
+ * A gap of 1 node takes the node that closes it on the right down to its
+ * lane and, if the gap after that node had more than one, raises the first
+ * of them in exchange (a borrow); otherwise both gaps merge into one of 3.
+ * When the node on the right is the last of its lane or is taller (it closes
+ * the gap of the lane above), the gap on the left is used instead: sentinel
+ * itself comes down.
+ *
+ * @param skiplist ptr to the skiplist of sentinel.
+ * @param sentinel the last node of a fast lane before the searched item.
+ * @param prev the node before sentinel on its lane, or NULL if sentinel is
+ * the one the descent came down to.
+ * @param above the node the descent came down from, or NULL on the top lane.
+ * @return Node* the last node before the searched item after the change.
+ *
+ * @note the node raised by a borrow is allocated before the lowered one is
+ * freed; if it can not be, the gaps merge instead, a bit wider than
+ * DET_MAX_GAP.
+ */
+static Node *lane_widen(SkipList *skiplist, Node *sentinel, Node *prev,
+                        Node *above) {
+    Node *right = sentinel->next;
+    if (gap_size(sentinel->down, right ? right->down : NULL) >= 2)
+        return sentinel;
+
+    _Bool right_is_tall = right && above && above->next &&
+                          above->next->down == right;
+
+    // Borrow from or merge with the gap on the right
+    if (right && !right_is_tall) {
+        Node *until = right->next ? right->next->down : NULL;
+        Node *raised = NULL;
+        if (gap_size(right->down, until) >= 2)
+            raised = node_new(skiplist, (Node){
+                .item = right->down->next->item,
+                .next = right->next,
+                .down = right->down->next,
+            });
+        sentinel->next = raised ? raised : right->next;
+        node_shallow_del(skiplist, right);
+        return sentinel;
+    }
+
+    // Borrow from or merge with the gap on the left
+    // NOTE (b): on a valid list prev is only NULL if the gap above has a
+    // single node, which the lane above did not allow.
+    if (NULL == prev) return sentinel;
+
+    Node *last = prev->down;
+    while (last->next != sentinel->down) last = last->next;
+
+    Node *raised = NULL;
+    if (gap_size(prev->down, sentinel->down) >= 2)
+        raised = node_new(skiplist, (Node){
+            .item = last->item,
+            .next = sentinel->next,
+            .down = last,
+        });
+    prev->next = raised ? raised : sentinel->next;
+    node_shallow_del(skiplist, sentinel);
+    return raised ? raised : prev;
+}
+
+/**
+ * @brief Inserts an item in a non-empty deterministic list, top-down: every
+ * full gap met on the way is split, so the main lane node lands in a gap
+ * with room for it.
+ *
+ * @param skiplist ptr to the skiplist, with the deterministic mode.
+ * @param item ptr to the item, not in the list yet.
+ * @return status_t \c SUCCESS or \c ALLOC_ERR.
+ */
+static status_t skiplist_det_insert(SkipList *skiplist, Item *item) {
+    // A new first item takes over the head column, the old one is inserted
+    if (item_cmp(skiplist->top->item, item) > 0) {
+        Item *first = skiplist->top->item;
+        for (Node *n = skiplist->top; n; n = n->down) n->item = item;
+
+        status_t flag = skiplist_det_insert(skiplist, first);
+        if (SUCCESS != flag) // err handling: give the head back
+            for (Node *n = skiplist->top; n; n = n->down) n->item = first;
+        return flag;
+    }
+
+    // A full top lane gets a new lane above it, whose only gap is split below
+    if (gap_size(skiplist->top, NULL) >= DET_MAX_GAP) {
+        Node *top = node_new(skiplist, (Node){
+            .item = skiplist->top->item,
+            .down = skiplist->top,
+        });
+        if (top) {
+            skiplist->top = top;
+            skiplist->height++;
+        }
+        // NOTE (b): a failure here only makes the top lane one node longer.
+    }
+
+    Node *sentinel = fastlane_search(skiplist->top, item);
+    while (sentinel->down) {
+        Node *raised = lane_split(skiplist, sentinel);
+        if (raised && item_cmp(raised->item, item) < 0) sentinel = raised;
+        sentinel = fastlane_search(sentinel->down, item);
+    }
+
+    Node *node =
+        bottom_new(skiplist, (Node){.item = item, .next = sentinel->next});
+    if (NULL == node) return ALLOC_ERR; // err handling: the splits are harmless
+    sentinel->next = node;
+    back_set(skiplist, node, sentinel);
+    back_set(skiplist, node->next, node);
+
+    skiplist->length++;
+    return SUCCESS;
+}
+
+/**
+ * @brief Removes an item other than the first from a deterministic list,
+ * top-down: every gap entered on the way is widened to 2 nodes first (see
+ * lane_widen()), so the one the item leaves keeps 1 at least.
+ *
+ * If the item has a tall column, the column stays and takes the item just
+ * before it on the main lane, whose single node is the one unlinked.
+ *
+ * @param skiplist ptr to the skiplist, with the deterministic mode.
+ * @param item ptr to an item with the key to remove.
+ * @return Item* the removed item, WITH OWNERSHIP, or NULL if not found.
+ */
+static Item *skiplist_det_remove(SkipList *skiplist, const Item *item) {
+    skiplist_trim(skiplist);
+
+    Node *sentinel = skiplist->top;
+    Node *above = NULL; // the node the descent came down from
+    Node *tower = NULL; // the top of the column of the item, if it is tall
+    while (sentinel->down) {
+        Node *prev = NULL;
+        int cmp = 1;
+        while (sentinel->next &&
+               (cmp = item_cmp(sentinel->next->item, item)) < 0) {
+            prev = sentinel;
+            sentinel = sentinel->next;
+        }
+        Item *found = 0 == cmp ? sentinel->next->item : NULL;
+
+        sentinel = lane_widen(skiplist, sentinel, prev, above);
+        if (NULL == tower && found && sentinel->next &&
+            found == sentinel->next->item)
+            tower = sentinel->next;
+
+        above = sentinel;
+        sentinel = sentinel->down;
+    }
+
+    // Main lane
+    Node *prev = NULL;
+    int cmp = 1;
+    while (sentinel->next && (cmp = item_cmp(sentinel->next->item, item)) < 0) {
+        prev = sentinel;
+        sentinel = sentinel->next;
+    }
+    if (0 != cmp || (tower && NULL == prev)) return NULL; // err handling
+
+    Node *victim = sentinel->next;
+    Item *result = victim->item;
+    if (NULL == tower) {
+        sentinel->next = victim->next;
+        back_set(skiplist, victim->next, sentinel);
+        node_shallow_del(skiplist, victim);
+    } else {
+        for (Node *n = tower; n; n = n->down) n->item = sentinel->item;
+        prev->next = victim;
+        back_set(skiplist, victim, prev);
+        node_shallow_del(skiplist, sentinel);
+    }
+
+    skiplist->length--;
+    skiplist_trim(skiplist);
+    return result;
+}
+
+/**
+ * @brief Removes the first item of a deterministic list: the second one
+ * leaves its place (see skiplist_det_remove()) and takes over the head
+ * column.
+ *
+ * @param skiplist ptr to the non-empty skiplist.
+ * @return Item* the removed item, WITH OWNERSHIP, or NULL on error.
+ */
+static Item *skiplist_det_pop_front(SkipList *skiplist) {
+    Node *bottom = skiplist->top;
+    while (bottom->down) bottom = bottom->down;
+    if (NULL == bottom->next) return skiplist_raw_pop_front(skiplist);
+
+    Item *first = skiplist->top->item;
+    Item *second = skiplist_det_remove(skiplist, bottom->next->item);
+    if (NULL == second) return NULL; // err handling
+
+    for (Node *n = skiplist->top; n; n = n->down) n->item = second;
+    return first;
+}
 
+/**
+ * @brief Rebuilds the fast lanes from the main lane with balanced towers,
+ * the i-th item rising one lane per factor 2 of i, and makes the list
+ * deterministic: every gap holds a single node.
+ *
+ * @param skiplist ptr to the skiplist.
+ * @return status_t \c SUCCESS or \c ALLOC_ERR, in which case the list keeps
+ * its mode and the lanes built so far, which are still valid.
+ */
+static status_t skiplist_relane(SkipList *skiplist) {
+    Node *bottom = skiplist_drop_lanes(skiplist);
+    if (NULL == bottom) {
+        skiplist->config.mode = SKIPLIST_DETERMINISTIC;
+        return SUCCESS;
+    }
+
+    // Lowest height whose top lane holds at most DET_MAX_GAP nodes
+    // besides the head
+    size_t h = 1;
+    while (((skiplist->length - 1) >> (h - 1)) > DET_MAX_GAP) h++;
+
+    Node *last[BUILD_MAX_HEIGHT]; // last node of every lane
+    if (SUCCESS != skiplist_raise_head(skiplist, h, last)) return ALLOC_ERR;
+
+    // Every 2^lv-th node rises to lane lv, but for the last one: it would
+    // end the lane with an empty gap below it
+    size_t i = 1;
+    for (Node *car = bottom->next; car; car = car->next, i++) {
+        Node *below = car;
+        for (size_t lv = 1; lv < h && 0 == i % ((size_t)1 << lv) &&
+                            i + ((size_t)1 << lv) <= skiplist->length;
+             lv++) {
+            Node *node = node_new(skiplist, (Node){.item = car->item, .down = below});
+            if (NULL == node) return ALLOC_ERR; // err handling
+            last[lv] = last[lv]->next = node;
+            below = node;
+        }
+    }
+
+    skiplist->config.mode = SKIPLIST_DETERMINISTIC;
     return SUCCESS;
 }
 
-// Temporary disable the "-Wunused-parameter" warning.
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wunused-parameter"
+/**
+ * @brief Frees every fast lane of the skiplist, which keeps its main lane.
+ *
+ * @param skiplist ptr to the skiplist.
+ * @return Node* the head of the main lane, now the top, or NULL if the list
+ * is empty.
+ */
+static Node *skiplist_drop_lanes(SkipList *skiplist) {
+    Node *bottom = skiplist->top;
+    if (NULL == bottom) return NULL;
 
-_Bool skiplist_is_full(const SkipList *skiplist) {
-    // clang-format off
-    #ifdef SKIPLIST_MAX_LENGTH
-        return skiplist ? SKIPLIST_MAX_LENGTH <= skiplist->length : 0;
-    #else
-        return 0;
-    #endif // SKIPLIST_MAX_LENGTH
-    // clang-format on
+    while (bottom->down) {
+        Node *temp = bottom->down;
+        for (Node *car = bottom; car;) {
+            Node *temp_car = car->next;
+            node_shallow_del(skiplist, car);
+            car = temp_car;
+        }
+        bottom = temp;
+    }
+    skiplist->top = bottom;
+    skiplist->height = 1;
+    return bottom;
 }
 
-// restoring the diagnostic stack to its previous state.
-#pragma GCC diagnostic pop
+/**
+ * @brief Raises the head column of a list with a single lane to height h.
+ * It goes first, so a failure later on leaves every lane reachable.
+ *
+ * @param skiplist ptr to the skiplist, with its main lane only.
+ * @param h the new height, at most BUILD_MAX_HEIGHT.
+ * @param last output, the last node of every lane: the head column.
+ * @return status_t \c SUCCESS or \c ALLOC_ERR, in which case the column is
+ * as tall as it could be made.
+ */
+static status_t skiplist_raise_head(SkipList *skiplist, size_t h,
+                                    Node **last) {
+    Node *bottom = skiplist->top;
+    last[0] = bottom;
+    for (size_t lv = 1; lv < h; lv++) {
+        Node *node = node_new(skiplist, (Node){.item = bottom->item, .down = last[lv - 1]});
+        if (NULL == node) return ALLOC_ERR; // err handling
+        last[lv] = skiplist->top = node;
+        skiplist->height++;
+    }
+    return SUCCESS;
+}
 
-_Bool skiplist_is_empty(const SkipList *skiplist) {
-    return skiplist ? skiplist->length <= 0 : 0;
+/**
+ * @brief Draws the height of a tower for skiplist_reshape(): from the word
+ * hash in the adaptive mode (see drawn_height()), by flipping coins
+ * otherwise.
+ *
+ * @param skiplist ptr to the skiplist.
+ * @param item the item of the tower.
+ * @param max the tallest height allowed.
+ * @return size_t a height in [1, max].
+ */
+static size_t tower_height(SkipList *skiplist, Item *item, size_t max) {
+    double prob = skiplist->config.prob;
+    if (skiplist->freq) return drawn_height(item_hash(item), max, prob);
+    return 1 + geometric_dist_test_r(prob, (int)max - 1, &skiplist->seed);
 }
 
-size_t skiplist_length(const SkipList *skiplist) {
-    return skiplist ? skiplist->length : 0;
+/**
+ * @brief Counts an operation and runs the background work it pays for: the
+ * expiry of the items due (see skiplist_insert_ttl()), the auto-tuning of
+ * skiplist_new_with_config() and a bounded step of the running rebalance,
+ * if any (see skiplist_rebalance()). With \c rebalance,
+ * a new one starts once the insertions and removals since the last one
+ * reach REBALANCE_DRIFT of the length.
+ *
+ * @param skiplist ptr to the skiplist.
+ * @param write \c 1 for an insertion or removal, \c 0 for a lookup.
+ */
+static void skiplist_maintain(SkipList *skiplist, _Bool write) {
+    if (skiplist->wheel) skiplist_expire(skiplist);
+
+    // A write drops the frozen index; a long enough run of lookups pays for
+    // another one. If it cannot be built, the next run tries again.
+    if (write) {
+        skiplist_thaw(skiplist);
+        skiplist->streak = 0;
+    } else if (skiplist->config.freeze && NULL == skiplist->frozen &&
+               ++skiplist->streak >= SKIPLIST_FREEZE_READS &&
+               skiplist->streak >= skiplist->length) {
+        skiplist_freeze(skiplist);
+    }
+    if (SKIPLIST_DETERMINISTIC == skiplist->config.mode) return;
+
+    _Bool start = 0;
+    if (write) skiplist->drift++;
+    if (skiplist->config.auto_tune) {
+        if (write) skiplist->writes++;
+        else skiplist->reads++;
+        start = skiplist_autotune(skiplist);
+    }
+    if (skiplist->config.rebalance && skiplist->drift >= TUNE_MIN_OPS &&
+        skiplist->drift >= REBALANCE_DRIFT * skiplist->length)
+        start = 1;
+
+    if (start || skiplist->balance_height)
+        skiplist_rebalance(skiplist, REBALANCE_STEP);
 }
 
-size_t skiplist_height(const SkipList *skiplist) {
-    return skiplist ? skiplist->height : 0;
+/**
+ * @brief Once an auto-tuned list has seen about as many operations as it
+ * holds items, picks its p and max height again from the share of lookups
+ * and its length (see skiplist_new_with_config()).
+ *
+ * @param skiplist ptr to the skiplist.
+ * @return _Bool \c 1 if the towers no longer fit the new shape and need a
+ * rebalance, \c 0 otherwise.
+ */
+static _Bool skiplist_autotune(SkipList *skiplist) {
+    size_t ops = skiplist->reads + skiplist->writes;
+    if (ops < TUNE_MIN_OPS || ops < skiplist->length) return 0;
+
+    double reads = (double)skiplist->reads / ops;
+    skiplist->reads = skiplist->writes = 0;
+
+    double prob = skiplist->config.prob;
+    if (reads >= TUNE_READ_HEAVY) prob = TUNE_PROB_READS;
+    else if (reads <= TUNE_WRITE_HEAVY) prob = TUNE_PROB_WRITES;
+
+    // Room for twice the length, which the next tuning comes before
+    size_t max_height = 1;
+    for (double nodes = 2.0 * skiplist->length; nodes >= 1; nodes *= prob)
+        max_height++;
+
+    _Bool changed =
+        prob != skiplist->config.prob || max_height < skiplist->height;
+    skiplist->config.prob = prob;
+    skiplist->config.max_height = max_height;
+    return changed;
 }
 
-//=============================================================================/
-//=================|    Private Function Implementations    |==================/
-//=============================================================================/
+/**
+ * @brief The height of the column at a position of the main lane in an
+ * ideal list, where every base-th node of a lane rises to the next one.
+ *
+ * @param pos the position, from 1 (the head column is 0).
+ * @param base the inverse of p, rounded.
+ * @param max the tallest height allowed.
+ * @return size_t a height in [1, max].
+ */
+static size_t ideal_height(size_t pos, size_t base, size_t max) {
+    size_t height = 1;
+    for (; height < max && 0 == pos % base; pos /= base) height++;
+    return height;
+}
 
 /**
- * @brief Creates a heap allocated skiplist node based on a stack allocated skip
- * list.
+ * @brief Checks the 1-2-3 invariant of a deterministic list.
  *
- * @param base a stack allocated node that will be copied into the heap.
- * @return Node* ptr to the heap allocated node, WITH OWNERSHIP, or NULL on
- * error.
+ * @param skiplist ptr to the skiplist.
+ * @return _Bool \c 1 if every gap holds 1 to DET_MAX_GAP nodes and the top
+ * lane at most DET_MAX_GAP besides the head, \c 0 otherwise.
  */
-static Node *node_new(const Node base) {
-    Node *n = (Node *)malloc(sizeof(Node)); // mem alloc
-    if (n) *n = base;                       // if no error, init
-    return n;                               // return ptr, might be null
+static _Bool valid_gaps(const SkipList *skiplist) {
+    Node *top = skiplist->top;
+    if (NULL == top) return 1;
+    if (gap_size(top, NULL) > DET_MAX_GAP) return 0;
+
+    for (Node *lane = top; lane->down; lane = lane->down)
+        for (Node *x = lane; x; x = x->next) {
+            size_t gap = gap_size(x->down, x->next ? x->next->down : NULL);
+            if (gap < 1 || gap > DET_MAX_GAP) return 0;
+        }
+    return 1;
 }
 
 /**
- * @brief frees the memory used to store a node on the heap without freeing
- the
- *  memory used to store the node contents.
- * @warning if item is not freed elsewhere, this function will cause a memory
- *  leak.
+ * @brief Puts item in the column of the tombstone with the same word, if
+ * there is one, and frees the tombstone.
  *
- * @param node
+ * @param skiplist ptr to the skiplist.
+ * @param item ptr to the item, whose word is not alive in the list.
+ * @return status_t \c SUCCESS, or \c NOT_FOUND_ERR if no tombstone has the
+ * word.
+ */
+static status_t skiplist_revive(SkipList *skiplist, Item *item) {
+    Item *old = column_swap(skiplist, item);
+    if (NULL == old) return NOT_FOUND_ERR;
+
+    item_del(&old);
+    skiplist->dead--;
+    skiplist_indexes_add(skiplist, item);
+    return SUCCESS;
+}
+
+/**
+ * @brief Puts an item in the column of the item of its word, found from the
+ * top lane down as a search does. Nothing else changes: the caller keeps the
+ * counts, the index and the timers.
+ *
+ * @param skiplist ptr to the skiplist.
+ * @param item ptr to the item.
+ * @return Item* the item taken out of the column, WITH OWNERSHIP, or NULL if
+ * no column has the word.
+ */
+static Item *column_swap(SkipList *skiplist, Item *item) {
+    Node *sentinel = skiplist->top;
+    Item *old = NULL;
+
+    if (0 == item_cmp(sentinel->item, item)) { // the head column
+        old = sentinel->item;
+        for (; sentinel; sentinel = sentinel->down) sentinel->item = item;
+    }
+
+    // Down to the top of the column, then along it
+    for (; sentinel; sentinel = sentinel->down) {
+        if (NULL == old) {
+            int cmp = 1;
+            while (sentinel->next &&
+                   (cmp = item_cmp(sentinel->next->item, item)) < 0)
+                sentinel = sentinel->next;
+            if (0 != cmp) continue;
+            old = sentinel->next->item;
+        } else {
+            while (sentinel->next->item != old) sentinel = sentinel->next;
+        }
+        sentinel->next->item = item;
+    }
+
+    return old;
+}
+
+/**
+ * @brief Moves a trace to a word after the one it was made for: it climbs
+ * while the lane above can still move forward, then descends from there, so
+ * a word d columns after the last one costs O(log d) instead of a search.
+ *
+ * @param skiplist ptr to the skiplist.
+ * @param trace a trace of the list, see skiplist_raw_trace(), with room for
+ * its height. Only read when fresh is not set, and then it must not have
+ * been made for a word after item.
+ * @param fresh \c 1 to make the trace from the top lane instead.
+ * @param item ptr to an item with the word.
+ * @return Item* the item of the word in the list, gone or not, or NULL.
+ */
+static Item *trace_seek(const SkipList *skiplist, Node **trace, _Bool fresh,
+                        const Item *item) {
+    Node *sentinel = skiplist->top;
+    if (NULL == sentinel) return NULL;
+
+    // Up while the lane above moves forward: the lanes over it stay
+    size_t h = skiplist->height, lv = 0;
+    if (!fresh) {
+        lv = h - 1;
+        while (lv > 0 && trace[lv - 1]->next &&
+               item_cmp(trace[lv - 1]->next->item, item) < 0)
+            lv--;
+        sentinel = trace[lv];
+    }
+
+    // Then down, as a search
+    for (;; lv++, sentinel = sentinel->down) {
+        while (sentinel->next && item_cmp(sentinel->next->item, item) < 0)
+            sentinel = sentinel->next;
+        trace[lv] = sentinel;
+        if (NULL == sentinel->down) break;
+    }
+
+    if (0 == item_cmp(skiplist->top->item, item)) return skiplist->top->item;
+    Node *next = trace[h - 1]->next;
+    return next && 0 == item_cmp(next->item, item) ? next->item : NULL;
+}
+
+/**
+ * @brief Orders the ops of a batch by word, and those of a word in batch
+ * order, which is the order of their addresses.
+ */
+static int op_cmp(const void *a, const void *b) {
+    const skiplist_op_t *x = *(skiplist_op_t *const *)a;
+    const skiplist_op_t *y = *(skiplist_op_t *const *)b;
+    int cmp = item_cmp(x->item, y->item);
+    if (cmp) return cmp;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Sorts a batch by word and plays it against the list without a
+ * change: the words are found in one left-to-right sweep of a single trace,
+ * and the ops of each word run on what the ones before them leave.
+ *
+ * @param skiplist ptr to the skiplist.
+ * @param ops the batch. Each op gets its status and a NULL result.
+ * @param n number of ops.
+ * @param plan output, to free with commit_plan_free() whatever the result.
+ * @return status_t \c SUCCESS, \c NUL_ERR if an op has no item, \c ALLOC_ERR,
+ * \c ARR_IS_FULL_ERR if the list can not take the new words, or the status
+ * of the first op that fails, by word.
+ */
+static status_t commit_plan(const SkipList *skiplist, skiplist_op_t *ops,
+                            size_t n, commit_plan_t *plan) {
+    size_t lanes = skiplist->height ? skiplist->height : 1;
+    *plan = (commit_plan_t){
+        .order = (skiplist_op_t **)malloc((n ? n : 1) *
+                                          sizeof(skiplist_op_t *)),
+        .words = (commit_word_t *)malloc((n ? n : 1) * sizeof(commit_word_t)),
+        .trace = (Node **)calloc(lanes, sizeof(Node *)),
+        .lanes = lanes,
+    };
+    if (NULL == plan->order || NULL == plan->words || NULL == plan->trace)
+        return ALLOC_ERR; // err handling
+
+    // PART 1: sorting
+    for (size_t i = 0; i < n; i++) {
+        if (NULL == ops[i].item) return NUL_ERR; // err handling
+        ops[i].result = NULL;
+        ops[i].status = SUCCESS;
+        plan->order[i] = &ops[i];
+    }
+    qsort(plan->order, n, sizeof(skiplist_op_t *), op_cmp);
+
+    // PART 2: the sweep, word by word
+    status_t flag = SUCCESS;
+    for (size_t i = 0; SUCCESS == flag && i < n;) {
+        const Item *key = plan->order[i]->item;
+        Item *raw = trace_seek(skiplist, plan->trace, 0 == i, key);
+
+        commit_word_t *word = &plan->words[plan->count++];
+        *word = (commit_word_t){
+            .ops = plan->order + i,
+            .raw = raw,
+            .alive = raw && !item_gone(skiplist, raw),
+        };
+
+        Item *cur = word->alive ? raw : NULL;
+        for (; i < n && 0 == item_cmp(plan->order[i]->item, key); i++) {
+            skiplist_op_t *op = plan->order[i];
+            word->count++;
+            switch (op->kind) {
+            case SKIPLIST_INSERT:
+                if (cur) op->status = REPEATED_ENTRY_ERR;
+                else cur = op->item;
+                break;
+            case SKIPLIST_UPDATE:
+                if (NULL == cur) op->status = NOT_FOUND_ERR;
+                break;
+            case SKIPLIST_REMOVE:
+                if (NULL == cur) op->status = NOT_FOUND_ERR;
+                cur = NULL;
+                break;
+            default:
+                op->status = CRITICAL_ERR;
+            }
+            if (SUCCESS != op->status) {
+                flag = op->status;
+                break;
+            }
+        }
+
+        word->last = cur;
+        if (cur && NULL == raw) plan->links++;
+        if (word->alive && NULL == cur) plan->unlinks++;
+    }
+
+    // PART 3: the room, as if every removal ran first
+    if (SUCCESS == flag && plan->links > plan->unlinks &&
+        skiplist_full_at(skiplist, skiplist->length + plan->links -
+                                       plan->unlinks - 1))
+        flag = ARR_IS_FULL_ERR;
+
+    return flag;
+}
+
+/**
+ * @brief Frees what commit_plan() allocated.
+ */
+static void commit_plan_free(commit_plan_t *plan) {
+    free(plan->order);
+    free(plan->words);
+    free(plan->trace);
+    *plan = (commit_plan_t){0};
+}
+
+/**
+ * @brief Changes the column of a word as its ops ask: a new column for a word
+ * that had none, the item of the batch in the column of one that had an
+ * item (removed and inserted again, or gone), or no column for a removed
+ * word. Updates alone change nothing here, see commit_results().
+ *
+ * @param skiplist ptr to the skiplist, with room in its index.
+ * @param word ptr to the word, see commit_plan().
+ * @param trace the trace of the sweep, with room for the height of the list.
+ * @param fresh in and out, \c 1 if the trace must be made again first.
+ * @return status_t \c SUCCESS or \c ALLOC_ERR, in which case nothing changed.
+ */
+static status_t commit_word(SkipList *skiplist, commit_word_t *word,
+                            Node **trace, _Bool *fresh) {
+    Item *raw = word->raw, *last = word->last;
+    if (last == raw || (NULL == last && !word->alive)) return SUCCESS;
+
+    size_t height = skiplist->height;
+    _Bool own_path = SKIPLIST_DETERMINISTIC == skiplist->config.mode ||
+                     NULL == skiplist->top ||
+                     item_cmp(skiplist->top->item, raw ? raw : last) >= 0;
+
+    // PART 1: a removed word
+    if (NULL == last) {
+        Item *removed = NULL;
+        if (own_path) removed = skiplist_unlink(skiplist, raw);
+        else {
+            trace_seek(skiplist, trace, *fresh, raw);
+            removed = skiplist_unlink_at(skiplist, trace);
+        }
+        if (NULL == removed) return ALLOC_ERR; // err handling
+
+        *fresh = own_path || height != skiplist->height;
+        word->done = 1;
+        return SUCCESS;
+    }
+
+    // PART 2: the item of the batch, scheduled if it expires
+    uint32_t ttl = skiplist->config.ttl;
+    if (ttl && 0 == item_expiry(last))
+        item_set_expiry(last, skiplist_deadline(skiplist, ttl));
+    if (item_expiry(last) &&
+        (SUCCESS != skiplist_timers_start(skiplist) ||
+         SUCCESS != timerwheel_add(skiplist->wheel, last)))
+        return ALLOC_ERR; // err handling
+
+    // PART 3: in the column of the old item, which can not fail
+    if (raw) {
+        column_swap(skiplist, last);
+        timerwheel_cancel(skiplist->wheel, raw);
+        if (item_is_tombstone(raw)) skiplist->dead--;
+        skiplist_indexes_add(skiplist, last);
+        word->done = 1;
+        return SUCCESS;
+    }
+
+    // PART 4: or in a new column
+    status_t flag = SUCCESS;
+    if (own_path) flag = skiplist_link(skiplist, last);
+    else {
+        trace_seek(skiplist, trace, *fresh, last);
+        flag = skiplist_link_at(skiplist, trace, last);
+    }
+    if (SUCCESS != flag) { // err handling: a trace or a node, memory either way
+        timerwheel_cancel(skiplist->wheel, last);
+        return ALLOC_ERR;
+    }
+
+    *fresh = own_path || height != skiplist->height;
+    word->done = 1;
+    return SUCCESS;
+}
+
+/**
+ * @brief Undoes commit_word(), for a batch that fails.
+ *
+ * @param skiplist ptr to the skiplist.
+ * @param word ptr to the word.
+ * @return status_t \c SUCCESS, or \c CRITICAL_ERR if the list could not take
+ * its old item back.
+ */
+static status_t commit_undo(SkipList *skiplist, commit_word_t *word) {
+    if (!word->done) return SUCCESS;
+    word->done = 0;
+
+    Item *raw = word->raw, *last = word->last;
+
+    // A new column goes, with the item of the batch
+    if (NULL == raw) {
+        Item *removed = skiplist_unlink(skiplist, last);
+        return removed ? SUCCESS : CRITICAL_ERR;
+    }
+
+    // The old item comes back, and its timer with it
+    if (last) {
+        column_swap(skiplist, raw);
+        skiplist_indexes_drop(skiplist, last);
+        if (item_is_tombstone(raw)) skiplist->dead++;
+        else hashindex_put(skiplist->index, raw); // reserved, can not fail
+    } else if (SUCCESS != skiplist_link(skiplist, raw)) {
+        return CRITICAL_ERR;
+    }
+
+    if (skiplist->wheel && item_expiry(raw) && !item_is_tombstone(raw) &&
+        SUCCESS != timerwheel_add(skiplist->wheel, raw))
+        return CRITICAL_ERR;
+    return SUCCESS;
+}
+
+/**
+ * @brief Runs the ops of a word on the items again, once the columns are in
+ * place: updates write the item they reach and removals hand it over.
+ * The gone item a column dropped is freed.
+ *
+ * @param skiplist ptr to the skiplist.
+ * @param word ptr to the word.
+ */
+static void commit_results(SkipList *skiplist, commit_word_t *word) {
+    Item *cur = word->alive ? word->raw : NULL;
+    for (size_t i = 0; i < word->count; i++) {
+        skiplist_op_t *op = word->ops[i];
+        if (SKIPLIST_INSERT == op->kind) cur = op->item;
+        else if (SKIPLIST_UPDATE == op->kind) item_raw_update(cur, op->item);
+        else {
+            op->result = cur;
+            cur = NULL;
+        }
+    }
+
+    if (word->raw && !word->alive && word->last) {
+        if (!item_is_tombstone(word->raw)) skiplist->expired++;
+        skiplist_drop(skiplist, &word->raw);
+    }
+}
+
+/**
+ * @brief Turns a found item into a tombstone and, while there are too many
+ * of them, runs a compaction step (see skiplist_lazy_enable()).
+ *
+ * @param skiplist ptr to the skiplist.
+ * @param item ptr to the item, alive and in the list.
+ * @return status_t \c SUCCESS, or \c ALLOC_ERR if an open snapshot could not
+ * keep the item, which is then left alive.
+ */
+static status_t skiplist_bury(SkipList *skiplist, Item *item) {
+    if (SUCCESS != skiplist_preserve(skiplist, item)) return ALLOC_ERR;
+    item_set_tombstone(item, 1);
+    skiplist->dead++;
+    skiplist_indexes_drop(skiplist, item);
+
+    size_t limit = (size_t)(skiplist->lazy_ratio * skiplist->length);
+    if (skiplist->dead > limit) skiplist->compacting = 1;
+    if (!skiplist->compacting) return SUCCESS;
+
+    skiplist_compact(skiplist, LAZY_COMPACT_BATCH);
+    if (skiplist->dead <= limit / 2) skiplist->compacting = 0;
+    return SUCCESS;
+}
+
+/**
+ * @brief Moves the compaction cursor back to the start of the list.
+ *
+ * @param skiplist ptr to the skiplist.
+ */
+static void cursor_rewind(SkipList *skiplist) {
+    if (skiplist->cursor)
+        item_place((item_buf_t *)skiplist->cursor, "", 0, NULL, 0);
+}
+
+/**
+ * @brief The head of the main lane, or NULL if the list is empty.
+ */
+static Node *main_lane(const SkipList *skiplist) {
+    Node *sentinel = skiplist->top;
+    while (sentinel && sentinel->down) sentinel = sentinel->down;
+    return sentinel;
+}
+
+/**
+ * @brief Counts the nodes of every lane, from the head of the top one.
  */
-static void node_shallow_del(Node *node) { free(node); }
+static size_t lanes_count(const Node *top) {
+    size_t count = 0;
+    for (; top; top = top->down)
+        for (const Node *car = top; car; car = car->next) count++;
+    return count;
+}
+
+/**
+ * @brief The last item of a list that is not empty.
+ */
+static Item *last_item(const SkipList *skiplist) {
+    return last_not_after(skiplist, NULL)->item;
+}
+
+/**
+ * @brief Links the lanes of a list after the ones of another list, whose
+ * words all come before. The head column of the left list is raised to the
+ * height of the right one first, so a failure changes nothing.
+ *
+ * @param skiplist ptr to the list of the left lanes, which counts the nodes
+ * raised.
+ * @param top in and out, the head of the top lane of the left list.
+ * @param height in and out, the height of the left list.
+ * @param right the head of the top lane of the right list.
+ * @param right_height the height of the right list.
+ * @return status_t \c SUCCESS or \c ALLOC_ERR.
+ */
+static status_t lanes_join(SkipList *skiplist, Node **top, size_t *height,
+                           Node *right, size_t right_height) {
+    // PART 1: raise the head column of the left list
+    Node *head = *top;
+    for (size_t lv = *height; lv < right_height; lv++) {
+        Node *node = node_new(skiplist, (Node){.item = head->item, .down = head});
+        if (NULL == node) { // err handling: undo the new nodes
+            while (head != *top) {
+                Node *temp = head->down;
+                node_shallow_del(skiplist, head);
+                head = temp;
+            }
+            return ALLOC_ERR;
+        }
+        head = node;
+    }
+    size_t h = *height > right_height ? *height : right_height;
+
+    // PART 2: from the top, the end of every lane takes the right lane
+    Node *sentinel = head;
+    for (size_t lv = h; lv > 0; lv--, sentinel = sentinel->down) {
+        while (sentinel->next) sentinel = sentinel->next;
+        if (lv > right_height) continue;
+        sentinel->next = right;
+        right = right->down;
+    }
+
+    *top = head;
+    *height = h;
+    return SUCCESS;
+}
+
+/**
+ * @brief Moves the columns of other into the skiplist when the words of one
+ * list all come before the words of the other, in O(log n), then adds the
+ * items moved to the index, filter and timer wheel. other is emptied.
+ *
+ * @param skiplist ptr to the skiplist, whose index has room for the items.
+ * @param other ptr to the other list, not empty.
+ * @return status_t \c SUCCESS, \c ALLOC_ERR, or \c NOT_FOUND_ERR if the
+ * words interleave or the lanes can not be kept as they are: in the
+ * deterministic mode, or with tombstones the skiplist could not compact.
+ */
+static status_t skiplist_join(SkipList *skiplist, SkipList *other) {
+    if (SKIPLIST_DETERMINISTIC == skiplist->config.mode ||
+        (other->dead && NULL == skiplist->cursor))
+        return NOT_FOUND_ERR;
+
+    // PART 1: the lanes of the first list take the ones of the second
+    Node *moved = main_lane(other);
+    status_t flag = SUCCESS;
+    if (NULL == skiplist->top) {
+        skiplist->top = other->top;
+        skiplist->height = other->height;
+    } else if (item_cmp(last_item(skiplist), other->top->item) < 0) {
+        Node *end = last_not_after(skiplist, NULL);
+        flag = lanes_join(skiplist, &skiplist->top, &skiplist->height,
+                          other->top, other->height);
+        if (SUCCESS == flag) back_set(skiplist, moved, end);
+    } else if (item_cmp(last_item(other), skiplist->top->item) < 0) {
+        Node *end = last_not_after(other, NULL), *first = main_lane(skiplist);
+        Node *top = other->top;
+        size_t height = other->height;
+        flag = lanes_join(other, &top, &height, skiplist->top,
+                          skiplist->height);
+        if (SUCCESS == flag) {
+            back_set(skiplist, first, end);
+            skiplist->top = top;
+            skiplist->height = height;
+        }
+    } else {
+        return NOT_FOUND_ERR;
+    }
+    if (SUCCESS != flag) return flag; // err handling
+
+    // PART 2: the items moved are indexed, filtered and scheduled
+    _Bool rewind = 0;
+    Node *car = moved;
+    for (size_t i = 0; i < other->length; i++, car = car->next) {
+        Item *it = car->item;
+        if (item_is_tombstone(it)) continue;
+        hashindex_put(skiplist->index, it); // reserved, can not fail
+        if (skiplist->bloom) bloom_add(skiplist->bloom, item_hash(it));
+        if (skiplist->wheel && item_expiry(it) &&
+            SUCCESS != timerwheel_add(skiplist->wheel, it))
+            rewind = 1;
+    }
+    if (skiplist->bloom && bloom_is_saturated(skiplist->bloom))
+        skiplist_bloom_rebuild(skiplist, bloom_fp_rate(skiplist->bloom));
+    if (rewind) { // err handling: every item is scheduled again, if it can
+        timerwheel_del(&skiplist->wheel);
+        skiplist_timers_start(skiplist);
+    }
+
+    skiplist->length += other->length;
+    skiplist->dead += other->dead;
+    skiplist->nodes += other->nodes;
+    skiplist->balance_height = 0; // positions of a running rebalance
+
+    other->top = NULL;
+    skiplist_shallow_clear(other);
+    return SUCCESS;
+}
 
 /**
- * @brief frees the memory used to store a node and its contetns.
+ * @brief Merges the main lane of other into the one of the skiplist, in
+ * order, after dropping the fast lanes of both. The tombstones and the items
+ * that lose to the policy are freed; the index takes every item kept. other
+ * is emptied.
  *
- * @warning if item is used elsewhere after a node containing a reference to it
- * if deleted using this function, a segfault by dangling ptr access may occur.
+ * @param skiplist ptr to the skiplist, whose index has room for the items.
+ * @param other ptr to the other list.
+ * @param policy see skiplist_merge_t.
  *
- * @param node the node that will be destroyed.
+ * @note the timer wheel of the skiplist may hold freed items: it has to be
+ * built again.
  */
-static void node_deep_del(Node *node) {
-    if (node) item_del(&node->item);
-    free(node);
+static void skiplist_interleave(SkipList *skiplist, SkipList *other,
+                                skiplist_merge_t policy) {
+    Node *ours = skiplist_drop_lanes(skiplist);
+    Node *theirs = skiplist_drop_lanes(other);
+    hashindex_clear(skiplist->index);
+
+    Node head = (Node){0};
+    Node *tail = &head;
+    size_t length = 0;
+    while (ours || theirs) {
+        int cmp = NULL == ours     ? 1
+                  : NULL == theirs ? -1
+                                   : item_cmp(ours->item, theirs->item);
+
+        // The same word in both: one node stays, the other goes
+        Node *keep = cmp <= 0 ? ours : theirs, *lose = NULL;
+        if (0 == cmp) {
+            if (item_gone(skiplist, ours->item) ||
+                (SKIPLIST_KEEP_THEIRS == policy &&
+                 !item_gone(other, theirs->item)))
+                keep = theirs;
+            lose = keep == ours ? theirs : ours;
+        }
+        if (cmp <= 0) ours = ours->next;
+        if (cmp >= 0) theirs = theirs->next;
+
+        if (lose) node_deep_del(skiplist, lose);
+        if (item_is_tombstone(keep->item)) {
+            node_deep_del(skiplist, keep);
+            continue;
+        }
+
+        hashindex_put(skiplist->index, keep->item); // reserved, can not fail
+        back_set(skiplist, keep, tail == &head ? NULL : tail);
+        tail = tail->next = keep;
+        length++;
+    }
+    tail->next = NULL;
+
+    skiplist->top = head.next;
+    skiplist->height = head.next ? 1 : 0;
+    skiplist->length = length;
+    skiplist->nodes = length;
+    skiplist->dead = 0;
+    skiplist->compacting = 0;
+    skiplist->balance_height = 0;
+    cursor_rewind(skiplist);
+
+    other->top = NULL;
+    skiplist_shallow_clear(other);
 }
 
 /**
- * @brief Checks if the skiplist contains a item.
- *
- * @param skiplist a pointer to the skiplist.
- * @param item a pointer to the item.
- * @return _Bool \c 1 if the skiplist contains the item, \c 0 otherwise.
+ * @brief Visitor that prints an item per line and counts them, see print_t.
  */
-_Bool skiplist_includes(const SkipList *skiplist, const Item *item) {
-    Item *it = skiplist_search(skiplist, item);
-    return it && 0 == item_cmp(it, item) ? 1 : 0;
+static status_t print_visit(Item *item, void *ctx) {
+    print_t *print = (print_t *)ctx;
+    item_fprint(print->out, item);
+    fprintf(print->out, "\n");
+    print->count++;
+    return SUCCESS;
 }
 
 /**
- * @brief Searches the main lane of the skiplist for a item.
+ * @brief Passes the items of the frozen index to the callback of a walk,
+ * except the ones that expired since it was built.
  *
- * @param sentinel a pointer to the first node of the main lane.
- * @param item a pointer to the item.
- * @return Node* a pointer to the node that preceeds the node that contains the
- * item, or NULL if the item is not in the skiplist.
+ * @param item the item.
+ * @param ctx ptr to a frozen_walk_t.
+ * @return status_t the status of the callback, or \c SUCCESS if skipped.
  */
-static inline Node *mainlane_search(Node *sentinel, const Item *item) {
-    while (sentinel && item_cmp(sentinel->item, item) < 0) {
-        sentinel = sentinel->next;
-    }
-    return sentinel;
+static status_t frozen_visit(Item *item, void *ctx) {
+    frozen_walk_t *walk = (frozen_walk_t *)ctx;
+    if (item_gone(walk->skiplist, item)) return SUCCESS;
+    return walk->fn(item, walk->ctx);
 }
 
 /**
- * @brief Searches the fast lane of the skiplist for a item.
+ * @brief Keeps, for the newest open snapshot, the state of a word about to be
+ * written: a copy of its item, or a tombstone if it is absent. A word kept
+ * since that snapshot was taken is left as it was kept.
  *
- * @param sentinel a pointer to the first node of the fast lane.
- * @param item a pointer to the item.
- * @return Node* a pointer to the node that preceeds the node that contains the
- * item, or NULL if the item is not in the skiplist.
+ * @param skiplist ptr to the skiplist.
+ * @param item ptr to an item with the word.
+ * @return status_t \c SUCCESS (also without snapshots) or \c ALLOC_ERR, in
+ * which case the word must not be written.
  */
-static inline Node *fastlane_search(Node *sentinel, const Item *item) {
-    // WARNING: We assume `NULL != sentinel` and `NULL != item`
-    if (NULL == sentinel) return NULL;
-    while (sentinel->next && item_cmp(sentinel->next->item, item) < 0) {
-        sentinel = sentinel->next;
-    }
-    return sentinel;
+static status_t skiplist_preserve(SkipList *skiplist, const Item *item) {
+    if (NULL == skiplist->snap) return SUCCESS;
+    SkipList *kept = skiplist->snap->kept;
+    if (skiplist_find(kept, item)) return SUCCESS;
+
+    const char *word = item_word(item);
+    Item *current = skiplist_find(skiplist, item);
+    Item *copy = current ? item_clone(current)
+                         : item_new_from(word, strlen(word), NULL, 0);
+    if (NULL == copy) return ALLOC_ERR; // err handling
+    if (NULL == current) item_set_tombstone(copy, 1);
+
+    status_t flag = skiplist_link(kept, copy);
+    if (SUCCESS != flag) item_del(&copy); // err handling
+    return flag;
 }
 
 /**
- * @brief Searches the skiplist for a item, except for the main lane.
+ * @brief Moves the versions kept for a snapshot into the ones of the
+ * snapshot before it, which keeps its own for the words both have. Only the
+ * main lanes are merged; the fast lanes are drawn again.
  *
- * @param sentinel a pointer to the first node of the skiplist.
- * @param item a pointer to the item.
- * @return Node* a pointer to the node that preceeds the node that contains the
+ * @param into ptr to the versions of the older snapshot.
+ * @param from ptr to the versions of the newer one, left empty.
  */
-static inline Node *express_search(Node *sentinel, const Item *item) {
-    // WARNING: We assume `NULL != sentinel` and `NULL != item`
-    if (NULL == sentinel) return NULL;
-    while (sentinel->down) { // while sentinel.level > 0
-        while (sentinel->next && item_cmp(sentinel->next->item, item) < 0) {
-            sentinel = sentinel->next;
+static void kept_fold(SkipList *into, SkipList *from) {
+    Node *ours = skiplist_drop_lanes(into);
+    Node *theirs = skiplist_drop_lanes(from);
+    Node head = {0}, *tail = &head;
+    size_t length = 0;
+
+    for (; ours || theirs; length++) {
+        int cmp = NULL == theirs ? -1
+                  : NULL == ours ? 1
+                                 : item_raw_cmp(ours->item, theirs->item);
+        if (0 == cmp) { // the older version is the one that counts
+            Node *gone = theirs;
+            theirs = theirs->next;
+            node_deep_del(from, gone);
+        }
+        if (cmp <= 0) {
+            tail = tail->next = ours;
+            ours = ours->next;
+        } else {
+            tail = tail->next = theirs;
+            theirs = theirs->next;
         }
-        sentinel = sentinel->down;
     }
-    return sentinel;
+    tail->next = NULL;
+
+    into->top = head.next;
+    into->height = head.next ? 1 : 0;
+    into->length = length;
+    into->nodes = length;
+    *from = (SkipList){.seed = from->seed, .config = from->config};
+    skiplist_reshape(into, into->config.prob, into->config.max_height);
 }
 
 /**
- * @brief Searched the skiplist and returns every node, one for each level, that
- * preceeds a node equal o grater than the target item.
- *
- * @note this function assumes that skiplist and item are valid pointers and it
- * also assumes that the list is not empty.
- *
- * @param skiplist a ptr to the skiplist.
- * @param item ptr to an item containing the target key.
- * @return Node** vector of pointers to Nodes that were found dyring the trace
- * search. You have ownership.
+ * @brief Checks if an item was visible when the snapshot was taken: not a
+ * tombstone, nor expired on the clock of the list then.
  */
-Node **skiplist_raw_trace(SkipList *skiplist, Item *item) {
-    if (NULL == skiplist || item == NULL || skiplist->top == NULL) return NULL;
-
-    Node **updates = (Node **)calloc(skiplist->height, sizeof(Node *));
-    if (NULL == updates) return NULL;
+static inline _Bool snapshot_sees(const Snapshot *snapshot, const Item *item) {
+    if (NULL == item || item_is_tombstone(item)) return 0;
+    uint32_t expires = item_expiry(item);
+    return !(snapshot->timed && expires &&
+             (int32_t)(expires - snapshot->now) <= 0);
+}
 
-    size_t depth = 0;
+/**
+ * @brief The first node of the main lane whose word starts with c or comes
+ * after it, reached through the fast lanes.
+ */
+static Node *lane_from_char(const SkipList *skiplist, const char c) {
     Node *sentinel = skiplist->top;
 
     if (sentinel)
-        while (sentinel->down) { // while sentinel.level > 0
-            while (sentinel->next && item_cmp(sentinel->next->item, item) < 0) {
+        while (sentinel->down) {
+            while (sentinel->next &&
+                   item_raw_char_cmp(sentinel->next->item, c) < 0)
                 sentinel = sentinel->next;
-            }
-            updates[depth++] = sentinel;
             sentinel = sentinel->down;
         }
 
-    if (sentinel)
-        while (sentinel->next && item_cmp(sentinel->next->item, item) < 0) {
-            sentinel = sentinel->next;
-        }
-
-    updates[depth++] = sentinel;
-    // printf("<trace depth(%lu)>\n", depth);
-
-    return updates;
+    while (sentinel && item_raw_char_cmp(sentinel->item, c) < 0)
+        sentinel = sentinel->next;
+    return sentinel;
 }
 
 /**
- * @brief Inserts a item on the start of the skiplist.
+ * @brief Walks the words of a snapshot in order: the main lanes of the
+ * versions kept since it was taken and of the list, side by side. A word
+ * takes the state of the first of them that has it.
  *
- * @param skiplist ptr to the skiplist.
- * @param item ptr to the item that will be inserted. You lose ownership on a
- * successiful push.
- * @return status_t \c SUCCESS if we succeded on the push, \c ALLOC_ERR if we
- * fail to allocate memory for the new node.
+ * @param snapshot ptr to the snapshot.
+ * @param whole \c 1 for every word, \c 0 for the ones starting with c.
+ * @param c the first character, when not whole.
+ * @param fn the visitor, see skiplist_foreach().
+ * @param ctx opaque ptr forwarded to fn.
+ * @return status_t see skiplist_snapshot_foreach(), or \c ALLOC_ERR.
  */
-static status_t skiplist_raw_push_front(SkipList *skiplist, Item *item) {
-    // New top
-    Node *new_node = node_new((Node){.item = item, .next = skiplist->top});
-    if (NULL == new_node) return ALLOC_ERR; // Error handling
-    Node *sentinel = skiplist->top->down;
-    skiplist->top = new_node;
-
-    // Creating the new nodes for each level
-    Node *previous = new_node;
-    while (sentinel) {
-        // Creating the new node
-        new_node = node_new((Node){.item = item, .next = sentinel});
-
-        // Error handling: revert all to recover
-        if (NULL == new_node) {
-            Node *previous_top = skiplist->top->next;
+static status_t snapshot_walk(const Snapshot *snapshot, _Bool whole,
+                              const char c,
+                              status_t (*fn)(Item *item, void *ctx),
+                              void *ctx) {
+    if (NULL == snapshot || NULL == snapshot->list || NULL == fn)
+        return NUL_ERR; // err handling
 
-            sentinel = skiplist->top; // current top
-            while (sentinel) {
-                Node *temp = sentinel->down;
-                node_shallow_del(sentinel);
-                sentinel = temp;
-            }
+    // PART 1: where each source starts, the list being the last one
+    size_t n = 1;
+    for (const Snapshot *s = snapshot; s; s = s->newer) n++;
+    Node **at = (Node **)malloc(n * sizeof(Node *));
+    if (NULL == at) return ALLOC_ERR; // err handling
 
-            skiplist->top = previous_top;
-        }
+    size_t k = 0;
+    for (const Snapshot *s = snapshot; s; s = s->newer)
+        at[k++] = whole ? main_lane(s->kept) : lane_from_char(s->kept, c);
+    at[k] = whole ? main_lane(snapshot->list)
+                  : lane_from_char(snapshot->list, c);
 
-        // Adding the new node
-        previous->down = new_node;
-        previous = new_node;
+    // PART 2: the smallest word of all, from the first source that has it
+    status_t flag = SUCCESS;
+    while (SUCCESS == flag) {
+        Node *first = NULL;
+        for (size_t i = 0; i < n; i++)
+            if (at[i] && (NULL == first ||
+                          item_raw_cmp(at[i]->item, first->item) < 0))
+                first = at[i];
+        if (NULL == first ||
+            (!whole && item_raw_char_cmp(first->item, c) > 0))
+            break;
 
-        sentinel = sentinel->down;
+        Item *it = first->item;
+        for (size_t i = 0; i < n; i++)
+            if (at[i] && 0 == item_raw_cmp(at[i]->item, it))
+                at[i] = at[i]->next;
+        if (snapshot_sees(snapshot, it)) flag = fn(it, ctx);
     }
 
-    skiplist->length++;
-    return SUCCESS;
+    free(at);
+    return flag;
 }
 
 /**
- * @brief Reduces the height of the skiplist if it has small lanes on the top.
- *
- * Every lane above the main lane (the bottom lane, aka: the true lane), if they
- * exist, should have at least 2 itens. Otherwise, there would be no peformance
- * gain provided by the lane ;)
- *
- * @param skiplist a pointer to the skiplist.
+ * @brief Reads the clock of the expiries: \c clock of the configuration, or
+ * the seconds of the monotonic clock.
  */
-void skiplist_trim(SkipList *skiplist) {
-    if (NULL == skiplist || NULL == skiplist->top) return; // err handling
-
-    // Loop from top to bottom untill we reach the bottom or until a valid top
-    // lane is stabilished.
-    while (skiplist->height > 1 && NULL == skiplist->top->next) {
-        // Destroy the lane
-        Node *temp = skiplist->top->down;
-        node_shallow_del(skiplist->top);
-        skiplist->top = temp;
+static uint32_t skiplist_clock(const SkipList *skiplist) {
+    if (skiplist->config.clock) return skiplist->config.clock();
 
-        skiplist->height--; // dec the height
-    }
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)ts.tv_sec;
 }
 
 /**
- * @brief removes the first element of the skiplist.
+ * @brief The tick at which an item inserted now with a TTL expires.
  *
- * @param skiplist ptr to skiplist.
- * @return Item* ptr to the the removed item or NULL. You have ownership.
+ * @param skiplist ptr to the skiplist.
+ * @param ttl ticks the item lives, not 0.
+ * @return uint32_t the tick, never 0 (which means no expiry).
  */
-Item *skiplist_raw_pop_front(SkipList *skiplist) {
-    Item *return_item = skiplist->top->item;
-    Node *sentinel = skiplist->top;
-
-    // Trivial case: list has only one
-    if (1 == skiplist->length) {
-        // Cleanup loop
-        while (sentinel) {
-            Node *temp = sentinel->down;
-            node_shallow_del(sentinel);
-            sentinel = temp;
-        }
-
-        // Set zeros
-        *skiplist = (SkipList){0};
+static uint32_t skiplist_deadline(const SkipList *skiplist, uint32_t ttl) {
+    uint32_t at = skiplist_clock(skiplist) + ttl;
+    return at ? at : 1;
+}
 
-        return return_item;
-    }
+/**
+ * @brief Checks if an item is invisible: a tombstone, or expired on the
+ * clock read by the last operation.
+ */
+static inline _Bool item_gone(const SkipList *skiplist, const Item *item) {
+    if (item_is_tombstone(item)) return 1;
+    uint32_t expires = item_expiry(item);
+    return skiplist->wheel && expires &&
+           (int32_t)(expires - skiplist->now) <= 0;
+}
 
-    // Tracing next
-    size_t h = skiplist->height;
-    Node **updates = (Node **)calloc(h, sizeof(Node *));
-    if (NULL == updates) return NULL; // err handling
+/**
+ * @brief Gives the list its timer wheel, if it has none, and schedules the
+ * items that carry an expiry, e.g. after skiplist_from_sorted().
+ *
+ * @param skiplist ptr to the skiplist.
+ * @return status_t \c SUCCESS or \c ALLOC_ERR, in which case the list is
+ * left without a wheel and no item expires.
+ */
+static status_t skiplist_timers_start(SkipList *skiplist) {
+    if (skiplist->wheel) return SUCCESS;
 
-    // Going down and tracing
-    size_t depth = 0;
-    while (sentinel) {
-        updates[depth++] = sentinel->next;
-        sentinel = sentinel->down;
-    }
+    skiplist->now = skiplist_clock(skiplist);
+    skiplist->wheel = timerwheel_new(TTL_WHEEL_SLOTS, skiplist->now);
+    if (NULL == skiplist->wheel) return ALLOC_ERR; // err handling
 
-    // The new start of the main lane (bottom lane):
-    Node *new_bottom = updates[h - 1];
+    // Go to the main lane
+    Node *sentinel = skiplist->top;
+    while (sentinel && sentinel->down) sentinel = sentinel->down;
 
-    if (NULL == new_bottom) { // err handling
-        free(updates);
-        return NULL;
+    for (; sentinel; sentinel = sentinel->next) {
+        Item *it = sentinel->item;
+        if (0 == item_expiry(it) || item_is_tombstone(it)) continue;
+        if (SUCCESS != timerwheel_add(skiplist->wheel, it)) {
+            timerwheel_del(&skiplist->wheel); // err handling
+            return ALLOC_ERR;
+        }
     }
+    return SUCCESS;
+}
 
-    Item *bottom_item = new_bottom->item;
+/**
+ * @brief Reads the clock and unlinks and frees the items that expired, up
+ * to EXPIRE_STEP of them: the rest waits for the next operations.
+ *
+ * @param skiplist ptr to the skiplist, with a timer wheel.
+ */
+static void skiplist_expire(SkipList *skiplist) {
+    skiplist->now = skiplist_clock(skiplist);
 
-    // Making shure the first object is tall enought
-    Node *temp = updates[h - 1];
-    long long i = h - 2;
-    for (; i >= 0 && updates[i]->item == bottom_item; i--)
-        temp = updates[i];
+    for (size_t i = 0; i < EXPIRE_STEP; i++) {
+        Item *due = timerwheel_pop_due(skiplist->wheel, skiplist->now);
+        if (NULL == due) return;
 
-    // Raise level of the new first object if needed
-    // NOTE (b): `i` can only be inside [-1, h - 2] here.
-    for (; i >= 0; i--) {
-        temp = node_new((Node){
-            .item = bottom_item,
-            .next = updates[i],
-            .down = temp,
-        });
+        // Before the unlink: an unlink that empties the list resets it, and
+        // the frozen index would be lost with it. Nor must it keep a freed
+        // item.
+        skiplist_thaw(skiplist);
+        Item *gone = skiplist_unlink(skiplist, due);
+        if (NULL == gone) { // err handling: the next operation retries
+            timerwheel_add(skiplist->wheel, due);
+            return;
+        }
+        skiplist_drop(skiplist, &gone);
+        skiplist->expired++;
     }
+}
 
-    // Setting new top
-    sentinel = skiplist->top;
-    skiplist->top = temp;
-
-    // Deleting the old first
-    while (sentinel) {
-        temp = sentinel->down;
-        node_shallow_del(temp);
-        sentinel = temp;
-    }
+/**
+ * @brief Frees items while the list holds more than \c max_bytes, see
+ * skiplist_evict().
+ *
+ * @param skiplist ptr to the skiplist.
+ * @param spare ptr to an item of the list that is not freed, or NULL.
+ * @return status_t \c SUCCESS, or \c ARR_IS_FULL_ERR if the list does not
+ * evict or nothing else is left to free.
+ */
+static status_t skiplist_fit(SkipList *skiplist, const Item *spare) {
+    size_t max = skiplist->config.max_bytes;
+    while (max && max < skiplist_bytes(skiplist))
+        if (!skiplist->config.evict ||
+            SUCCESS != skiplist_evict(skiplist, spare))
+            return ARR_IS_FULL_ERR;
+    return SUCCESS;
+}
 
-    // Trimming the skiplist: it might be taller than needed.
-    skiplist_trim(skiplist);
+/**
+ * @brief The heap bytes of the skiplist at another length: the ones it holds
+ * now (see skiplist_bytes()), plus or minus a column of the expected height
+ * per item of difference.
+ *
+ * @param skiplist ptr to the skiplist.
+ * @param length the columns to count, e.g. its length.
+ */
+static size_t skiplist_bytes_at(const SkipList *skiplist, size_t length) {
+    double node = sizeof(Node) + memutils_alloc_overhead(sizeof(Node));
+    double item = item_size() + memutils_alloc_overhead(item_size());
+    double column = item + node / (1 - skiplist->config.prob);
+    if (skiplist->back) // the main lane node is a BackNode instead
+        column += sizeof(BackNode) + memutils_alloc_overhead(sizeof(BackNode)) -
+                  node;
 
-    // Cleanup and exit
-    skiplist->length--;
-    free(updates);
-    return return_item;
+    double bytes = (double)skiplist_bytes(skiplist) +
+                   column * ((double)length - (double)skiplist->length);
+    return bytes > 0 ? (size_t)bytes : 0;
 }
 
 /**
- * @brief Checks if all the nodes in a column is are valid.
- *
- * @param n a pointer to the node.
- * @return _Bool \c 1 if the column is valid, \c 0 if it contains one o more
- * detectable errors.
+ * @brief Checks if the skiplist would be full with a given length, that is,
+ * if one more column would take it past a limit. See skiplist_is_full().
  */
-static _Bool valid_column(Node *n) {
-    Node *sentinel = n;
-    if (sentinel)
-        while (sentinel->down) {
-            if (sentinel->down->item != sentinel->item) return 0;
-            sentinel = sentinel->down;
-        }
-    return 1;
-}
\ No newline at end of file
+static _Bool skiplist_full_at(const SkipList *skiplist, size_t length) {
+    const skiplist_config_t *config = &skiplist->config;
+    return (config->max_length && config->max_length <= length) ||
+           (config->max_bytes &&
+            config->max_bytes < skiplist_bytes_at(skiplist, length + 1));
+}
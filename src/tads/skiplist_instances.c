@@ -0,0 +1,19 @@
+#include "tads/skiplist_instances.h"
+
+//=============================================================================/
+//=================|    Comparators     |======================================/
+//=============================================================================/
+
+// NOTE (b): they receive ptrs to the keys and are expanded inside the search
+// loops, so none of them costs a function call per node.
+#define U64_CMP(a, b) ((*(a) > *(b)) - (*(a) < *(b)))
+#define WORD_CMP(a, b) strcmp((a)->s, (b)->s)
+#define ITEM_CMP(a, b) item_raw_cmp(*(a), *(b))
+
+//=============================================================================/
+//=================|    Instances     |========================================/
+//=============================================================================/
+
+SKIPLIST_TEMPLATE_DEFINE(U64SkipList, u64skiplist, uint64_t, void *, U64_CMP)
+SKIPLIST_TEMPLATE_DEFINE(WordSkipList, wordskiplist, word_t, void *, WORD_CMP)
+SKIPLIST_TEMPLATE_DEFINE(ItemSkipList, itemskiplist, Item *, void *, ITEM_CMP)
@@ -0,0 +1,222 @@
+/**
+ * @file timerwheel.c
+ * @brief Implementation of a hashed timer wheel of expiring items.
+ */
+
+#include "tads/timerwheel.h"
+
+// Smallest wheel, in slots.
+#define TIMERWHEEL_MIN_SLOTS (64)
+
+// Room of a slot when its first item arrives.
+#define TIMERWHEEL_MIN_ROOM (4)
+
+//=============================================================================/
+//=================|    Data Structures     |==================================/
+//=============================================================================/
+
+/**
+ * @brief The items expiring at the ticks of a slot, in no order.
+ */
+typedef struct {
+    Item **items;
+    uint32_t count;
+    uint32_t room;
+} timer_slot_t;
+
+/**
+ * @brief Timer wheel: mask + 1 slots. Every tick before \c tick was
+ * handled, and so were the first \c pos items of the slot of \c tick.
+ */
+struct _timerwheel_s {
+    timer_slot_t *slots;
+    size_t mask;
+    uint32_t tick;
+    uint32_t pos;
+    size_t length;
+    size_t room; // item ptrs the slots have room for, all together
+};
+
+//=============================================================================/
+//=================|    Private Function Declarations     |====================/
+//=============================================================================/
+
+static inline _Bool is_due(uint32_t expires, uint32_t now);
+static inline timer_slot_t *slot_of(const TimerWheel *wheel, uint32_t tick);
+static inline void slot_move(timer_slot_t *slot, uint32_t from, uint32_t to);
+static void slot_take(TimerWheel *wheel, timer_slot_t *slot, uint32_t pos);
+
+//=============================================================================/
+//=================|    Public Function Implementations     |==================/
+//=============================================================================/
+
+TimerWheel *timerwheel_new(size_t slots, uint32_t now) {
+    size_t n = TIMERWHEEL_MIN_SLOTS;
+    while (n < slots) n *= 2;
+
+    TimerWheel *wheel = (TimerWheel *)malloc(sizeof(TimerWheel));
+    if (NULL == wheel) return NULL; // err handling
+
+    *wheel = (TimerWheel){
+        .slots = (timer_slot_t *)calloc(n, sizeof(timer_slot_t)),
+        .mask = n - 1,
+        .tick = now,
+    };
+    if (NULL == wheel->slots) timerwheel_del(&wheel); // err handling
+    return wheel;
+}
+
+void timerwheel_del(TimerWheel **wheel) {
+    if (NULL == wheel || NULL == *wheel) return;
+    if ((*wheel)->slots)
+        for (size_t i = 0; i <= (*wheel)->mask; i++)
+            free((*wheel)->slots[i].items);
+    free((*wheel)->slots);
+    free(*wheel);
+    *wheel = NULL;
+}
+
+void timerwheel_clear(TimerWheel *wheel, uint32_t now) {
+    if (NULL == wheel) return;
+    for (size_t i = 0; i <= wheel->mask; i++) wheel->slots[i].count = 0;
+    wheel->tick = now;
+    wheel->pos = 0;
+    wheel->length = 0;
+}
+
+status_t timerwheel_add(TimerWheel *wheel, Item *item) {
+    if (NULL == wheel || NULL == item) return NUL_ERR;
+
+    // Late items go to the slot scanned next, not a turn away
+    uint32_t at = item_expiry(item);
+    if (is_due(at, wheel->tick)) at = wheel->tick;
+    timer_slot_t *slot = slot_of(wheel, at);
+
+    if (slot->count == slot->room) {
+        uint32_t room = slot->room ? 2 * slot->room : TIMERWHEEL_MIN_ROOM;
+        Item **items = (Item **)realloc(slot->items, room * sizeof(Item *));
+        if (NULL == items) return ALLOC_ERR; // err handling
+        wheel->room += room - slot->room;
+        slot->items = items;
+        slot->room = room;
+    }
+
+    item_set_timer(item, slot->count);
+    slot->items[slot->count++] = item;
+    wheel->length++;
+    return SUCCESS;
+}
+
+void timerwheel_cancel(TimerWheel *wheel, Item *item) {
+    if (NULL == wheel || 0 == item_expiry(item)) return;
+
+    // In the slot of its expiry, or of the tick if it was late
+    uint32_t pos = item_timer(item);
+    timer_slot_t *slot = slot_of(wheel, item_expiry(item));
+    if (pos >= slot->count || item != slot->items[pos])
+        slot = slot_of(wheel, wheel->tick);
+    if (pos >= slot->count || item != slot->items[pos]) return;
+
+    slot_take(wheel, slot, pos);
+}
+
+Item *timerwheel_pop_due(TimerWheel *wheel, uint32_t now) {
+    if (NULL == wheel) return NULL;
+
+    // A turn visits every slot: the ones before it add nothing
+    if (is_due(wheel->tick + (uint32_t)wheel->mask + 1, now)) {
+        wheel->tick = now - (uint32_t)wheel->mask;
+        wheel->pos = 0;
+    }
+
+    for (; is_due(wheel->tick, now); wheel->tick++, wheel->pos = 0) {
+        timer_slot_t *slot = slot_of(wheel, wheel->tick);
+        for (; wheel->pos < slot->count; wheel->pos++) {
+            Item *item = slot->items[wheel->pos];
+            if (!is_due(item_expiry(item), now)) continue; // a later turn
+
+            slot_take(wheel, slot, wheel->pos);
+            return item;
+        }
+
+        // A slot left empty gives its room back until its next turn
+        if (0 == slot->count && slot->room > 0) {
+            wheel->room -= slot->room;
+            free(slot->items);
+            *slot = (timer_slot_t){0};
+        }
+    }
+    return NULL;
+}
+
+void timerwheel_renumber(TimerWheel *wheel) {
+    if (NULL == wheel) return;
+    for (size_t i = 0; i <= wheel->mask; i++)
+        for (uint32_t j = 0; j < wheel->slots[i].count; j++)
+            item_set_timer(wheel->slots[i].items[j], j);
+}
+
+size_t timerwheel_length(const TimerWheel *wheel) {
+    return wheel ? wheel->length : 0;
+}
+
+size_t timerwheel_bytes(const TimerWheel *wheel) {
+    if (NULL == wheel) return 0;
+    return sizeof(TimerWheel) + (wheel->mask + 1) * sizeof(timer_slot_t) +
+           wheel->room * sizeof(Item *);
+}
+
+//=============================================================================/
+//=================|    Private Function Implementations    |==================/
+//=============================================================================/
+
+/**
+ * @brief Checks if a tick is at or before another one, on a clock that may
+ * wrap around.
+ */
+static inline _Bool is_due(uint32_t expires, uint32_t now) {
+    return (int32_t)(expires - now) <= 0;
+}
+
+/**
+ * @brief The slot of a tick.
+ */
+static inline timer_slot_t *slot_of(const TimerWheel *wheel, uint32_t tick) {
+    return &wheel->slots[tick & wheel->mask];
+}
+
+/**
+ * @brief Moves an item of a slot to another position, recording it.
+ */
+static inline void slot_move(timer_slot_t *slot, uint32_t from, uint32_t to) {
+    slot->items[to] = slot->items[from];
+    item_set_timer(slot->items[to], to);
+}
+
+/**
+ * @brief Takes an item out of its slot by moving the last one to its place.
+ * In the slot being scanned, the last scanned item fills the hole first, so
+ * the scanned ones stay ahead of the others. A slot mostly empty shrinks.
+ *
+ * @param wheel ptr to the wheel.
+ * @param slot ptr to the slot of the item.
+ * @param pos position of the item in the slot.
+ */
+static void slot_take(TimerWheel *wheel, timer_slot_t *slot, uint32_t pos) {
+    if (slot == slot_of(wheel, wheel->tick) && pos < wheel->pos) {
+        slot_move(slot, --wheel->pos, pos);
+        pos = wheel->pos;
+    }
+    slot_move(slot, --slot->count, pos);
+    wheel->length--;
+
+    // Room for four times the items is too much: half of it goes back
+    if (slot->room > TIMERWHEEL_MIN_ROOM && slot->count < slot->room / 4) {
+        uint32_t room = slot->room / 2;
+        Item **items = (Item **)realloc(slot->items, room * sizeof(Item *));
+        if (NULL == items) return; // err handling: it keeps the room
+        wheel->room -= slot->room - room;
+        slot->items = items;
+        slot->room = room;
+    }
+}
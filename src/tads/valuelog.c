@@ -0,0 +1,276 @@
+/**
+ * @file valuelog.c
+ * @brief Implementation of an append-only log of descriptions on disk.
+ *
+ * A reference packs the offset of a description in its 56 high bits and its
+ * length in the 8 low ones. Pages are numbered from the start of the file;
+ * the cache keeps page p in set p % sets, so the pages of a readahead fall
+ * in different sets and are read with a single preadv().
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "tads/valuelog.h"
+
+//=============================================================================/
+//=================|    Data Structures     |==================================/
+//=============================================================================/
+
+struct _valuelog_s {
+    int fd;
+    uint64_t size;    // bytes appended
+    uint64_t flushed; // bytes written to the file, in whole pages
+    char *tail;       // the page being filled, at offset flushed
+
+    // Page cache: frames * VALUELOG_PAGE bytes, in sets of VALUELOG_WAYS
+    char *frames;
+    uint64_t *tags;          // page number + 1 of every frame, 0 when empty
+    unsigned char *recent;   // clock bits, set by the hits
+    unsigned char *hands;    // clock hand of every set
+    size_t sets;
+
+    uint64_t ahead; // the page after the last read, see valuelog.h
+    size_t window;  // pages read by the last miss
+    size_t hits, misses, reads;
+};
+
+//=============================================================================/
+//=================|    Private Function Declarations     |====================/
+//=============================================================================/
+
+static status_t valuelog_flush_tail(ValueLog *log);
+static const char *valuelog_page(ValueLog *log, uint64_t page);
+static const char *valuelog_cached(ValueLog *log, uint64_t page);
+static size_t valuelog_victim(ValueLog *log, size_t set);
+
+//=============================================================================/
+//=================|    Public Function Implementations     |==================/
+//=============================================================================/
+
+ValueLog *valuelog_new(const char *dir, size_t cache_bytes) {
+    if (0 == cache_bytes) cache_bytes = VALUELOG_CACHE;
+    size_t sets = cache_bytes / (VALUELOG_PAGE * VALUELOG_WAYS);
+    if (0 == sets) sets = 1;
+    size_t frames = sets * VALUELOG_WAYS;
+
+    ValueLog *log = (ValueLog *)malloc(sizeof(ValueLog));
+    if (NULL == log) return NULL; // err handling
+
+    *log = (ValueLog){.fd = -1, .sets = sets};
+    log->tail = (char *)malloc(VALUELOG_PAGE);
+    log->frames = (char *)malloc(frames * VALUELOG_PAGE);
+    log->tags = (uint64_t *)calloc(frames, sizeof(uint64_t));
+    log->recent = (unsigned char *)calloc(frames, 1);
+    log->hands = (unsigned char *)calloc(sets, 1);
+    if (NULL == log->tail || NULL == log->frames || NULL == log->tags ||
+        NULL == log->recent || NULL == log->hands) { // err handling
+        valuelog_del(&log);
+        return NULL;
+    }
+
+    // A scratch file: it goes away with the descriptor
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/valuelog-XXXXXX", dir ? dir : "/tmp");
+    log->fd = mkstemp(path);
+    if (-1 == log->fd) { // err handling
+        int reason = errno;
+        valuelog_del(&log);
+        errno = reason;
+        return NULL;
+    }
+    unlink(path);
+
+    return log;
+}
+
+void valuelog_del(ValueLog **log) {
+    if (NULL == log || NULL == *log) return;
+    if (-1 != (*log)->fd) close((*log)->fd);
+    free((*log)->tail);
+    free((*log)->frames);
+    free((*log)->tags);
+    free((*log)->recent);
+    free((*log)->hands);
+    free(*log);
+    *log = NULL;
+}
+
+status_t valuelog_append(ValueLog *log, const char *data, size_t len,
+                         uint64_t *ref) {
+    if (NULL == log || NULL == ref || (NULL == data && len > 0))
+        return NUL_ERR;
+    if (len > UINT8_MAX) return TOO_MUCH_ERR;
+
+    *ref = log->size << 8 | len;
+    while (len > 0) {
+        size_t at = log->size - log->flushed;
+        size_t chunk = VALUELOG_PAGE - at < len ? VALUELOG_PAGE - at : len;
+        memcpy(log->tail + at, data, chunk);
+        log->size += chunk;
+        data += chunk;
+        len -= chunk;
+
+        if (log->size - log->flushed == VALUELOG_PAGE &&
+            SUCCESS != valuelog_flush_tail(log))
+            return CRITICAL_ERR; // err handling
+    }
+
+    return SUCCESS;
+}
+
+status_t valuelog_read(ValueLog *log, uint64_t ref, char *out) {
+    if (NULL == log || NULL == out) return NUL_ERR;
+
+    uint64_t offset = ref >> 8;
+    size_t len = valuelog_ref_length(ref);
+    if (offset + len > log->size) return NOT_FOUND_ERR;
+
+    // A description may span two pages
+    for (size_t done = 0; done < len;) {
+        const char *page = valuelog_page(log, offset / VALUELOG_PAGE);
+        if (NULL == page) return CRITICAL_ERR; // err handling
+
+        size_t at = offset % VALUELOG_PAGE;
+        size_t chunk = VALUELOG_PAGE - at < len - done ? VALUELOG_PAGE - at
+                                                       : len - done;
+        memcpy(out + done, page + at, chunk);
+        done += chunk;
+        offset += chunk;
+    }
+
+    out[len] = '\0';
+    return SUCCESS;
+}
+
+size_t valuelog_ref_length(uint64_t ref) { return (size_t)(ref & UINT8_MAX); }
+
+uint64_t valuelog_size(const ValueLog *log) { return log ? log->size : 0; }
+
+size_t valuelog_bytes(const ValueLog *log) {
+    if (NULL == log) return 0;
+    size_t frames = log->sets * VALUELOG_WAYS;
+    return sizeof(ValueLog) + VALUELOG_PAGE +
+           frames * (VALUELOG_PAGE + sizeof(uint64_t) + 1) + log->sets;
+}
+
+void valuelog_memory_fprint(FILE *out, const ValueLog *log) {
+    if (NULL == log) return;
+    fprintf(out, "value log: %llu bytes on disk, %zu pages of cache\n",
+            (unsigned long long)log->size, log->sets * VALUELOG_WAYS);
+    fprintf(out, "value log: %zu hits, %zu misses in %zu reads\n", log->hits,
+            log->misses, log->reads);
+    fprintf(out, "value log: %zu bytes\n", valuelog_bytes(log));
+}
+
+//=============================================================================/
+//=================|    Private Function Implementations    |==================/
+//=============================================================================/
+
+/**
+ * @brief Writes the full tail page to the file, and starts a new one.
+ */
+static status_t valuelog_flush_tail(ValueLog *log) {
+    for (size_t done = 0; done < VALUELOG_PAGE;) {
+        ssize_t n = pwrite(log->fd, log->tail + done, VALUELOG_PAGE - done,
+                           (off_t)(log->flushed + done));
+        if (n <= 0) return CRITICAL_ERR; // err handling
+        done += (size_t)n;
+    }
+
+    log->flushed += VALUELOG_PAGE;
+    return SUCCESS;
+}
+
+/**
+ * @brief The bytes of a page: the tail, a cached page, or else a page read,
+ * with the ones after it when the reads look sequential.
+ *
+ * @param log ptr to the log.
+ * @param page the page number.
+ * @return const char* the page, borrowed until the next read, or NULL if the
+ * file could not be read.
+ */
+static const char *valuelog_page(ValueLog *log, uint64_t page) {
+    if (page * VALUELOG_PAGE >= log->flushed) return log->tail;
+
+    const char *cached = valuelog_cached(log, page);
+    if (cached) {
+        log->hits++;
+        return cached;
+    }
+    log->misses++;
+
+    // PART 1: how far to read, without pages already cached
+    uint64_t pages = log->flushed / VALUELOG_PAGE;
+    size_t window = page == log->ahead ? 2 * log->window : 1;
+    if (window > VALUELOG_READAHEAD) window = VALUELOG_READAHEAD;
+    if (window > log->sets) window = log->sets; // one frame per set
+    size_t count = 1;
+    while (count < window && page + count < pages &&
+           NULL == valuelog_cached(log, page + count))
+        count++;
+
+    // PART 2: a frame per page, all filled by one call
+    struct iovec iov[VALUELOG_READAHEAD];
+    size_t frame[VALUELOG_READAHEAD];
+    for (size_t i = 0; i < count; i++) {
+        frame[i] = valuelog_victim(log, (page + i) % log->sets);
+        log->tags[frame[i]] = 0;
+        iov[i] = (struct iovec){
+            .iov_base = log->frames + frame[i] * VALUELOG_PAGE,
+            .iov_len = VALUELOG_PAGE,
+        };
+    }
+
+    ssize_t n = preadv(log->fd, iov, (int)count, (off_t)(page * VALUELOG_PAGE));
+    log->reads++;
+    if (n < VALUELOG_PAGE) return NULL; // err handling
+
+    // PART 3: only the pages read in full are kept. The one asked for is
+    // marked recent; the ones ahead go first if nobody asks for them.
+    for (size_t i = 0; i < count && (size_t)n >= (i + 1) * VALUELOG_PAGE; i++) {
+        log->tags[frame[i]] = page + i + 1;
+        log->recent[frame[i]] = 0 == i;
+    }
+
+    log->ahead = page + count;
+    log->window = count;
+    return log->frames + frame[0] * VALUELOG_PAGE;
+}
+
+/**
+ * @brief Searches the set of a page for it, marking it recent.
+ *
+ * @return const char* the page, or NULL if it is not cached.
+ */
+static const char *valuelog_cached(ValueLog *log, uint64_t page) {
+    size_t first = (size_t)(page % log->sets) * VALUELOG_WAYS;
+    for (size_t f = first; f < first + VALUELOG_WAYS; f++) {
+        if (page + 1 != log->tags[f]) continue;
+        log->recent[f] = 1;
+        return log->frames + f * VALUELOG_PAGE;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Picks the frame of a set to be replaced: an empty one, or the first
+ * one the clock hand finds not recent, clearing the bits it passes.
+ *
+ * @return size_t the frame.
+ */
+static size_t valuelog_victim(ValueLog *log, size_t set) {
+    size_t first = set * VALUELOG_WAYS;
+    for (size_t f = first; f < first + VALUELOG_WAYS; f++)
+        if (0 == log->tags[f]) return f;
+
+    for (;;) {
+        size_t f = first + log->hands[set];
+        log->hands[set] = (log->hands[set] + 1) % VALUELOG_WAYS;
+        if (!log->recent[f]) return f;
+        log->recent[f] = 0;
+    }
+}
@@ -0,0 +1,95 @@
+#include <string.h>
+
+#include "utils/bytebuf.h"
+
+// First allocation of an empty buffer.
+#define BYTEBUF_MIN_CAP (256)
+
+//=============================================================================/
+//=================|    Public Function Implementations     |==================/
+//=============================================================================/
+
+status_t bytebuf_reserve(ByteBuf *buf, size_t need) {
+    if (NULL == buf) return NUL_ERR;
+    if (need <= buf->cap) return SUCCESS;
+
+    size_t cap = buf->cap ? buf->cap : BYTEBUF_MIN_CAP;
+    while (cap < need) cap *= 2;
+
+    unsigned char *grown = (unsigned char *)realloc(buf->data, cap);
+    if (NULL == grown) return ALLOC_ERR; // err handling
+
+    buf->data = grown;
+    buf->cap = cap;
+    return SUCCESS;
+}
+
+status_t bytebuf_append(ByteBuf *buf, const void *data, size_t len) {
+    if (0 == len) return SUCCESS;
+
+    status_t flag = bytebuf_reserve(buf, buf->len + len);
+    if (SUCCESS != flag) return flag; // err handling
+
+    memcpy(buf->data + buf->len, data, len);
+    buf->len += len;
+    return SUCCESS;
+}
+
+status_t bytebuf_put_u8(ByteBuf *buf, uint8_t value) {
+    return bytebuf_append(buf, &value, 1);
+}
+
+status_t bytebuf_put_u16(ByteBuf *buf, uint16_t value) {
+    unsigned char b[2] = {value & 0xff, value >> 8};
+    return bytebuf_append(buf, b, sizeof(b));
+}
+
+status_t bytebuf_put_u32(ByteBuf *buf, uint32_t value) {
+    unsigned char b[4] = {value & 0xff, (value >> 8) & 0xff,
+                          (value >> 16) & 0xff, value >> 24};
+    return bytebuf_append(buf, b, sizeof(b));
+}
+
+status_t bytebuf_put_u64(ByteBuf *buf, uint64_t value) {
+    status_t flag = bytebuf_put_u32(buf, (uint32_t)value);
+    if (SUCCESS != flag) return flag; // err handling
+    return bytebuf_put_u32(buf, (uint32_t)(value >> 32));
+}
+
+void bytebuf_set_u32(ByteBuf *buf, size_t at, uint32_t value) {
+    if (NULL == buf || at + 4 > buf->len) return;
+    buf->data[at] = value & 0xff;
+    buf->data[at + 1] = (value >> 8) & 0xff;
+    buf->data[at + 2] = (value >> 16) & 0xff;
+    buf->data[at + 3] = value >> 24;
+}
+
+void bytebuf_consume(ByteBuf *buf, size_t n) {
+    if (NULL == buf) return;
+    if (n >= buf->len) {
+        buf->len = 0;
+        return;
+    }
+    memmove(buf->data, buf->data + n, buf->len - n);
+    buf->len -= n;
+}
+
+void bytebuf_free(ByteBuf *buf) {
+    if (NULL == buf) return;
+    free(buf->data);
+    *buf = (ByteBuf){0};
+}
+
+uint16_t bytebuf_get_u16(const unsigned char *at) {
+    return (uint16_t)(at[0] | at[1] << 8);
+}
+
+uint32_t bytebuf_get_u32(const unsigned char *at) {
+    return (uint32_t)at[0] | (uint32_t)at[1] << 8 | (uint32_t)at[2] << 16 |
+           (uint32_t)at[3] << 24;
+}
+
+uint64_t bytebuf_get_u64(const unsigned char *at) {
+    return (uint64_t)bytebuf_get_u32(at) |
+           (uint64_t)bytebuf_get_u32(at + 4) << 32;
+}
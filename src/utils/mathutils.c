@@ -8,4 +8,20 @@ int geometric_dist_test (float p, int max_val) {
     int x = 0;
     for (; x < max_val && rnd_normalized() <= p; x++);
     return x;
-}
\ No newline at end of file
+}
+
+float rnd_normalized_r (unsigned int *state) {
+    // xorshift32, good enough to flip coins
+    unsigned int x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return (float)(x >> 8) / (float)(1u << 24);
+}
+
+int geometric_dist_test_r (float p, int max_val, unsigned int *state) {
+    int x = 0;
+    for (; x < max_val && rnd_normalized_r(state) <= p; x++);
+    return x;
+}
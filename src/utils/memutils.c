@@ -0,0 +1,14 @@
+#include "utils/memutils.h"
+
+size_t memutils_alloc_size(size_t request) {
+    const size_t header = sizeof(size_t);
+    const size_t align = 2 * sizeof(size_t);
+    const size_t min_chunk = 4 * sizeof(size_t);
+
+    size_t chunk = (request + header + align - 1) & ~(align - 1);
+    return chunk < min_chunk ? min_chunk : chunk;
+}
+
+size_t memutils_alloc_overhead(size_t request) {
+    return memutils_alloc_size(request) - request;
+}
@@ -0,0 +1,155 @@
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "utils/netutils.h"
+
+#define UNIX_PREFIX "unix:"
+
+//=============================================================================/
+//=================|    Data Structures     |==================================/
+//=============================================================================/
+
+/**
+ * @brief A resolved address, ready for bind() or connect().
+ */
+typedef struct {
+    int family;
+    socklen_t len;
+    union {
+        struct sockaddr any;
+        struct sockaddr_un un;
+        struct sockaddr_in in;
+    } as;
+} netaddr_t;
+
+//=============================================================================/
+//=================|    Private Function Declarations     |====================/
+//=============================================================================/
+
+static status_t netaddr_parse(const char *addr, netaddr_t *out);
+
+//=============================================================================/
+//=================|    Public Function Implementations     |==================/
+//=============================================================================/
+
+int netutils_listen(const char *addr, int backlog) {
+    netaddr_t na;
+    if (SUCCESS != netaddr_parse(addr, &na)) return -1; // err handling
+
+    int fd = socket(na.family, SOCK_STREAM, 0);
+    if (fd < 0) return -1; // err handling
+
+    if (AF_UNIX == na.family) {
+        unlink(na.as.un.sun_path);
+    } else {
+        int one = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    }
+
+    if (0 != bind(fd, &na.as.any, na.len) || 0 != listen(fd, backlog) ||
+        SUCCESS != netutils_set_nonblocking(fd)) { // err handling
+        int err = errno;
+        close(fd);
+        errno = err;
+        return -1;
+    }
+
+    return fd;
+}
+
+int netutils_connect(const char *addr) {
+    netaddr_t na;
+    if (SUCCESS != netaddr_parse(addr, &na)) return -1; // err handling
+
+    int fd = socket(na.family, SOCK_STREAM, 0);
+    if (fd < 0) return -1; // err handling
+
+    if (0 != connect(fd, &na.as.any, na.len)) { // err handling
+        int err = errno;
+        close(fd);
+        errno = err;
+        return -1;
+    }
+
+    // Requests are small and pipelined, do not hold them back
+    if (AF_INET == na.family) {
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+
+    return fd;
+}
+
+status_t netutils_set_nonblocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0)
+        return CRITICAL_ERR;
+    return SUCCESS;
+}
+
+void netutils_unlink(const char *addr) {
+    netaddr_t na;
+    if (SUCCESS == netaddr_parse(addr, &na) && AF_UNIX == na.family)
+        unlink(na.as.un.sun_path);
+}
+
+//=============================================================================/
+//=================|    Private Function Implementations    |==================/
+//=============================================================================/
+
+/**
+ * @brief Resolves an address string, see netutils.h for the forms.
+ */
+static status_t netaddr_parse(const char *addr, netaddr_t *out) {
+    if (NULL == addr || NULL == out) return NUL_ERR;
+    *out = (netaddr_t){0};
+
+    // Unix domain socket
+    if (0 == strncmp(addr, UNIX_PREFIX, strlen(UNIX_PREFIX))) {
+        const char *path = addr + strlen(UNIX_PREFIX);
+        if ('\0' == path[0] || strlen(path) >= sizeof(out->as.un.sun_path)) {
+            errno = EINVAL;
+            return TOO_MUCH_ERR;
+        }
+        out->family = AF_UNIX;
+        out->len = sizeof(out->as.un);
+        out->as.un.sun_family = AF_UNIX;
+        strcpy(out->as.un.sun_path, path);
+        return SUCCESS;
+    }
+
+    // TCP: HOST:PORT or PORT
+    const char *colon = strrchr(addr, ':');
+    const char *port = colon ? colon + 1 : addr;
+    char host[64] = "127.0.0.1";
+    if (colon) {
+        size_t host_len = (size_t)(colon - addr);
+        if (host_len >= sizeof(host)) {
+            errno = EINVAL;
+            return TOO_MUCH_ERR;
+        }
+        memcpy(host, addr, host_len);
+        host[host_len] = '\0';
+    }
+
+    char *end = NULL;
+    unsigned long p = strtoul(port, &end, 10);
+    out->family = AF_INET;
+    out->len = sizeof(out->as.in);
+    out->as.in.sin_family = AF_INET;
+    out->as.in.sin_port = htons((unsigned short)p);
+    if ('\0' == port[0] || '\0' != *end || p > 65535 ||
+        1 != inet_pton(AF_INET, host, &out->as.in.sin_addr)) {
+        errno = EINVAL;
+        return NOT_FOUND_ERR;
+    }
+
+    return SUCCESS;
+}
@@ -0,0 +1,144 @@
+#include <sched.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <time.h>
+
+#include "utils/ring.h"
+
+// Waiting: spin (yielding) this many times, then sleep RING_NAP_NS per try.
+#define RING_SPINS (64)
+#define RING_NAP_NS (50000L)
+
+//=============================================================================/
+//=================|    Data Structures     |==================================/
+//=============================================================================/
+
+struct _ring_s {
+    // Consumer side
+    _Alignas(64) atomic_size_t head; // next slot to pop
+    size_t tail_cache;               // last tail seen by the consumer
+
+    // Producer side
+    _Alignas(64) atomic_size_t tail; // next slot to push
+    size_t head_cache;               // last head seen by the producer
+    atomic_bool closed;
+
+    // Read only after creation
+    _Alignas(64) size_t mask;
+    size_t elem_size;
+    unsigned char *slots;
+};
+
+//=============================================================================/
+//=================|    Private Function Declarations     |====================/
+//=============================================================================/
+
+static void ring_wait(unsigned int *tries);
+
+//=============================================================================/
+//=================|    Public Function Implementations     |==================/
+//=============================================================================/
+
+Ring *ring_new(size_t capacity, size_t elem_size) {
+    if (0 == elem_size) return NULL; // err handling
+
+    size_t size = 1;
+    while (size < capacity) size <<= 1;
+
+    Ring *ring = (Ring *)calloc(1, sizeof(Ring));
+    if (NULL == ring) return NULL; // err handling
+
+    ring->slots = (unsigned char *)malloc(size * elem_size);
+    if (NULL == ring->slots) { // err handling
+        free(ring);
+        return NULL;
+    }
+
+    ring->mask = size - 1;
+    ring->elem_size = elem_size;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    atomic_init(&ring->closed, 0);
+    return ring;
+}
+
+void ring_del(Ring **ring) {
+    if (NULL == ring || NULL == *ring) return;
+    free((*ring)->slots);
+    free(*ring);
+    *ring = NULL;
+}
+
+status_t ring_push(Ring *ring, const void *elem) {
+    if (NULL == ring || NULL == elem) return NUL_ERR;
+
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+    // Full: refresh the cached head until the consumer frees a slot
+    unsigned int tries = 0;
+    while (tail - ring->head_cache > ring->mask) {
+        ring->head_cache =
+            atomic_load_explicit(&ring->head, memory_order_acquire);
+        if (tail - ring->head_cache > ring->mask) ring_wait(&tries);
+    }
+
+    memcpy(ring->slots + (tail & ring->mask) * ring->elem_size, elem,
+           ring->elem_size);
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+    return SUCCESS;
+}
+
+status_t ring_pop(Ring *ring, void *elem) {
+    if (NULL == ring || NULL == elem) return NUL_ERR;
+
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+
+    // Empty: refresh the cached tail until the producer pushes or closes
+    unsigned int tries = 0;
+    while (head == ring->tail_cache) {
+        _Bool closed = atomic_load_explicit(&ring->closed, memory_order_acquire);
+        ring->tail_cache =
+            atomic_load_explicit(&ring->tail, memory_order_acquire);
+        if (head != ring->tail_cache) break;
+        if (closed) return EOF_ERR; // the tail was read after the close
+        ring_wait(&tries);
+    }
+
+    memcpy(elem, ring->slots + (head & ring->mask) * ring->elem_size,
+           ring->elem_size);
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+    return SUCCESS;
+}
+
+void ring_close(Ring *ring) {
+    if (NULL == ring) return;
+    atomic_store_explicit(&ring->closed, 1, memory_order_release);
+}
+
+_Bool ring_is_empty(Ring *ring) {
+    if (NULL == ring) return 1;
+
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    if (head != ring->tail_cache) return 0;
+
+    ring->tail_cache = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    return head == ring->tail_cache;
+}
+
+//=============================================================================/
+//=================|    Private Function Implementations    |==================/
+//=============================================================================/
+
+/**
+ * @brief Backs off while the other side catches up: yields first and then
+ * sleeps, so an idle stage does not burn a core.
+ *
+ * @param tries number of waits so far, incremented.
+ */
+static void ring_wait(unsigned int *tries) {
+    if ((*tries)++ < RING_SPINS) {
+        sched_yield();
+        return;
+    }
+    nanosleep(&(struct timespec){.tv_nsec = RING_NAP_NS}, NULL);
+}
@@ -0,0 +1,145 @@
+#include "utils/threadpool.h"
+
+//=============================================================================/
+//=================|    Data Structures     |==================================/
+//=============================================================================/
+
+typedef struct _task_s {
+    void (*fn)(void *);
+    void *arg;
+    struct _task_s *next;
+} Task;
+
+struct _threadpool_s {
+    pthread_mutex_t lock;
+    pthread_cond_t has_work; // signaled when a task is queued or on shutdown
+    pthread_cond_t idle;     // signaled when the last pending task finishes
+    Task *head;
+    Task *tail;
+    size_t pending; // queued + running tasks
+    _Bool stop;
+    size_t size;
+    pthread_t *workers;
+};
+
+//=============================================================================/
+//=================|    Private Function Declarations     |====================/
+//=============================================================================/
+
+static void *worker_loop(void *arg);
+
+//=============================================================================/
+//=================|    Public Function Implementations     |==================/
+//=============================================================================/
+
+ThreadPool *threadpool_new(size_t threads) {
+    if (0 == threads) threads = 1;
+
+    ThreadPool *pool = (ThreadPool *)calloc(1, sizeof(ThreadPool));
+    if (NULL == pool) return NULL; // err handling
+
+    pool->workers = (pthread_t *)calloc(threads, sizeof(pthread_t));
+    if (NULL == pool->workers) {
+        free(pool);
+        return NULL;
+    }
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->has_work, NULL);
+    pthread_cond_init(&pool->idle, NULL);
+
+    for (; pool->size < threads; pool->size++) {
+        if (0 != pthread_create(&pool->workers[pool->size], NULL, worker_loop,
+                                pool))
+            break; // err handling: keep the workers we got
+    }
+
+    if (0 == pool->size) threadpool_del(&pool);
+    return pool;
+}
+
+void threadpool_del(ThreadPool **pool) {
+    if (NULL == pool || NULL == *pool) return;
+    ThreadPool *p = *pool;
+
+    threadpool_wait(p);
+
+    pthread_mutex_lock(&p->lock);
+    p->stop = 1;
+    pthread_cond_broadcast(&p->has_work);
+    pthread_mutex_unlock(&p->lock);
+
+    for (size_t i = 0; i < p->size; i++) pthread_join(p->workers[i], NULL);
+
+    pthread_cond_destroy(&p->idle);
+    pthread_cond_destroy(&p->has_work);
+    pthread_mutex_destroy(&p->lock);
+    free(p->workers);
+    free(p);
+    *pool = NULL;
+}
+
+status_t threadpool_submit(ThreadPool *pool, void (*fn)(void *), void *arg) {
+    if (NULL == pool || NULL == fn) return NUL_ERR;
+
+    Task *task = (Task *)malloc(sizeof(Task));
+    if (NULL == task) return ALLOC_ERR;
+    *task = (Task){.fn = fn, .arg = arg};
+
+    pthread_mutex_lock(&pool->lock);
+    if (pool->tail) pool->tail->next = task;
+    else pool->head = task;
+    pool->tail = task;
+    pool->pending++;
+    pthread_cond_signal(&pool->has_work);
+    pthread_mutex_unlock(&pool->lock);
+
+    return SUCCESS;
+}
+
+void threadpool_wait(ThreadPool *pool) {
+    if (NULL == pool) return;
+    pthread_mutex_lock(&pool->lock);
+    while (pool->pending > 0) pthread_cond_wait(&pool->idle, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+size_t threadpool_size(const ThreadPool *pool) {
+    return pool ? pool->size : 0;
+}
+
+//=============================================================================/
+//=================|    Private Function Implementations    |==================/
+//=============================================================================/
+
+/**
+ * @brief The body of every worker: pop a task, run it, repeat until the pool
+ * is stopped and the queue is empty.
+ *
+ * @param arg ptr to the pool.
+ * @return void* always NULL.
+ */
+static void *worker_loop(void *arg) {
+    ThreadPool *pool = (ThreadPool *)arg;
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (NULL == pool->head && !pool->stop)
+            pthread_cond_wait(&pool->has_work, &pool->lock);
+        if (NULL == pool->head) break; // stopped and drained
+
+        Task *task = pool->head;
+        pool->head = task->next;
+        if (NULL == pool->head) pool->tail = NULL;
+
+        pthread_mutex_unlock(&pool->lock);
+        task->fn(task->arg);
+        free(task);
+        pthread_mutex_lock(&pool->lock);
+
+        if (0 == --pool->pending) pthread_cond_broadcast(&pool->idle);
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    return NULL;
+}